@@ -0,0 +1,277 @@
+// avg_pool_2d.hpp
+
+#ifndef TOYNET_AVG_POOL_2D_HPP
+#define TOYNET_AVG_POOL_2D_HPP
+
+#include "cost_model.hpp"
+#include "data_types.hpp"
+
+// Number of extra integer bits to hold the sum of `n` elements
+constexpr int AvgPoolSumBits(int n)
+{
+  return n <= 1 ? 0 : 1 + AvgPoolSumBits((n + 1) / 2);
+}
+
+// Sum of `N` elements, which does not saturate before the division
+// The reciprocal of `N` is held in `norm_param_t`, because it is truncated
+// to zero in the narrow formats (e.g., 1 / 25 with 4 fractional bits)
+template <int N>
+using avg_pool_sum_t = ap_fixed<kBitWidth + AvgPoolSumBits(N),
+                                kIntegerBitWidth + AvgPoolSumBits(N),
+                                ap_q_mode::AP_TRN, ap_o_mode::AP_SAT, 0>;
+
+template <int C, int H, int W, int OH, int OW, int K, int P, int S>
+void AvgPool2d(const fixed_t x[C][H][W],
+               fixed_t y[C][OH][OW])
+{
+  // Naive implementation of the 2D average-pooling layer
+  // Padded elements are treated as zeros and the sum is always divided by
+  // `K` * `K` (same as `count_include_pad=True` in PyTorch)
+  // The division is replaced with the multiplication by the reciprocal,
+  // and the sum is kept in the wider type (`avg_pool_sum_t`)
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`, `OH`, `OW`)
+
+#pragma HLS INLINE off
+
+  static_assert(P <= K / 2, "`P` must be at most half of `K`");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  const norm_param_t scale = 1.0 / (K * K);
+
+  for (int c = 0; c < C; ++c) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        avg_pool_sum_t<K * K> val = 0;
+
+        for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE off
+            int ih = oh * S + kh - P;
+            int iw = ow * S + kw - P;
+
+            if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+              val += x[c][ih][iw];
+          }
+        }
+
+        y[c][oh][ow] = val * scale;
+      }
+    }
+  }
+}
+
+constexpr KernelCost AvgPool2dCost(int c, int /* h */, int /* w */,
+                                   int oh, int ow, int k,
+                                   int /* p */, int /* s */)
+{
+  // Estimated cost of `AvgPool2d`
+  // Each addition is made sequentially, followed by the multiplication by
+  // the reciprocal
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c) * oh * ow,
+      SequentialLoopCycles(k * k, kMemoryLatency + kAddLatency)
+      + kMulLatency + 1),
+    1, FixedBytes(c * oh * ow) };
+}
+
+template <int C, int H, int W, int OH, int OW, int K, int P, int S, int B>
+void AvgPool2d2(const fixed_t x[C][H][W],
+                fixed_t y[C][OH][OW])
+{
+  // Parallel implementation of the 2D average-pooling layer
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`, `OH`, `OW`)
+
+#pragma HLS INLINE off
+
+  static_assert(C % B == 0, "`C` must be a multiple of `B`");
+  static_assert(P <= K / 2, "`P` must be at most half of `K`");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  const norm_param_t scale = 1.0 / (K * K);
+
+  for (int c0 = 0; c0 < C; c0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        avg_pool_sum_t<K * K> vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+            int ih = oh * S + kh - P;
+            int iw = ow * S + kw - P;
+
+            for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+              int c = c0 + c1;
+              avg_pool_sum_t<K * K> v0 = (kh == 0 && kw == 0) ?
+                avg_pool_sum_t<K * K>(0) : vals[c1];
+              if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+                vals[c1] = v0 + x[c][ih][iw];
+              else
+                vals[c1] = v0;
+            }
+          }
+        }
+
+        for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int c = c0 + c1;
+          y[c][oh][ow] = vals[c1] * scale;
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct AvgPool2d2Ports
+{
+  // Number of elements accessed per cycle by `AvgPool2d2`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+constexpr KernelCost AvgPool2d2Cost(int c, int /* h */, int /* w */,
+                                    int oh, int ow, int k,
+                                    int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `AvgPool2d2`
+  // `B` additions are made in parallel in the pipelined loop, and the `B`
+  // sums are multiplied by the reciprocal after it
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c / b) * oh * ow,
+      PipelinedLoopCycles(k * k, 1, kMemoryLatency + kAddLatency)
+      + kMulLatency + 1),
+    b, FixedBytes(c * oh * ow) };
+}
+
+template <int C, int H, int W>
+void GlobalAvgPool2d(const fixed_t x[C][H][W],
+                     fixed_t y[C])
+{
+  // Naive implementation of the 2D global average-pooling layer
+  // The output can be directly passed to the fully-connected layer
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`)
+
+#pragma HLS INLINE off
+
+  const norm_param_t scale = 1.0 / (H * W);
+
+  for (int c = 0; c < C; ++c) {
+#pragma HLS PIPELINE off
+    avg_pool_sum_t<H * W> val = 0;
+
+    for (int h = 0; h < H; ++h) {
+#pragma HLS PIPELINE off
+      for (int w = 0; w < W; ++w) {
+#pragma HLS PIPELINE off
+        val += x[c][h][w];
+      }
+    }
+
+    y[c] = val * scale;
+  }
+}
+
+constexpr KernelCost GlobalAvgPool2dCost(int c, int h, int w)
+{
+  // Estimated cost of `GlobalAvgPool2d`
+  // Each addition is made sequentially, followed by the multiplication by
+  // the reciprocal
+  return KernelCost {
+    SequentialLoopCycles(
+      c,
+      SequentialLoopCycles(static_cast<long long>(h) * w,
+                           kMemoryLatency + kAddLatency)
+      + kMulLatency + 1),
+    1, FixedBytes(c) };
+}
+
+template <int C, int H, int W, int B>
+void GlobalAvgPool2d2(const fixed_t x[C][H][W],
+                      fixed_t y[C])
+{
+  // Parallel implementation of the 2D global average-pooling layer
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`)
+
+#pragma HLS INLINE off
+
+  static_assert(C % B == 0, "`C` must be a multiple of `B`");
+
+  const norm_param_t scale = 1.0 / (H * W);
+
+  for (int c0 = 0; c0 < C; c0 += B) {
+#pragma HLS PIPELINE off
+    avg_pool_sum_t<H * W> vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+    for (int h = 0; h < H; ++h) {
+#pragma HLS PIPELINE off
+      for (int w = 0; w < W; ++w) {
+#pragma HLS PIPELINE II=1
+        for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+          int c = c0 + c1;
+          avg_pool_sum_t<H * W> v0 = (h == 0 && w == 0) ?
+            avg_pool_sum_t<H * W>(0) : vals[c1];
+          vals[c1] = v0 + x[c][h][w];
+        }
+      }
+    }
+
+    for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+      int c = c0 + c1;
+      y[c] = vals[c1] * scale;
+    }
+  }
+}
+
+template <int B>
+struct GlobalAvgPool2d2Ports
+{
+  // Number of elements accessed per cycle by `GlobalAvgPool2d2`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+constexpr KernelCost GlobalAvgPool2d2Cost(int c, int h, int w, int b)
+{
+  // Estimated cost of `GlobalAvgPool2d2`
+  // `B` additions are made in parallel in the pipelined loop, and the `B`
+  // sums are multiplied by the reciprocal after it
+  return KernelCost {
+    SequentialLoopCycles(
+      c / b,
+      PipelinedLoopCycles(static_cast<long long>(h) * w, 1,
+                          kMemoryLatency + kAddLatency)
+      + kMulLatency + 1),
+    b, FixedBytes(c) };
+}
+
+#endif // TOYNET_AVG_POOL_2D_HPP
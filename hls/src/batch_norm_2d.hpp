@@ -4,7 +4,10 @@
 #ifndef TOYNET_BATCH_NORM_2D_HPP
 #define TOYNET_BATCH_NORM_2D_HPP
 
+#include "cost_model.hpp"
 #include "data_types.hpp"
+#include "loop_trips.hpp"
+#include "range_monitor.hpp"
 
 template <int C, int H, int W>
 void BatchNorm2dReLU(const fixed_t x[C][H][W],
@@ -37,6 +40,16 @@ void BatchNorm2dReLU(const fixed_t x[C][H][W],
   }
 }
 
+constexpr KernelCost BatchNorm2dReLUCost(int c, int h, int w)
+{
+  // Estimated cost of `BatchNorm2dReLU`
+  // Each element is subtracted, multiplied, added, and clipped sequentially
+  return KernelCost {
+    SequentialLoopCycles(static_cast<long long>(c) * h * w,
+                         kMemoryLatency + kAddLatency + kMacLatency + 1),
+    1, FixedBytes(c * h * w) };
+}
+
 template <int C, int H, int W, int B>
 void BatchNorm2dReLU2(const fixed_t x[C][H][W],
                       fixed_t y[C][H][W],
@@ -73,6 +86,26 @@ void BatchNorm2dReLU2(const fixed_t x[C][H][W],
   }
 }
 
+template <int B>
+struct BatchNorm2dReLU2Ports
+{
+  // Number of elements accessed per cycle by `BatchNorm2dReLU2`
+  // `x`, `y`, and the parameters are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+  static constexpr int kParams = B;
+};
+
+constexpr KernelCost BatchNorm2dReLU2Cost(int c, int h, int w, int b)
+{
+  // Estimated cost of `BatchNorm2dReLU2`
+  // `B` elements are processed in parallel without pipelining
+  return KernelCost {
+    SequentialLoopCycles(static_cast<long long>(c / b) * h * w,
+                         kMemoryLatency + kAddLatency + kMacLatency + 1),
+    b, FixedBytes(c * h * w) };
+}
+
 template <int C, int H, int W, int B>
 void BatchNorm2dReLU3(const fixed_t x[C][H][W],
                       fixed_t y[C][H][W],
@@ -100,7 +133,8 @@ void BatchNorm2dReLU3(const fixed_t x[C][H][W],
 #pragma HLS UNROLL
           int c = c0 + c1;
           // Batch normalization with the learned parameters
-          fixed_t val = (x[c][h][w] - mean[c]) * scale[c] + bias[c];
+          fixed_t val = MonitorRange(
+            (x[c][h][w] - mean[c]) * scale[c] + bias[c]);
           // ReLU activation
           y[c][h][w] = val > fixed_t(0) ? val : fixed_t(0);
         }
@@ -109,4 +143,143 @@ void BatchNorm2dReLU3(const fixed_t x[C][H][W],
   }
 }
 
+template <int B>
+struct BatchNorm2dReLU3Ports
+{
+  // Number of elements accessed per cycle by `BatchNorm2dReLU3`
+  // `x`, `y`, and the parameters are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+  static constexpr int kParams = B;
+};
+
+constexpr LoopTrips BatchNorm2dReLU3Trips(int c, int h, int w, int b)
+{
+  // Loop trip counts of `BatchNorm2dReLU3`
+  // All loops are flattened into a single pipelined loop
+  return LoopTrips { 1, static_cast<long long>(c / b) * h * w, 0 };
+}
+
+constexpr KernelCost BatchNorm2dReLU3Cost(int c, int h, int w, int b)
+{
+  // Estimated cost of `BatchNorm2dReLU3`
+  // `B` elements are processed in parallel in the pipelined loop
+  const LoopTrips trips = BatchNorm2dReLU3Trips(c, h, w, b);
+  return KernelCost {
+    trips.outer * PipelinedLoopCycles(
+      trips.inner, 1, kMemoryLatency + kAddLatency + kMacLatency + 1),
+    b, FixedBytes(c * h * w) };
+}
+
+template <int MaxLayers, int MaxC, int MaxInHW, int MaxOutHW, int B>
+void BatchNorm2dReLUDynamic(const fixed_t x[MaxC][MaxInHW],
+                            fixed_t y[MaxC][MaxOutHW],
+                            const fixed_t scale[MaxLayers][MaxC],
+                            const fixed_t bias[MaxLayers][MaxC],
+                            const fixed_t mean[MaxLayers][MaxC],
+                            const int layer,
+                            const int c,
+                            const int hw)
+{
+  // Parallel implementation of the batch normalization and ReLU activation
+  // with runtime shapes
+  // Used as a single engine shared by all batch normalization layers
+  // `x` is of size (`c`, `hw`)
+  // `y` is of size (`c`, `hw`)
+  // `scale`, `bias`, and `mean` of the `layer`-th layer are of size (`c`)
+
+#pragma HLS INLINE off
+
+  static_assert(MaxC % B == 0, "`MaxC` must be a multiple of `B`");
+
+  constexpr int kMaxGroups = MaxC / B;
+
+  for (int c0 = 0; c0 < c; c0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxGroups
+#pragma HLS PIPELINE off
+    for (int i = 0; i < hw; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxInHW
+#pragma HLS PIPELINE II=1
+      for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+        int ch = c0 + c1;
+        // Batch normalization with the learned parameters
+        fixed_t val = (x[ch][i] - mean[layer][ch]) * scale[layer][ch]
+          + bias[layer][ch];
+        // ReLU activation
+        if (ch < c)
+          y[ch][i] = val > fixed_t(0) ? val : fixed_t(0);
+      }
+    }
+  }
+}
+
+template <int B>
+struct BatchNorm2dReLUDynamicPorts
+{
+  // Number of elements accessed per cycle by `BatchNorm2dReLUDynamic`
+  // `x`, `y`, and the parameters are accessed along the first dimension
+  // (the second dimension for the parameters)
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+  static constexpr int kParams = B;
+};
+
+template <int MaxLayers, int MaxC, int MaxSize, int B>
+void BatchNorm2dReLUOverlay(fixed_t fmap[MaxC][MaxSize],
+                            const fixed_t scale[MaxLayers][MaxC],
+                            const fixed_t bias[MaxLayers][MaxC],
+                            const fixed_t mean[MaxLayers][MaxC],
+                            const int src,
+                            const int dst,
+                            const int layer,
+                            const int c,
+                            const int hw)
+{
+  // Parallel implementation of the batch normalization and ReLU activation
+  // with runtime shapes for the programmable layer engine
+  // (same as `BatchNorm2dReLUDynamic` except for the buffers)
+  // `x` is of size (`c`, `hw`) and starts from the column `src`
+  // `y` is of size (`c`, `hw`) and starts from the column `dst`
+  // `scale`, `bias`, and `mean` of the `layer`-th layer are of size (`c`)
+  // `x` and `y` may be the same buffer (in-place operation)
+
+#pragma HLS INLINE off
+
+  static_assert(MaxC % B == 0, "`MaxC` must be a multiple of `B`");
+
+  constexpr int kMaxGroups = MaxC / B;
+
+  for (int c0 = 0; c0 < c; c0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxGroups
+#pragma HLS PIPELINE off
+    for (int i = 0; i < hw; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE II=1
+      for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+        int ch = c0 + c1;
+        // Batch normalization with the learned parameters
+        fixed_t val = (fmap[ch][src + i] - mean[layer][ch]) *
+          scale[layer][ch] + bias[layer][ch];
+        // ReLU activation
+        if (ch < c)
+          fmap[ch][dst + i] = val > fixed_t(0) ? val : fixed_t(0);
+      }
+    }
+  }
+}
+
+template <int B>
+struct BatchNorm2dReLUOverlayPorts
+{
+  // Number of elements accessed per cycle by `BatchNorm2dReLUOverlay`
+  // `x`, `y`, and the parameters are accessed along the first dimension
+  // (the second dimension for the parameters)
+  // `x` and `y` are read and written in the same cycle
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+  static constexpr int kParams = B;
+};
+
 #endif // TOYNET_BATCH_NORM_2D_HPP
@@ -4,7 +4,13 @@
 #ifndef TOYNET_CONV_2D_HPP
 #define TOYNET_CONV_2D_HPP
 
+#include "cost_model.hpp"
+#include "data_packing.hpp"
 #include "data_types.hpp"
+#include "dual_mac.hpp"
+#include "log_quantization.hpp"
+#include "loop_trips.hpp"
+#include "range_monitor.hpp"
 
 template <int InCh, int OutCh, int H, int W, int OH, int OW,
           int K, int P, int S>
@@ -54,6 +60,20 @@ void Conv2d(const fixed_t x[InCh][H][W],
   }
 }
 
+constexpr KernelCost Conv2dCost(int in_ch, int out_ch,
+                                int /* h */, int /* w */,
+                                int oh, int ow, int k,
+                                int /* p */, int /* s */)
+{
+  // Estimated cost of `Conv2d`
+  // Each product is computed sequentially
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch) * oh * ow,
+      SequentialLoopCycles(in_ch * k * k, kMemoryLatency + kMacLatency) + 1),
+    1, FixedBytes(out_ch * oh * ow) };
+}
+
 template <int InCh, int OutCh, int H, int W, int OH, int OW,
           int K, int P, int S, int B>
 void Conv2d2(const fixed_t x[InCh][H][W],
@@ -112,6 +132,35 @@ void Conv2d2(const fixed_t x[InCh][H][W],
   }
 }
 
+template <int B>
+struct Conv2d2Ports
+{
+  // Number of elements accessed per cycle by `Conv2d2`
+  // `x` is read along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  // `weight` is read along the second dimension
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost Conv2d2Cost(int in_ch, int out_ch,
+                                 int /* h */, int /* w */,
+                                 int oh, int ow, int k,
+                                 int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `Conv2d2`
+  // The loops over the input channels and kernel are pipelined (and
+  // flattened) automatically, and the `B` partial sums are added up at the
+  // end of each output element
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch) * oh * ow,
+      PipelinedLoopCycles(in_ch / b * k * k, 1,
+                          kMemoryLatency + kMacLatency)
+      + AdderTreeDepth(b) * kAddLatency + 1),
+    b, FixedBytes(out_ch * oh * ow) };
+}
+
 template <int InCh, int OutCh, int H, int W, int OH, int OW,
           int K, int P, int S, int B>
 void Conv2d3(const fixed_t x[InCh][H][W],
@@ -177,6 +226,31 @@ void Conv2d3(const fixed_t x[InCh][H][W],
   }
 }
 
+template <int B>
+struct Conv2d3Ports
+{
+  // Number of elements accessed per cycle by `Conv2d3`
+  // `x` is shared by all `B` output channels
+  static constexpr int kInput = 1;
+  // `y` and `weight` are accessed along the first dimension
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost Conv2d3Cost(int in_ch, int out_ch,
+                                 int /* h */, int /* w */,
+                                 int oh, int ow, int k,
+                                 int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `Conv2d3`
+  // `B` products are computed in parallel without pipelining
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch / b) * oh * ow,
+      SequentialLoopCycles(in_ch * k * k, kMemoryLatency + kMacLatency) + 1),
+    b, FixedBytes(out_ch * oh * ow) };
+}
+
 template <int InCh, int OutCh, int H, int W, int OH, int OW,
           int K, int P, int S, int B>
 void Conv2d4(const fixed_t x[InCh][H][W],
@@ -223,7 +297,8 @@ void Conv2d4(const fixed_t x[InCh][H][W],
                 fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
                   fixed_t(0) : vals[oc1];
                 if (ih >= 0 && ih < H && iw >= 0 && iw < W)
-                  vals[oc1] = v0 + x[ic][ih][iw] * weight[oc][ic][kh][kw];
+                  vals[oc1] = MonitorRange(
+                    v0 + x[ic][ih][iw] * weight[oc][ic][kh][kw]);
                 else
                   vals[oc1] = v0;
               }
@@ -242,4 +317,518 @@ void Conv2d4(const fixed_t x[InCh][H][W],
   }
 }
 
+template <int B>
+struct Conv2d4Ports
+{
+  // Number of elements accessed per cycle by `Conv2d4`
+  // `x` is shared by all `B` output channels
+  static constexpr int kInput = 1;
+  // `y` and `weight` are accessed along the first dimension
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+constexpr LoopTrips Conv2d4Trips(int in_ch, int out_ch,
+                                 int /* h */, int /* w */,
+                                 int oh, int ow, int k,
+                                 int /* p */, int /* s */, int b)
+{
+  // Loop trip counts of `Conv2d4`
+  // The products over the input channels and window are pipelined, and
+  // the `B` outputs are written after them
+  return LoopTrips { static_cast<long long>(out_ch / b) * oh * ow,
+                     in_ch * k * k, 1 };
+}
+
+constexpr KernelCost Conv2d4Cost(int in_ch, int out_ch, int h, int w,
+                                 int oh, int ow, int k, int p, int s, int b)
+{
+  // Estimated cost of `Conv2d4`
+  // `B` products are computed in parallel in the pipelined loop
+  const LoopTrips trips = Conv2d4Trips(
+    in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+  return KernelCost {
+    SequentialLoopCycles(
+      trips.outer,
+      PipelinedLoopCycles(trips.inner, 1, kMemoryLatency + kMacLatency)
+      + trips.tail),
+    b, FixedBytes(out_ch * oh * ow) };
+}
+
+template <int MaxInCh, int MaxOutCh, int MaxInHW, int MaxOutHW,
+          int MaxWeightCols, int K, int B>
+void Conv2dDynamic(const fixed_t x[MaxInCh][MaxInHW],
+                   fixed_t y[MaxOutCh][MaxOutHW],
+                   const fixed_t weight[MaxOutCh][MaxWeightCols],
+                   const int weight_offset,
+                   const int in_ch,
+                   const int out_ch,
+                   const int h,
+                   const int w,
+                   const int oh,
+                   const int ow,
+                   const int pad)
+{
+  // Parallel implementation of the 2D convolution layer with runtime shapes
+  // Used as a single engine shared by all convolution layers
+  // `x` is of size (`in_ch`, `h` * `w`)
+  // `y` is of size (`out_ch`, `oh` * `ow`)
+  // `weight` is of size (`out_ch`, `in_ch` * `K` * `K`) and starts from
+  // the column `weight_offset`
+  // Output channels beyond `out_ch` are computed but not written
+
+#pragma HLS INLINE off
+
+  static_assert(MaxOutCh % B == 0,
+                "`MaxOutCh` must be a multiple of `B`");
+  static_assert(K % 2 == 1, "`K` must be an odd number");
+
+  constexpr int kMaxGroups = MaxOutCh / B;
+
+  for (int oc0 = 0; oc0 < out_ch; oc0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxGroups
+#pragma HLS PIPELINE off
+    for (int oy = 0; oy < oh; ++oy) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutHW
+#pragma HLS PIPELINE off
+      for (int ox = 0; ox < ow; ++ox) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutHW
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic = 0; ic < in_ch; ++ic) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxInCh
+#pragma HLS PIPELINE off
+          for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+            for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+              int ih = oy + kh - pad;
+              int iw = ox + kw - pad;
+              int col = weight_offset + (ic * K + kh) * K + kw;
+              bool valid = ih >= 0 && ih < h && iw >= 0 && iw < w;
+
+              for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS UNROLL
+                int oc = oc0 + oc1;
+                fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1];
+                if (valid)
+                  vals[oc1] = v0 + x[ic][ih * w + iw] * weight[oc][col];
+                else
+                  vals[oc1] = v0;
+              }
+            }
+          }
+        }
+
+        for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          if (oc < out_ch)
+            y[oc][oy * ow + ox] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct Conv2dDynamicPorts
+{
+  // Number of elements accessed per cycle by `Conv2dDynamic`
+  // `x` is shared by all `B` output channels
+  static constexpr int kInput = 1;
+  // `y` and `weight` are accessed along the first dimension
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+template <int MaxC, int MaxSize, int MaxWeightCols, int MaxK, int B>
+void Conv2dOverlay(fixed_t fmap[MaxC][MaxSize],
+                   const fixed_t weight[MaxC][MaxWeightCols],
+                   const int src,
+                   const int dst,
+                   const int in_ch,
+                   const int out_ch,
+                   const int h,
+                   const int w,
+                   const int oh,
+                   const int ow,
+                   const int k,
+                   const int pad,
+                   const int stride,
+                   const int weight_offset)
+{
+  // Parallel implementation of the 2D convolution layer with runtime
+  // shapes, kernel size, and stride for the programmable layer engine
+  // (same as `Conv2dDynamic` except for the buffers)
+  // The input and output are stored in the same feature map memory
+  // `x` is of size (`in_ch`, `h` * `w`) and starts from the column `src`
+  // `y` is of size (`out_ch`, `oh` * `ow`) and starts from the column `dst`
+  // `weight` is of size (`out_ch`, `in_ch` * `k` * `k`) and starts from
+  // the column `weight_offset`
+  // `x` and `y` must not overlap
+
+#pragma HLS INLINE off
+
+  static_assert(MaxC % B == 0, "`MaxC` must be a multiple of `B`");
+
+  constexpr int kMaxGroups = MaxC / B;
+
+  for (int oc0 = 0; oc0 < out_ch; oc0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxGroups
+#pragma HLS PIPELINE off
+    for (int oy = 0; oy < oh; ++oy) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE off
+      for (int ox = 0; ox < ow; ++ox) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic = 0; ic < in_ch; ++ic) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+          for (int kh = 0; kh < k; ++kh) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxK
+#pragma HLS PIPELINE off
+            for (int kw = 0; kw < k; ++kw) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxK
+#pragma HLS PIPELINE II=1
+              int ih = oy * stride + kh - pad;
+              int iw = ox * stride + kw - pad;
+              int col = weight_offset + (ic * k + kh) * k + kw;
+              bool valid = ih >= 0 && ih < h && iw >= 0 && iw < w;
+
+              for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS UNROLL
+                int oc = oc0 + oc1;
+                fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1];
+                if (valid)
+                  vals[oc1] = v0 + fmap[ic][src + ih * w + iw] *
+                    weight[oc][col];
+                else
+                  vals[oc1] = v0;
+              }
+            }
+          }
+        }
+
+        for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          if (oc < out_ch)
+            fmap[oc][dst + oy * ow + ox] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct Conv2dOverlayPorts
+{
+  // Number of elements accessed per cycle by `Conv2dOverlay`
+  // `x` is shared by all `B` output channels
+  static constexpr int kInput = 1;
+  // `y` and `weight` are accessed along the first dimension
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int B>
+void Conv2dPacked(const fixed_t x[InCh][H][W],
+                  fixed_t y[OutCh][OH][OW],
+                  const packed_t<B> weight[OutCh / B][InCh][K][K])
+{
+  // Parallel implementation of the 2D convolution layer with the packed
+  // weights (same as `Conv2d4` except for the weight format)
+  // The weights of `B` consecutive output channels are packed into a
+  // single word, so that one memory access feeds all `B` lanes
+  // `x` is of size (`InCh`, `H`, `W`)
+  // `y` is of size (`OutCh`, `OH`, `OW`)
+  // `weight` is of size (`OutCh` / `B`, `InCh`, `K`, `K`)
+
+#pragma HLS INLINE off
+
+  static_assert(OutCh % B == 0,
+                "`OutCh` must be a multiple of `B`");
+  static_assert(K % 2 == 1, "`K` must be an odd number");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  for (int oc0 = 0; oc0 < OutCh; oc0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+          for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+            for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+              int ih = oh * S + kh - P;
+              int iw = ow * S + kw - P;
+              const packed_t<B> word = weight[oc0 / B][ic][kh][kw];
+
+              for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS UNROLL
+                fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1];
+                if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+                  vals[oc1] = v0 + x[ic][ih][iw] *
+                    UnpackValue<B>(word, oc1);
+                else
+                  vals[oc1] = v0;
+              }
+            }
+          }
+        }
+
+        for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          y[oc][oh][ow] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct Conv2dPackedPorts
+{
+  // Number of elements accessed per cycle by `Conv2dPacked`
+  // `x` is read one element at a time
+  static constexpr int kInput = 1;
+  // `y` is written along the first dimension
+  static constexpr int kOutput = B;
+  // `weight` is read one packed word at a time
+  static constexpr int kWeight = 1;
+};
+
+constexpr KernelCost Conv2dPackedCost(int in_ch, int out_ch, int h, int w,
+                                      int oh, int ow, int k, int p, int s,
+                                      int b)
+{
+  // Estimated cost of `Conv2dPacked` (same as `Conv2d4`)
+  return Conv2d4Cost(in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int B>
+void Conv2dDualMac(const fixed_t x[InCh][H][W],
+                   fixed_t y[OutCh][OH][OW],
+                   const fixed_t weight[OutCh][InCh][K][K])
+{
+  // Parallel implementation of the 2D convolution layer with two
+  // multiplications per DSP (same as `Conv2d4` except for the multipliers)
+  // Each input element is multiplied by the weights of two adjacent output
+  // channels with a single multiplier (see `DualMultiply`)
+  // `x` is of size (`InCh`, `H`, `W`)
+  // `y` is of size (`OutCh`, `OH`, `OW`)
+  // `weight` is of size (`OutCh`, `InCh`, `K`, `K`)
+
+#pragma HLS INLINE off
+
+  static_assert(OutCh % B == 0,
+                "`OutCh` must be a multiple of `B`");
+  static_assert(B % 2 == 0, "`B` must be an even number");
+  static_assert(K % 2 == 1, "`K` must be an odd number");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  for (int oc0 = 0; oc0 < OutCh; oc0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+          for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+            for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+              int ih = oh * S + kh - P;
+              int iw = ow * S + kw - P;
+
+              for (int oc1 = 0; oc1 < B; oc1 += 2) {
+#pragma HLS UNROLL
+                int oc = oc0 + oc1;
+                fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1];
+                fixed_t v1 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1 + 1];
+
+                if (ih >= 0 && ih < H && iw >= 0 && iw < W) {
+                  product_t p_hi;
+                  product_t p_lo;
+                  DualMultiply(x[ic][ih][iw], weight[oc + 1][ic][kh][kw],
+                               weight[oc][ic][kh][kw], p_hi, p_lo);
+                  vals[oc1] = v0 + p_lo;
+                  vals[oc1 + 1] = v1 + p_hi;
+                } else {
+                  vals[oc1] = v0;
+                  vals[oc1 + 1] = v1;
+                }
+              }
+            }
+          }
+        }
+
+        for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          y[oc][oh][ow] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct Conv2dDualMacPorts
+{
+  // Number of elements accessed per cycle by `Conv2dDualMac`
+  // `x` is read one element at a time
+  static constexpr int kInput = 1;
+  // `y` and `weight` are accessed along the first dimension
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost Conv2dDualMacCost(int in_ch, int out_ch,
+                                       int /* h */, int /* w */,
+                                       int oh, int ow, int k,
+                                       int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `Conv2dDualMac`
+  // Same as `Conv2d4` except that each multiplier computes two products
+  // and the products are split after the multiplication
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch / b) * oh * ow,
+      PipelinedLoopCycles(in_ch * k * k, 1,
+                          kMemoryLatency + kMacLatency + kAddLatency) + 1),
+    b / 2, FixedBytes(out_ch * oh * ow) };
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int B>
+void Conv2dLog(const fixed_t x[InCh][H][W],
+               fixed_t y[OutCh][OH][OW],
+               const log_weight_t weight[OutCh][InCh][K][K])
+{
+  // Parallel implementation of the 2D convolution layer with the
+  // log-quantized weights (same as `Conv2d4` except for the multipliers)
+  // Each multiplication is replaced with a shift of the input element
+  // (see `LogMultiply`), so that `B` can be increased beyond the number of
+  // DSPs
+  // `x` is of size (`InCh`, `H`, `W`)
+  // `y` is of size (`OutCh`, `OH`, `OW`)
+  // `weight` is of size (`OutCh`, `InCh`, `K`, `K`)
+
+#pragma HLS INLINE off
+
+  static_assert(OutCh % B == 0,
+                "`OutCh` must be a multiple of `B`");
+  static_assert(K % 2 == 1, "`K` must be an odd number");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  for (int oc0 = 0; oc0 < OutCh; oc0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+          for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+            for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+              int ih = oh * S + kh - P;
+              int iw = ow * S + kw - P;
+
+              for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS UNROLL
+                int oc = oc0 + oc1;
+                fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1];
+                if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+                  vals[oc1] = v0 + LogMultiply(x[ic][ih][iw],
+                                               weight[oc][ic][kh][kw]);
+                else
+                  vals[oc1] = v0;
+              }
+            }
+          }
+        }
+
+        for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          y[oc][oh][ow] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct Conv2dLogPorts
+{
+  // Number of elements accessed per cycle by `Conv2dLog`
+  // `x` is read one element at a time
+  static constexpr int kInput = 1;
+  // `y` and `weight` are accessed along the first dimension
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost Conv2dLogCost(int in_ch, int out_ch,
+                                   int /* h */, int /* w */,
+                                   int oh, int ow, int k,
+                                   int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `Conv2dLog`
+  // Same as `Conv2d4` except that the multiplications are replaced with
+  // the shifts
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch / b) * oh * ow,
+      PipelinedLoopCycles(in_ch * k * k, 1,
+                          kMemoryLatency + kShiftLatency + kAddLatency) + 1),
+    0, FixedBytes(out_ch * oh * ow) };
+}
+
 #endif // TOYNET_CONV_2D_HPP
@@ -0,0 +1,321 @@
+// conv_2d_tiled.hpp
+
+#ifndef TOYNET_CONV_2D_TILED_HPP
+#define TOYNET_CONV_2D_TILED_HPP
+
+#include "cost_model.hpp"
+#include "data_types.hpp"
+#include "partition_plan.hpp"
+
+// Tiled 2D convolution for the feature maps that do not fit on chip
+// The input, output, and weights reside in the external memory (DDR) and
+// are accessed through the AXI4 master interface
+// The output is divided into tiles of size (`TOC`, `TH`, `TW`), and each
+// tile is computed from the input tile of size (`InCh`, `TIH`, `TIW`)
+// including the halo and the weight tile of size (`TOC`, `InCh`, `K`, `K`)
+// The tiles are processed in three stages (load, compute, and store) with
+// the ping-pong buffers, so that the load of the next tile and the store
+// of the previous tile overlap with the computation of the current tile
+// The tiles are ordered by the output channels first, and the weight tile
+// is only read when the tile of the output channels changes
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int TH, int TW, int TOC>
+struct Conv2dTiledShape
+{
+  // Size of the input tile including the halo
+  static constexpr int kTileInH = (TH - 1) * S + K;
+  static constexpr int kTileInW = (TW - 1) * S + K;
+
+  // Number of tiles along the output channels, height, and width
+  static constexpr int kTilesOutCh = OutCh / TOC;
+  static constexpr int kTilesH = OH / TH;
+  static constexpr int kTilesW = OW / TW;
+  static constexpr int kNumTiles = kTilesOutCh * kTilesH * kTilesW;
+
+  static_assert(OutCh % TOC == 0, "`OutCh` must be a multiple of `TOC`");
+  static_assert(OH % TH == 0, "`OH` must be a multiple of `TH`");
+  static_assert(OW % TW == 0, "`OW` must be a multiple of `TW`");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+};
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int TH, int TW, int TOC>
+void Conv2dTiledLoad(
+  const fixed_t* x,
+  const fixed_t* weight,
+  fixed_t x_tile[InCh][(TH - 1) * S + K][(TW - 1) * S + K],
+  fixed_t weight_tile[TOC][InCh][K][K],
+  int& weight_toc,
+  const int t)
+{
+  // Read the `t`-th input tile (with the halo) and weight tile
+  // The out-of-bounds elements of the input tile are filled with zeros
+  // `weight_toc` is the tile of the output channels held in `weight_tile`
+  // (-1 if none), and the weight tile is only read when it changes
+
+#pragma HLS INLINE off
+
+  using Shape = Conv2dTiledShape<InCh, OutCh, H, W, OH, OW,
+                                 K, P, S, TH, TW, TOC>;
+  constexpr int TIH = Shape::kTileInH;
+  constexpr int TIW = Shape::kTileInW;
+  constexpr int kWeightSize = TOC * InCh * K * K;
+
+  if (t < 0 || t >= Shape::kNumTiles)
+    return;
+
+  const int toc = t / (Shape::kTilesH * Shape::kTilesW);
+  const int th = (t / Shape::kTilesW) % Shape::kTilesH;
+  const int tw = t % Shape::kTilesW;
+  const int ih0 = th * TH * S - P;
+  const int iw0 = tw * TW * S - P;
+
+  // In-bounds span [`c_begin`, `c_end`) of the rows of the tile
+  const int c_begin = iw0 < 0 ? -iw0 : 0;
+  const int c_end = iw0 + TIW > W ? W - iw0 : TIW;
+
+  for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+    for (int r = 0; r < TIH; ++r) {
+#pragma HLS PIPELINE off
+      const int ih = ih0 + r;
+      const bool row_in_bounds = ih >= 0 && ih < H;
+      const int begin = row_in_bounds ? c_begin : 0;
+      const int end = row_in_bounds ? c_end : 0;
+
+      // Copy the in-bounds span, which is contiguous in the external
+      // memory, without the bounds check, so that it is read in a burst
+      const int offset = (ic * H + ih) * W + iw0;
+
+      for (int c = begin; c < end; ++c) {
+#pragma HLS LOOP_TRIPCOUNT max=TIW
+#pragma HLS PIPELINE II=1
+        x_tile[ic][r][c] = x[offset + c];
+      }
+
+      // Fill the halo (the elements before `begin` and after `end`)
+      for (int i = 0; i < TIW - (end - begin); ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=TIW
+#pragma HLS PIPELINE II=1
+        const int c = i < begin ? i : end + i - begin;
+        x_tile[ic][r][c] = fixed_t(0);
+      }
+    }
+  }
+
+  if (toc == weight_toc)
+    return;
+
+  // The weight tile is a contiguous block in the external memory
+  for (int i = 0; i < kWeightSize; ++i) {
+#pragma HLS PIPELINE II=1
+    int oc = i / (InCh * K * K);
+    int ic = (i / (K * K)) % InCh;
+    int kh = (i / K) % K;
+    int kw = i % K;
+    weight_tile[oc][ic][kh][kw] = weight[toc * kWeightSize + i];
+  }
+
+  weight_toc = toc;
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int TH, int TW, int TOC, int B>
+void Conv2dTiledCompute(
+  const fixed_t x_tile[InCh][(TH - 1) * S + K][(TW - 1) * S + K],
+  const fixed_t weight_tile[TOC][InCh][K][K],
+  fixed_t y_tile[TOC][TH][TW],
+  const int t)
+{
+  // Compute the `t`-th output tile in the same way as `Conv2d4`
+  // The padding is already applied to the input tile, so that there is no
+  // boundary check
+
+#pragma HLS INLINE off
+
+  using Shape = Conv2dTiledShape<InCh, OutCh, H, W, OH, OW,
+                                 K, P, S, TH, TW, TOC>;
+
+  static_assert(TOC % B == 0, "`TOC` must be a multiple of `B`");
+
+  if (t < 0 || t >= Shape::kNumTiles)
+    return;
+
+  for (int oc0 = 0; oc0 < TOC; oc0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < TH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < TW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+          for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+            for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+              int ih = oh * S + kh;
+              int iw = ow * S + kw;
+
+              for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS UNROLL
+                int oc = oc0 + oc1;
+                fixed_t v0 = (ic == 0 && kh == 0 && kw == 0) ?
+                  fixed_t(0) : vals[oc1];
+                vals[oc1] = v0 + x_tile[ic][ih][iw] *
+                  weight_tile[oc][ic][kh][kw];
+              }
+            }
+          }
+        }
+
+        for (int oc1 = 0; oc1 < B; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          y_tile[oc][oh][ow] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int TH, int TW, int TOC>
+void Conv2dTiledStore(const fixed_t y_tile[TOC][TH][TW],
+                      fixed_t* y,
+                      const int t)
+{
+  // Write the `t`-th output tile
+
+#pragma HLS INLINE off
+
+  using Shape = Conv2dTiledShape<InCh, OutCh, H, W, OH, OW,
+                                 K, P, S, TH, TW, TOC>;
+
+  if (t < 0 || t >= Shape::kNumTiles)
+    return;
+
+  const int toc = t / (Shape::kTilesH * Shape::kTilesW);
+  const int th = (t / Shape::kTilesW) % Shape::kTilesH;
+  const int tw = t % Shape::kTilesW;
+  const int oc0 = toc * TOC;
+  const int oh0 = th * TH;
+  const int ow0 = tw * TW;
+
+  for (int oc = 0; oc < TOC; ++oc) {
+#pragma HLS PIPELINE off
+    for (int r = 0; r < TH; ++r) {
+#pragma HLS PIPELINE off
+      for (int c = 0; c < TW; ++c) {
+#pragma HLS PIPELINE II=1
+        y[((oc0 + oc) * OH + oh0 + r) * OW + ow0 + c] = y_tile[oc][r][c];
+      }
+    }
+  }
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int TH, int TW, int TOC, int B>
+void Conv2dTiled(const fixed_t* x,
+                 fixed_t* y,
+                 const fixed_t* weight)
+{
+  // Tiled implementation of the 2D convolution layer
+  // `x` points to the array of size (`InCh`, `H`, `W`)
+  // `y` points to the array of size (`OutCh`, `OH`, `OW`)
+  // `weight` points to the array of size (`OutCh`, `InCh`, `K`, `K`)
+  // `TH`, `TW`, and `TOC` are the tile sizes of the output
+
+#pragma HLS INLINE off
+
+  using Shape = Conv2dTiledShape<InCh, OutCh, H, W, OH, OW,
+                                 K, P, S, TH, TW, TOC>;
+  constexpr int TIH = Shape::kTileInH;
+  constexpr int TIW = Shape::kTileInW;
+
+  // `B` weights are read and `B` outputs are written per cycle
+  constexpr int kWeightFactor = CyclicPartition<TOC, 1, B>::kFactor;
+  constexpr int kOutputFactor = CyclicPartition<TOC, B, 1>::kFactor;
+
+  // Ping-pong buffers
+  fixed_t x_tile0[InCh][TIH][TIW];
+  fixed_t x_tile1[InCh][TIH][TIW];
+  fixed_t weight_tile0[TOC][InCh][K][K];
+  fixed_t weight_tile1[TOC][InCh][K][K];
+  fixed_t y_tile0[TOC][TH][TW];
+  fixed_t y_tile1[TOC][TH][TW];
+
+  // Tiles of the output channels held in the weight buffers
+  int weight_toc0 = -1;
+  int weight_toc1 = -1;
+
+#pragma HLS ARRAY_PARTITION variable=weight_tile0 dim=1 factor=kWeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=weight_tile1 dim=1 factor=kWeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=y_tile0 dim=1 factor=kOutputFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=y_tile1 dim=1 factor=kOutputFactor cyclic
+
+  // In the `t`-th iteration, the `t`-th tile is loaded, the `t-1`-th tile
+  // is computed, and the `t-2`-th tile is stored
+  // The three stages access different buffers and run in parallel
+  for (int t = 0; t < Shape::kNumTiles + 2; ++t) {
+#pragma HLS PIPELINE off
+    if (t % 2 == 0) {
+      Conv2dTiledLoad<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC>(
+        x, weight, x_tile0, weight_tile0, weight_toc0, t);
+      Conv2dTiledCompute<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC, B>(
+        x_tile1, weight_tile1, y_tile1, t - 1);
+      Conv2dTiledStore<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC>(
+        y_tile0, y, t - 2);
+    } else {
+      Conv2dTiledLoad<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC>(
+        x, weight, x_tile1, weight_tile1, weight_toc1, t);
+      Conv2dTiledCompute<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC, B>(
+        x_tile0, weight_tile0, y_tile0, t - 1);
+      Conv2dTiledStore<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC>(
+        y_tile1, y, t - 2);
+    }
+  }
+}
+
+constexpr KernelCost Conv2dTiledCost(int in_ch, int out_ch,
+                                     int /* h */, int /* w */,
+                                     int oh, int ow, int k,
+                                     int /* p */, int s,
+                                     int th, int tw, int toc, int b)
+{
+  // Estimated cost of `Conv2dTiled`
+  // The load, computation, and store of the consecutive tiles overlap, so
+  // that each of the (number of tiles + 2) iterations takes as long as the
+  // slowest of the three, and the weight tile is read once for each tile
+  // of the output channels
+  // Each row of the input tile is read in a burst, and the output tile is
+  // written without waiting for the external memory
+  const long long num_tiles =
+    static_cast<long long>(out_ch / toc) * (oh / th) * (ow / tw);
+  const long long load = SequentialLoopCycles(
+    static_cast<long long>(in_ch) * ((th - 1) * s + k),
+    PipelinedLoopCycles((tw - 1) * s + k, 1, kAxiLatency));
+  const long long load_weight = PipelinedLoopCycles(
+    static_cast<long long>(toc) * in_ch * k * k, 1, kAxiLatency);
+  const long long compute = SequentialLoopCycles(
+    static_cast<long long>(toc / b) * th * tw,
+    PipelinedLoopCycles(in_ch * k * k, 1, kMemoryLatency + kMacLatency)
+    + 1);
+  const long long store = SequentialLoopCycles(
+    static_cast<long long>(toc) * th,
+    PipelinedLoopCycles(tw, 1, kMemoryLatency + 1));
+  return KernelCost {
+    SequentialLoopCycles(num_tiles + 2,
+                         MaxCycles(MaxCycles(load, compute), store))
+    + (out_ch / toc) * load_weight,
+    b, FixedBytes(2 * toc * th * tw) };
+}
+
+#endif // TOYNET_CONV_2D_TILED_HPP
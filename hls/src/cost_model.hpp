@@ -0,0 +1,84 @@
+// cost_model.hpp
+
+#ifndef TOYNET_COST_MODEL_HPP
+#define TOYNET_COST_MODEL_HPP
+
+#include "data_types.hpp"
+
+// Analytical cost model of the kernels
+// Each kernel has a constexpr `*Cost` function next to its template, which
+// takes the same arguments as the template and estimates the latency from
+// the loop structure and pragmas of the kernel, without running the
+// synthesis
+// The estimates are meant for comparing the variants and parallelization
+// factors, and are not exact: the operator latencies below depend on the
+// clock period and bit width, and the loop overheads vary with the loop
+// structure that Vitis HLS finally schedules
+// The model assumes that the perfectly nested loops around the pipelined
+// loop are flattened (the default of Vitis HLS), and that the innermost
+// loops without any pragmas are pipelined automatically with II=1
+
+// Latency of reading the on-chip memory (BRAM)
+constexpr int kMemoryLatency = 2;
+// Latency of the multiplication (DSP) and addition of `fixed_t`
+constexpr int kMulLatency = 2;
+constexpr int kAddLatency = 1;
+constexpr int kMacLatency = kMulLatency + kAddLatency;
+// Latency of the shift used in place of the multiplication
+constexpr int kShiftLatency = 1;
+// Latency of the conversion between `float` and `fixed_t`
+constexpr int kConversionLatency = 3;
+// Latency of reading or writing the AXI4-Stream interface
+constexpr int kStreamLatency = 1;
+// Latency of the first beat of the burst read on the AXI4 master
+// interface (the external memory)
+constexpr int kAxiLatency = 64;
+// Extra cycles to enter and exit each iteration of the non-pipelined loop
+constexpr int kLoopOverhead = 1;
+
+// Estimated cost of one kernel call
+struct KernelCost
+{
+  // Number of cycles to process one sample
+  long long cycles;
+  // Number of multipliers running in parallel
+  int multipliers;
+  // Size of the output buffer in bytes
+  long long buffer_bytes;
+};
+
+// Number of cycles of the loop with `trips` iterations pipelined at `ii`,
+// whose iteration takes `depth` cycles
+constexpr long long PipelinedLoopCycles(long long trips,
+                                        long long ii,
+                                        long long depth)
+{
+  return trips > 0 ? (trips - 1) * ii + depth + kLoopOverhead : 0;
+}
+
+// Number of cycles of the non-pipelined loop with `trips` iterations,
+// whose body takes `body` cycles
+constexpr long long SequentialLoopCycles(long long trips, long long body)
+{
+  return trips * (body + kLoopOverhead);
+}
+
+// Larger of the two numbers of cycles (e.g., of the stages that overlap)
+constexpr long long MaxCycles(long long a, long long b)
+{
+  return a > b ? a : b;
+}
+
+// Depth of the adder tree that sums up `n` values
+constexpr int AdderTreeDepth(int n)
+{
+  return n > 1 ? 1 + AdderTreeDepth((n + 1) / 2) : 0;
+}
+
+// Size of `n` elements of `fixed_t` in bytes
+constexpr long long FixedBytes(long long n)
+{
+  return n * ((kBitWidth + 7) / 8);
+}
+
+#endif // TOYNET_COST_MODEL_HPP
@@ -0,0 +1,35 @@
+// data_packing.hpp
+
+#ifndef TOYNET_DATA_PACKING_HPP
+#define TOYNET_DATA_PACKING_HPP
+
+#include "data_types.hpp"
+
+// Word that packs `N` values of `fixed_t`
+// The `i`-th value occupies the bits [`i` * `kBitWidth`,
+// (`i` + 1) * `kBitWidth`), so that a single memory access reads `N`
+// values at once (e.g., 4x8-bit values in a 32-bit word)
+template <int N>
+using packed_t = ap_uint<N * kBitWidth>;
+
+// Extract the `i`-th value from the packed word
+template <int N>
+inline fixed_t UnpackValue(const packed_t<N>& word, const int i)
+{
+#pragma HLS INLINE
+  fixed_t val;
+  val.range(kBitWidth - 1, 0) =
+    word.range((i + 1) * kBitWidth - 1, i * kBitWidth);
+  return val;
+}
+
+// Store the value to the `i`-th position of the packed word
+template <int N>
+inline void PackValue(packed_t<N>& word, const int i, const fixed_t val)
+{
+#pragma HLS INLINE
+  word.range((i + 1) * kBitWidth - 1, i * kBitWidth) =
+    val.range(kBitWidth - 1, 0);
+}
+
+#endif // TOYNET_DATA_PACKING_HPP
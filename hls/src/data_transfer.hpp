@@ -4,8 +4,18 @@
 #ifndef TOYNET_DATA_TRANSFER_HPP
 #define TOYNET_DATA_TRANSFER_HPP
 
+#include "cost_model.hpp"
 #include "data_conversion.hpp"
+#include "data_packing.hpp"
 #include "data_types.hpp"
+#include "log_quantization.hpp"
+#include "range_monitor.hpp"
+
+// The tops keep the arrays written by the `Read*Params` functions (and the
+// overlay program) in static variables, so that the model parameters
+// persist across the calls in the C simulation as they do on the device
+// (the host runtime and its emulator backend load the parameters and run
+// the inference in separate calls)
 
 // Read the 1D array from the AXI4-Stream interface
 template <int D0>
@@ -17,10 +27,20 @@ void ReadArray1d(fixed_t x[D0],
 #pragma HLS PIPELINE off
     axi_stream_data_t in_data = in_stream.read();
     float val = U32ToFloat(in_data.data.to_uint());
-    x[i] = static_cast<fixed_t>(val);
+    x[i] = MonitorRange(val);
   }
 }
 
+constexpr KernelCost ReadArray1dCost(int d0)
+{
+  // Estimated cost of `ReadArray1d`
+  // Each element is read and converted sequentially
+  return KernelCost {
+    SequentialLoopCycles(d0,
+                         kStreamLatency + kConversionLatency + 1),
+    0, FixedBytes(d0) };
+}
+
 // Read the 2D array from the AXI4-Stream interface
 template <int D0, int D1>
 void ReadArray2d(fixed_t x[D0][D1],
@@ -33,11 +53,17 @@ void ReadArray2d(fixed_t x[D0][D1],
 #pragma HLS PIPELINE off
       axi_stream_data_t in_data = in_stream.read();
       float val = U32ToFloat(in_data.data.to_uint());
-      x[i][j] = static_cast<fixed_t>(val);
+      x[i][j] = MonitorRange(val);
     }
   }
 }
 
+constexpr KernelCost ReadArray2dCost(int d0, int d1)
+{
+  // Estimated cost of `ReadArray2d` (same as `ReadArray1d`)
+  return ReadArray1dCost(d0 * d1);
+}
+
 // Read the 3D array from the AXI4-Stream interface
 template <int D0, int D1, int D2>
 void ReadArray3d(fixed_t x[D0][D1][D2],
@@ -52,12 +78,18 @@ void ReadArray3d(fixed_t x[D0][D1][D2],
 #pragma HLS PIPELINE off
         axi_stream_data_t in_data = in_stream.read();
         float val = U32ToFloat(in_data.data.to_uint());
-        x[i][j][k] = static_cast<fixed_t>(val);
+        x[i][j][k] = MonitorRange(val);
       }
     }
   }
 }
 
+constexpr KernelCost ReadArray3dCost(int d0, int d1, int d2)
+{
+  // Estimated cost of `ReadArray3d` (same as `ReadArray1d`)
+  return ReadArray1dCost(d0 * d1 * d2);
+}
+
 // Read the 3D array from the AXI4-Stream interface
 template <int D0, int D1, int D2>
 void ReadArray3d2(fixed_t x[D0][D1][D2],
@@ -75,6 +107,113 @@ void ReadArray3d2(fixed_t x[D0][D1][D2],
   }
 }
 
+constexpr KernelCost ReadArray3d2Cost(int d0, int d1, int d2)
+{
+  // Estimated cost of `ReadArray3d2`
+  // The loops are pipelined (and flattened) automatically
+  return KernelCost {
+    PipelinedLoopCycles(static_cast<long long>(d0) * d1 * d2, 1,
+                        kStreamLatency + kConversionLatency + 1),
+    0, FixedBytes(static_cast<long long>(d0) * d1 * d2) };
+}
+
+// Read the 3D array of the raw pixels from the AXI4-Stream interface
+// The pixels are packed four per transfer (the first pixel in the lowest
+// byte), and are normalized as `pixel * scale + bias`
+template <int D0, int D1, int D2>
+void ReadPixelArray3d(fixed_t x[D0][D1][D2],
+                      const norm_param_t scale,
+                      const norm_param_t bias,
+                      hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  ap_uint<kAxiStreamWidth> pixels = 0;
+  int lane = 0;
+
+  for (int i = 0; i < D0; ++i) {
+    for (int j = 0; j < D1; ++j) {
+      for (int k = 0; k < D2; ++k) {
+#pragma HLS PIPELINE II=1
+        if (lane == 0)
+          pixels = in_stream.read().data;
+
+        const pixel_t pixel = pixels.range(pixel_t::width - 1, 0);
+        pixels >>= pixel_t::width;
+        lane = (lane == kPixelsPerBeat - 1) ? 0 : lane + 1;
+
+        x[i][j][k] = static_cast<fixed_t>(pixel * scale + bias);
+      }
+    }
+  }
+}
+
+constexpr KernelCost ReadPixelArray3dCost(int d0, int d1, int d2)
+{
+  // Estimated cost of `ReadPixelArray3d`
+  // One pixel is normalized per cycle in the pipelined loop
+  return KernelCost {
+    PipelinedLoopCycles(static_cast<long long>(d0) * d1 * d2, 1,
+                        kStreamLatency + kMacLatency + 1),
+    1, FixedBytes(static_cast<long long>(d0) * d1 * d2) };
+}
+
+// Read the 3D array of the run-length-encoded pixels from the AXI4-Stream
+// interface
+// The pairs are packed two per transfer (the first pair in the lower half),
+// and each frame starts at the new transfer; the pixels are normalized as
+// in `ReadPixelArray3d`
+// The pairs are expanded at one pixel per cycle regardless of the number of
+// zeros, so the latency is the same as `ReadPixelArray3d` and does not
+// stall the following layers in the dataflow region
+template <int D0, int D1, int D2>
+void ReadRlePixelArray3d(fixed_t x[D0][D1][D2],
+                         const norm_param_t scale,
+                         const norm_param_t bias,
+                         hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  ap_uint<kAxiStreamWidth> pairs = 0;
+  int lane = 0;
+  // Remaining zeros and the value of the current pair
+  rle_run_t run = 0;
+  pixel_t value = 0;
+  bool expanding = false;
+
+  for (int i = 0; i < D0; ++i) {
+    for (int j = 0; j < D1; ++j) {
+      for (int k = 0; k < D2; ++k) {
+#pragma HLS PIPELINE II=1
+        if (!expanding) {
+          if (lane == 0)
+            pairs = in_stream.read().data;
+
+          run = pairs.range(kRleRunWidth - 1, 0);
+          value = pairs.range(kRlePairWidth - 1, kRleRunWidth);
+          pairs >>= kRlePairWidth;
+          lane = (lane == kRlePairsPerBeat - 1) ? 0 : lane + 1;
+          expanding = true;
+        }
+
+        pixel_t pixel = 0;
+        if (run > 0) {
+          --run;
+        } else {
+          pixel = value;
+          expanding = false;
+        }
+
+        x[i][j][k] = static_cast<fixed_t>(pixel * scale + bias);
+      }
+    }
+  }
+}
+
+constexpr KernelCost ReadRlePixelArray3dCost(int d0, int d1, int d2)
+{
+  // Estimated cost of `ReadRlePixelArray3d` (same as `ReadPixelArray3d`)
+  return ReadPixelArray3dCost(d0, d1, d2);
+}
+
 // Read the 4D array from the AXI4-Stream interface
 template <int D0, int D1, int D2, int D3>
 void ReadArray4d(fixed_t x[D0][D1][D2][D3],
@@ -98,6 +237,18 @@ void ReadArray4d(fixed_t x[D0][D1][D2][D3],
   }
 }
 
+constexpr KernelCost ReadArray4dCost(int d0, int d1, int d2, int d3)
+{
+  // Estimated cost of `ReadArray4d` (same as `ReadArray1d`)
+  return ReadArray1dCost(d0 * d1 * d2 * d3);
+}
+
+struct ReadArrayPorts
+{
+  // Number of elements written per cycle by `ReadArray*`
+  static constexpr int kOutput = 1;
+};
+
 // Read the parameters for the 2D convolutional layer
 template <int InCh, int OutCh, int K>
 void ReadConv2dParams(fixed_t weight[OutCh][InCh][K][K],
@@ -131,6 +282,415 @@ void ReadLinearParams(fixed_t weight[OutDims][InDims],
   ReadArray1d<OutDims>(bias, in_stream);
 }
 
+// Read the parameters for the 2D depthwise convolutional layer
+template <int C, int K>
+void ReadDepthwiseConv2dParams(fixed_t weight[C][K][K],
+                               hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  ReadArray3d<C, K, K>(weight, in_stream);
+}
+
+// Read the parameters for the 2D pointwise convolutional layer
+template <int InCh, int OutCh>
+void ReadPointwiseConv2dParams(fixed_t weight[OutCh][InCh],
+                               hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  ReadArray2d<OutCh, InCh>(weight, in_stream);
+}
+
+// Read the normalization constants of the raw pixels
+inline void ReadNormParams(norm_param_t& scale,
+                           norm_param_t& bias,
+                           hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  axi_stream_data_t in_data = in_stream.read();
+  scale = static_cast<norm_param_t>(U32ToFloat(in_data.data.to_uint()));
+  in_data = in_stream.read();
+  bias = static_cast<norm_param_t>(U32ToFloat(in_data.data.to_uint()));
+}
+
+// Read the parameters for the fully-connected layer
+// The weight is packed into the words, each of which holds `B` consecutive
+// weights in a row (as in `ReadPackedLinearParams`), and is written to the
+// external memory (DDR) through the AXI4 master interface, and the bias is
+// kept on chip
+template <int InDims, int OutDims, int B>
+void ReadPackedLinearParamsToDdr(packed_t<B>* weight,
+                                 fixed_t bias[OutDims],
+                                 hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < OutDims * InDims / B; ++i) {
+#pragma HLS PIPELINE off
+    packed_t<B> word;
+
+    for (int j = 0; j < B; ++j) {
+#pragma HLS PIPELINE II=1
+      axi_stream_data_t in_data = in_stream.read();
+      float val = U32ToFloat(in_data.data.to_uint());
+      PackValue<B>(word, j, static_cast<fixed_t>(val));
+    }
+
+    weight[i] = word;
+  }
+
+  ReadArray1d<OutDims>(bias, in_stream);
+}
+
+// Read the parameters for the 2D convolutional layer into the packed
+// words, each of which holds the weights of `B` consecutive output channels
+template <int InCh, int OutCh, int K, int B>
+void ReadPackedConv2dParams(packed_t<B> weight[OutCh / B][InCh][K][K],
+                            hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int oc = 0; oc < OutCh; ++oc) {
+#pragma HLS PIPELINE off
+    for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+      for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+        for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE off
+          axi_stream_data_t in_data = in_stream.read();
+          float val = U32ToFloat(in_data.data.to_uint());
+          packed_t<B> word = weight[oc / B][ic][kh][kw];
+          PackValue<B>(word, oc % B, static_cast<fixed_t>(val));
+          weight[oc / B][ic][kh][kw] = word;
+        }
+      }
+    }
+  }
+}
+
+// Read the parameters for the fully-connected layer
+// The weights are packed into the words, each of which holds `B`
+// consecutive weights in a row
+template <int InDims, int OutDims, int B>
+void ReadPackedLinearParams(packed_t<B> weight[OutDims][InDims / B],
+                            fixed_t bias[OutDims],
+                            hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < OutDims; ++i) {
+#pragma HLS PIPELINE off
+    for (int j0 = 0; j0 < InDims; j0 += B) {
+#pragma HLS PIPELINE off
+      packed_t<B> word;
+
+      for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS PIPELINE off
+        axi_stream_data_t in_data = in_stream.read();
+        float val = U32ToFloat(in_data.data.to_uint());
+        PackValue<B>(word, j1, static_cast<fixed_t>(val));
+      }
+
+      weight[i][j0 / B] = word;
+    }
+  }
+
+  ReadArray1d<OutDims>(bias, in_stream);
+}
+
+// Read the parameters for the 2D convolutional layer, and convert the
+// weights to the log-quantized format (see `FloatToLogWeight`)
+template <int InCh, int OutCh, int K>
+void ReadLogConv2dParams(log_weight_t weight[OutCh][InCh][K][K],
+                         hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int oc = 0; oc < OutCh; ++oc) {
+#pragma HLS PIPELINE off
+    for (int ic = 0; ic < InCh; ++ic) {
+#pragma HLS PIPELINE off
+      for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+        for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE off
+          axi_stream_data_t in_data = in_stream.read();
+          float val = U32ToFloat(in_data.data.to_uint());
+          weight[oc][ic][kh][kw] = FloatToLogWeight(val);
+        }
+      }
+    }
+  }
+}
+
+// Read the parameters for the fully-connected layer, and convert the
+// weights to the log-quantized format (the bias is kept in `fixed_t`)
+template <int InDims, int OutDims>
+void ReadLogLinearParams(log_weight_t weight[OutDims][InDims],
+                         fixed_t bias[OutDims],
+                         hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < OutDims; ++i) {
+#pragma HLS PIPELINE off
+    for (int j = 0; j < InDims; ++j) {
+#pragma HLS PIPELINE off
+      axi_stream_data_t in_data = in_stream.read();
+      float val = U32ToFloat(in_data.data.to_uint());
+      weight[i][j] = FloatToLogWeight(val);
+    }
+  }
+
+  ReadArray1d<OutDims>(bias, in_stream);
+}
+
+// Read the 1D array from the AXI4-Stream interface into `N` replicas
+template <int N, int D0>
+void ReadReplicatedArray1d(fixed_t x[N][D0],
+                           hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < D0; ++i) {
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    float val = U32ToFloat(in_data.data.to_uint());
+    for (int n = 0; n < N; ++n)
+#pragma HLS UNROLL
+      x[n][i] = static_cast<fixed_t>(val);
+  }
+}
+
+// Read the 2D array from the AXI4-Stream interface into `N` replicas
+template <int N, int D0, int D1>
+void ReadReplicatedArray2d(fixed_t x[N][D0][D1],
+                           hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < D0; ++i) {
+#pragma HLS PIPELINE off
+    for (int j = 0; j < D1; ++j) {
+#pragma HLS PIPELINE off
+      axi_stream_data_t in_data = in_stream.read();
+      float val = U32ToFloat(in_data.data.to_uint());
+      for (int n = 0; n < N; ++n)
+#pragma HLS UNROLL
+        x[n][i][j] = static_cast<fixed_t>(val);
+    }
+  }
+}
+
+// Read the 4D array from the AXI4-Stream interface into `N` replicas
+template <int N, int D0, int D1, int D2, int D3>
+void ReadReplicatedArray4d(fixed_t x[N][D0][D1][D2][D3],
+                           hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < D0; ++i) {
+#pragma HLS PIPELINE off
+    for (int j = 0; j < D1; ++j) {
+#pragma HLS PIPELINE off
+      for (int k = 0; k < D2; ++k) {
+#pragma HLS PIPELINE off
+        for (int l = 0; l < D3; ++l) {
+#pragma HLS PIPELINE off
+          axi_stream_data_t in_data = in_stream.read();
+          float val = U32ToFloat(in_data.data.to_uint());
+          for (int n = 0; n < N; ++n)
+#pragma HLS UNROLL
+            x[n][i][j][k][l] = static_cast<fixed_t>(val);
+        }
+      }
+    }
+  }
+}
+
+// Read the parameters for the 2D convolutional layer into `N` replicas
+template <int N, int InCh, int OutCh, int K>
+void ReadReplicatedConv2dParams(fixed_t weight[N][OutCh][InCh][K][K],
+                                hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  ReadReplicatedArray4d<N, OutCh, InCh, K, K>(weight, in_stream);
+}
+
+// Read the parameters for the 2D batch normalization layer into `N` replicas
+template <int N, int C>
+void ReadReplicatedBatchNorm2dParams(
+  fixed_t scale[N][C],
+  fixed_t bias[N][C],
+  fixed_t mean[N][C],
+  hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  ReadReplicatedArray1d<N, C>(scale, in_stream);
+  ReadReplicatedArray1d<N, C>(bias, in_stream);
+  ReadReplicatedArray1d<N, C>(mean, in_stream);
+}
+
+// Read the parameters for the fully-connected layer into `N` replicas
+template <int N, int InDims, int OutDims>
+void ReadReplicatedLinearParams(fixed_t weight[N][OutDims][InDims],
+                                fixed_t bias[N][OutDims],
+                                hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  ReadReplicatedArray2d<N, OutDims, InDims>(weight, in_stream);
+  ReadReplicatedArray1d<N, OutDims>(bias, in_stream);
+}
+
+// Read the parameters for the 2D convolutional layer into the shared
+// weight memory, starting from the column `col_offset`
+// Each output channel has `cols` (`InCh` * `K` * `K`) parameters
+template <int MaxOutCh, int MaxCols>
+void ReadDynamicConv2dParams(fixed_t weight[MaxOutCh][MaxCols],
+                             const int col_offset,
+                             const int out_ch,
+                             const int cols,
+                             hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < out_ch; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutCh
+#pragma HLS PIPELINE off
+    for (int j = 0; j < cols; ++j) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxCols
+#pragma HLS PIPELINE off
+      axi_stream_data_t in_data = in_stream.read();
+      float val = U32ToFloat(in_data.data.to_uint());
+      weight[i][col_offset + j] = static_cast<fixed_t>(val);
+    }
+  }
+}
+
+// Read the parameters for the `layer`-th 2D batch normalization layer
+// into the shared parameter memory
+template <int MaxLayers, int MaxC>
+void ReadDynamicBatchNorm2dParams(fixed_t scale[MaxLayers][MaxC],
+                                  fixed_t bias[MaxLayers][MaxC],
+                                  fixed_t mean[MaxLayers][MaxC],
+                                  const int layer,
+                                  const int c,
+                                  hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < c; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    scale[layer][i] = static_cast<fixed_t>(
+      U32ToFloat(in_data.data.to_uint()));
+  }
+  for (int i = 0; i < c; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    bias[layer][i] = static_cast<fixed_t>(
+      U32ToFloat(in_data.data.to_uint()));
+  }
+  for (int i = 0; i < c; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    mean[layer][i] = static_cast<fixed_t>(
+      U32ToFloat(in_data.data.to_uint()));
+  }
+}
+
+// Read the parameters for the fully-connected layer into the shared
+// weight and bias memory
+// Each row of the weight is zero-padded from `in_dims` to `in_stride`
+template <int MaxWeightSize, int MaxBiasSize, int MaxInDims>
+void ReadDynamicLinearParams(fixed_t weight[MaxWeightSize],
+                             fixed_t bias[MaxBiasSize],
+                             const int weight_offset,
+                             const int bias_offset,
+                             const int in_dims,
+                             const int in_stride,
+                             const int out_dims,
+                             hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < out_dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxBiasSize
+#pragma HLS PIPELINE off
+    for (int j = 0; j < in_stride; ++j) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxInDims
+#pragma HLS PIPELINE off
+      fixed_t val = 0;
+      if (j < in_dims) {
+        axi_stream_data_t in_data = in_stream.read();
+        val = static_cast<fixed_t>(U32ToFloat(in_data.data.to_uint()));
+      }
+      weight[weight_offset + i * in_stride + j] = val;
+    }
+  }
+  for (int i = 0; i < out_dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxBiasSize
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    bias[bias_offset + i] = static_cast<fixed_t>(
+      U32ToFloat(in_data.data.to_uint()));
+  }
+}
+
+// Read the parameters for the fully-connected layer into the weight and
+// bias memory of the overlay
+// The weight memory holds `B` elements per row (see `LinearOverlay`), and
+// each row of the weight is zero-padded from `in_dims` to `in_stride`
+template <int MaxWeightSize, int MaxBiasSize, int MaxInDims, int B>
+void ReadOverlayLinearParams(fixed_t weight[MaxWeightSize / B][B],
+                             fixed_t bias[MaxBiasSize],
+                             const int weight_offset,
+                             const int bias_offset,
+                             const int in_dims,
+                             const int in_stride,
+                             const int out_dims,
+                             hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < out_dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxBiasSize
+#pragma HLS PIPELINE off
+    for (int j = 0; j < in_stride; ++j) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxInDims
+#pragma HLS PIPELINE off
+      fixed_t val = 0;
+      if (j < in_dims) {
+        axi_stream_data_t in_data = in_stream.read();
+        val = static_cast<fixed_t>(U32ToFloat(in_data.data.to_uint()));
+      }
+      const int e = weight_offset + i * in_stride + j;
+      weight[e / B][e % B] = val;
+    }
+  }
+  for (int i = 0; i < out_dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxBiasSize
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    bias[bias_offset + i] = static_cast<fixed_t>(
+      U32ToFloat(in_data.data.to_uint()));
+  }
+}
+
+// Read the 2D array of size (`c`, `size`) from the AXI4-Stream interface
+// into the shared memory, starting from the column `offset`
+template <int MaxC, int MaxSize>
+void ReadDynamicArray2d(fixed_t x[MaxC][MaxSize],
+                        const int offset,
+                        const int c,
+                        const int size,
+                        hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < c; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+    for (int j = 0; j < size; ++j) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE off
+      axi_stream_data_t in_data = in_stream.read();
+      float val = U32ToFloat(in_data.data.to_uint());
+      x[i][offset + j] = static_cast<fixed_t>(val);
+    }
+  }
+}
+
 // Write the 1D array to the AXI4-Stream interface
 template <int D0>
 void WriteArray1d(const fixed_t x[D0],
@@ -151,6 +711,16 @@ void WriteArray1d(const fixed_t x[D0],
   }
 }
 
+constexpr KernelCost WriteArray1dCost(int d0)
+{
+  // Estimated cost of `WriteArray1d`
+  // Each element is converted and written sequentially
+  return KernelCost {
+    SequentialLoopCycles(d0,
+                         kMemoryLatency + kConversionLatency + kStreamLatency),
+    0, 0 };
+}
+
 // Write the 1D array to the AXI4-Stream interface
 template <int D0>
 void WriteArray1d2(const fixed_t x[D0],
@@ -170,6 +740,16 @@ void WriteArray1d2(const fixed_t x[D0],
   }
 }
 
+constexpr KernelCost WriteArray1d2Cost(int d0)
+{
+  // Estimated cost of `WriteArray1d2`
+  // The loop is pipelined automatically
+  return KernelCost {
+    PipelinedLoopCycles(d0, 1,
+                        kMemoryLatency + kConversionLatency + kStreamLatency),
+    0, 0 };
+}
+
 // Write the 2D array to the AXI4-Stream interface
 template <int D0, int D1>
 void WriteArray2d(const fixed_t x[D0][D1],
@@ -193,6 +773,12 @@ void WriteArray2d(const fixed_t x[D0][D1],
   }
 }
 
+constexpr KernelCost WriteArray2dCost(int d0, int d1)
+{
+  // Estimated cost of `WriteArray2d` (same as `WriteArray1d`)
+  return WriteArray1dCost(d0 * d1);
+}
+
 // Write the 3D array to the AXI4-Stream interface
 template <int D0, int D1, int D2>
 void WriteArray3d(const fixed_t x[D0][D1][D2],
@@ -219,8 +805,46 @@ void WriteArray3d(const fixed_t x[D0][D1][D2],
   }
 }
 
+constexpr KernelCost WriteArray3dCost(int d0, int d1, int d2)
+{
+  // Estimated cost of `WriteArray3d` (same as `WriteArray1d`)
+  return WriteArray1dCost(d0 * d1 * d2);
+}
+
+// Write the vector of size (`dims`) in the vector memory of the overlay,
+// which holds `B` elements per row (see `LinearOverlay`), to the
+// AXI4-Stream interface, starting from the element `offset`
+template <int MaxSize, int B>
+void WriteOverlayVector(const fixed_t x[MaxSize / B][B],
+                        const int offset,
+                        const int dims,
+                        hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INLINE off
+  axi_stream_data_t out_data;
+  out_data.keep = 0xF;
+  out_data.strb = 0xF;
+
+  for (int i = 0; i < dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE off
+    // Set all bits in `keep` and `strb` fields to 1
+    const int e = offset + i;
+    float val = static_cast<float>(x[e / B][e % B]);
+    out_data.data = FloatToU32(val);
+    out_data.last = (i == dims - 1);
+    out_stream.write(out_data);
+  }
+}
+
+struct WriteArrayPorts
+{
+  // Number of elements read per cycle by `WriteArray*`
+  static constexpr int kInput = 1;
+};
+
 // Write the acknowledgment message to the AXI4-Stream interface
-void WriteAck(hls::stream<axi_stream_data_t>& out_stream)
+inline void WriteAck(hls::stream<axi_stream_data_t>& out_stream)
 {
 #pragma HLS INLINE off
   // Set all bits in `keep` and `strb` fields to 1
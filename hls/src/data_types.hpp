@@ -20,8 +20,28 @@ using axi_stream_data_t = ap_axiu<kAxiStreamWidth, 0, 0, 0>;
 using fixed_t = ap_fixed<kBitWidth, kIntegerBitWidth,
                          ap_q_mode::AP_TRN, ap_o_mode::AP_SAT, 0>;
 
+// Raw input pixels (e.g., MNIST images), packed into the AXI4-Stream data
+using pixel_t = ap_uint<8>;
+// Number of pixels per AXI4-Stream transfer
+constexpr int kPixelsPerBeat = kAxiStreamWidth / pixel_t::width;
+
+// Run-length-encoded pixels, where each pair holds the number of zeros
+// (lower bits) followed by the pixel value (upper bits)
+constexpr int kRleRunWidth = 8;
+using rle_run_t = ap_uint<kRleRunWidth>;
+constexpr int kRlePairWidth = kRleRunWidth + pixel_t::width;
+// Number of pairs per AXI4-Stream transfer
+constexpr int kRlePairsPerBeat = kAxiStreamWidth / kRlePairWidth;
+
+// Normalization constants applied to the raw pixels on chip
+// The constants are wider than `fixed_t`, because the scale (inverse of the
+// standard deviation divided by 255) is tiny and is multiplied by up to 255
+using norm_param_t = ap_fixed<32, 8, ap_q_mode::AP_RND, ap_o_mode::AP_SAT>;
+
 // Operation modes
 constexpr int kModeInitWeights = 1;
 constexpr int kModeInference = 2;
+// Inference followed by the cycle counters (`InferenceProfile` only)
+constexpr int kModeProfile = 3;
 
 #endif // TOYNET_DATA_TYPES_HPP
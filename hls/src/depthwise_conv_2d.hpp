@@ -4,6 +4,7 @@
 #ifndef TOYNET_DEPTHWISE_CONV_2D_HPP
 #define TOYNET_DEPTHWISE_CONV_2D_HPP
 
+#include "cost_model.hpp"
 #include "data_types.hpp"
 
 template <int C, int H, int W, int OH, int OW,
@@ -46,6 +47,19 @@ void DepthwiseConv2d(const fixed_t x[C][H][W],
   }
 }
 
+constexpr KernelCost DepthwiseConv2dCost(int c, int /* h */, int /* w */,
+                                         int oh, int ow, int k,
+                                         int /* p */, int /* s */)
+{
+  // Estimated cost of `DepthwiseConv2d`
+  // The loops over the kernel are pipelined (and flattened) automatically
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c) * oh * ow,
+      PipelinedLoopCycles(k * k, 1, kMemoryLatency + kMacLatency) + 1),
+    1, FixedBytes(c * oh * ow) };
+}
+
 template <int C, int H, int W, int OH, int OW,
           int K, int P, int S, int B>
 void DepthwiseConv2d2(const fixed_t x[C][H][W],
@@ -100,4 +114,108 @@ void DepthwiseConv2d2(const fixed_t x[C][H][W],
   }
 }
 
+template <int B>
+struct DepthwiseConv2d2Ports
+{
+  // Number of elements accessed per cycle by `DepthwiseConv2d2`
+  // `x`, `y`, and `weight` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost DepthwiseConv2d2Cost(int c, int /* h */, int /* w */,
+                                          int oh, int ow, int k,
+                                          int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `DepthwiseConv2d2`
+  // The loops over the kernel are pipelined (and flattened) automatically,
+  // and `B` products are computed in parallel
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c / b) * oh * ow,
+      PipelinedLoopCycles(k * k, 1, kMemoryLatency + kMacLatency) + 1),
+    b, FixedBytes(c * oh * ow) };
+}
+
+template <int C, int H, int W, int OH, int OW,
+          int K, int P, int S, int B>
+void DepthwiseConv2d3(const fixed_t x[C][H][W],
+                      fixed_t y[C][OH][OW],
+                      const fixed_t weight[C][K][K])
+{
+  // Parallel implementation of the depthwise convolution
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`, `OH`, `OW`)
+  // `weight` is of size (`C`, `K`, `K`)
+
+#pragma HLS INLINE off
+
+  static_assert(C % B == 0,
+                "`C` must be a multiple of `B`");
+  static_assert(K % 2 == 1, "`K` must be an odd number");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  for (int c0 = 0; c0 < C; c0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+            int ih = oh * S + kh - P;
+            int iw = ow * S + kw - P;
+
+            for (int c1 = 0; c1 < B; ++c1) {
+// #pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+              int c = c0 + c1;
+              fixed_t v0 = (kh == 0 && kw == 0) ? fixed_t(0) : vals[c1];
+              if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+                vals[c1] = v0 + x[c][ih][iw] * weight[c][kh][kw];
+              else
+                vals[c1] = v0;
+            }
+          }
+        }
+
+        for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int c = c0 + c1;
+          y[c][oh][ow] = vals[c1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct DepthwiseConv2d3Ports
+{
+  // Number of elements accessed per cycle by `DepthwiseConv2d3`
+  // `x`, `y`, and `weight` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost DepthwiseConv2d3Cost(int c, int h, int w,
+                                          int oh, int ow, int k,
+                                          int p, int s, int b)
+{
+  // Estimated cost of `DepthwiseConv2d3`
+  // Same loop structure as `DepthwiseConv2d2` with the explicit pragmas
+  return DepthwiseConv2d2Cost(c, h, w, oh, ow, k, p, s, b);
+}
+
 #endif // TOYNET_DEPTHWISE_CONV_2D_HPP
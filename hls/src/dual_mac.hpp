@@ -0,0 +1,107 @@
+// dual_mac.hpp
+
+#ifndef TOYNET_DUAL_MAC_HPP
+#define TOYNET_DUAL_MAC_HPP
+
+#include "data_types.hpp"
+
+// Two multiplications sharing one operand are computed by a single DSP48E2
+// multiplier (27x18 bits) when the bit width is small enough
+// The two weights are packed into the 27-bit input as
+// `w_hi` * 2^`kDualMacShift` + `w_lo`, multiplied by the activation in the
+// 18-bit input, and the two products are separated from the result
+
+// Widths of the DSP48E2 multiplier inputs
+constexpr int kDspWidthA = 27;
+constexpr int kDspWidthB = 18;
+
+// Each product occupies `2 * kBitWidth` bits
+constexpr int kDualMacShift = 2 * kBitWidth;
+
+// Width of the packed weights (one extra bit is required, since adding the
+// negative `w_lo` to the minimum `w_hi` * 2^`kDualMacShift` borrows a bit)
+constexpr int kDualMacWeightWidth = kDualMacShift + kBitWidth + 1;
+
+// Two multiplications are packed if the weights fit in the 27-bit input
+// and the activation fits in the 18-bit input (up to 8-bit values)
+constexpr bool kDualMacEnabled =
+  kDualMacWeightWidth <= kDspWidthA && kBitWidth <= kDspWidthB;
+
+// Exact product of two `fixed_t` values (same as the type of `x * w`)
+using product_t = ap_fixed<2 * kBitWidth, 2 * kIntegerBitWidth>;
+
+// Compute `a` * `w_hi` and `a` * `w_lo` of `Width`-bit values
+// The packed implementation is selected at compile time, so that it is only
+// instantiated when the two multiplications fit in a single DSP
+template <int Width, bool Enabled>
+struct DualMultiplier
+{
+  static void Multiply(const fixed_t a,
+                       const fixed_t w_hi,
+                       const fixed_t w_lo,
+                       product_t& p_hi,
+                       product_t& p_lo)
+  {
+#pragma HLS INLINE
+    // Two separate multiplications
+    p_hi = a * w_hi;
+    p_lo = a * w_lo;
+  }
+};
+
+template <int Width>
+struct DualMultiplier<Width, true>
+{
+  static constexpr int kShift = 2 * Width;
+  static constexpr int kWeightWidth = kShift + Width + 1;
+
+  static void Multiply(const fixed_t a,
+                       const fixed_t w_hi,
+                       const fixed_t w_lo,
+                       product_t& p_hi,
+                       product_t& p_lo)
+  {
+#pragma HLS INLINE
+    using packed_weight_t = ap_int<kWeightWidth>;
+    using packed_product_t = ap_int<kWeightWidth + Width>;
+    using raw_product_t = ap_int<2 * Width>;
+
+    // Raw integer representations
+    ap_int<Width> a_raw = a.range(Width - 1, 0);
+    ap_int<Width> w_hi_raw = w_hi.range(Width - 1, 0);
+    ap_int<Width> w_lo_raw = w_lo.range(Width - 1, 0);
+
+    // `w_lo_raw` is sign-extended, so that the packed weight is
+    // `w_hi_raw` * 2^`kShift` + `w_lo_raw`
+    packed_weight_t w_packed = packed_weight_t(w_hi_raw) << kShift;
+    w_packed += w_lo_raw;
+
+    // Single wide multiplication
+    packed_product_t p = a_raw * w_packed;
+
+    // The lower product is sign-extended from the lower bits, and the upper
+    // product is corrected by the borrow when the lower product is negative
+    raw_product_t p_lo_raw = p.range(kShift - 1, 0);
+    raw_product_t p_hi_raw = p >> kShift;
+    if (p_lo_raw < 0)
+      p_hi_raw += 1;
+
+    p_hi.range(2 * Width - 1, 0) = p_hi_raw.range(2 * Width - 1, 0);
+    p_lo.range(2 * Width - 1, 0) = p_lo_raw.range(2 * Width - 1, 0);
+  }
+};
+
+// Compute `a` * `w_hi` and `a` * `w_lo` with a single multiplication
+// The results are the same as the two separate multiplications
+inline void DualMultiply(const fixed_t a,
+                         const fixed_t w_hi,
+                         const fixed_t w_lo,
+                         product_t& p_hi,
+                         product_t& p_lo)
+{
+#pragma HLS INLINE
+  DualMultiplier<kBitWidth, kDualMacEnabled>::Multiply(
+    a, w_hi, w_lo, p_hi, p_lo);
+}
+
+#endif // TOYNET_DUAL_MAC_HPP
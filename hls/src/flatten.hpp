@@ -4,7 +4,9 @@
 #ifndef TOYNET_FLATTEN_HPP
 #define TOYNET_FLATTEN_HPP
 
+#include "cost_model.hpp"
 #include "data_types.hpp"
+#include "loop_trips.hpp"
 
 template <int C, int H, int W>
 void Flatten3d(const fixed_t x[C][H][W],
@@ -28,6 +30,31 @@ void Flatten3d(const fixed_t x[C][H][W],
   }
 }
 
+struct Flatten3dPorts
+{
+  // Number of elements accessed per cycle by `Flatten3d`
+  static constexpr int kInput = 1;
+  static constexpr int kOutput = 1;
+};
+
+constexpr LoopTrips Flatten3dTrips(int c, int h, int w)
+{
+  // Loop trip counts of `Flatten3d`
+  // There is no pipelined loop, and each element is copied in its own
+  // iteration
+  return LoopTrips { static_cast<long long>(c) * h * w, 0, 1 };
+}
+
+constexpr KernelCost Flatten3dCost(int c, int h, int w)
+{
+  // Estimated cost of `Flatten3d`
+  // Each element is copied sequentially
+  const LoopTrips trips = Flatten3dTrips(c, h, w);
+  return KernelCost {
+    SequentialLoopCycles(trips.outer, kMemoryLatency + trips.tail),
+    0, FixedBytes(c * h * w) };
+}
+
 template <int C, int H, int W>
 void Flatten3d2(const fixed_t x[C][H][W],
                 fixed_t y[C * H * W])
@@ -45,4 +72,79 @@ void Flatten3d2(const fixed_t x[C][H][W],
   }
 }
 
+constexpr KernelCost Flatten3d2Cost(int c, int h, int w)
+{
+  // Estimated cost of `Flatten3d2`
+  // The loops are pipelined (and flattened) automatically
+  return KernelCost {
+    PipelinedLoopCycles(static_cast<long long>(c) * h * w, 1,
+                        kMemoryLatency + 1),
+    0, FixedBytes(c * h * w) };
+}
+
+template <int MaxC, int MaxHW, int MaxDims>
+void Flatten2dDynamic(const fixed_t x[MaxC][MaxHW],
+                      fixed_t y[MaxDims],
+                      const int c,
+                      const int hw)
+{
+  // Flatten layer with runtime shapes
+  // `x` is of size (`c`, `hw`)
+  // `y` is of size (`c` * `hw`)
+
+#pragma HLS INLINE off
+
+  for (int ch = 0; ch < c; ++ch) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+    for (int i = 0; i < hw; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxHW
+#pragma HLS PIPELINE II=1
+      y[ch * hw + i] = x[ch][i];
+    }
+  }
+}
+
+struct Flatten2dDynamicPorts
+{
+  // Number of elements accessed per cycle by `Flatten2dDynamic`
+  static constexpr int kInput = 1;
+  static constexpr int kOutput = 1;
+};
+
+template <int MaxC, int MaxSize, int MaxVecSize, int B>
+void Flatten2dOverlay(const fixed_t fmap[MaxC][MaxSize],
+                      fixed_t vec[MaxVecSize / B][B],
+                      const int src,
+                      const int dst,
+                      const int c,
+                      const int hw)
+{
+  // Flatten layer with runtime shapes for the programmable layer engine
+  // `x` is of size (`c`, `hw`) and starts from the column `src` of the
+  // feature map memory
+  // `y` is of size (`c` * `hw`) and starts from the element `dst` of the
+  // vector memory, which holds `B` elements per row (see `LinearOverlay`)
+
+#pragma HLS INLINE off
+
+  for (int ch = 0; ch < c; ++ch) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxC
+#pragma HLS PIPELINE off
+    for (int i = 0; i < hw; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE II=1
+      const int e = dst + ch * hw + i;
+      vec[e / B][e % B] = fmap[ch][src + i];
+    }
+  }
+}
+
+struct Flatten2dOverlayPorts
+{
+  // Number of elements accessed per cycle by `Flatten2dOverlay`
+  static constexpr int kInput = 1;
+  static constexpr int kOutput = 1;
+};
+
 #endif // TOYNET_FLATTEN_HPP
@@ -4,7 +4,13 @@
 #ifndef TOYNET_LINEAR_HPP
 #define TOYNET_LINEAR_HPP
 
+#include "cost_model.hpp"
+#include "data_packing.hpp"
 #include "data_types.hpp"
+#include "dual_mac.hpp"
+#include "log_quantization.hpp"
+#include "loop_trips.hpp"
+#include "range_monitor.hpp"
 
 template <int InDims, int OutDims, bool ApplyReLU>
 void Linear(const fixed_t x[InDims],
@@ -37,6 +43,19 @@ void Linear(const fixed_t x[InDims],
   }
 }
 
+constexpr KernelCost LinearCost(int in_dims, int out_dims,
+                                bool /* apply_relu */)
+{
+  // Estimated cost of `Linear`
+  // Each product is computed sequentially, followed by the bias and ReLU
+  return KernelCost {
+    SequentialLoopCycles(
+      out_dims,
+      SequentialLoopCycles(in_dims, kMemoryLatency + kMacLatency)
+      + kAddLatency + 1),
+    1, FixedBytes(out_dims) };
+}
+
 template <int InDims, int OutDims, bool ApplyReLU, int B>
 void Linear2(const fixed_t x[InDims],
              const fixed_t weight[OutDims][InDims],
@@ -88,6 +107,31 @@ void Linear2(const fixed_t x[InDims],
   }
 }
 
+template <int B>
+struct Linear2Ports
+{
+  // Number of elements accessed per cycle by `Linear2`
+  // `x` is read along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  // `weight` is read along the second dimension
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost Linear2Cost(int in_dims, int out_dims,
+                                 bool /* apply_relu */, int b)
+{
+  // Estimated cost of `Linear2`
+  // `B` products are computed in parallel without pipelining, and are
+  // added up at the end of each output element
+  return KernelCost {
+    SequentialLoopCycles(
+      out_dims,
+      SequentialLoopCycles(in_dims / b, kMemoryLatency + kMacLatency)
+      + (AdderTreeDepth(b) + 1) * kAddLatency + 1),
+    b, FixedBytes(out_dims) };
+}
+
 template <int InDims, int OutDims, bool ApplyReLU, int B>
 void Linear3(const fixed_t x[InDims],
              const fixed_t weight[OutDims][InDims],
@@ -119,9 +163,433 @@ void Linear3(const fixed_t x[InDims],
 #pragma HLS UNROLL
         int j = j0 + j1;
         if (j0 == 0)
-          vals[j1] = x[j] * weight[i][j];
+          vals[j1] = MonitorRange(x[j] * weight[i][j]);
         else
-          vals[j1] += x[j] * weight[i][j];
+          vals[j1] = MonitorRange(vals[j1] + x[j] * weight[i][j]);
+      }
+    }
+
+    for (int j1 = 0; j1 < B; ++j1)
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+      val = MonitorRange(val + vals[j1]);
+
+    val = MonitorRange(val + bias[i]);
+
+    if (ApplyReLU)
+      y[i] = val > fixed_t(0) ? val : fixed_t(0);
+    else
+      y[i] = val;
+  }
+}
+
+template <int B>
+struct Linear3Ports
+{
+  // Number of elements accessed per cycle by `Linear3`
+  // `x` is read along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  // `weight` is read along the second dimension
+  static constexpr int kWeight = B;
+};
+
+constexpr LoopTrips Linear3Trips(int in_dims, int out_dims,
+                                 bool /* apply_relu */, int b)
+{
+  // Loop trip counts of `Linear3`
+  // The products over the inputs are pipelined, and the `B` partial sums
+  // are added up after them
+  return LoopTrips { out_dims, in_dims / b, 1 };
+}
+
+constexpr KernelCost Linear3Cost(int in_dims, int out_dims,
+                                 bool apply_relu, int b)
+{
+  // Estimated cost of `Linear3`
+  // `B` products are computed in parallel in the pipelined loop
+  const LoopTrips trips = Linear3Trips(in_dims, out_dims, apply_relu, b);
+  return KernelCost {
+    SequentialLoopCycles(
+      trips.outer,
+      PipelinedLoopCycles(trips.inner, 1, kMemoryLatency + kMacLatency)
+      + (AdderTreeDepth(b) + 1) * kAddLatency + trips.tail),
+    b, FixedBytes(out_dims) };
+}
+
+template <int MaxInDims, int MaxOutDims,
+          int MaxWeightSize, int MaxBiasSize, int B>
+void LinearDynamic(const fixed_t x[MaxInDims],
+                   const fixed_t weight[MaxWeightSize],
+                   const fixed_t bias[MaxBiasSize],
+                   fixed_t y[MaxOutDims],
+                   const int weight_offset,
+                   const int bias_offset,
+                   const int in_stride,
+                   const int out_dims,
+                   const bool apply_relu)
+{
+  // Parallel implementation of the fully-connected layer with runtime shapes
+  // Used as a single engine shared by all fully-connected layers
+  // Innermost loop is parallelized by a factor of `B`
+  // `x` is of size (1, `in_stride`)
+  // `weight` is of size (`out_dims`, `in_stride`), starts from the element
+  // `weight_offset`, and each row is zero-padded to `in_stride`
+  // `bias` is of size (`out_dims`) and starts from the element `bias_offset`
+  // `y` is of size (1, `out_dims`)
+  // `in_stride` and `weight_offset` must be multiples of `B`
+
+#pragma HLS INLINE off
+
+  static_assert(MaxInDims % B == 0,
+                "`MaxInDims` must be a multiple of `B`");
+
+  constexpr int kMaxIters = MaxInDims / B;
+
+  for (int i = 0; i < out_dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutDims
+#pragma HLS PIPELINE off
+    fixed_t val = 0;
+    fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+    const int row_offset = weight_offset + i * in_stride;
+
+    for (int j0 = 0; j0 < in_stride; j0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxIters
+#pragma HLS PIPELINE II=1
+      for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS UNROLL
+        int j = j0 + j1;
+        if (j0 == 0)
+          vals[j1] = x[j] * weight[row_offset + j];
+        else
+          vals[j1] += x[j] * weight[row_offset + j];
+      }
+    }
+
+    for (int j1 = 0; j1 < B; ++j1)
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+      val += vals[j1];
+
+    val += bias[bias_offset + i];
+
+    if (apply_relu)
+      y[i] = val > fixed_t(0) ? val : fixed_t(0);
+    else
+      y[i] = val;
+  }
+}
+
+template <int B>
+struct LinearDynamicPorts
+{
+  // Number of elements accessed per cycle by `LinearDynamic`
+  // `x` and `weight` are read along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  static constexpr int kWeight = B;
+};
+
+template <int MaxVecSize, int MaxInDims, int MaxOutDims,
+          int MaxWeightSize, int MaxBiasSize, int B>
+void LinearOverlay(fixed_t vec[MaxVecSize / B][B],
+                   const fixed_t weight[MaxWeightSize / B][B],
+                   const fixed_t bias[MaxBiasSize],
+                   const int src,
+                   const int dst,
+                   const int weight_offset,
+                   const int bias_offset,
+                   const int in_stride,
+                   const int out_dims,
+                   const bool apply_relu)
+{
+  // Parallel implementation of the fully-connected layer with runtime
+  // shapes for the programmable layer engine
+  // (same as `LinearDynamic` except for the buffers)
+  // The input and output are stored in the same vector memory
+  // The vector memory and weight memory hold `B` elements per row, and the
+  // element `e` is stored in the column `e` % `B` of the row `e` / `B`, so
+  // that the `B` elements read per cycle are in the same row (the second
+  // dimension is completely partitioned) for any `src` and `weight_offset`
+  // `x` is of size (1, `in_stride`) and starts from the element `src`
+  // `y` is of size (1, `out_dims`) and starts from the element `dst`
+  // `weight` is of size (`out_dims`, `in_stride`), starts from the element
+  // `weight_offset`, and each row is zero-padded to `in_stride`
+  // `bias` is of size (`out_dims`) and starts from the element `bias_offset`
+  // `src`, `in_stride`, and `weight_offset` must be multiples of `B`, and
+  // `x` and `y` must not overlap
+
+#pragma HLS INLINE off
+
+  static_assert(MaxInDims % B == 0,
+                "`MaxInDims` must be a multiple of `B`");
+  static_assert(MaxVecSize % B == 0,
+                "`MaxVecSize` must be a multiple of `B`");
+  static_assert(MaxWeightSize % B == 0,
+                "`MaxWeightSize` must be a multiple of `B`");
+
+  constexpr int kMaxIters = MaxInDims / B;
+
+  const int src_row = src / B;
+  const int in_rows = in_stride / B;
+
+  for (int i = 0; i < out_dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutDims
+#pragma HLS PIPELINE off
+    fixed_t val = 0;
+    fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+    const int weight_row = weight_offset / B + i * in_rows;
+
+    for (int j0 = 0; j0 < in_rows; ++j0) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxIters
+#pragma HLS PIPELINE II=1
+      for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS UNROLL
+        if (j0 == 0)
+          vals[j1] = vec[src_row + j0][j1] * weight[weight_row + j0][j1];
+        else
+          vals[j1] += vec[src_row + j0][j1] * weight[weight_row + j0][j1];
+      }
+    }
+
+    for (int j1 = 0; j1 < B; ++j1)
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+      val += vals[j1];
+
+    val += bias[bias_offset + i];
+
+    const int e = dst + i;
+
+    if (apply_relu)
+      vec[e / B][e % B] = val > fixed_t(0) ? val : fixed_t(0);
+    else
+      vec[e / B][e % B] = val;
+  }
+}
+
+template <int B>
+struct LinearOverlayPorts
+{
+  // Number of elements accessed per cycle by `LinearOverlay`
+  // `x` and `weight` are read as a row of `B` elements of the vector and
+  // weight memories, whose second dimension is completely partitioned
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  static constexpr int kWeight = B;
+};
+
+template <int InDims, int OutDims, bool ApplyReLU, int B>
+void LinearPacked(const fixed_t x[InDims],
+                  const packed_t<B> weight[OutDims][InDims / B],
+                  const fixed_t bias[OutDims],
+                  fixed_t y[OutDims])
+{
+  // Parallel implementation of the fully-connected layer with the packed
+  // weights (same as `Linear3` except for the weight format)
+  // `B` consecutive weights in a row are packed into a single word, so
+  // that one memory access feeds all `B` lanes
+  // `x` is of size (1, `InDims`)
+  // `weight` is of size (`OutDims`, `InDims` / `B`)
+  // `bias` is of size (`OutDims`)
+  // `y` is of size (1, `OutDims`)
+
+#pragma HLS INLINE off
+
+  static_assert(InDims % B == 0,
+                "`InDims` must be a multiple of `B`");
+
+  for (int i = 0; i < OutDims; ++i) {
+#pragma HLS PIPELINE off
+    fixed_t val = 0;
+    fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+    for (int j0 = 0; j0 < InDims; j0 += B) {
+#pragma HLS PIPELINE II=1
+      const packed_t<B> word = weight[i][j0 / B];
+
+      for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS UNROLL
+        int j = j0 + j1;
+        if (j0 == 0)
+          vals[j1] = x[j] * UnpackValue<B>(word, j1);
+        else
+          vals[j1] += x[j] * UnpackValue<B>(word, j1);
+      }
+    }
+
+    for (int j1 = 0; j1 < B; ++j1)
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+      val += vals[j1];
+
+    val += bias[i];
+
+    if (ApplyReLU)
+      y[i] = val > fixed_t(0) ? val : fixed_t(0);
+    else
+      y[i] = val;
+  }
+}
+
+template <int B>
+struct LinearPackedPorts
+{
+  // Number of elements accessed per cycle by `LinearPacked`
+  // `x` is read along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  // `weight` is read one packed word at a time
+  static constexpr int kWeight = 1;
+};
+
+constexpr KernelCost LinearPackedCost(int in_dims, int out_dims,
+                                      bool apply_relu, int b)
+{
+  // Estimated cost of `LinearPacked` (same as `Linear3`)
+  return Linear3Cost(in_dims, out_dims, apply_relu, b);
+}
+
+template <int InDims, int OutDims, bool ApplyReLU, int B>
+void LinearDualMac(const fixed_t x[InDims],
+                   const fixed_t weight[OutDims][InDims],
+                   const fixed_t bias[OutDims],
+                   fixed_t y[OutDims])
+{
+  // Parallel implementation of the fully-connected layer with two
+  // multiplications per DSP (same as `Linear3` except for the multipliers)
+  // Two adjacent outputs are computed at once, and each input element is
+  // multiplied by the weights of two rows with a single multiplier
+  // (see `DualMultiply`)
+  // `x` is of size (1, `InDims`)
+  // `weight` is of size (`OutDims`, `InDims`)
+  // `bias` is of size (`OutDims`)
+  // `y` is of size (1, `OutDims`)
+
+#pragma HLS INLINE off
+
+  static_assert(InDims % B == 0,
+                "`InDims` must be a multiple of `B`");
+  static_assert(OutDims % 2 == 0,
+                "`OutDims` must be an even number");
+
+  for (int i0 = 0; i0 < OutDims; i0 += 2) {
+#pragma HLS PIPELINE off
+    fixed_t val_lo = 0;
+    fixed_t val_hi = 0;
+    fixed_t vals_lo[B];
+    fixed_t vals_hi[B];
+#pragma HLS ARRAY_PARTITION variable=vals_lo dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=vals_hi dim=1 complete
+
+    for (int j0 = 0; j0 < InDims; j0 += B) {
+#pragma HLS PIPELINE II=1
+      for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS UNROLL
+        int j = j0 + j1;
+        product_t p_hi;
+        product_t p_lo;
+        DualMultiply(x[j], weight[i0 + 1][j], weight[i0][j], p_hi, p_lo);
+
+        if (j0 == 0) {
+          vals_lo[j1] = p_lo;
+          vals_hi[j1] = p_hi;
+        } else {
+          vals_lo[j1] += p_lo;
+          vals_hi[j1] += p_hi;
+        }
+      }
+    }
+
+    for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+      val_lo += vals_lo[j1];
+      val_hi += vals_hi[j1];
+    }
+
+    val_lo += bias[i0];
+    val_hi += bias[i0 + 1];
+
+    if (ApplyReLU) {
+      y[i0] = val_lo > fixed_t(0) ? val_lo : fixed_t(0);
+      y[i0 + 1] = val_hi > fixed_t(0) ? val_hi : fixed_t(0);
+    } else {
+      y[i0] = val_lo;
+      y[i0 + 1] = val_hi;
+    }
+  }
+}
+
+template <int B>
+struct LinearDualMacPorts
+{
+  // Number of elements accessed per cycle by `LinearDualMac`
+  // `x` is read along the first dimension
+  static constexpr int kInput = B;
+  // Two outputs are written per row pair
+  static constexpr int kOutput = 2;
+  // `weight` is read along the second dimension from two adjacent rows
+  static constexpr int kWeight = B;
+  static constexpr int kWeightRows = 2;
+};
+
+constexpr KernelCost LinearDualMacCost(int in_dims, int out_dims,
+                                       bool /* apply_relu */, int b)
+{
+  // Estimated cost of `LinearDualMac`
+  // Same as `Linear3` except that two output elements are computed at once
+  // and the products are split after the multiplication
+  return KernelCost {
+    SequentialLoopCycles(
+      out_dims / 2,
+      PipelinedLoopCycles(in_dims / b, 1,
+                          kMemoryLatency + kMacLatency + kAddLatency)
+      + (AdderTreeDepth(b) + 1) * kAddLatency + 1),
+    b, FixedBytes(out_dims) };
+}
+
+template <int InDims, int OutDims, bool ApplyReLU, int B>
+void LinearLog(const fixed_t x[InDims],
+               const log_weight_t weight[OutDims][InDims],
+               const fixed_t bias[OutDims],
+               fixed_t y[OutDims])
+{
+  // Parallel implementation of the fully-connected layer with the
+  // log-quantized weights (same as `Linear3` except for the multipliers)
+  // Each multiplication is replaced with a shift of the input element
+  // (see `LogMultiply`), so that `B` can be increased beyond the number of
+  // DSPs
+  // `x` is of size (1, `InDims`)
+  // `weight` is of size (`OutDims`, `InDims`)
+  // `bias` is of size (`OutDims`)
+  // `y` is of size (1, `OutDims`)
+
+#pragma HLS INLINE off
+
+  static_assert(InDims % B == 0,
+                "`InDims` must be a multiple of `B`");
+
+  for (int i = 0; i < OutDims; ++i) {
+#pragma HLS PIPELINE off
+    fixed_t val = 0;
+    fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+    for (int j0 = 0; j0 < InDims; j0 += B) {
+#pragma HLS PIPELINE II=1
+      for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS UNROLL
+        int j = j0 + j1;
+        if (j0 == 0)
+          vals[j1] = LogMultiply(x[j], weight[i][j]);
+        else
+          vals[j1] += LogMultiply(x[j], weight[i][j]);
       }
     }
 
@@ -139,4 +607,30 @@ void Linear3(const fixed_t x[InDims],
   }
 }
 
+template <int B>
+struct LinearLogPorts
+{
+  // Number of elements accessed per cycle by `LinearLog`
+  // `x` is read along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+  // `weight` is read along the second dimension
+  static constexpr int kWeight = B;
+};
+
+constexpr KernelCost LinearLogCost(int in_dims, int out_dims,
+                                   bool /* apply_relu */, int b)
+{
+  // Estimated cost of `LinearLog`
+  // Same as `Linear3` except that the multiplications are replaced with
+  // the shifts
+  return KernelCost {
+    SequentialLoopCycles(
+      out_dims,
+      PipelinedLoopCycles(in_dims / b, 1,
+                          kMemoryLatency + kShiftLatency + kAddLatency)
+      + (AdderTreeDepth(b) + 1) * kAddLatency + 1),
+    0, FixedBytes(out_dims) };
+}
+
 #endif // TOYNET_LINEAR_HPP
@@ -0,0 +1,152 @@
+// linear_ddr.hpp
+
+#ifndef TOYNET_LINEAR_DDR_HPP
+#define TOYNET_LINEAR_DDR_HPP
+
+#include "cost_model.hpp"
+#include "data_packing.hpp"
+#include "data_types.hpp"
+
+// Fully-connected layer with the weights in the external memory (DDR)
+// The weights are accessed through the AXI4 master interface one row at a
+// time, and only two rows are kept on chip (row cache), so that the size
+// of the layer is not limited by the on-chip memory
+// The weights are packed into the words of `B` consecutive weights in a row
+// (`packed_t<B>`, as in `LinearPacked`), so that the row is fetched in
+// `InDims` / `B` beats of the wide AXI4 master port, which keeps up with
+// the `InDims` / `B` cycles to multiply it
+// The next row is fetched in a burst while the current row is multiplied
+
+template <int InDims, int OutDims, int B>
+void LinearDdrLoadRow(const packed_t<B>* weight,
+                      packed_t<B> row[InDims / B],
+                      const int i)
+{
+  // Read the `i`-th row of the weight in a single burst
+
+#pragma HLS INLINE off
+
+  constexpr int kRowWords = InDims / B;
+
+  if (i < 0 || i >= OutDims)
+    return;
+
+  for (int j = 0; j < kRowWords; ++j) {
+#pragma HLS PIPELINE II=1
+    row[j] = weight[i * kRowWords + j];
+  }
+}
+
+template <int InDims, int OutDims, bool ApplyReLU, int B>
+void LinearDdrComputeRow(const fixed_t x[InDims],
+                         const packed_t<B> row[InDims / B],
+                         const fixed_t bias[OutDims],
+                         fixed_t y[OutDims],
+                         const int i)
+{
+  // Compute the `i`-th output in the same way as `LinearPacked`
+
+#pragma HLS INLINE off
+
+  if (i < 0 || i >= OutDims)
+    return;
+
+  fixed_t val = 0;
+  fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+  for (int j0 = 0; j0 < InDims; j0 += B) {
+#pragma HLS PIPELINE II=1
+    const packed_t<B> word = row[j0 / B];
+
+    for (int j1 = 0; j1 < B; ++j1) {
+#pragma HLS UNROLL
+      int j = j0 + j1;
+      if (j0 == 0)
+        vals[j1] = x[j] * UnpackValue<B>(word, j1);
+      else
+        vals[j1] += x[j] * UnpackValue<B>(word, j1);
+    }
+  }
+
+  for (int j1 = 0; j1 < B; ++j1)
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+    val += vals[j1];
+
+  val += bias[i];
+
+  if (ApplyReLU)
+    y[i] = val > fixed_t(0) ? val : fixed_t(0);
+  else
+    y[i] = val;
+}
+
+template <int InDims, int OutDims, bool ApplyReLU, int B>
+void LinearDdr(const fixed_t x[InDims],
+               const packed_t<B>* weight,
+               const fixed_t bias[OutDims],
+               fixed_t y[OutDims])
+{
+  // Parallel implementation of the fully-connected layer with the weights
+  // streamed from the external memory
+  // Innermost loop is parallelized by a factor of `B`
+  // `x` is of size (1, `InDims`)
+  // `weight` points to the array of size (`OutDims`, `InDims` / `B`)
+  // `bias` is of size (`OutDims`)
+  // `y` is of size (1, `OutDims`)
+
+#pragma HLS INLINE off
+
+  static_assert(InDims % B == 0,
+                "`InDims` must be a multiple of `B`");
+
+  // Ping-pong row cache
+  // `B` weights are read from a single word per cycle, so that the row
+  // cache is not partitioned
+  packed_t<B> row0[InDims / B];
+  packed_t<B> row1[InDims / B];
+
+  // In the `i`-th iteration, the `i`-th row is loaded and the `i-1`-th
+  // output is computed from the previously loaded row
+  for (int i = 0; i < OutDims + 1; ++i) {
+#pragma HLS PIPELINE off
+    if (i % 2 == 0) {
+      LinearDdrLoadRow<InDims, OutDims, B>(weight, row0, i);
+      LinearDdrComputeRow<InDims, OutDims, ApplyReLU, B>(
+        x, row1, bias, y, i - 1);
+    } else {
+      LinearDdrLoadRow<InDims, OutDims, B>(weight, row1, i);
+      LinearDdrComputeRow<InDims, OutDims, ApplyReLU, B>(
+        x, row0, bias, y, i - 1);
+    }
+  }
+}
+
+template <int B>
+struct LinearDdrPorts
+{
+  // Number of elements accessed per cycle by `LinearDdr`
+  // `x` is read along the first dimension
+  // The weights are read from the row cache
+  static constexpr int kInput = B;
+  static constexpr int kOutput = 1;
+};
+
+constexpr KernelCost LinearDdrCost(int in_dims, int out_dims,
+                                   bool /* apply_relu */, int b)
+{
+  // Estimated cost of `LinearDdr`
+  // The load of the next row (a burst of `InDims` / `B` words) overlaps
+  // with the computation of the current row, so that each of the
+  // `OutDims` + 1 iterations takes as long as the slower of the two
+  const long long load = PipelinedLoopCycles(in_dims / b, 1, kAxiLatency);
+  const long long compute =
+    PipelinedLoopCycles(in_dims / b, 1, kMemoryLatency + kMacLatency)
+    + (AdderTreeDepth(b) + 1) * kAddLatency + 1;
+  return KernelCost {
+    SequentialLoopCycles(out_dims + 1, MaxCycles(load, compute)),
+    b, FixedBytes(out_dims) };
+}
+
+#endif // TOYNET_LINEAR_DDR_HPP
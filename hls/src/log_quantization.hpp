@@ -0,0 +1,129 @@
+// log_quantization.hpp
+
+#ifndef TOYNET_LOG_QUANTIZATION_HPP
+#define TOYNET_LOG_QUANTIZATION_HPP
+
+#include <cstdint>
+
+#include "data_conversion.hpp"
+#include "data_types.hpp"
+
+// Power-of-two (logarithmic) quantization of the weights
+// Each weight is rounded to the nearest power of two in the log domain and
+// stored as a sign bit and an exponent code, so that the multiplication by
+// the weight is replaced with a barrel shift of the activation (no DSPs)
+// The exponent code 0 represents the zero weight, and the code `c` (> 0)
+// represents the magnitude 2^(`kLogMinExponent` + `c` - 1)
+
+// Number of bits of the exponent code
+constexpr int kLogExponentWidth = 4;
+// Number of bits of the log-quantized weight (sign and exponent code)
+constexpr int kLogWeightWidth = kLogExponentWidth + 1;
+
+// Range of the exponents
+// The range is limited to the powers of two representable by `fixed_t`,
+// so that the shift gives the same result as the multiplication by the
+// dequantized weight
+constexpr int kLogMaxExponent =
+  kIntegerBitWidth - 2 < 1 ? kIntegerBitWidth - 2 : 1;
+constexpr int kLogMinExponent =
+  kLogMaxExponent - ((1 << kLogExponentWidth) - 2) >
+  -(kBitWidth - kIntegerBitWidth) ?
+  kLogMaxExponent - ((1 << kLogExponentWidth) - 2) :
+  -(kBitWidth - kIntegerBitWidth);
+// Maximum shift amount
+constexpr int kLogShiftRange = kLogMaxExponent - kLogMinExponent;
+
+static_assert(kLogMaxExponent >= kLogMinExponent,
+              "`fixed_t` cannot represent any power of two");
+
+// Log-quantized weight
+using log_weight_t = ap_uint<kLogWeightWidth>;
+
+// Product of `fixed_t` and the log-quantized weight
+// The activation is shifted by up to `kLogShiftRange` bits and negated,
+// and hence the product is exact
+using log_product_t = ap_fixed<kBitWidth + kLogShiftRange + 1,
+                               kIntegerBitWidth + kLogMaxExponent + 1>;
+
+// Mantissa of sqrt(2) in the single-precision format, which is the
+// boundary for rounding the exponent in the log domain
+constexpr std::uint32_t kLogRoundMantissa = 0x3504F3;
+
+// Convert the float value to the log-quantized weight
+// The magnitude is rounded to 2^round(log2(|`val`|)), and is saturated to
+// the largest exponent or flushed to zero if it is out of range
+// Only the sign, exponent, and mantissa fields are inspected, so that the
+// conversion is done by a few comparators at the initialization
+inline log_weight_t FloatToLogWeight(const float val)
+{
+#pragma HLS INLINE
+  const std::uint32_t u = FloatToU32(val);
+  const std::uint32_t sign = u >> 31;
+  const int exp_field = static_cast<int>((u >> 23) & 0xFF);
+  const std::uint32_t mantissa = u & 0x7FFFFF;
+
+  // Zero and subnormal values are flushed to zero
+  if (exp_field == 0)
+    return log_weight_t(0);
+
+  int exponent = exp_field - 127;
+  if (mantissa >= kLogRoundMantissa)
+    exponent += 1;
+
+  if (exponent < kLogMinExponent)
+    return log_weight_t(0);
+  if (exponent > kLogMaxExponent)
+    exponent = kLogMaxExponent;
+
+  log_weight_t w = exponent - kLogMinExponent + 1;
+  w[kLogExponentWidth] = sign;
+  return w;
+}
+
+// Convert the log-quantized weight to `fixed_t` (exact)
+inline fixed_t LogWeightToFixed(const log_weight_t w)
+{
+#pragma HLS INLINE
+  const int code = w.range(kLogExponentWidth - 1, 0).to_int();
+  if (code == 0)
+    return fixed_t(0);
+
+  // Raw integer representation of 2^(`kLogMinExponent` + `code` - 1)
+  ap_int<kBitWidth + 1> raw = 1;
+  raw <<= code - 1 + kLogMinExponent + (kBitWidth - kIntegerBitWidth);
+  if (w[kLogExponentWidth])
+    raw = -raw;
+
+  fixed_t val;
+  val.range(kBitWidth - 1, 0) = raw.range(kBitWidth - 1, 0);
+  return val;
+}
+
+// Compute `x` * `w` by shifting the activation
+// The result is the same as `x` * `LogWeightToFixed(w)`
+inline log_product_t LogMultiply(const fixed_t x, const log_weight_t w)
+{
+#pragma HLS INLINE
+  using raw_product_t = ap_int<kBitWidth + kLogShiftRange + 1>;
+
+  const int code = w.range(kLogExponentWidth - 1, 0).to_int();
+
+  // Raw integer representation of `x` sign-extended and shifted by
+  // `code` - 1 bits (the exponent relative to `kLogMinExponent`)
+  ap_int<kBitWidth> x_raw = x.range(kBitWidth - 1, 0);
+  raw_product_t p_raw = x_raw;
+  p_raw <<= (code == 0 ? 0 : code - 1);
+
+  if (code == 0)
+    p_raw = 0;
+  else if (w[kLogExponentWidth])
+    p_raw = -p_raw;
+
+  log_product_t p;
+  p.range(kBitWidth + kLogShiftRange, 0) =
+    p_raw.range(kBitWidth + kLogShiftRange, 0);
+  return p;
+}
+
+#endif // TOYNET_LOG_QUANTIZATION_HPP
@@ -0,0 +1,27 @@
+// loop_trips.hpp
+
+#ifndef TOYNET_LOOP_TRIPS_HPP
+#define TOYNET_LOOP_TRIPS_HPP
+
+// Loop trip counts of a kernel, given by a constexpr `*Trips` function next
+// to the kernel template, which takes the same arguments as the template
+// The kernels run a pipelined loop inside the (flattened) outer loops, and
+// a few iterations after the pipelined loop in each outer iteration (e.g.,
+// the unrolled loop that writes the outputs)
+struct LoopTrips
+{
+  // Number of iterations of the outer loops
+  long long outer;
+  // Number of iterations of the pipelined loop per outer iteration
+  long long inner;
+  // Number of iterations after the pipelined loop per outer iteration
+  long long tail;
+};
+
+// Total number of iterations of the kernel
+constexpr long long TotalTrips(const LoopTrips& trips)
+{
+  return trips.outer * (trips.inner + trips.tail);
+}
+
+#endif // TOYNET_LOOP_TRIPS_HPP
@@ -4,7 +4,9 @@
 #ifndef TOYNET_MAX_POOL_2D_HPP
 #define TOYNET_MAX_POOL_2D_HPP
 
+#include "cost_model.hpp"
 #include "data_types.hpp"
+#include "loop_trips.hpp"
 
 template <int C, int H, int W, int K>
 void MaxPool2d(const fixed_t x[C][H][W],
@@ -47,6 +49,17 @@ void MaxPool2d(const fixed_t x[C][H][W],
   }
 }
 
+constexpr KernelCost MaxPool2dCost(int c, int h, int w, int k)
+{
+  // Estimated cost of `MaxPool2d`
+  // Each comparison is made sequentially
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c) * (h / k) * (w / k),
+      SequentialLoopCycles(k * k, kMemoryLatency + kAddLatency) + 1),
+    0, FixedBytes(c * (h / k) * (w / k)) };
+}
+
 template <int C, int H, int W, int K, int B>
 void MaxPool2d2(const fixed_t x[C][H][W],
                 fixed_t y[C][H / K][W / K])
@@ -99,6 +112,26 @@ void MaxPool2d2(const fixed_t x[C][H][W],
   }
 }
 
+template <int B>
+struct MaxPool2d2Ports
+{
+  // Number of elements accessed per cycle by `MaxPool2d2`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+constexpr KernelCost MaxPool2d2Cost(int c, int h, int w, int k, int b)
+{
+  // Estimated cost of `MaxPool2d2`
+  // `B` comparisons are made in parallel without pipelining
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c / b) * (h / k) * (w / k),
+      SequentialLoopCycles(k * k, kMemoryLatency + kAddLatency) + 1),
+    0, FixedBytes(c * (h / k) * (w / k)) };
+}
+
 template <int C, int H, int W, int K, int B>
 void MaxPool2d3(const fixed_t x[C][H][W],
                 fixed_t y[C][H / K][W / K])
@@ -151,4 +184,340 @@ void MaxPool2d3(const fixed_t x[C][H][W],
   }
 }
 
+template <int B>
+struct MaxPool2d3Ports
+{
+  // Number of elements accessed per cycle by `MaxPool2d3`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+constexpr LoopTrips MaxPool2d3Trips(int c, int h, int w, int k, int b)
+{
+  // Loop trip counts of `MaxPool2d3`
+  // The comparisons over the window are pipelined, and the `B` outputs are
+  // written after them
+  return LoopTrips { static_cast<long long>(c / b) * (h / k) * (w / k),
+                     k * k, 1 };
+}
+
+constexpr KernelCost MaxPool2d3Cost(int c, int h, int w, int k, int b)
+{
+  // Estimated cost of `MaxPool2d3`
+  // `B` comparisons are made in parallel in the pipelined loop
+  const LoopTrips trips = MaxPool2d3Trips(c, h, w, k, b);
+  return KernelCost {
+    SequentialLoopCycles(
+      trips.outer,
+      PipelinedLoopCycles(trips.inner, 1, kMemoryLatency + kAddLatency)
+      + trips.tail),
+    0, FixedBytes(c * (h / k) * (w / k)) };
+}
+
+template <int MaxC, int MaxInHW, int MaxOutHW, int K, int B>
+void MaxPool2dDynamic(const fixed_t x[MaxC][MaxInHW],
+                      fixed_t y[MaxC][MaxOutHW],
+                      const int c,
+                      const int h,
+                      const int w)
+{
+  // Parallel implementation of the 2D max-pooling layer with runtime shapes
+  // Used as a single engine shared by all max-pooling layers
+  // `x` is of size (`c`, `h` * `w`)
+  // `y` is of size (`c`, `h/K` * `w/K`)
+  // `h` and `w` must be multiples of `K`
+
+#pragma HLS INLINE off
+
+  static_assert(MaxC % B == 0, "`MaxC` must be a multiple of `B`");
+
+  constexpr int kMaxGroups = MaxC / B;
+
+  const int oh = h / K;
+  const int ow = w / K;
+
+  for (int c0 = 0; c0 < c; c0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxGroups
+#pragma HLS PIPELINE off
+    for (int oy = 0; oy < oh; ++oy) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutHW
+#pragma HLS PIPELINE off
+      for (int ox = 0; ox < ow; ++ox) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxOutHW
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+            int ih = oy * K + kh;
+            int iw = ox * K + kw;
+
+            for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+              int ch = c0 + c1;
+              fixed_t val = x[ch][ih * w + iw];
+              if (kh == 0 && kw == 0)
+                vals[c1] = val;
+              else
+                vals[c1] = vals[c1] > val ? vals[c1] : val;
+            }
+          }
+        }
+
+        for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int ch = c0 + c1;
+          if (ch < c)
+            y[ch][oy * ow + ox] = vals[c1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct MaxPool2dDynamicPorts
+{
+  // Number of elements accessed per cycle by `MaxPool2dDynamic`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+template <int MaxC, int MaxSize, int MaxK, int B>
+void MaxPool2dOverlay(fixed_t fmap[MaxC][MaxSize],
+                      const int src,
+                      const int dst,
+                      const int c,
+                      const int h,
+                      const int w,
+                      const int k)
+{
+  // Parallel implementation of the 2D max-pooling layer with runtime
+  // shapes and kernel size for the programmable layer engine
+  // (same as `MaxPool2dDynamic` except for the buffers)
+  // `x` is of size (`c`, `h` * `w`) and starts from the column `src`
+  // `y` is of size (`c`, `h/k` * `w/k`) and starts from the column `dst`
+  // `h` and `w` must be multiples of `k`, and `x` and `y` must not overlap
+
+#pragma HLS INLINE off
+
+  static_assert(MaxC % B == 0, "`MaxC` must be a multiple of `B`");
+
+  constexpr int kMaxGroups = MaxC / B;
+
+  const int oh = h / k;
+  const int ow = w / k;
+
+  for (int c0 = 0; c0 < c; c0 += B) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxGroups
+#pragma HLS PIPELINE off
+    for (int oy = 0; oy < oh; ++oy) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE off
+      for (int ox = 0; ox < ow; ++ox) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxSize
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int kh = 0; kh < k; ++kh) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxK
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < k; ++kw) {
+#pragma HLS LOOP_TRIPCOUNT max=MaxK
+#pragma HLS PIPELINE II=1
+            int ih = oy * k + kh;
+            int iw = ox * k + kw;
+
+            for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+              int ch = c0 + c1;
+              fixed_t val = fmap[ch][src + ih * w + iw];
+              if (kh == 0 && kw == 0)
+                vals[c1] = val;
+              else
+                vals[c1] = vals[c1] > val ? vals[c1] : val;
+            }
+          }
+        }
+
+        for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int ch = c0 + c1;
+          if (ch < c)
+            fmap[ch][dst + oy * ow + ox] = vals[c1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct MaxPool2dOverlayPorts
+{
+  // Number of elements accessed per cycle by `MaxPool2dOverlay`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+template <int C, int H, int W, int OH, int OW, int K, int P, int S>
+void MaxPool2dStrided(const fixed_t x[C][H][W],
+                      fixed_t y[C][OH][OW])
+{
+  // Naive implementation of the 2D max-pooling layer with the independent
+  // kernel size, padding, and stride (e.g., overlapping 3x3 pooling with
+  // the stride of 2)
+  // Padded elements are excluded from the maximum
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`, `OH`, `OW`)
+
+#pragma HLS INLINE off
+
+  static_assert(P <= K / 2, "`P` must be at most half of `K`");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  for (int c = 0; c < C; ++c) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t val;
+        bool found = false;
+
+        for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE off
+            int ih = oh * S + kh - P;
+            int iw = ow * S + kw - P;
+
+            if (ih >= 0 && ih < H && iw >= 0 && iw < W) {
+              if (!found)
+                val = x[c][ih][iw];
+              else
+                val = val > x[c][ih][iw] ? val : x[c][ih][iw];
+              found = true;
+            }
+          }
+        }
+
+        y[c][oh][ow] = val;
+      }
+    }
+  }
+}
+
+constexpr KernelCost MaxPool2dStridedCost(int c, int /* h */, int /* w */,
+                                          int oh, int ow, int k,
+                                          int /* p */, int /* s */)
+{
+  // Estimated cost of `MaxPool2dStrided` (same as `MaxPool2d` except for
+  // the output size)
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c) * oh * ow,
+      SequentialLoopCycles(k * k, kMemoryLatency + kAddLatency) + 1),
+    0, FixedBytes(c * oh * ow) };
+}
+
+template <int C, int H, int W, int OH, int OW, int K, int P, int S, int B>
+void MaxPool2dStrided2(const fixed_t x[C][H][W],
+                       fixed_t y[C][OH][OW])
+{
+  // Parallel implementation of the 2D max-pooling layer with the
+  // independent kernel size, padding, and stride
+  // `x` is of size (`C`, `H`, `W`)
+  // `y` is of size (`C`, `OH`, `OW`)
+
+#pragma HLS INLINE off
+
+  static_assert(C % B == 0, "`C` must be a multiple of `B`");
+  static_assert(P <= K / 2, "`P` must be at most half of `K`");
+  static_assert((H + 2 * P - K) / S + 1 == OH,
+                "Output height is inconsistent with the parameters");
+  static_assert((W + 2 * P - K) / S + 1 == OW,
+                "Output width is inconsistent with the parameters");
+
+  for (int c0 = 0; c0 < C; c0 += B) {
+#pragma HLS PIPELINE off
+    for (int oh = 0; oh < OH; ++oh) {
+#pragma HLS PIPELINE off
+      for (int ow = 0; ow < OW; ++ow) {
+#pragma HLS PIPELINE off
+        fixed_t vals[B];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        // The window position is shared by all channels, so that a single
+        // flag tracks whether the first valid element has been read
+        bool found = false;
+
+        for (int kh = 0; kh < K; ++kh) {
+#pragma HLS PIPELINE off
+          for (int kw = 0; kw < K; ++kw) {
+#pragma HLS PIPELINE II=1
+            int ih = oh * S + kh - P;
+            int iw = ow * S + kw - P;
+            bool valid = ih >= 0 && ih < H && iw >= 0 && iw < W;
+
+            for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS UNROLL
+              int c = c0 + c1;
+              if (valid) {
+                if (!found)
+                  vals[c1] = x[c][ih][iw];
+                else
+                  vals[c1] = vals[c1] > x[c][ih][iw] ?
+                    vals[c1] : x[c][ih][iw];
+              }
+            }
+
+            found = found || valid;
+          }
+        }
+
+        for (int c1 = 0; c1 < B; ++c1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int c = c0 + c1;
+          y[c][oh][ow] = vals[c1];
+        }
+      }
+    }
+  }
+}
+
+template <int B>
+struct MaxPool2dStrided2Ports
+{
+  // Number of elements accessed per cycle by `MaxPool2dStrided2`
+  // `x` and `y` are accessed along the first dimension
+  static constexpr int kInput = B;
+  static constexpr int kOutput = B;
+};
+
+constexpr KernelCost MaxPool2dStrided2Cost(int c, int /* h */, int /* w */,
+                                           int oh, int ow, int k,
+                                           int /* p */, int /* s */, int b)
+{
+  // Estimated cost of `MaxPool2dStrided2` (same as `MaxPool2d3` except for
+  // the output size)
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(c / b) * oh * ow,
+      PipelinedLoopCycles(k * k, 1, kMemoryLatency + kAddLatency) + 1),
+    0, FixedBytes(c * oh * ow) };
+}
+
 #endif // TOYNET_MAX_POOL_2D_HPP
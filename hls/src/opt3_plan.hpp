@@ -0,0 +1,81 @@
+// opt3_plan.hpp
+
+#ifndef TOYNET_OPT3_PLAN_HPP
+#define TOYNET_OPT3_PLAN_HPP
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_transfer.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+#include "partition_plan.hpp"
+#include "toynet_plan.hpp"
+
+// Parallelization and partition factors of the `InferenceOpt3Core`
+// pipeline, shared by the tops built on the same pipeline (`InferenceOpt3`,
+// `InferenceMulti`, `InferenceProfile`, `InferencePixel`, and
+// `InferenceRle`), so that they are planned in the same way
+
+// Parallelization factors of the layers
+constexpr int kConv0B = kOpt3Conv0B;
+constexpr int kConv1B = kOpt3Conv1B;
+constexpr int kFc0B = kOpt3Fc0B;
+constexpr int kFc1B = kOpt3Fc1B;
+constexpr int kFc2B = kOpt3Fc2B;
+
+// Partition factors of the intermediate results, derived from the number of
+// ports required by the producer and consumer of each buffer
+constexpr int kX1Factor = CyclicPartition<6,
+  Conv2d4Ports<kConv0B>::kOutput,
+  MaxPool2d3Ports<kConv0B>::kInput>::kFactor;
+constexpr int kX2Factor = CyclicPartition<6,
+  MaxPool2d3Ports<kConv0B>::kOutput,
+  BatchNorm2dReLU3Ports<kConv0B>::kInput>::kFactor;
+constexpr int kX3Factor = CyclicPartition<6,
+  BatchNorm2dReLU3Ports<kConv0B>::kOutput,
+  Conv2d4Ports<kConv1B>::kInput>::kFactor;
+constexpr int kX4Factor = CyclicPartition<16,
+  Conv2d4Ports<kConv1B>::kOutput,
+  MaxPool2d3Ports<kConv1B>::kInput>::kFactor;
+constexpr int kX5Factor = CyclicPartition<16,
+  MaxPool2d3Ports<kConv1B>::kOutput,
+  BatchNorm2dReLU3Ports<kConv1B>::kInput>::kFactor;
+constexpr int kX6Factor = CyclicPartition<16,
+  BatchNorm2dReLU3Ports<kConv1B>::kOutput,
+  Flatten3dPorts::kInput>::kFactor;
+constexpr int kX7Factor = CyclicPartition<400,
+  Flatten3dPorts::kOutput,
+  Linear3Ports<kFc0B>::kInput>::kFactor;
+constexpr int kX8Factor = CyclicPartition<120,
+  Linear3Ports<kFc0B>::kOutput,
+  Linear3Ports<kFc1B>::kInput>::kFactor;
+constexpr int kX9Factor = CyclicPartition<84,
+  Linear3Ports<kFc1B>::kOutput,
+  Linear3Ports<kFc2B>::kInput>::kFactor;
+
+// Partition factors of the model parameters, which are written by
+// `ReadArray*` (or `ReadReplicatedArray*`) and read by the layers
+constexpr int kConv0WeightFactor = CyclicPartition<6,
+  ReadArrayPorts::kOutput,
+  Conv2d4Ports<kConv0B>::kWeight>::kFactor;
+constexpr int kBn0ParamsFactor = CyclicPartition<6,
+  ReadArrayPorts::kOutput,
+  BatchNorm2dReLU3Ports<kConv0B>::kParams>::kFactor;
+constexpr int kConv1WeightFactor = CyclicPartition<16,
+  ReadArrayPorts::kOutput,
+  Conv2d4Ports<kConv1B>::kWeight>::kFactor;
+constexpr int kBn1ParamsFactor = CyclicPartition<16,
+  ReadArrayPorts::kOutput,
+  BatchNorm2dReLU3Ports<kConv1B>::kParams>::kFactor;
+constexpr int kFc0WeightFactor = CyclicPartition<400,
+  ReadArrayPorts::kOutput,
+  Linear3Ports<kFc0B>::kWeight>::kFactor;
+constexpr int kFc1WeightFactor = CyclicPartition<120,
+  ReadArrayPorts::kOutput,
+  Linear3Ports<kFc1B>::kWeight>::kFactor;
+constexpr int kFc2WeightFactor = CyclicPartition<84,
+  ReadArrayPorts::kOutput,
+  Linear3Ports<kFc2B>::kWeight>::kFactor;
+
+#endif // TOYNET_OPT3_PLAN_HPP
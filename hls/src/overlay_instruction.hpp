@@ -0,0 +1,99 @@
+// overlay_instruction.hpp
+
+#ifndef TOYNET_OVERLAY_INSTRUCTION_HPP
+#define TOYNET_OVERLAY_INSTRUCTION_HPP
+
+#include "data_types.hpp"
+
+// Instruction format of the programmable layer engine (`InferenceOverlay`)
+// The program is a sequence of the instructions, each of which runs one
+// layer on the shared engines and is encoded as `kOverlayInstructionWords`
+// 32-bit words in the order of the fields of `OverlayInstruction`
+// The host-side compiler (host/overlay_compiler.py) must be kept in sync
+
+// Operation codes
+// `kOpEnd` marks the end of the program and is appended when the program
+// is loaded
+constexpr int kOpEnd = 0;
+constexpr int kOpInput = 1;
+constexpr int kOpConv2d = 2;
+constexpr int kOpMaxPool2d = 3;
+constexpr int kOpBatchNorm2dReLU = 4;
+constexpr int kOpFlatten = 5;
+constexpr int kOpLinear = 6;
+constexpr int kOpOutput = 7;
+
+// Flags
+constexpr int kFlagReLU = 1;
+
+// Number of words per instruction
+constexpr int kOverlayInstructionWords = 16;
+
+struct OverlayInstruction
+{
+  // Operation code (`kOp*`)
+  int opcode;
+  // Addresses of the input and output buffers
+  // The feature maps of size (`in_ch`, `h` * `w`) start from the column
+  // `src` of the feature map memory, and the vectors start from the
+  // element `src` of the vector memory
+  int src;
+  int dst;
+  // Number of the input and output channels (or dimensions)
+  int in_ch;
+  int out_ch;
+  // Input and output shapes
+  int h;
+  int w;
+  int oh;
+  int ow;
+  // Kernel size, padding, and stride
+  int k;
+  int pad;
+  int stride;
+  // Flags (`kFlag*`)
+  int flags;
+  // Offset of the parameters (column of the convolution weights, index of
+  // the batch normalization layer, or offset of the fully-connected weights)
+  int param_offset;
+  // Offset of the fully-connected bias
+  int bias_offset;
+  // Row stride of the fully-connected weights (multiple of `B`)
+  int in_stride;
+};
+
+// Read the instruction from the AXI4-Stream interface
+inline OverlayInstruction ReadOverlayInstruction(
+  hls::stream<axi_stream_data_t>& in_stream)
+{
+#pragma HLS INLINE
+  int words[kOverlayInstructionWords];
+#pragma HLS ARRAY_PARTITION variable=words dim=1 complete
+
+  for (int i = 0; i < kOverlayInstructionWords; ++i) {
+#pragma HLS PIPELINE off
+    axi_stream_data_t in_data = in_stream.read();
+    words[i] = static_cast<int>(in_data.data.to_int());
+  }
+
+  OverlayInstruction inst;
+  inst.opcode = words[0];
+  inst.src = words[1];
+  inst.dst = words[2];
+  inst.in_ch = words[3];
+  inst.out_ch = words[4];
+  inst.h = words[5];
+  inst.w = words[6];
+  inst.oh = words[7];
+  inst.ow = words[8];
+  inst.k = words[9];
+  inst.pad = words[10];
+  inst.stride = words[11];
+  inst.flags = words[12];
+  inst.param_offset = words[13];
+  inst.bias_offset = words[14];
+  inst.in_stride = words[15];
+  return inst;
+}
+
+#endif // TOYNET_OVERLAY_INSTRUCTION_HPP
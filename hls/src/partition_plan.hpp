@@ -0,0 +1,37 @@
+// partition_plan.hpp
+
+#ifndef TOYNET_PARTITION_PLAN_HPP
+#define TOYNET_PARTITION_PLAN_HPP
+
+// Number of ports in each memory bank (true dual-port BRAM)
+constexpr int kBramPorts = 2;
+
+template <int D, int ProducerPorts, int ConsumerPorts>
+struct CyclicPartition
+{
+  // Cyclic partition factor of a buffer shared by the two kernels
+  // `D` is the size of the partitioned dimension
+  // `ProducerPorts` is the number of elements written per cycle
+  // `ConsumerPorts` is the number of elements read per cycle
+  // Each kernel accesses `Ports` consecutive elements per cycle, which are
+  // distributed over `kFactor` banks with at most `kBramPorts` accesses
+  // to each bank
+
+  static_assert(ProducerPorts > 0 && ConsumerPorts > 0,
+                "Number of ports must be positive");
+
+  static constexpr int kPorts = ProducerPorts > ConsumerPorts ?
+    ProducerPorts : ConsumerPorts;
+  static constexpr int kFactor = (kPorts + kBramPorts - 1) / kBramPorts;
+
+  static_assert(kFactor <= D,
+                "Partition factor exceeds the size of the dimension");
+  static_assert(D % kFactor == 0,
+                "Dimension must be a multiple of the partition factor");
+  static_assert((ProducerPorts + kFactor - 1) / kFactor <= kBramPorts,
+                "Producer needs more ports than the banks provide");
+  static_assert((ConsumerPorts + kFactor - 1) / kFactor <= kBramPorts,
+                "Consumer needs more ports than the banks provide");
+};
+
+#endif // TOYNET_PARTITION_PLAN_HPP
@@ -0,0 +1,136 @@
+// pointwise_conv_2d.hpp
+
+#ifndef TOYNET_POINTWISE_CONV_2D_HPP
+#define TOYNET_POINTWISE_CONV_2D_HPP
+
+#include "cost_model.hpp"
+#include "data_types.hpp"
+
+template <int InCh, int OutCh, int H, int W>
+void PointwiseConv2d(const fixed_t x[InCh][H][W],
+                     fixed_t y[OutCh][H][W],
+                     const fixed_t weight[OutCh][InCh])
+{
+  // Naive implementation of the pointwise (1x1) convolution
+  // `x` is of size (`InCh`, `H`, `W`)
+  // `y` is of size (`OutCh`, `H`, `W`)
+  // `weight` is of size (`OutCh`, `InCh`)
+
+#pragma HLS INLINE off
+
+  for (int oc = 0; oc < OutCh; ++oc) {
+#pragma HLS PIPELINE off
+    for (int h = 0; h < H; ++h) {
+#pragma HLS PIPELINE off
+      for (int w = 0; w < W; ++w) {
+#pragma HLS PIPELINE off
+        fixed_t val = 0;
+
+        for (int ic = 0; ic < InCh; ++ic)
+#pragma HLS PIPELINE off
+          val += x[ic][h][w] * weight[oc][ic];
+
+        y[oc][h][w] = val;
+      }
+    }
+  }
+}
+
+constexpr KernelCost PointwiseConv2dCost(int in_ch, int out_ch, int h, int w)
+{
+  // Estimated cost of `PointwiseConv2d`
+  // Each product is computed sequentially
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch) * h * w,
+      SequentialLoopCycles(in_ch, kMemoryLatency + kMacLatency) + 1),
+    1, FixedBytes(out_ch * h * w) };
+}
+
+template <int InCh, int OutCh, int H, int W, int BI, int BO>
+void PointwiseConv2d2(const fixed_t x[InCh][H][W],
+                      fixed_t y[OutCh][H][W],
+                      const fixed_t weight[OutCh][InCh])
+{
+  // Parallel implementation of the pointwise (1x1) convolution
+  // Input and output channels are parallelized by factors of `BI` and `BO`
+  // There are no window loops, and `BI` * `BO` products are computed
+  // per cycle
+  // `x` is of size (`InCh`, `H`, `W`)
+  // `y` is of size (`OutCh`, `H`, `W`)
+  // `weight` is of size (`OutCh`, `InCh`)
+
+#pragma HLS INLINE off
+
+  static_assert(InCh % BI == 0,
+                "`InCh` must be a multiple of `BI`");
+  static_assert(OutCh % BO == 0,
+                "`OutCh` must be a multiple of `BO`");
+
+  for (int oc0 = 0; oc0 < OutCh; oc0 += BO) {
+#pragma HLS PIPELINE off
+    for (int h = 0; h < H; ++h) {
+#pragma HLS PIPELINE off
+      for (int w = 0; w < W; ++w) {
+#pragma HLS PIPELINE off
+        fixed_t vals[BO];
+#pragma HLS ARRAY_PARTITION variable=vals dim=1 complete
+
+        for (int ic0 = 0; ic0 < InCh; ic0 += BI) {
+#pragma HLS PIPELINE II=1
+          for (int oc1 = 0; oc1 < BO; ++oc1) {
+#pragma HLS UNROLL
+            int oc = oc0 + oc1;
+            fixed_t val = (ic0 == 0) ? fixed_t(0) : vals[oc1];
+
+            for (int ic1 = 0; ic1 < BI; ++ic1) {
+#pragma HLS UNROLL
+              int ic = ic0 + ic1;
+              val += x[ic][h][w] * weight[oc][ic];
+            }
+
+            vals[oc1] = val;
+          }
+        }
+
+        for (int oc1 = 0; oc1 < BO; ++oc1) {
+#pragma HLS PIPELINE II=1
+#pragma HLS UNROLL
+          int oc = oc0 + oc1;
+          y[oc][h][w] = vals[oc1];
+        }
+      }
+    }
+  }
+}
+
+template <int BI, int BO>
+struct PointwiseConv2d2Ports
+{
+  // Number of elements accessed per cycle by `PointwiseConv2d2`
+  // `x` is read along the first dimension
+  static constexpr int kInput = BI;
+  // `y` is written along the first dimension
+  static constexpr int kOutput = BO;
+  // `weight` is read along the first and second dimensions (`BI` elements
+  // from each of the `BO` rows), so the second dimension is completely
+  // partitioned and the first is partitioned for the `BO` rows
+  static constexpr int kWeightOut = BO;
+};
+
+constexpr KernelCost PointwiseConv2d2Cost(int in_ch, int out_ch, int h, int w,
+                                          int bi, int bo)
+{
+  // Estimated cost of `PointwiseConv2d2`
+  // `BI` * `BO` products are computed in parallel in the pipelined loop,
+  // and the `BI` products of each output are added up in a chain
+  return KernelCost {
+    SequentialLoopCycles(
+      static_cast<long long>(out_ch / bo) * h * w,
+      PipelinedLoopCycles(in_ch / bi, 1,
+                          kMemoryLatency + kMulLatency + bi * kAddLatency)
+      + 1),
+    bi * bo, FixedBytes(out_ch * h * w) };
+}
+
+#endif // TOYNET_POINTWISE_CONV_2D_HPP
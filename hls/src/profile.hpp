@@ -0,0 +1,239 @@
+// profile.hpp
+
+#ifndef TOYNET_PROFILE_HPP
+#define TOYNET_PROFILE_HPP
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_conversion.hpp"
+#include "data_types.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+
+// Cycle counters for profiling the stages of the dataflow region
+// Each stage (layer call) notifies its completion to the monitor process
+// through the dedicated stream, and the monitor counts the cycles from the
+// start of the sample until each notification arrives
+// In the C simulation, the stages run one after another before the monitor,
+// so the loop trip counts of the stages (`*Trips` next to the kernels)
+// stand in for the cycles (the pipelined loops with II=1 are counted as
+// one cycle per iteration)
+
+// Counter type (wraps around after 2^32 cycles)
+using cycle_count_t = ap_uint<32>;
+
+// Notification from the stage to the monitor
+struct stage_event_t
+{
+  // Number of iterations of the pipelined loops in the stage
+  cycle_count_t trips;
+  // Number of cycles stalled on the AXI4-Stream interface
+  cycle_count_t stalls;
+};
+
+// Layout of the counters for the dataflow region with `NumStages` stages,
+// where the first and last stages read the input and write the output
+template <int NumStages>
+struct ProfileCounters
+{
+  // Cycles spent by each stage after the previous stage completes
+  static constexpr int kStage = 0;
+  // Cycles stalled on the input and output streams
+  static constexpr int kInputStall = NumStages;
+  static constexpr int kOutputStall = NumStages + 1;
+  // Cycles spent by the whole sample loop
+  static constexpr int kSampleLoop = NumStages + 2;
+  static constexpr int kNum = NumStages + 3;
+};
+
+// Notify the completion of the stage to the monitor
+inline void NotifyStage(hls::stream<stage_event_t>& event,
+                        const cycle_count_t trips,
+                        const cycle_count_t stalls)
+{
+#pragma HLS INLINE
+  stage_event_t data;
+  data.trips = trips;
+  data.stalls = stalls;
+  event.write(data);
+}
+
+// Read the 3D array from the AXI4-Stream interface (same as `ReadArray3d`)
+// and count the cycles stalled on the empty stream
+template <int D0, int D1, int D2>
+void ReadArray3dProfile(fixed_t x[D0][D1][D2],
+                        hls::stream<axi_stream_data_t>& in_stream,
+                        hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  cycle_count_t stalls = 0;
+
+  for (int i = 0; i < D0; ++i) {
+#pragma HLS PIPELINE off
+    for (int j = 0; j < D1; ++j) {
+#pragma HLS PIPELINE off
+      for (int k = 0; k < D2; ++k) {
+#pragma HLS PIPELINE off
+        axi_stream_data_t in_data;
+        while (!in_stream.read_nb(in_data)) {
+#pragma HLS PIPELINE II=1
+          ++stalls;
+        }
+
+        float val = U32ToFloat(in_data.data.to_uint());
+        x[i][j][k] = static_cast<fixed_t>(val);
+      }
+    }
+  }
+
+  NotifyStage(event, D0 * D1 * D2, stalls);
+}
+
+// Write the 1D array to the AXI4-Stream interface (same as `WriteArray1d`)
+// and count the cycles stalled on the full stream
+template <int D0>
+void WriteArray1dProfile(const fixed_t x[D0],
+                         hls::stream<axi_stream_data_t>& out_stream,
+                         hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  cycle_count_t stalls = 0;
+  axi_stream_data_t out_data;
+  out_data.keep = 0xF;
+  out_data.strb = 0xF;
+
+  for (int i = 0; i < D0; ++i) {
+#pragma HLS PIPELINE off
+    // Set all bits in `keep` and `strb` fields to 1
+    float val = static_cast<float>(x[i]);
+    out_data.data = FloatToU32(val);
+    out_data.last = (i == D0 - 1);
+
+    while (!out_stream.write_nb(out_data)) {
+#pragma HLS PIPELINE II=1
+      ++stalls;
+    }
+  }
+
+  NotifyStage(event, D0, stalls);
+}
+
+// Layers that notify their completion to the monitor
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int B>
+void Conv2d4Stage(const fixed_t x[InCh][H][W],
+                  fixed_t y[OutCh][OH][OW],
+                  const fixed_t weight[OutCh][InCh][K][K],
+                  hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  Conv2d4<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y, weight);
+  NotifyStage(event, TotalTrips(
+    Conv2d4Trips(InCh, OutCh, H, W, OH, OW, K, P, S, B)), 0);
+}
+
+template <int C, int H, int W, int K, int B>
+void MaxPool2d3Stage(const fixed_t x[C][H][W],
+                     fixed_t y[C][H / K][W / K],
+                     hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  MaxPool2d3<C, H, W, K, B>(x, y);
+  NotifyStage(event, TotalTrips(MaxPool2d3Trips(C, H, W, K, B)), 0);
+}
+
+template <int C, int H, int W, int B>
+void BatchNorm2dReLU3Stage(const fixed_t x[C][H][W],
+                           fixed_t y[C][H][W],
+                           const fixed_t scale[C],
+                           const fixed_t bias[C],
+                           const fixed_t mean[C],
+                           hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  BatchNorm2dReLU3<C, H, W, B>(x, y, scale, bias, mean);
+  NotifyStage(event, TotalTrips(BatchNorm2dReLU3Trips(C, H, W, B)), 0);
+}
+
+template <int C, int H, int W>
+void Flatten3dStage(const fixed_t x[C][H][W],
+                    fixed_t y[C * H * W],
+                    hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  Flatten3d<C, H, W>(x, y);
+  NotifyStage(event, TotalTrips(Flatten3dTrips(C, H, W)), 0);
+}
+
+template <int InDims, int OutDims, bool ApplyReLU, int B>
+void Linear3Stage(const fixed_t x[InDims],
+                  const fixed_t weight[OutDims][InDims],
+                  const fixed_t bias[OutDims],
+                  fixed_t y[OutDims],
+                  hls::stream<stage_event_t>& event)
+{
+#pragma HLS INLINE off
+  Linear3<InDims, OutDims, ApplyReLU, B>(x, weight, bias, y);
+  NotifyStage(event, TotalTrips(
+    Linear3Trips(InDims, OutDims, ApplyReLU, B)), 0);
+}
+
+// Monitor the stages of one sample and accumulate the counters
+// The stages complete in order, because each stage consumes the result of
+// the previous one; the cycles are counted from the start of the monitor,
+// which starts when the monitor of the previous sample completes
+template <int NumStages>
+void MonitorStages(hls::stream<stage_event_t> events[NumStages],
+                   cycle_count_t counters[ProfileCounters<NumStages>::kNum])
+{
+#pragma HLS INLINE off
+  using Layout = ProfileCounters<NumStages>;
+
+  cycle_count_t cycles = 0;
+  cycle_count_t prev = 0;
+
+  for (int s = 0; s < NumStages; ++s) {
+#pragma HLS UNROLL
+    stage_event_t data;
+    while (!events[s].read_nb(data)) {
+#pragma HLS PIPELINE II=1
+      ++cycles;
+    }
+
+#ifndef __SYNTHESIS__
+    // The stage has already completed in the C simulation
+    cycles += data.trips;
+#endif
+
+    counters[Layout::kStage + s] += cycles - prev;
+    prev = cycles;
+
+    if (s == 0)
+      counters[Layout::kInputStall] += data.stalls;
+    if (s == NumStages - 1)
+      counters[Layout::kOutputStall] += data.stalls;
+  }
+
+  counters[Layout::kSampleLoop] += cycles;
+}
+
+// Write the counters to the AXI4-Stream interface as a separate packet
+template <int N>
+void WriteCounters(const cycle_count_t counters[N],
+                   hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INLINE off
+  axi_stream_data_t out_data;
+  out_data.keep = 0xF;
+  out_data.strb = 0xF;
+
+  for (int i = 0; i < N; ++i) {
+#pragma HLS PIPELINE off
+    out_data.data = counters[i];
+    out_data.last = (i == N - 1);
+    out_stream.write(out_data);
+  }
+}
+
+#endif // TOYNET_PROFILE_HPP
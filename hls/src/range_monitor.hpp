@@ -0,0 +1,306 @@
+// range_monitor.hpp
+
+#ifndef TOYNET_RANGE_MONITOR_HPP
+#define TOYNET_RANGE_MONITOR_HPP
+
+#include "data_types.hpp"
+
+// Saturation and range monitor for choosing the bit widths
+// The kernels pass the exact (wide) results to `MonitorRange` before they
+// are quantized to `fixed_t`, and the monitor counts the values that
+// saturate (`AP_SAT`) or lose fractional bits (`AP_TRN`) and tracks their
+// range for the layer set by `TOYNET_RANGE_LAYER`
+// The top records the range of its intermediate results (x0 to x10) with
+// `TOYNET_RANGE_TENSOR` after each sample
+// This is only enabled in the C simulation with `TOYNET_RANGE_MONITOR`, and
+// is compiled out in the synthesis
+// The ranges of the partial sums are exact as long as nothing saturates
+// before them, so the integer bits should be chosen from a run with a wide
+// format (e.g., 32 bits with 16 integer bits)
+
+#if defined(TOYNET_RANGE_MONITOR) && !defined(__SYNTHESIS__)
+#define TOYNET_RANGE_MONITOR_ENABLED
+#endif
+
+#ifdef TOYNET_RANGE_MONITOR_ENABLED
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#endif // TOYNET_RANGE_MONITOR_ENABLED
+
+// Layers of `InferenceOpt3`, where the layer `i` writes the intermediate
+// result `x{i}` (the input is written by the stream interface)
+constexpr int kRangeInput = 0;
+constexpr int kRangeConv0 = 1;
+constexpr int kRangePool0 = 2;
+constexpr int kRangeBn0 = 3;
+constexpr int kRangeConv1 = 4;
+constexpr int kRangePool1 = 5;
+constexpr int kRangeBn1 = 6;
+constexpr int kRangeFlatten = 7;
+constexpr int kRangeFc0 = 8;
+constexpr int kRangeFc1 = 9;
+constexpr int kRangeFc2 = 10;
+constexpr int kRangeNumLayers = 11;
+// No layer is monitored
+constexpr int kRangeNone = -1;
+
+#ifdef TOYNET_RANGE_MONITOR_ENABLED
+
+// Statistics of the values (exact results or stored elements)
+struct RangeStats
+{
+  long long count = 0;
+  // Number of values clipped by the saturation (or stored at the limits
+  // of `fixed_t`)
+  long long saturated = 0;
+  // Number of values that lost the fractional bits by the truncation
+  long long truncated = 0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+
+  void Merge(const RangeStats& other)
+  {
+    count += other.count;
+    saturated += other.saturated;
+    truncated += other.truncated;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+};
+
+// Statistics collected by one thread
+struct RangeTable
+{
+  // Current layer (`TOYNET_RANGE_LAYER`)
+  int layer = kRangeNone;
+  // Exact results computed in the layers (partial sums, batch
+  // normalization, and input conversion)
+  RangeStats results[kRangeNumLayers];
+  // Elements of the intermediate results
+  RangeStats tensors[kRangeNumLayers];
+};
+
+// Tables of all threads, which are merged in the report
+struct RangeRegistry
+{
+  std::mutex mutex;
+  std::vector<std::shared_ptr<RangeTable>> tables;
+};
+
+inline RangeRegistry& GetRangeRegistry()
+{
+  static RangeRegistry registry;
+  return registry;
+}
+
+// Table of the calling thread, so that the C simulation can run on
+// multiple threads without the locks
+inline RangeTable& GetRangeTable()
+{
+  thread_local std::shared_ptr<RangeTable> table = [] {
+    auto table = std::make_shared<RangeTable>();
+    RangeRegistry& registry = GetRangeRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.tables.push_back(table);
+    return table;
+  }();
+  return *table;
+}
+
+// Largest and smallest values of `fixed_t`
+inline double FixedMax()
+{
+  return std::ldexp(1.0, kIntegerBitWidth - 1)
+         - std::ldexp(1.0, kIntegerBitWidth - kBitWidth);
+}
+
+inline double FixedMin()
+{
+  return -std::ldexp(1.0, kIntegerBitWidth - 1);
+}
+
+template <typename T>
+double RangeToDouble(const T& x)
+{
+  return x.to_double();
+}
+
+inline double RangeToDouble(const float x)
+{
+  return static_cast<double>(x);
+}
+
+// Record the exact value and its quantized value in the current layer
+inline void RecordRangeResult(const double exact, const double quantized)
+{
+  RangeTable& table = GetRangeTable();
+  if (table.layer == kRangeNone)
+    return;
+
+  RangeStats& stats = table.results[table.layer];
+  const bool saturated = exact > FixedMax() || exact < FixedMin();
+  ++stats.count;
+  stats.saturated += saturated;
+  stats.truncated += !saturated && exact != quantized;
+  stats.min = std::min(stats.min, exact);
+  stats.max = std::max(stats.max, exact);
+}
+
+// Record the elements of the intermediate result written by `layer`
+inline void RecordRangeTensor(const int layer,
+                              const fixed_t* x,
+                              const int size)
+{
+  RangeStats& stats = GetRangeTable().tensors[layer];
+
+  for (int i = 0; i < size; ++i) {
+    const double val = x[i].to_double();
+    ++stats.count;
+    stats.saturated += val >= FixedMax() || val <= FixedMin();
+    stats.min = std::min(stats.min, val);
+    stats.max = std::max(stats.max, val);
+  }
+}
+
+inline void SetRangeLayer(const int layer)
+{
+  GetRangeTable().layer = layer;
+}
+
+// Clear the statistics of all threads
+inline void ResetRangeMonitor()
+{
+  RangeRegistry& registry = GetRangeRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  for (auto& table : registry.tables) {
+    const int layer = table->layer;
+    *table = RangeTable();
+    table->layer = layer;
+  }
+}
+
+// Number of integer bits (including the sign bit) to hold the range
+// without the saturation
+inline int SuggestIntegerBits(const double min, const double max)
+{
+  int bits = 1;
+  while (bits < 64 && (min < -std::ldexp(1.0, bits - 1)
+                       || max >= std::ldexp(1.0, bits - 1)))
+    ++bits;
+  return bits;
+}
+
+// Print the statistics merged over all threads
+inline void PrintRangeReport(std::ostream& os)
+{
+  static const char* const kLayerNames[kRangeNumLayers] = {
+    "input", "conv0", "pool0", "bn0", "conv1", "pool1", "bn1",
+    "flatten", "fc0", "fc1", "fc2" };
+
+  RangeTable merged;
+
+  {
+    RangeRegistry& registry = GetRangeRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (const auto& table : registry.tables) {
+      for (int l = 0; l < kRangeNumLayers; ++l) {
+        merged.results[l].Merge(table->results[l]);
+        merged.tensors[l].Merge(table->tensors[l]);
+      }
+    }
+  }
+
+  long long count = 0;
+  for (int l = 0; l < kRangeNumLayers; ++l)
+    count += merged.results[l].count + merged.tensors[l].count;
+
+  if (count == 0) {
+    os << "No values are recorded by the range monitor "
+       << "(only `InferenceOpt3` sets the layers)\n";
+    return;
+  }
+
+  auto percent = [](long long n, long long count) {
+    return count > 0 ? 100.0 * n / count : 0.0;
+  };
+
+  os << std::fixed << std::setprecision(4)
+     << "Format: " << kBitWidth << " bits (" << kIntegerBitWidth
+     << " integer bits), range: [" << FixedMin() << ", " << FixedMax()
+     << "]\n"
+     << std::left << std::setw(9) << "Layer" << std::right
+     << std::setw(14) << "Result min" << std::setw(14) << "Result max"
+     << std::setw(11) << "Sat. (%)" << std::setw(11) << "Trn. (%)"
+     << std::setw(14) << "Output min" << std::setw(14) << "Output max"
+     << std::setw(11) << "Clip. (%)" << std::setw(10) << "Int bits"
+     << '\n';
+
+  for (int l = 0; l < kRangeNumLayers; ++l) {
+    const RangeStats& results = merged.results[l];
+    const RangeStats& tensors = merged.tensors[l];
+
+    os << std::left << std::setw(9) << kLayerNames[l] << std::right;
+
+    if (results.count > 0)
+      os << std::setw(14) << results.min << std::setw(14) << results.max
+         << std::setw(11) << percent(results.saturated, results.count)
+         << std::setw(11) << percent(results.truncated, results.count);
+    else
+      os << std::setw(14) << "-" << std::setw(14) << "-"
+         << std::setw(11) << "-" << std::setw(11) << "-";
+
+    if (tensors.count > 0)
+      os << std::setw(14) << tensors.min << std::setw(14) << tensors.max
+         << std::setw(11) << percent(tensors.saturated, tensors.count);
+    else
+      os << std::setw(14) << "-" << std::setw(14) << "-"
+         << std::setw(11) << "-";
+
+    // The exact results include the partial sums, which may exceed the
+    // range of the outputs
+    const double min = std::min(results.min, tensors.min);
+    const double max = std::max(results.max, tensors.max);
+
+    if (results.count > 0 || tensors.count > 0)
+      os << std::setw(10) << SuggestIntegerBits(min, max) << '\n';
+    else
+      os << std::setw(10) << "-" << '\n';
+  }
+
+  os.unsetf(std::ios::floatfield);
+}
+
+#define TOYNET_RANGE_LAYER(layer) SetRangeLayer(layer)
+#define TOYNET_RANGE_TENSOR(layer, x) \
+  RecordRangeTensor(layer, reinterpret_cast<const fixed_t*>(x), \
+                    static_cast<int>(sizeof(x) / sizeof(fixed_t)))
+
+#else
+
+#define TOYNET_RANGE_LAYER(layer)
+#define TOYNET_RANGE_TENSOR(layer, x)
+
+#endif // TOYNET_RANGE_MONITOR_ENABLED
+
+// Quantize the exact result `x` to `fixed_t` (same as the assignment), and
+// record it in the monitor if enabled
+template <typename T>
+fixed_t MonitorRange(const T& x)
+{
+#pragma HLS INLINE
+  const fixed_t val = x;
+#ifdef TOYNET_RANGE_MONITOR_ENABLED
+  RecordRangeResult(RangeToDouble(x), val.to_double());
+#endif
+  return val;
+}
+
+#endif // TOYNET_RANGE_MONITOR_HPP
@@ -0,0 +1,113 @@
+// resource_model.hpp
+
+#ifndef TOYNET_RESOURCE_MODEL_HPP
+#define TOYNET_RESOURCE_MODEL_HPP
+
+// Static model of the on-chip memory used by the arrays
+// Each array is split into `banks` banks by the cyclic partitioning, and
+// each bank is mapped to the block RAM (BRAM18), UltraRAM (URAM), distributed
+// RAM (LUTRAM), or registers, depending on its size and binding
+// The estimates follow the default mapping of Vitis HLS and are not exact:
+// the tool may merge the small banks, or choose the other aspect ratios
+
+// Aspect ratios (depth x width) of the BRAM18 block (the 512x36 one is only
+// available in the simple dual-port mode, which is enough for the buffers
+// written by one kernel and read by the other)
+constexpr int kBram18NumShapes = 6;
+constexpr int kBram18Depths[kBram18NumShapes] = {
+  16384, 8192, 4096, 2048, 1024, 512 };
+constexpr int kBram18Widths[kBram18NumShapes] = {
+  1, 2, 4, 9, 18, 36 };
+
+// Aspect ratio of the URAM block
+constexpr int kUramDepth = 4096;
+constexpr int kUramWidth = 72;
+
+// Banks with up to `kLutramMaxBits` bits are mapped to the LUTRAM
+constexpr int kLutramMaxBits = 1024;
+// Each LUTRAM primitive uses 4 LUTs and holds 32x6 bits (RAM32M) or 64x3
+// bits (RAM64M) in the simple dual-port mode
+constexpr int kLutramLuts = 4;
+
+// Storage of the array
+enum class MemoryStorage
+{
+  // Default mapping of Vitis HLS
+  kAuto,
+  // Bound to the URAM (BIND_STORAGE impl=uram)
+  kUram,
+};
+
+// On-chip memory used by the array
+struct MemoryResources
+{
+  // Number of BRAM18 blocks (one BRAM36 block counts as two)
+  long long bram18;
+  // Number of URAM blocks
+  long long uram;
+  // Number of LUTs used as the LUTRAM
+  long long lutram;
+  // Number of flip-flops used as the registers
+  long long registers;
+};
+
+constexpr long long CeilDiv(long long x, long long y)
+{
+  return (x + y - 1) / y;
+}
+
+// Number of BRAM18 blocks for one bank with the best aspect ratio
+constexpr long long Bram18Blocks(long long depth, int width)
+{
+  long long blocks = CeilDiv(depth, kBram18Depths[0])
+    * CeilDiv(width, kBram18Widths[0]);
+
+  for (int i = 1; i < kBram18NumShapes; ++i) {
+    const long long n = CeilDiv(depth, kBram18Depths[i])
+      * CeilDiv(width, kBram18Widths[i]);
+    blocks = n < blocks ? n : blocks;
+  }
+
+  return blocks;
+}
+
+// Number of URAM blocks for one bank
+constexpr long long UramBlocks(long long depth, int width)
+{
+  return CeilDiv(depth, kUramDepth) * CeilDiv(width, kUramWidth);
+}
+
+// Number of LUTs for one bank mapped to the LUTRAM
+constexpr long long LutramLuts(long long depth, int width)
+{
+  return depth <= 32 ? CeilDiv(width, 6) * kLutramLuts :
+    CeilDiv(depth, 64) * CeilDiv(width, 3) * kLutramLuts;
+}
+
+// On-chip memory used by the array with `elements` elements of `width`
+// bits, which is partitioned into `banks` banks and instantiated `copies`
+// times (two for the ping-pong buffers between the dataflow processes)
+constexpr MemoryResources ArrayResources(long long elements,
+                                         int width,
+                                         int banks,
+                                         int copies,
+                                         MemoryStorage storage)
+{
+  const long long depth = CeilDiv(elements, banks);
+  const long long n = static_cast<long long>(banks) * copies;
+
+  MemoryResources res { 0, 0, 0, 0 };
+
+  if (depth == 1)
+    res.registers = n * width;
+  else if (storage == MemoryStorage::kUram)
+    res.uram = n * UramBlocks(depth, width);
+  else if (depth * width <= kLutramMaxBits)
+    res.lutram = n * LutramLuts(depth, width);
+  else
+    res.bram18 = n * Bram18Blocks(depth, width);
+
+  return res;
+}
+
+#endif // TOYNET_RESOURCE_MODEL_HPP
@@ -1,18 +1,31 @@
 
 // layer_test.cpp
 
+#include <cmath>
+#include <cstdint>
 #include <random>
+#include <vector>
 
+#include "avg_pool_2d.hpp"
 #include "batch_norm_2d.hpp"
 #include "conv_2d.hpp"
+#include "conv_2d_tiled.hpp"
+#include "data_conversion.hpp"
+#include "data_transfer.hpp"
 #include "data_types.hpp"
 #include "depthwise_conv_2d.hpp"
+#include "dual_mac.hpp"
 #include "linear.hpp"
+#include "linear_ddr.hpp"
 #include "max_pool_2d.hpp"
+#include "pointwise_conv_2d.hpp"
+#include "profile.hpp"
 
 #include "tb/test_util.hpp"
 
 constexpr float kTolerance = 1.0e-6;
+// Resolution of `fixed_t`
+const float kFixedStep = std::ldexp(1.0f, kIntegerBitWidth - kBitWidth);
 
 template <int C, int H, int W, int B>
 void TestBatchNorm2dReLU()
@@ -56,20 +69,145 @@ void TestConv2d()
   fixed_t y0[OutCh][OH][OW];
   fixed_t y1[OutCh][OH][OW];
   fixed_t y2[OutCh][OH][OW];
+  fixed_t y3[OutCh][OH][OW];
+  fixed_t y4[OutCh][OH][OW];
+  fixed_t y5[OutCh][OH][OW];
+  packed_t<B> weight_packed[OutCh / B][InCh][K][K];
+  log_weight_t weight_log[OutCh][InCh][K][K];
+  fixed_t weight_log_fixed[OutCh][InCh][K][K];
 
   GenerateRandomTensor3d<InCh, H, W>(x, rnd);
   GenerateRandomTensor4d<OutCh, InCh, K, K>(weight, rnd);
 
+  for (int oc = 0; oc < OutCh; ++oc)
+    for (int ic = 0; ic < InCh; ++ic)
+      for (int kh = 0; kh < K; ++kh)
+        for (int kw = 0; kw < K; ++kw)
+          PackValue<B>(weight_packed[oc / B][ic][kh][kw], oc % B,
+                       weight[oc][ic][kh][kw]);
+
+  // Log-quantized weights and their dequantized values
+  for (int oc = 0; oc < OutCh; ++oc)
+    for (int ic = 0; ic < InCh; ++ic)
+      for (int kh = 0; kh < K; ++kh)
+        for (int kw = 0; kw < K; ++kw) {
+          weight_log[oc][ic][kh][kw] = FloatToLogWeight(
+            weight[oc][ic][kh][kw].to_float());
+          weight_log_fixed[oc][ic][kh][kw] = LogWeightToFixed(
+            weight_log[oc][ic][kh][kw]);
+        }
+
   // Test the naive implementation
   Conv2d<InCh, OutCh, H, W, OH, OW, K, P, S>(x, y0, weight);
   // Test the parallel implementation
   Conv2d2<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y1, weight);
   // Test the parallel implementation
   Conv2d3<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y2, weight);
+  // Test the parallel implementation with the packed weights
+  Conv2dPacked<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y3, weight_packed);
+  // Test the parallel implementation with the log-quantized weights
+  Conv2d<InCh, OutCh, H, W, OH, OW, K, P, S>(x, y4, weight_log_fixed);
+  Conv2dLog<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y5, weight_log);
 
   // Compare the results
   CompareTensor3d<OutCh, OH, OW>(y0, y1, kTolerance, "Conv2d2");
   CompareTensor3d<OutCh, OH, OW>(y0, y2, kTolerance, "Conv2d3");
+  CompareTensor3d<OutCh, OH, OW>(y0, y3, kTolerance, "Conv2dPacked");
+  CompareTensor3d<OutCh, OH, OW>(y4, y5, kTolerance, "Conv2dLog");
+}
+
+void TestDualMultiply()
+{
+  // All pairs of the weights are multiplied by all activations, so that
+  // the sign correction and the borrow of the packed products are checked
+  if (!kDualMacEnabled) {
+    std::cerr << "Test for DualMultiply skipped (bit width is too large)\n";
+    return;
+  }
+
+  const long long num_values = 1LL << kBitWidth;
+
+  for (int i = 0; i < num_values; ++i) {
+    for (int j = 0; j < num_values; ++j) {
+      for (int k = 0; k < num_values; ++k) {
+        fixed_t a;
+        fixed_t w_hi;
+        fixed_t w_lo;
+        a.range(kBitWidth - 1, 0) = i;
+        w_hi.range(kBitWidth - 1, 0) = j;
+        w_lo.range(kBitWidth - 1, 0) = k;
+
+        product_t p_hi;
+        product_t p_lo;
+        DualMultiply(a, w_hi, w_lo, p_hi, p_lo);
+
+        if (p_hi != product_t(a * w_hi) || p_lo != product_t(a * w_lo)) {
+          std::cerr << "Test for DualMultiply failed: "
+                    << a << " * (" << w_hi << ", " << w_lo << "), "
+                    << "Output: (" << p_hi << ", " << p_lo << ")\n";
+          std::exit(EXIT_FAILURE);
+        }
+      }
+    }
+  }
+
+  std::cerr << "Test for DualMultiply succeeded!\n";
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int B>
+void TestConv2dDualMac()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  // The inputs and weights are drawn from the wide range, so that the
+  // negative and large products are packed
+  std::uniform_real_distribution<float> dist { -4.0f, 4.0f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  fixed_t x[InCh][H][W];
+  fixed_t weight[OutCh][InCh][K][K];
+  fixed_t y0[OutCh][OH][OW];
+  fixed_t y1[OutCh][OH][OW];
+
+  GenerateRandomTensor3d<InCh, H, W>(x, rnd);
+  GenerateRandomTensor4d<OutCh, InCh, K, K>(weight, rnd);
+
+  // Test the parallel implementation with the same order of additions
+  Conv2d4<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y0, weight);
+  // Test the parallel implementation with two multiplications per DSP
+  Conv2dDualMac<InCh, OutCh, H, W, OH, OW, K, P, S, B>(x, y1, weight);
+
+  // Compare the results (bit-exact)
+  CompareTensor3d<OutCh, OH, OW>(y0, y1, 0.0f, "Conv2dDualMac");
+}
+
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int S, int TH, int TW, int TOC, int B>
+void TestConv2dTiled()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_real_distribution<float> dist { -0.1f, 0.1f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  // Host arrays are used in place of the external memory
+  fixed_t x[InCh][H][W];
+  fixed_t weight[OutCh][InCh][K][K];
+  fixed_t y0[OutCh][OH][OW];
+  fixed_t y1[OutCh][OH][OW];
+
+  GenerateRandomTensor3d<InCh, H, W>(x, rnd);
+  GenerateRandomTensor4d<OutCh, InCh, K, K>(weight, rnd);
+
+  // Test the naive implementation
+  Conv2d<InCh, OutCh, H, W, OH, OW, K, P, S>(x, y0, weight);
+  // Test the tiled implementation
+  Conv2dTiled<InCh, OutCh, H, W, OH, OW, K, P, S, TH, TW, TOC, B>(
+    &x[0][0][0], &y1[0][0][0], &weight[0][0][0][0]);
+
+  // Compare the results
+  CompareTensor3d<OutCh, OH, OW>(y0, y1, kTolerance, "Conv2dTiled");
 }
 
 template <int C, int H, int W, int OH, int OW,
@@ -85,6 +223,7 @@ void TestDepthwiseConv2d()
   fixed_t weight[C][K][K];
   fixed_t y0[C][OH][OW];
   fixed_t y1[C][OH][OW];
+  fixed_t y2[C][OH][OW];
 
   GenerateRandomTensor3d<C, H, W>(x, rnd);
   GenerateRandomTensor3d<C, K, K>(weight, rnd);
@@ -93,9 +232,46 @@ void TestDepthwiseConv2d()
   DepthwiseConv2d<C, H, W, OH, OW, K, P, S>(x, y0, weight);
   // Test the parallel implementation
   DepthwiseConv2d2<C, H, W, OH, OW, K, P, S, B>(x, y1, weight);
+  // Test the pipelined implementation
+  DepthwiseConv2d3<C, H, W, OH, OW, K, P, S, B>(x, y2, weight);
 
   // Compare the results
   CompareTensor3d<C, OH, OW>(y0, y1, kTolerance, "DepthwiseConv2d2");
+  CompareTensor3d<C, OH, OW>(y0, y2, kTolerance, "DepthwiseConv2d3");
+}
+
+template <int InCh, int OutCh, int H, int W, int BI, int BO>
+void TestPointwiseConv2d()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_real_distribution<float> dist { -0.1f, 0.1f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  fixed_t x[InCh][H][W];
+  fixed_t weight[OutCh][InCh];
+  fixed_t weight4d[OutCh][InCh][1][1];
+  fixed_t y0[OutCh][H][W];
+  fixed_t y1[OutCh][H][W];
+  fixed_t y2[OutCh][H][W];
+
+  GenerateRandomTensor3d<InCh, H, W>(x, rnd);
+  GenerateRandomTensor2d<OutCh, InCh>(weight, rnd);
+
+  for (int oc = 0; oc < OutCh; ++oc)
+    for (int ic = 0; ic < InCh; ++ic)
+      weight4d[oc][ic][0][0] = weight[oc][ic];
+
+  // Test the naive convolution with the 1x1 kernel
+  Conv2d<InCh, OutCh, H, W, H, W, 1, 0, 1>(x, y0, weight4d);
+  // Test the naive implementation
+  PointwiseConv2d<InCh, OutCh, H, W>(x, y1, weight);
+  // Test the parallel implementation
+  PointwiseConv2d2<InCh, OutCh, H, W, BI, BO>(x, y2, weight);
+
+  // Compare the results
+  CompareTensor3d<OutCh, H, W>(y0, y1, kTolerance, "PointwiseConv2d");
+  CompareTensor3d<OutCh, H, W>(y0, y2, kTolerance, "PointwiseConv2d2");
 }
 
 template <int C, int H, int W, int K, int B>
@@ -112,6 +288,7 @@ void TestMaxPool2d()
   fixed_t x[C][H][W];
   fixed_t y0[C][OH][OW];
   fixed_t y1[C][OH][OW];
+  fixed_t y2[C][OH][OW];
 
   GenerateRandomTensor3d<C, H, W>(x, rnd);
 
@@ -119,9 +296,123 @@ void TestMaxPool2d()
   MaxPool2d<C, H, W, K>(x, y0);
   // Test the parallel implementation
   MaxPool2d2<C, H, W, K, B>(x, y1);
+  // Test the strided implementation with the stride of `K`
+  MaxPool2dStrided<C, H, W, OH, OW, K, 0, K>(x, y2);
 
   // Compare the results
   CompareTensor3d<C, OH, OW>(y0, y1, kTolerance, "MaxPool2d2");
+  CompareTensor3d<C, OH, OW>(y0, y2, kTolerance, "MaxPool2dStrided");
+}
+
+template <int C, int H, int W, int OH, int OW, int K, int P, int S, int B>
+void TestMaxPool2dStrided()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_real_distribution<float> dist { -0.1f, 0.1f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  fixed_t x[C][H][W];
+  fixed_t y0[C][OH][OW];
+  fixed_t y1[C][OH][OW];
+
+  GenerateRandomTensor3d<C, H, W>(x, rnd);
+
+  // Test the naive implementation
+  MaxPool2dStrided<C, H, W, OH, OW, K, P, S>(x, y0);
+  // Test the parallel implementation
+  MaxPool2dStrided2<C, H, W, OH, OW, K, P, S, B>(x, y1);
+
+  // Compare the results
+  CompareTensor3d<C, OH, OW>(y0, y1, kTolerance, "MaxPool2dStrided2");
+}
+
+template <int C, int H, int W, int OH, int OW, int K, int P, int S, int B>
+void TestAvgPool2d()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  // The inputs are drawn from the wide range, so that the averages are
+  // representable in the narrow formats (e.g., 8 bits)
+  std::uniform_real_distribution<float> dist { -2.0f, 2.0f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  fixed_t x[C][H][W];
+  fixed_t y0[C][OH][OW];
+  fixed_t y1[C][OH][OW];
+  fixed_t y2[C][OH][OW];
+
+  GenerateRandomTensor3d<C, H, W>(x, rnd);
+
+  // Compute the averages in floating-point
+  for (int c = 0; c < C; ++c) {
+    for (int oh = 0; oh < OH; ++oh) {
+      for (int ow = 0; ow < OW; ++ow) {
+        double val = 0.0;
+        for (int kh = 0; kh < K; ++kh) {
+          for (int kw = 0; kw < K; ++kw) {
+            int ih = oh * S + kh - P;
+            int iw = ow * S + kw - P;
+            if (ih >= 0 && ih < H && iw >= 0 && iw < W)
+              val += static_cast<double>(x[c][ih][iw]);
+          }
+        }
+        y2[c][oh][ow] = static_cast<fixed_t>(val / (K * K));
+      }
+    }
+  }
+
+  // Test the naive implementation
+  AvgPool2d<C, H, W, OH, OW, K, P, S>(x, y0);
+  // Test the parallel implementation
+  AvgPool2d2<C, H, W, OH, OW, K, P, S, B>(x, y1);
+
+  // Compare the results
+  // The reciprocal of `K` * `K` is rounded, which changes the last bit
+  CompareTensor3d<C, OH, OW>(y2, y0, kFixedStep, "AvgPool2d (reference)");
+  CompareTensor3d<C, OH, OW>(y0, y1, kTolerance, "AvgPool2d2");
+}
+
+template <int C, int H, int W, int B>
+void TestGlobalAvgPool2d()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_real_distribution<float> dist { -2.0f, 2.0f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  fixed_t x[C][H][W];
+  fixed_t y0[C];
+  fixed_t y1[C];
+  fixed_t y2[C][1][1];
+  fixed_t y3[C];
+  fixed_t y4[C];
+
+  GenerateRandomTensor3d<C, H, W>(x, rnd);
+
+  // Compute the averages in floating-point
+  for (int c = 0; c < C; ++c) {
+    double val = 0.0;
+    for (int h = 0; h < H; ++h)
+      for (int w = 0; w < W; ++w)
+        val += static_cast<double>(x[c][h][w]);
+    y4[c] = static_cast<fixed_t>(val / (H * W));
+  }
+
+  // Test the naive implementation
+  GlobalAvgPool2d<C, H, W>(x, y0);
+  // Test the parallel implementation
+  GlobalAvgPool2d2<C, H, W, B>(x, y1);
+  // Test the average-pooling with the kernel covering the whole input
+  AvgPool2d<C, H, W, 1, 1, H, 0, 1>(x, y2);
+
+  for (int c = 0; c < C; ++c)
+    y3[c] = y2[c][0][0];
+
+  // Compare the results
+  CompareTensor1d<C>(y4, y0, kFixedStep, "GlobalAvgPool2d (reference)");
+  CompareTensor1d<C>(y0, y1, kTolerance, "GlobalAvgPool2d2");
+  CompareTensor1d<C>(y0, y3, kTolerance, "GlobalAvgPool2d");
 }
 
 template <int InDims, int OutDims, int B, bool ApplyReLU>
@@ -137,18 +428,309 @@ void TestLinear()
   fixed_t bias[OutDims];
   fixed_t y0[OutDims];
   fixed_t y1[OutDims];
+  fixed_t y2[OutDims];
+  fixed_t y3[OutDims];
+  fixed_t y4[OutDims];
+  fixed_t y5[OutDims];
+  packed_t<B> weight_packed[OutDims][InDims / B];
+  log_weight_t weight_log[OutDims][InDims];
+  fixed_t weight_log_fixed[OutDims][InDims];
 
   GenerateRandomTensor1d<InDims>(x, rnd);
   GenerateRandomTensor2d<OutDims, InDims>(weight, rnd);
   GenerateRandomTensor1d<OutDims>(bias, rnd);
 
+  for (int i = 0; i < OutDims; ++i)
+    for (int j = 0; j < InDims; ++j)
+      PackValue<B>(weight_packed[i][j / B], j % B, weight[i][j]);
+
+  // Log-quantized weights and their dequantized values
+  for (int i = 0; i < OutDims; ++i)
+    for (int j = 0; j < InDims; ++j) {
+      weight_log[i][j] = FloatToLogWeight(weight[i][j].to_float());
+      weight_log_fixed[i][j] = LogWeightToFixed(weight_log[i][j]);
+    }
+
   // Test the naive implementation
   Linear<InDims, OutDims, ApplyReLU>(x, weight, bias, y0);
   // Test the parallel implementation
   Linear2<InDims, OutDims, ApplyReLU, B>(x, weight, bias, y1);
+  // Test the implementation with the packed weights in the external memory
+  // (host array is used in place of DDR)
+  LinearDdr<InDims, OutDims, ApplyReLU, B>(
+    x, &weight_packed[0][0], bias, y2);
+  // Test the parallel implementation with the packed weights
+  LinearPacked<InDims, OutDims, ApplyReLU, B>(x, weight_packed, bias, y3);
+  // Test the parallel implementation with the log-quantized weights
+  Linear<InDims, OutDims, ApplyReLU>(x, weight_log_fixed, bias, y4);
+  LinearLog<InDims, OutDims, ApplyReLU, B>(x, weight_log, bias, y5);
 
   // Compare the results
   CompareTensor1d<OutDims>(y0, y1, kTolerance, "Linear2");
+  CompareTensor1d<OutDims>(y0, y2, kTolerance, "LinearDdr");
+  CompareTensor1d<OutDims>(y0, y3, kTolerance, "LinearPacked");
+  CompareTensor1d<OutDims>(y4, y5, kTolerance, "LinearLog");
+}
+
+template <int InDims, int OutDims, int B, bool ApplyReLU>
+void TestLinearDualMac()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  // The inputs and weights are drawn from the wide range, so that the
+  // negative and large products are packed
+  std::uniform_real_distribution<float> dist { -4.0f, 4.0f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  fixed_t x[InDims];
+  fixed_t weight[OutDims][InDims];
+  fixed_t bias[OutDims];
+  fixed_t y0[OutDims];
+  fixed_t y1[OutDims];
+
+  GenerateRandomTensor1d<InDims>(x, rnd);
+  GenerateRandomTensor2d<OutDims, InDims>(weight, rnd);
+  GenerateRandomTensor1d<OutDims>(bias, rnd);
+
+  // Test the parallel implementation with the same order of additions
+  Linear3<InDims, OutDims, ApplyReLU, B>(x, weight, bias, y0);
+  // Test the parallel implementation with two multiplications per DSP
+  LinearDualMac<InDims, OutDims, ApplyReLU, B>(x, weight, bias, y1);
+
+  // Compare the results (bit-exact)
+  CompareTensor1d<OutDims>(y0, y1, 0.0f, "LinearDualMac");
+}
+
+// Mean and standard deviation of the MNIST dataset
+constexpr float kMnistMean = 0.1307f;
+constexpr float kMnistStd = 0.3081f;
+
+// Write the normalized pixels as floats (same as the float-input tops)
+template <int C, int H, int W>
+void WriteNormalizedPixels(const std::uint8_t pixels[C * H * W],
+                           hls::stream<axi_stream_data_t>& in_stream)
+{
+  for (int i = 0; i < C * H * W; ++i) {
+    axi_stream_data_t in_data;
+    in_data.data = FloatToU32((pixels[i] / 255.0f - kMnistMean) / kMnistStd);
+    in_stream.write(in_data);
+  }
+}
+
+// Write the 8-bit pixels packed four per transfer (the first pixel in the
+// lowest bits)
+template <int C, int H, int W>
+void WritePackedPixels(const std::uint8_t pixels[C * H * W],
+                       hls::stream<axi_stream_data_t>& in_stream)
+{
+  for (int i = 0; i < C * H * W; i += kPixelsPerBeat) {
+    axi_stream_data_t in_data;
+    in_data.data = 0;
+    for (int j = 0; j < kPixelsPerBeat && i + j < C * H * W; ++j)
+      in_data.data.range(pixel_t::width * (j + 1) - 1, pixel_t::width * j) =
+        pixels[i + j];
+    in_stream.write(in_data);
+  }
+}
+
+// Write the run-length-encoded pixels (same as host/toynet_test_rle.py)
+// Each nonzero pixel (and the last pixel) ends the pair of the number of
+// zeros before it and its value, and the runs longer than the maximum are
+// split with the zero-valued pairs; the pairs are packed two per transfer
+// (the first pair in the lower half), and the last transfer is padded
+template <int C, int H, int W>
+void WriteRlePixels(const std::uint8_t pixels[C * H * W],
+                   hls::stream<axi_stream_data_t>& in_stream)
+{
+  constexpr int kMaxRun = (1 << kRleRunWidth) - 1;
+  std::vector<std::uint32_t> pairs;
+  int run = 0;
+
+  for (int i = 0; i < C * H * W; ++i) {
+    if (pixels[i] == 0 && i != C * H * W - 1) {
+      ++run;
+      continue;
+    }
+
+    while (run > kMaxRun) {
+      pairs.push_back(kMaxRun);
+      run -= kMaxRun + 1;
+    }
+
+    pairs.push_back(run | (pixels[i] << kRleRunWidth));
+    run = 0;
+  }
+
+  if (pairs.size() % kRlePairsPerBeat != 0)
+    pairs.push_back(0);
+
+  for (std::size_t i = 0; i < pairs.size(); i += kRlePairsPerBeat) {
+    axi_stream_data_t in_data;
+    in_data.data = 0;
+    for (int j = 0; j < kRlePairsPerBeat; ++j)
+      in_data.data.range(kRlePairWidth * (j + 1) - 1, kRlePairWidth * j) =
+        pairs[i + j];
+    in_stream.write(in_data);
+  }
+}
+
+template <int C, int H, int W>
+void TestReadPixelArray3d()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_int_distribution<int> dist { 0, 255 };
+
+  std::uint8_t pixels[C * H * W];
+  fixed_t x0[C][H][W];
+  fixed_t x1[C][H][W];
+  hls::stream<axi_stream_data_t> in_stream;
+
+  // The first and last pixels are the extreme values
+  for (int i = 0; i < C * H * W; ++i)
+    pixels[i] = static_cast<std::uint8_t>(dist(engine));
+  pixels[0] = 0;
+  pixels[C * H * W - 1] = 255;
+
+  // Test the float input
+  WriteNormalizedPixels<C, H, W>(pixels, in_stream);
+  ReadArray3d<C, H, W>(x0, in_stream);
+
+  // Test the 8-bit pixels, where the last transfer is partially filled
+  WritePackedPixels<C, H, W>(pixels, in_stream);
+
+  const norm_param_t scale = 1.0 / (255.0 * kMnistStd);
+  const norm_param_t bias = -kMnistMean / kMnistStd;
+  ReadPixelArray3d<C, H, W>(x1, scale, bias, in_stream);
+
+  if (!in_stream.empty()) {
+    std::cerr << "Test for ReadPixelArray3d failed: "
+              << in_stream.size() << " transfers are left\n";
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Compare the results
+  // The normalization constants are rounded, which changes the last bit
+  CompareTensor3d<C, H, W>(x0, x1, kFixedStep, "ReadPixelArray3d");
+}
+
+template <int C, int H, int W>
+void TestReadRlePixelArray3d()
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_int_distribution<int> value_dist { 1, 255 };
+  std::uniform_real_distribution<float> density_dist { 0.0f, 1.0f };
+
+  constexpr int kSize = C * H * W;
+  // Frames with the various densities of the nonzero pixels, including the
+  // blank frame (split runs) and the frame without zeros
+  constexpr int kNumFrames = 8;
+  const float densities[kNumFrames] = {
+    0.0f, 1.0f, 0.5f, 0.2f, 0.05f, 0.01f, 0.0f, 0.0f };
+
+  std::uint8_t pixels[kNumFrames][kSize];
+  fixed_t x0[C][H][W];
+  fixed_t x1[C][H][W];
+  hls::stream<axi_stream_data_t> in_stream;
+
+  for (int n = 0; n < kNumFrames; ++n)
+    for (int i = 0; i < kSize; ++i)
+      pixels[n][i] = density_dist(engine) < densities[n] ?
+        static_cast<std::uint8_t>(value_dist(engine)) : 0;
+
+  // Runs longer than the maximum, whose second pair is in the next
+  // transfer (one pair before), and a run that ends at the last pixel
+  pixels[6][0] = 255;
+  pixels[6][kSize / 2] = 1;
+  pixels[7][1] = 128;
+  pixels[7][3] = 64;
+
+  const norm_param_t scale = 1.0 / (255.0 * kMnistStd);
+  const norm_param_t bias = -kMnistMean / kMnistStd;
+
+  // Each frame starts at the new transfer, so the frames are decoded one
+  // after another from the same stream
+  for (int n = 0; n < kNumFrames; ++n)
+    WriteRlePixels<C, H, W>(pixels[n], in_stream);
+
+  for (int n = 0; n < kNumFrames; ++n) {
+    // Test the raw pixels
+    hls::stream<axi_stream_data_t> raw_stream;
+    WritePackedPixels<C, H, W>(pixels[n], raw_stream);
+    ReadPixelArray3d<C, H, W>(x0, scale, bias, raw_stream);
+    // Test the run-length-encoded pixels
+    ReadRlePixelArray3d<C, H, W>(x1, scale, bias, in_stream);
+    // Compare the results (the decoding is lossless)
+    CompareTensor3d<C, H, W>(x0, x1, 0.0f, "ReadRlePixelArray3d");
+  }
+
+  if (!in_stream.empty()) {
+    std::cerr << "Test for ReadRlePixelArray3d failed: "
+              << in_stream.size() << " transfers are left\n";
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+// `conv_trips` and `pool_trips` are the loop trip counts of the layers
+// computed by hand, so that the `*Trips` functions of the kernels are also
+// checked
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, int B>
+void TestProfile(const int conv_trips, const int pool_trips)
+{
+  std::random_device random_dev;
+  std::default_random_engine engine { random_dev() };
+  std::uniform_real_distribution<float> dist { -0.1f, 0.1f };
+  auto rnd = [&dist, &engine] { return dist(engine); };
+
+  using Layout = ProfileCounters<2>;
+  constexpr int kSamples = 3;
+
+  fixed_t x[InCh][H][W];
+  fixed_t weight[OutCh][InCh][K][K];
+  fixed_t y0[OutCh][OH][OW];
+  fixed_t y1[OutCh][OH][OW];
+  fixed_t z0[OutCh][OH / 2][OW / 2];
+  fixed_t z1[OutCh][OH / 2][OW / 2];
+  cycle_count_t counters[Layout::kNum];
+
+  GenerateRandomTensor3d<InCh, H, W>(x, rnd);
+  GenerateRandomTensor4d<OutCh, InCh, K, K>(weight, rnd);
+
+  for (int i = 0; i < Layout::kNum; ++i)
+    counters[i] = 0;
+
+  // Run the layers with and without the notifications
+  Conv2d4<InCh, OutCh, H, W, OH, OW, K, P, 1, B>(x, y0, weight);
+  MaxPool2d3<OutCh, OH, OW, 2, B>(y0, z0);
+
+  for (int i = 0; i < kSamples; ++i) {
+    hls::stream<stage_event_t> events[2];
+    Conv2d4Stage<InCh, OutCh, H, W, OH, OW, K, P, 1, B>(
+      x, y1, weight, events[0]);
+    MaxPool2d3Stage<OutCh, OH, OW, 2, B>(y1, z1, events[1]);
+    MonitorStages<2>(events, counters);
+  }
+
+  // Compare the results
+  CompareTensor3d<OutCh, OH / 2, OW / 2>(z0, z1, kTolerance, "Profile");
+
+  // The loop trip counts stand in for the cycles in the C simulation
+  const int expected[Layout::kNum] = {
+    kSamples * conv_trips, kSamples * pool_trips, 0, 0,
+    kSamples * (conv_trips + pool_trips) };
+
+  for (int i = 0; i < Layout::kNum; ++i) {
+    if (counters[i] != expected[i]) {
+      std::cerr << "Test for ProfileCounters failed: "
+                << "Expected[" << i << "]: " << expected[i] << ", "
+                << "Output[" << i << "]: " << counters[i] << '\n';
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  std::cerr << "Test for ProfileCounters succeeded!\n";
 }
 
 int main(int argc, char** argv)
@@ -157,12 +739,47 @@ int main(int argc, char** argv)
   TestConv2d<32, 64, 10, 10, 10, 10, 3, 1, 1, 8>();
   TestConv2d<32, 64, 10, 10, 5, 5, 3, 1, 2, 8>();
   TestConv2d<6, 16, 14, 14, 10, 10, 5, 0, 1, 2>();
+  TestDualMultiply();
+  TestConv2dDualMac<32, 64, 10, 10, 10, 10, 3, 1, 1, 8>();
+  TestConv2dDualMac<6, 16, 14, 14, 10, 10, 5, 0, 1, 2>();
+  TestConv2dTiled<3, 16, 32, 32, 32, 32, 3, 1, 1, 8, 16, 8, 4>();
+  TestConv2dTiled<4, 8, 20, 20, 10, 10, 3, 1, 2, 5, 5, 4, 4>();
+  TestConv2dTiled<6, 16, 14, 14, 10, 10, 5, 0, 1, 5, 10, 16, 16>();
   TestDepthwiseConv2d<64, 10, 10, 10, 10, 3, 1, 1, 8>();
   TestDepthwiseConv2d<64, 10, 10, 5, 5, 3, 1, 2, 8>();
   TestDepthwiseConv2d<16, 14, 14, 10, 10, 5, 0, 1, 2>();
+  TestDepthwiseConv2d<6, 14, 14, 10, 10, 5, 0, 1, 6>();
+  TestPointwiseConv2d<32, 64, 10, 10, 4, 8>();
+  TestPointwiseConv2d<6, 16, 10, 10, 2, 16>();
   TestMaxPool2d<64, 12, 12, 2, 8>();
+  TestMaxPool2dStrided<64, 12, 12, 6, 6, 2, 0, 2, 8>();
+  TestMaxPool2dStrided<64, 13, 13, 6, 6, 3, 0, 2, 8>();
+  TestMaxPool2dStrided<32, 14, 14, 7, 7, 3, 1, 2, 8>();
+  TestAvgPool2d<64, 12, 12, 6, 6, 2, 0, 2, 8>();
+  TestAvgPool2d<32, 14, 14, 7, 7, 3, 1, 2, 8>();
+  TestAvgPool2d<16, 10, 10, 2, 2, 5, 0, 5, 8>();
+  TestAvgPool2d<16, 7, 7, 1, 1, 7, 0, 1, 8>();
+  TestGlobalAvgPool2d<64, 7, 7, 8>();
   TestLinear<64, 128, 8, false>();
   TestLinear<64, 128, 8, true>();
+  TestLinearDualMac<64, 128, 8, false>();
+  TestLinearDualMac<64, 128, 8, true>();
+  TestReadPixelArray3d<1, 28, 28>();
+  TestReadPixelArray3d<3, 5, 7>();
+  TestReadRlePixelArray3d<1, 28, 28>();
+  TestReadRlePixelArray3d<3, 5, 7>();
+  // conv0 and pool0 of ToyNet with `B` = 6
+  // conv0: 6x28x28x25 MACs in 6 lanes (28x28x25 trips), and 28x28 trips to
+  // write the outputs (20384 trips)
+  // pool0: 6x14x14x4 comparisons in 6 lanes (14x14x4 trips), and 14x14
+  // trips to write the outputs (980 trips)
+  TestProfile<1, 6, 28, 28, 28, 28, 5, 2, 6>(20384, 980);
+  // conv1 and pool1 of ToyNet with `B` = 8
+  // conv1: 16x10x10x150 MACs in 8 lanes (2x10x10x150 trips), and 2x10x10
+  // trips to write the outputs (30200 trips)
+  // pool1: 16x5x5x4 comparisons in 8 lanes (2x5x5x4 trips), and 2x5x5
+  // trips to write the outputs (250 trips)
+  TestProfile<6, 16, 14, 14, 10, 10, 5, 0, 8>(30200, 250);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,49 @@
+// top_conv_tiled.cpp
+
+#include "conv_2d_tiled.hpp"
+#include "data_types.hpp"
+#include "toynet_plan.hpp"
+
+// First convolution of the 224x224 input, whose output (16x224x224) does
+// not fit on chip
+constexpr int kInCh = 3;
+constexpr int kOutCh = 16;
+constexpr int kHeight = 224;
+constexpr int kWidth = 224;
+constexpr int kKernelSize = 3;
+constexpr int kPadding = 1;
+constexpr int kStride = 1;
+constexpr int kOutHeight = 224;
+constexpr int kOutWidth = 224;
+
+// Tile sizes and parallelization factor
+constexpr int kTileHeight = kConvTiledTileH;
+constexpr int kTileWidth = kConvTiledTileW;
+constexpr int kTileOutCh = kConvTiledTileOutCh;
+constexpr int kConvB = kConvTiledB;
+
+// Sizes of the arrays in the external memory
+constexpr int kInputSize = kInCh * kHeight * kWidth;
+constexpr int kOutputSize = kOutCh * kOutHeight * kOutWidth;
+constexpr int kWeightSize = kOutCh * kInCh * kKernelSize * kKernelSize;
+
+void InferenceConvTiled(const fixed_t* x,
+                        fixed_t* y,
+                        const fixed_t* weight)
+{
+#pragma HLS INTERFACE m_axi port=x offset=slave bundle=gmem0 depth=kInputSize max_read_burst_length=64
+#pragma HLS INTERFACE m_axi port=y offset=slave bundle=gmem1 depth=kOutputSize max_write_burst_length=64
+#pragma HLS INTERFACE m_axi port=weight offset=slave bundle=gmem0 depth=kWeightSize max_read_burst_length=64
+#pragma HLS INTERFACE s_axilite port=x bundle=control
+#pragma HLS INTERFACE s_axilite port=y bundle=control
+#pragma HLS INTERFACE s_axilite port=weight bundle=control
+#pragma HLS INTERFACE s_axilite port=return bundle=control
+
+  // Tiled implementation with the feature maps in the external memory
+  // The input tiles and weights are read through `gmem0`, and the output
+  // tiles are written through `gmem1`
+
+  Conv2dTiled<kInCh, kOutCh, kHeight, kWidth, kOutHeight, kOutWidth,
+              kKernelSize, kPadding, kStride,
+              kTileHeight, kTileWidth, kTileOutCh, kConvB>(x, y, weight);
+}
@@ -0,0 +1,220 @@
+
+// top_log.cpp
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_transfer.hpp"
+#include "data_types.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+#include "partition_plan.hpp"
+#include "toynet_plan.hpp"
+
+// Parallelization factors of the layers
+constexpr int kConv0B = kLogConv0B;
+constexpr int kConv1B = kLogConv1B;
+constexpr int kFc0B = kLogFc0B;
+constexpr int kFc1B = kLogFc1B;
+constexpr int kFc2B = kLogFc2B;
+
+// Partition factors of the intermediate results, derived from the number of
+// ports required by the producer and consumer of each buffer
+constexpr int kX1Factor = CyclicPartition<6,
+  Conv2dLogPorts<kConv0B>::kOutput,
+  MaxPool2d3Ports<kConv0B>::kInput>::kFactor;
+constexpr int kX2Factor = CyclicPartition<6,
+  MaxPool2d3Ports<kConv0B>::kOutput,
+  BatchNorm2dReLU3Ports<kConv0B>::kInput>::kFactor;
+constexpr int kX3Factor = CyclicPartition<6,
+  BatchNorm2dReLU3Ports<kConv0B>::kOutput,
+  Conv2dLogPorts<kConv1B>::kInput>::kFactor;
+constexpr int kX4Factor = CyclicPartition<16,
+  Conv2dLogPorts<kConv1B>::kOutput,
+  MaxPool2d3Ports<kConv1B>::kInput>::kFactor;
+constexpr int kX5Factor = CyclicPartition<16,
+  MaxPool2d3Ports<kConv1B>::kOutput,
+  BatchNorm2dReLU3Ports<kConv1B>::kInput>::kFactor;
+constexpr int kX6Factor = CyclicPartition<16,
+  BatchNorm2dReLU3Ports<kConv1B>::kOutput,
+  Flatten3dPorts::kInput>::kFactor;
+constexpr int kX7Factor = CyclicPartition<400,
+  Flatten3dPorts::kOutput,
+  LinearLogPorts<kFc0B>::kInput>::kFactor;
+constexpr int kX8Factor = CyclicPartition<120,
+  LinearLogPorts<kFc0B>::kOutput,
+  LinearLogPorts<kFc1B>::kInput>::kFactor;
+constexpr int kX9Factor = CyclicPartition<84,
+  LinearLogPorts<kFc1B>::kOutput,
+  LinearLogPorts<kFc2B>::kInput>::kFactor;
+
+// Partition factors of the model parameters, which are written by
+// `ReadArray*` and read by the layers
+constexpr int kConv0WeightFactor = CyclicPartition<6,
+  ReadArrayPorts::kOutput,
+  Conv2dLogPorts<kConv0B>::kWeight>::kFactor;
+constexpr int kBn0ParamsFactor = CyclicPartition<6,
+  ReadArrayPorts::kOutput,
+  BatchNorm2dReLU3Ports<kConv0B>::kParams>::kFactor;
+constexpr int kConv1WeightFactor = CyclicPartition<16,
+  ReadArrayPorts::kOutput,
+  Conv2dLogPorts<kConv1B>::kWeight>::kFactor;
+constexpr int kBn1ParamsFactor = CyclicPartition<16,
+  ReadArrayPorts::kOutput,
+  BatchNorm2dReLU3Ports<kConv1B>::kParams>::kFactor;
+constexpr int kFc0WeightFactor = CyclicPartition<400,
+  ReadArrayPorts::kOutput,
+  LinearLogPorts<kFc0B>::kWeight>::kFactor;
+constexpr int kFc1WeightFactor = CyclicPartition<120,
+  ReadArrayPorts::kOutput,
+  LinearLogPorts<kFc1B>::kWeight>::kFactor;
+constexpr int kFc2WeightFactor = CyclicPartition<84,
+  ReadArrayPorts::kOutput,
+  LinearLogPorts<kFc2B>::kWeight>::kFactor;
+
+void InferenceLogCore(hls::stream<axi_stream_data_t>& in_stream,
+                      hls::stream<axi_stream_data_t>& out_stream,
+                      const int num_samples,
+                      const log_weight_t conv0_weight[6][1][5][5],
+                      const fixed_t bn0_scale[6],
+                      const fixed_t bn0_bias[6],
+                      const fixed_t bn0_mean[6],
+                      const log_weight_t conv1_weight[16][6][5][5],
+                      const fixed_t bn1_scale[16],
+                      const fixed_t bn1_bias[16],
+                      const fixed_t bn1_mean[16],
+                      const log_weight_t fc0_weight[120][400],
+                      const fixed_t fc0_bias[120],
+                      const log_weight_t fc1_weight[84][120],
+                      const fixed_t fc1_bias[84],
+                      const log_weight_t fc2_weight[10][84],
+                      const fixed_t fc2_bias[10])
+{
+#pragma HLS INLINE off
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS DATAFLOW
+
+#pragma HLS STABLE variable=conv0_weight
+#pragma HLS STABLE variable=bn0_scale
+#pragma HLS STABLE variable=bn0_bias
+#pragma HLS STABLE variable=bn0_mean
+#pragma HLS STABLE variable=conv1_weight
+#pragma HLS STABLE variable=bn1_scale
+#pragma HLS STABLE variable=bn1_bias
+#pragma HLS STABLE variable=bn1_mean
+#pragma HLS STABLE variable=fc0_weight
+#pragma HLS STABLE variable=fc0_bias
+#pragma HLS STABLE variable=fc1_weight
+#pragma HLS STABLE variable=fc1_bias
+#pragma HLS STABLE variable=fc2_weight
+#pragma HLS STABLE variable=fc2_bias
+
+    // Input, output, and intermediate results
+    fixed_t x0[1][28][28];
+    fixed_t x1[6][28][28];
+    fixed_t x2[6][14][14];
+    fixed_t x3[6][14][14];
+    fixed_t x4[16][10][10];
+    fixed_t x5[16][5][5];
+    fixed_t x6[16][5][5];
+    fixed_t x7[400];
+    fixed_t x8[120];
+    fixed_t x9[84];
+    fixed_t x10[10];
+
+#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=kX1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=kX2Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=kX3Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=kX4Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=kX5Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=kX6Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=kX7Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=kX8Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=kX9Factor cyclic
+
+    // Read the input
+    ReadArray3d<1, 28, 28>(x0, in_stream);
+
+    // Inference
+    Conv2dLog<1, 6, 28, 28, 28, 28, 5, 2, 1, kConv0B>(x0, x1, conv0_weight);
+    MaxPool2d3<6, 28, 28, 2, kConv0B>(x1, x2);
+    BatchNorm2dReLU3<6, 14, 14, kConv0B>(
+      x2, x3, bn0_scale, bn0_bias, bn0_mean);
+    Conv2dLog<6, 16, 14, 14, 10, 10, 5, 0, 1, kConv1B>(x3, x4, conv1_weight);
+    MaxPool2d3<16, 10, 10, 2, kConv1B>(x4, x5);
+    BatchNorm2dReLU3<16, 5, 5, kConv1B>(
+      x5, x6, bn1_scale, bn1_bias, bn1_mean);
+    Flatten3d<16, 5, 5>(x6, x7);
+    LinearLog<400, 120, true, kFc0B>(x7, fc0_weight, fc0_bias, x8);
+    LinearLog<120, 84, true, kFc1B>(x8, fc1_weight, fc1_bias, x9);
+    LinearLog<84, 10, false, kFc2B>(x9, fc2_weight, fc2_bias, x10);
+
+    // Write the output
+    WriteArray1d<10>(x10, out_stream);
+  }
+}
+
+void InferenceLog(hls::stream<axi_stream_data_t>& in_stream,
+                  hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INTERFACE axis register_mode=both register port=in_stream
+#pragma HLS INTERFACE axis register_mode=both register port=out_stream
+#pragma HLS INTERFACE s_axilite port=return bundle=control
+
+  // Optimized implementation with the log-quantized weights
+  // The weights are converted from float to the power-of-two format when
+  // they are read, and the multiplications are replaced with the shifts
+
+  // Model parameters
+  static log_weight_t conv0_weight[6][1][5][5];
+  static fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
+  static log_weight_t conv1_weight[16][6][5][5];
+  static fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
+  static log_weight_t fc0_weight[120][400];
+  static fixed_t fc0_bias[120];
+  static log_weight_t fc1_weight[84][120];
+  static fixed_t fc1_bias[84];
+  static log_weight_t fc2_weight[10][84];
+  static fixed_t fc2_bias[10];
+
+#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 factor=kConv0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 factor=kConv1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=2 factor=kFc0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=2 factor=kFc1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=2 factor=kFc2WeightFactor cyclic
+
+  axi_stream_data_t in_data;
+  in_data = in_stream.read();
+  const int mode = static_cast<int>(in_data.data.to_int());
+
+  if (mode == kModeInitWeights) {
+    // Read the model parameters
+    ReadLogConv2dParams<1, 6, 5>(conv0_weight, in_stream);
+    ReadBatchNorm2dParams<6>(bn0_scale, bn0_bias, bn0_mean, in_stream);
+    ReadLogConv2dParams<6, 16, 5>(conv1_weight, in_stream);
+    ReadBatchNorm2dParams<16>(bn1_scale, bn1_bias, bn1_mean, in_stream);
+    ReadLogLinearParams<400, 120>(fc0_weight, fc0_bias, in_stream);
+    ReadLogLinearParams<120, 84>(fc1_weight, fc1_bias, in_stream);
+    ReadLogLinearParams<84, 10>(fc2_weight, fc2_bias, in_stream);
+
+    // Write the acknowledgment message
+    WriteAck(out_stream);
+  } else if (mode == kModeInference) {
+    // Get the number of samples
+    in_data = in_stream.read();
+    const int num_samples = static_cast<int>(in_data.data.to_int());
+
+    InferenceLogCore(in_stream, out_stream, num_samples,
+      conv0_weight, bn0_scale, bn0_bias, bn0_mean,
+      conv1_weight, bn1_scale, bn1_bias, bn1_mean,
+      fc0_weight, fc0_bias, fc1_weight, fc1_bias,
+      fc2_weight, fc2_bias);
+  }
+}
@@ -0,0 +1,282 @@
+// top_multi.cpp
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_transfer.hpp"
+#include "data_types.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+#include "opt3_plan.hpp"
+
+#ifndef NUM_CORES
+#warning Number of cores is not defined (default: 2)
+#endif // NUM_CORES
+
+// Number of replicated inference cores
+constexpr int kNumCores = kMultiNumCores;
+
+static_assert(kNumCores > 0, "`kNumCores` must be positive");
+
+// Number of elements in an input sample and an output
+constexpr int kInputSize = 1 * 28 * 28;
+constexpr int kOutputSize = 10;
+
+void InferenceMultiCore(hls::stream<axi_stream_data_t>& in_stream,
+                        hls::stream<axi_stream_data_t>& out_stream,
+                        const int num_samples,
+                        const fixed_t conv0_weight[6][1][5][5],
+                        const fixed_t bn0_scale[6],
+                        const fixed_t bn0_bias[6],
+                        const fixed_t bn0_mean[6],
+                        const fixed_t conv1_weight[16][6][5][5],
+                        const fixed_t bn1_scale[16],
+                        const fixed_t bn1_bias[16],
+                        const fixed_t bn1_mean[16],
+                        const fixed_t fc0_weight[120][400],
+                        const fixed_t fc0_bias[120],
+                        const fixed_t fc1_weight[84][120],
+                        const fixed_t fc1_bias[84],
+                        const fixed_t fc2_weight[10][84],
+                        const fixed_t fc2_bias[10])
+{
+#pragma HLS INLINE off
+
+  // Same pipeline as `InferenceOpt3Core`, which processes every
+  // `kNumCores`-th sample
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS DATAFLOW
+
+#pragma HLS STABLE variable=conv0_weight
+#pragma HLS STABLE variable=bn0_scale
+#pragma HLS STABLE variable=bn0_bias
+#pragma HLS STABLE variable=bn0_mean
+#pragma HLS STABLE variable=conv1_weight
+#pragma HLS STABLE variable=bn1_scale
+#pragma HLS STABLE variable=bn1_bias
+#pragma HLS STABLE variable=bn1_mean
+#pragma HLS STABLE variable=fc0_weight
+#pragma HLS STABLE variable=fc0_bias
+#pragma HLS STABLE variable=fc1_weight
+#pragma HLS STABLE variable=fc1_bias
+#pragma HLS STABLE variable=fc2_weight
+#pragma HLS STABLE variable=fc2_bias
+
+    // Input, output, and intermediate results
+    fixed_t x0[1][28][28];
+    fixed_t x1[6][28][28];
+    fixed_t x2[6][14][14];
+    fixed_t x3[6][14][14];
+    fixed_t x4[16][10][10];
+    fixed_t x5[16][5][5];
+    fixed_t x6[16][5][5];
+    fixed_t x7[400];
+    fixed_t x8[120];
+    fixed_t x9[84];
+    fixed_t x10[10];
+
+#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=kX1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=kX2Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=kX3Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=kX4Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=kX5Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=kX6Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=kX7Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=kX8Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=kX9Factor cyclic
+
+    // Read the input
+    ReadArray3d<1, 28, 28>(x0, in_stream);
+
+    // Inference
+    Conv2d4<1, 6, 28, 28, 28, 28, 5, 2, 1, kConv0B>(x0, x1, conv0_weight);
+    MaxPool2d3<6, 28, 28, 2, kConv0B>(x1, x2);
+    BatchNorm2dReLU3<6, 14, 14, kConv0B>(
+      x2, x3, bn0_scale, bn0_bias, bn0_mean);
+    Conv2d4<6, 16, 14, 14, 10, 10, 5, 0, 1, kConv1B>(x3, x4, conv1_weight);
+    MaxPool2d3<16, 10, 10, 2, kConv1B>(x4, x5);
+    BatchNorm2dReLU3<16, 5, 5, kConv1B>(
+      x5, x6, bn1_scale, bn1_bias, bn1_mean);
+    Flatten3d<16, 5, 5>(x6, x7);
+    Linear3<400, 120, true, kFc0B>(x7, fc0_weight, fc0_bias, x8);
+    Linear3<120, 84, true, kFc1B>(x8, fc1_weight, fc1_bias, x9);
+    Linear3<84, 10, false, kFc2B>(x9, fc2_weight, fc2_bias, x10);
+
+    // Write the output
+    WriteArray1d<10>(x10, out_stream);
+  }
+}
+
+void DispatchSamples(hls::stream<axi_stream_data_t>& in_stream,
+                     hls::stream<axi_stream_data_t> core_in_streams[kNumCores],
+                     const int num_samples)
+{
+#pragma HLS INLINE off
+
+  // Forward the `i`-th sample to the `i % kNumCores`-th core
+  int core = 0;
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS PIPELINE off
+    for (int j = 0; j < kInputSize; ++j) {
+#pragma HLS PIPELINE II=1
+      core_in_streams[core].write(in_stream.read());
+    }
+
+    core = (core == kNumCores - 1) ? 0 : core + 1;
+  }
+}
+
+void CollectResults(hls::stream<axi_stream_data_t> core_out_streams[kNumCores],
+                    hls::stream<axi_stream_data_t>& out_stream,
+                    const int num_samples)
+{
+#pragma HLS INLINE off
+
+  // Collect the outputs in the same round-robin order as `DispatchSamples`,
+  // so that the outputs are written in the input order
+  int core = 0;
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS PIPELINE off
+    for (int j = 0; j < kOutputSize; ++j) {
+#pragma HLS PIPELINE II=1
+      out_stream.write(core_out_streams[core].read());
+    }
+
+    core = (core == kNumCores - 1) ? 0 : core + 1;
+  }
+}
+
+void InferenceMultiCores(hls::stream<axi_stream_data_t>& in_stream,
+                         hls::stream<axi_stream_data_t>& out_stream,
+                         const int num_samples,
+                         const fixed_t conv0_weight[kNumCores][6][1][5][5],
+                         const fixed_t bn0_scale[kNumCores][6],
+                         const fixed_t bn0_bias[kNumCores][6],
+                         const fixed_t bn0_mean[kNumCores][6],
+                         const fixed_t conv1_weight[kNumCores][16][6][5][5],
+                         const fixed_t bn1_scale[kNumCores][16],
+                         const fixed_t bn1_bias[kNumCores][16],
+                         const fixed_t bn1_mean[kNumCores][16],
+                         const fixed_t fc0_weight[kNumCores][120][400],
+                         const fixed_t fc0_bias[kNumCores][120],
+                         const fixed_t fc1_weight[kNumCores][84][120],
+                         const fixed_t fc1_bias[kNumCores][84],
+                         const fixed_t fc2_weight[kNumCores][10][84],
+                         const fixed_t fc2_bias[kNumCores][10])
+{
+#pragma HLS INLINE off
+#pragma HLS DATAFLOW
+
+  // Streams between the dispatcher, cores, and collector
+  hls::stream<axi_stream_data_t> core_in_streams[kNumCores];
+  hls::stream<axi_stream_data_t> core_out_streams[kNumCores];
+
+  // Each core may finish a sample ahead of the collector
+#pragma HLS STREAM variable=core_out_streams depth=kOutputSize
+
+  DispatchSamples(in_stream, core_in_streams, num_samples);
+
+  for (int n = 0; n < kNumCores; ++n) {
+#pragma HLS UNROLL
+    // Number of samples assigned to the `n`-th core
+    const int num_core_samples = (num_samples + kNumCores - 1 - n)
+      / kNumCores;
+
+    InferenceMultiCore(core_in_streams[n], core_out_streams[n],
+      num_core_samples,
+      conv0_weight[n], bn0_scale[n], bn0_bias[n], bn0_mean[n],
+      conv1_weight[n], bn1_scale[n], bn1_bias[n], bn1_mean[n],
+      fc0_weight[n], fc0_bias[n], fc1_weight[n], fc1_bias[n],
+      fc2_weight[n], fc2_bias[n]);
+  }
+
+  CollectResults(core_out_streams, out_stream, num_samples);
+}
+
+void InferenceMulti(hls::stream<axi_stream_data_t>& in_stream,
+                    hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INTERFACE axis register_mode=both register port=in_stream
+#pragma HLS INTERFACE axis register_mode=both register port=out_stream
+#pragma HLS INTERFACE s_axilite port=return bundle=control
+
+  // Optimized implementation with `kNumCores` replicated inference cores
+  // Each core has its own read-only copy of the model parameters, so that
+  // the cores never compete for the memory ports
+
+  // Model parameters
+  static fixed_t conv0_weight[kNumCores][6][1][5][5];
+  static fixed_t bn0_scale[kNumCores][6];
+  static fixed_t bn0_bias[kNumCores][6];
+  static fixed_t bn0_mean[kNumCores][6];
+  static fixed_t conv1_weight[kNumCores][16][6][5][5];
+  static fixed_t bn1_scale[kNumCores][16];
+  static fixed_t bn1_bias[kNumCores][16];
+  static fixed_t bn1_mean[kNumCores][16];
+  static fixed_t fc0_weight[kNumCores][120][400], fc0_bias[kNumCores][120];
+  static fixed_t fc1_weight[kNumCores][84][120], fc1_bias[kNumCores][84];
+  static fixed_t fc2_weight[kNumCores][10][84], fc2_bias[kNumCores][10];
+
+#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=fc0_bias dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=fc1_bias dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=1 complete
+#pragma HLS ARRAY_PARTITION variable=fc2_bias dim=1 complete
+
+#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=2 factor=kConv0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=2 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=2 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=2 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=2 factor=kConv1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=2 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=2 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=2 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=3 factor=kFc0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=3 factor=kFc1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=3 factor=kFc2WeightFactor cyclic
+
+  axi_stream_data_t in_data;
+  in_data = in_stream.read();
+  const int mode = static_cast<int>(in_data.data.to_int());
+
+  if (mode == kModeInitWeights) {
+    // Read the model parameters into all replicas
+    ReadReplicatedConv2dParams<kNumCores, 1, 6, 5>(conv0_weight, in_stream);
+    ReadReplicatedBatchNorm2dParams<kNumCores, 6>(
+      bn0_scale, bn0_bias, bn0_mean, in_stream);
+    ReadReplicatedConv2dParams<kNumCores, 6, 16, 5>(conv1_weight, in_stream);
+    ReadReplicatedBatchNorm2dParams<kNumCores, 16>(
+      bn1_scale, bn1_bias, bn1_mean, in_stream);
+    ReadReplicatedLinearParams<kNumCores, 400, 120>(
+      fc0_weight, fc0_bias, in_stream);
+    ReadReplicatedLinearParams<kNumCores, 120, 84>(
+      fc1_weight, fc1_bias, in_stream);
+    ReadReplicatedLinearParams<kNumCores, 84, 10>(
+      fc2_weight, fc2_bias, in_stream);
+
+    // Write the acknowledgment message
+    WriteAck(out_stream);
+  } else if (mode == kModeInference) {
+    // Get the number of samples
+    in_data = in_stream.read();
+    const int num_samples = static_cast<int>(in_data.data.to_int());
+
+    InferenceMultiCores(in_stream, out_stream, num_samples,
+      conv0_weight, bn0_scale, bn0_bias, bn0_mean,
+      conv1_weight, bn1_scale, bn1_bias, bn1_mean,
+      fc0_weight, fc0_bias, fc1_weight, fc1_bias,
+      fc2_weight, fc2_bias);
+  }
+}
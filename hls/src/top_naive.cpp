@@ -69,13 +69,13 @@ void InferenceNaive(hls::stream<axi_stream_data_t>& in_stream,
 #pragma HLS INTERFACE s_axilite port=return bundle=control
 
   // Model parameters
-  fixed_t conv0_weight[6][1][5][5];
-  fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
-  fixed_t conv1_weight[16][6][5][5];
-  fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
-  fixed_t fc0_weight[120][400], fc0_bias[120];
-  fixed_t fc1_weight[84][120], fc1_bias[84];
-  fixed_t fc2_weight[10][84], fc2_bias[10];
+  static fixed_t conv0_weight[6][1][5][5];
+  static fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
+  static fixed_t conv1_weight[16][6][5][5];
+  static fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
+  static fixed_t fc0_weight[120][400], fc0_bias[120];
+  static fixed_t fc1_weight[84][120], fc1_bias[84];
+  static fixed_t fc2_weight[10][84], fc2_bias[10];
 
   axi_stream_data_t in_data;
   in_data = in_stream.read();
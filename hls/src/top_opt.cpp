@@ -9,6 +9,7 @@
 #include "flatten.hpp"
 #include "linear.hpp"
 #include "max_pool_2d.hpp"
+#include "toynet_plan.hpp"
 
 void ConvBlock0(const fixed_t x0[1][28][28],
                 fixed_t x3[6][14][14],
@@ -27,8 +28,8 @@ void ConvBlock0(const fixed_t x0[1][28][28],
   fixed_t x1[6][28][28];
   fixed_t x2[6][14][14];
 
-#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=3 cyclic
+#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=kOptConv0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=kOptConv0Factor cyclic
 
   Conv2d3<1, 6, 28, 28, 28, 28, 5, 2, 1, 6>(x0, x1, conv0_weight);
   MaxPool2d2<6, 28, 28, 2, 6>(x1, x2);
@@ -52,8 +53,8 @@ void ConvBlock1(const fixed_t x3[6][14][14],
   fixed_t x4[16][10][10];
   fixed_t x5[16][5][5];
 
-#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=8 cyclic
+#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=kOptConv1Factor cyclic
 
   Conv2d3<6, 16, 14, 14, 10, 10, 5, 0, 1, 16>(x3, x4, conv1_weight);
   MaxPool2d2<16, 10, 10, 2, 16>(x4, x5);
@@ -96,15 +97,15 @@ void InferenceOptCore(hls::stream<axi_stream_data_t>& in_stream,
     fixed_t x9[84];
     fixed_t x10[10];
 
-// #pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=3 cyclic
-// #pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=3 cyclic
-// #pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=8 cyclic
-// #pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=4 cyclic
-#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=2 cyclic
+// #pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=kOptConv0Factor cyclic
+// #pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=kOptConv0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=kOptConv0Factor cyclic
+// #pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=kOptConv1Factor cyclic
+// #pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=kOptFc0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=kOptFc1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=kOptFc2Factor cyclic
 
     // Read the input
     ReadArray3d<1, 28, 28>(x0, in_stream);
@@ -132,25 +133,25 @@ void InferenceOpt(hls::stream<axi_stream_data_t>& in_stream,
   // Optimized implementation with the loop unrolling
 
   // Model parameters
-  fixed_t conv0_weight[6][1][5][5];
-  fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
-  fixed_t conv1_weight[16][6][5][5];
-  fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
-  fixed_t fc0_weight[120][400], fc0_bias[120];
-  fixed_t fc1_weight[84][120], fc1_bias[84];
-  fixed_t fc2_weight[10][84], fc2_bias[10];
-
-#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=2 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=2 factor=4 cyclic
-#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=2 factor=2 cyclic
+  static fixed_t conv0_weight[6][1][5][5];
+  static fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
+  static fixed_t conv1_weight[16][6][5][5];
+  static fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
+  static fixed_t fc0_weight[120][400], fc0_bias[120];
+  static fixed_t fc1_weight[84][120], fc1_bias[84];
+  static fixed_t fc2_weight[10][84], fc2_bias[10];
+
+#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 factor=kOptConv0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 factor=kOptConv0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 factor=kOptConv0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 factor=kOptConv0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 factor=kOptConv1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=2 factor=kOptFc0Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=2 factor=kOptFc1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=2 factor=kOptFc2Factor cyclic
 
   axi_stream_data_t in_data;
   in_data = in_stream.read();
@@ -9,6 +9,8 @@
 #include "flatten.hpp"
 #include "linear.hpp"
 #include "max_pool_2d.hpp"
+#include "opt3_plan.hpp"
+#include "range_monitor.hpp"
 
 void InferenceOpt3Core(hls::stream<axi_stream_data_t>& in_stream,
                        hls::stream<axi_stream_data_t>& out_stream,
@@ -61,33 +63,58 @@ void InferenceOpt3Core(hls::stream<axi_stream_data_t>& in_stream,
     fixed_t x9[84];
     fixed_t x10[10];
 
-#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=4 cyclic
-#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=2 cyclic
+#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=kX1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=kX2Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=kX3Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=kX4Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=kX5Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=kX6Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=kX7Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=kX8Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=kX9Factor cyclic
 
     // Read the input
+    // `TOYNET_RANGE_LAYER` and `TOYNET_RANGE_TENSOR` are only expanded in
+    // the C simulation with the range monitor
+    TOYNET_RANGE_LAYER(kRangeInput);
     ReadArray3d<1, 28, 28>(x0, in_stream);
 
     // Inference
-    Conv2d4<1, 6, 28, 28, 28, 28, 5, 2, 1, 6>(x0, x1, conv0_weight);
-    MaxPool2d3<6, 28, 28, 2, 6>(x1, x2);
-    BatchNorm2dReLU3<6, 14, 14, 6>(x2, x3, bn0_scale, bn0_bias, bn0_mean);
-    Conv2d4<6, 16, 14, 14, 10, 10, 5, 0, 1, 16>(x3, x4, conv1_weight);
-    MaxPool2d3<16, 10, 10, 2, 16>(x4, x5);
-    BatchNorm2dReLU3<16, 5, 5, 16>(x5, x6, bn1_scale, bn1_bias, bn1_mean);
+    TOYNET_RANGE_LAYER(kRangeConv0);
+    Conv2d4<1, 6, 28, 28, 28, 28, 5, 2, 1, kConv0B>(x0, x1, conv0_weight);
+    MaxPool2d3<6, 28, 28, 2, kConv0B>(x1, x2);
+    TOYNET_RANGE_LAYER(kRangeBn0);
+    BatchNorm2dReLU3<6, 14, 14, kConv0B>(
+      x2, x3, bn0_scale, bn0_bias, bn0_mean);
+    TOYNET_RANGE_LAYER(kRangeConv1);
+    Conv2d4<6, 16, 14, 14, 10, 10, 5, 0, 1, kConv1B>(x3, x4, conv1_weight);
+    MaxPool2d3<16, 10, 10, 2, kConv1B>(x4, x5);
+    TOYNET_RANGE_LAYER(kRangeBn1);
+    BatchNorm2dReLU3<16, 5, 5, kConv1B>(
+      x5, x6, bn1_scale, bn1_bias, bn1_mean);
     Flatten3d<16, 5, 5>(x6, x7);
-    Linear3<400, 120, true, 16>(x7, fc0_weight, fc0_bias, x8);
-    Linear3<120, 84, true, 8>(x8, fc1_weight, fc1_bias, x9);
-    Linear3<84, 10, false, 4>(x9, fc2_weight, fc2_bias, x10);
+    TOYNET_RANGE_LAYER(kRangeFc0);
+    Linear3<400, 120, true, kFc0B>(x7, fc0_weight, fc0_bias, x8);
+    TOYNET_RANGE_LAYER(kRangeFc1);
+    Linear3<120, 84, true, kFc1B>(x8, fc1_weight, fc1_bias, x9);
+    TOYNET_RANGE_LAYER(kRangeFc2);
+    Linear3<84, 10, false, kFc2B>(x9, fc2_weight, fc2_bias, x10);
+    TOYNET_RANGE_LAYER(kRangeNone);
 
     // Write the output
     WriteArray1d<10>(x10, out_stream);
+
+    TOYNET_RANGE_TENSOR(kRangeInput, x0);
+    TOYNET_RANGE_TENSOR(kRangeConv0, x1);
+    TOYNET_RANGE_TENSOR(kRangePool0, x2);
+    TOYNET_RANGE_TENSOR(kRangeBn0, x3);
+    TOYNET_RANGE_TENSOR(kRangeConv1, x4);
+    TOYNET_RANGE_TENSOR(kRangePool1, x5);
+    TOYNET_RANGE_TENSOR(kRangeBn1, x6);
+    TOYNET_RANGE_TENSOR(kRangeFlatten, x7);
+    TOYNET_RANGE_TENSOR(kRangeFc0, x8);
+    TOYNET_RANGE_TENSOR(kRangeFc1, x9);
+    TOYNET_RANGE_TENSOR(kRangeFc2, x10);
   }
 }
 
@@ -102,25 +129,25 @@ void InferenceOpt3(hls::stream<axi_stream_data_t>& in_stream,
   // inter-layer pipelining
 
   // Model parameters
-  fixed_t conv0_weight[6][1][5][5];
-  fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
-  fixed_t conv1_weight[16][6][5][5];
-  fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
-  fixed_t fc0_weight[120][400], fc0_bias[120];
-  fixed_t fc1_weight[84][120], fc1_bias[84];
-  fixed_t fc2_weight[10][84], fc2_bias[10];
-
-#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 factor=3 cyclic
-#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=2 factor=8 cyclic
-#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=2 factor=4 cyclic
-#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=2 factor=2 cyclic
+  static fixed_t conv0_weight[6][1][5][5];
+  static fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
+  static fixed_t conv1_weight[16][6][5][5];
+  static fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
+  static fixed_t fc0_weight[120][400], fc0_bias[120];
+  static fixed_t fc1_weight[84][120], fc1_bias[84];
+  static fixed_t fc2_weight[10][84], fc2_bias[10];
+
+#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 factor=kConv0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 factor=kConv1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=2 factor=kFc0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=2 factor=kFc1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=2 factor=kFc2WeightFactor cyclic
 
   axi_stream_data_t in_data;
   in_data = in_stream.read();
@@ -0,0 +1,225 @@
+// top_overlay.cpp
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_transfer.hpp"
+#include "data_types.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+#include "overlay_instruction.hpp"
+#include "partition_plan.hpp"
+#include "toynet_plan.hpp"
+
+// Capacity of the programmable layer engine
+// The host-side compiler (host/overlay_compiler.py) checks the networks
+// against these limits, and must be kept in sync
+// Maximum number of instructions (including `kOpEnd`)
+constexpr int kMaxInstructions = 32;
+// Maximum number of channels and kernel size
+constexpr int kMaxC = 16;
+constexpr int kMaxK = 7;
+// Number of columns of the feature map memory, which holds two feature
+// maps of size 28x28 per channel
+constexpr int kFmapSize = 2 * 28 * 28;
+// Number of elements of the vector memory, which holds two vectors of
+// size `kMaxDims`
+constexpr int kMaxDims = 512;
+constexpr int kVecSize = 2 * kMaxDims;
+// Sizes of the parameter memories
+constexpr int kMaxConvWeightCols = 512;
+constexpr int kMaxBnLayers = 4;
+constexpr int kLinearWeightSize = 64 * 1024;
+constexpr int kLinearBiasSize = 512;
+
+// Parallelization factors of the shared engines
+// The convolution, max-pooling, and batch normalization engines are
+// parallelized over the channels, and the fully-connected engine is
+// parallelized over the input dimensions
+constexpr int kConvB = kOverlayConvB;
+constexpr int kLinearB = kOverlayLinearB;
+
+// Partition factor of the feature map memory
+// Each engine reads and writes the same memory, and the batch normalization
+// engine reads and writes `B` channels in the same cycle
+// The vector memory and the weight memory of the fully-connected engine
+// hold `kLinearB` elements per row, and their second dimension is
+// completely partitioned, so that the engine reads a row per cycle from
+// any offset in the program (see `LinearOverlay`)
+constexpr int kFmapFactor = CyclicPartition<kMaxC,
+  BatchNorm2dReLUOverlayPorts<kConvB>::kOutput +
+  BatchNorm2dReLUOverlayPorts<kConvB>::kInput,
+  MaxPool2dOverlayPorts<kConvB>::kInput>::kFactor;
+
+// Partition factors of the model parameters
+constexpr int kConvWeightFactor = CyclicPartition<kMaxC,
+  ReadArrayPorts::kOutput,
+  Conv2dOverlayPorts<kConvB>::kWeight>::kFactor;
+constexpr int kBnParamsFactor = CyclicPartition<kMaxC,
+  ReadArrayPorts::kOutput,
+  BatchNorm2dReLUOverlayPorts<kConvB>::kParams>::kFactor;
+
+void InferenceOverlayCore(
+  hls::stream<axi_stream_data_t>& in_stream,
+  hls::stream<axi_stream_data_t>& out_stream,
+  const int num_samples,
+  const OverlayInstruction program[kMaxInstructions],
+  const fixed_t conv_weight[kMaxC][kMaxConvWeightCols],
+  const fixed_t bn_scale[kMaxBnLayers][kMaxC],
+  const fixed_t bn_bias[kMaxBnLayers][kMaxC],
+  const fixed_t bn_mean[kMaxBnLayers][kMaxC],
+  const fixed_t fc_weight[kLinearWeightSize / kLinearB][kLinearB],
+  const fixed_t fc_bias[kLinearBiasSize])
+{
+#pragma HLS INLINE off
+
+  // Each engine has a single call site, so that one datapath is
+  // time-multiplexed over all layers of the same type
+
+  // Feature map memory (input, convolution, max-pooling, and batch
+  // normalization layers) and vector memory (flatten and fully-connected
+  // layers), which are addressed by the instructions
+  fixed_t fmap[kMaxC][kFmapSize];
+  fixed_t vec[kVecSize / kLinearB][kLinearB];
+
+#pragma HLS ARRAY_PARTITION variable=fmap dim=1 factor=kFmapFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=vec dim=2 complete
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS PIPELINE off
+    for (int pc = 0; pc < kMaxInstructions; ++pc) {
+#pragma HLS PIPELINE off
+      // Runtime shape registers
+      const OverlayInstruction inst = program[pc];
+
+      if (inst.opcode == kOpEnd)
+        break;
+
+      switch (inst.opcode) {
+        case kOpInput:
+          ReadDynamicArray2d<kMaxC, kFmapSize>(
+            fmap, inst.dst, inst.in_ch, inst.h * inst.w, in_stream);
+          break;
+        case kOpConv2d:
+          Conv2dOverlay<kMaxC, kFmapSize, kMaxConvWeightCols,
+                        kMaxK, kConvB>(
+            fmap, conv_weight, inst.src, inst.dst, inst.in_ch, inst.out_ch,
+            inst.h, inst.w, inst.oh, inst.ow, inst.k, inst.pad, inst.stride,
+            inst.param_offset);
+          break;
+        case kOpMaxPool2d:
+          MaxPool2dOverlay<kMaxC, kFmapSize, kMaxK, kConvB>(
+            fmap, inst.src, inst.dst, inst.in_ch, inst.h, inst.w, inst.k);
+          break;
+        case kOpBatchNorm2dReLU:
+          BatchNorm2dReLUOverlay<kMaxBnLayers, kMaxC, kFmapSize, kConvB>(
+            fmap, bn_scale, bn_bias, bn_mean, inst.src, inst.dst,
+            inst.param_offset, inst.in_ch, inst.h * inst.w);
+          break;
+        case kOpFlatten:
+          Flatten2dOverlay<kMaxC, kFmapSize, kVecSize, kLinearB>(
+            fmap, vec, inst.src, inst.dst, inst.in_ch, inst.h * inst.w);
+          break;
+        case kOpLinear:
+          LinearOverlay<kVecSize, kMaxDims, kMaxDims, kLinearWeightSize,
+                        kLinearBiasSize, kLinearB>(
+            vec, fc_weight, fc_bias, inst.src, inst.dst,
+            inst.param_offset, inst.bias_offset, inst.in_stride,
+            inst.out_ch, (inst.flags & kFlagReLU) != 0);
+          break;
+        case kOpOutput:
+          WriteOverlayVector<kVecSize, kLinearB>(
+            vec, inst.src, inst.in_ch, out_stream);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+}
+
+void InferenceOverlay(hls::stream<axi_stream_data_t>& in_stream,
+                      hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INTERFACE axis register_mode=both register port=in_stream
+#pragma HLS INTERFACE axis register_mode=both register port=out_stream
+#pragma HLS INTERFACE s_axilite port=return bundle=control
+
+  // Instruction-driven implementation (overlay)
+  // The network is described by the program loaded with the weights, and
+  // each layer is run on the shared engine of the same type, so that the
+  // networks within the capacity can be changed without resynthesis
+
+  // Program and model parameters
+  static OverlayInstruction program[kMaxInstructions];
+
+  static fixed_t conv_weight[kMaxC][kMaxConvWeightCols];
+  static fixed_t bn_scale[kMaxBnLayers][kMaxC];
+  static fixed_t bn_bias[kMaxBnLayers][kMaxC];
+  static fixed_t bn_mean[kMaxBnLayers][kMaxC];
+  static fixed_t fc_weight[kLinearWeightSize / kLinearB][kLinearB];
+  static fixed_t fc_bias[kLinearBiasSize];
+
+#pragma HLS ARRAY_PARTITION variable=conv_weight dim=1 factor=kConvWeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn_scale dim=2 factor=kBnParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn_bias dim=2 factor=kBnParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn_mean dim=2 factor=kBnParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc_weight dim=2 complete
+
+  axi_stream_data_t in_data;
+  in_data = in_stream.read();
+  const int mode = static_cast<int>(in_data.data.to_int());
+
+  if (mode == kModeInitWeights) {
+    // Read the program (number of instructions followed by the
+    // instructions) and append the end marker
+    // The number of instructions is clamped, so that the program and the
+    // end marker fit in the instruction memory (the host-side compiler
+    // rejects the longer programs)
+    in_data = in_stream.read();
+    const int num_requested = static_cast<int>(in_data.data.to_int());
+    const int num_instructions = num_requested < 0 ? 0 :
+      num_requested < kMaxInstructions ? num_requested :
+      kMaxInstructions - 1;
+
+    for (int pc = 0; pc < num_instructions; ++pc) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxInstructions
+#pragma HLS PIPELINE off
+      program[pc] = ReadOverlayInstruction(in_stream);
+    }
+
+    program[num_instructions].opcode = kOpEnd;
+
+    // Read the model parameters in the order of the instructions
+    for (int pc = 0; pc < num_instructions; ++pc) {
+#pragma HLS LOOP_TRIPCOUNT max=kMaxInstructions
+#pragma HLS PIPELINE off
+      const OverlayInstruction inst = program[pc];
+
+      if (inst.opcode == kOpConv2d) {
+        ReadDynamicConv2dParams<kMaxC, kMaxConvWeightCols>(
+          conv_weight, inst.param_offset, inst.out_ch,
+          inst.in_ch * inst.k * inst.k, in_stream);
+      } else if (inst.opcode == kOpBatchNorm2dReLU) {
+        ReadDynamicBatchNorm2dParams<kMaxBnLayers, kMaxC>(
+          bn_scale, bn_bias, bn_mean, inst.param_offset, inst.in_ch,
+          in_stream);
+      } else if (inst.opcode == kOpLinear) {
+        ReadOverlayLinearParams<kLinearWeightSize, kLinearBiasSize,
+                                kMaxDims, kLinearB>(
+          fc_weight, fc_bias, inst.param_offset, inst.bias_offset,
+          inst.in_ch, inst.in_stride, inst.out_ch, in_stream);
+      }
+    }
+
+    // Write the acknowledgment message
+    WriteAck(out_stream);
+  } else if (mode == kModeInference) {
+    // Get the number of samples
+    in_data = in_stream.read();
+    const int num_samples = static_cast<int>(in_data.data.to_int());
+
+    InferenceOverlayCore(in_stream, out_stream, num_samples, program,
+      conv_weight, bn_scale, bn_bias, bn_mean, fc_weight, fc_bias);
+  }
+}
@@ -0,0 +1,184 @@
+
+// top_profile.cpp
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_transfer.hpp"
+#include "data_types.hpp"
+#include "depthwise_conv_2d.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+#include "opt3_plan.hpp"
+#include "profile.hpp"
+
+// Stages of the dataflow region (input, 10 layers, and output)
+constexpr int kNumStages = 12;
+using Counters = ProfileCounters<kNumStages>;
+
+void InferenceProfileCore(hls::stream<axi_stream_data_t>& in_stream,
+                          hls::stream<axi_stream_data_t>& out_stream,
+                          const int num_samples,
+                          cycle_count_t counters[Counters::kNum],
+                          const fixed_t conv0_weight[6][1][5][5],
+                          const fixed_t bn0_scale[6],
+                          const fixed_t bn0_bias[6],
+                          const fixed_t bn0_mean[6],
+                          const fixed_t conv1_weight[16][6][5][5],
+                          const fixed_t bn1_scale[16],
+                          const fixed_t bn1_bias[16],
+                          const fixed_t bn1_mean[16],
+                          const fixed_t fc0_weight[120][400],
+                          const fixed_t fc0_bias[120],
+                          const fixed_t fc1_weight[84][120],
+                          const fixed_t fc1_bias[84],
+                          const fixed_t fc2_weight[10][84],
+                          const fixed_t fc2_bias[10])
+{
+#pragma HLS INLINE off
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS DATAFLOW
+
+#pragma HLS STABLE variable=conv0_weight
+#pragma HLS STABLE variable=bn0_scale
+#pragma HLS STABLE variable=bn0_bias
+#pragma HLS STABLE variable=bn0_mean
+#pragma HLS STABLE variable=conv1_weight
+#pragma HLS STABLE variable=bn1_scale
+#pragma HLS STABLE variable=bn1_bias
+#pragma HLS STABLE variable=bn1_mean
+#pragma HLS STABLE variable=fc0_weight
+#pragma HLS STABLE variable=fc0_bias
+#pragma HLS STABLE variable=fc1_weight
+#pragma HLS STABLE variable=fc1_bias
+#pragma HLS STABLE variable=fc2_weight
+#pragma HLS STABLE variable=fc2_bias
+
+    // Input, output, and intermediate results
+    fixed_t x0[1][28][28];
+    fixed_t x1[6][28][28];
+    fixed_t x2[6][14][14];
+    fixed_t x3[6][14][14];
+    fixed_t x4[16][10][10];
+    fixed_t x5[16][5][5];
+    fixed_t x6[16][5][5];
+    fixed_t x7[400];
+    fixed_t x8[120];
+    fixed_t x9[84];
+    fixed_t x10[10];
+
+    // Completion of the stages
+    hls::stream<stage_event_t> events[kNumStages];
+
+#pragma HLS ARRAY_PARTITION variable=x1 dim=1 factor=kX1Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x2 dim=1 factor=kX2Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x3 dim=1 factor=kX3Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x4 dim=1 factor=kX4Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x5 dim=1 factor=kX5Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x6 dim=1 factor=kX6Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x7 dim=1 factor=kX7Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x8 dim=1 factor=kX8Factor cyclic
+#pragma HLS ARRAY_PARTITION variable=x9 dim=1 factor=kX9Factor cyclic
+
+    // Read the input
+    ReadArray3dProfile<1, 28, 28>(x0, in_stream, events[0]);
+
+    // Inference
+    Conv2d4Stage<1, 6, 28, 28, 28, 28, 5, 2, 1, kConv0B>(
+      x0, x1, conv0_weight, events[1]);
+    MaxPool2d3Stage<6, 28, 28, 2, kConv0B>(x1, x2, events[2]);
+    BatchNorm2dReLU3Stage<6, 14, 14, kConv0B>(
+      x2, x3, bn0_scale, bn0_bias, bn0_mean, events[3]);
+    Conv2d4Stage<6, 16, 14, 14, 10, 10, 5, 0, 1, kConv1B>(
+      x3, x4, conv1_weight, events[4]);
+    MaxPool2d3Stage<16, 10, 10, 2, kConv1B>(x4, x5, events[5]);
+    BatchNorm2dReLU3Stage<16, 5, 5, kConv1B>(
+      x5, x6, bn1_scale, bn1_bias, bn1_mean, events[6]);
+    Flatten3dStage<16, 5, 5>(x6, x7, events[7]);
+    Linear3Stage<400, 120, true, kFc0B>(
+      x7, fc0_weight, fc0_bias, x8, events[8]);
+    Linear3Stage<120, 84, true, kFc1B>(
+      x8, fc1_weight, fc1_bias, x9, events[9]);
+    Linear3Stage<84, 10, false, kFc2B>(
+      x9, fc2_weight, fc2_bias, x10, events[10]);
+
+    // Write the output
+    WriteArray1dProfile<10>(x10, out_stream, events[11]);
+
+    // Count the cycles of the stages
+    MonitorStages<kNumStages>(events, counters);
+  }
+}
+
+void InferenceProfile(hls::stream<axi_stream_data_t>& in_stream,
+                      hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INTERFACE axis register_mode=both register port=in_stream
+#pragma HLS INTERFACE axis register_mode=both register port=out_stream
+#pragma HLS INTERFACE s_axilite port=return bundle=control
+
+  // Same as `InferenceOpt3`, except that the stages of the dataflow region
+  // are profiled with the cycle counters
+
+  // Model parameters
+  static fixed_t conv0_weight[6][1][5][5];
+  static fixed_t bn0_scale[6], bn0_bias[6], bn0_mean[6];
+  static fixed_t conv1_weight[16][6][5][5];
+  static fixed_t bn1_scale[16], bn1_bias[16], bn1_mean[16];
+  static fixed_t fc0_weight[120][400], fc0_bias[120];
+  static fixed_t fc1_weight[84][120], fc1_bias[84];
+  static fixed_t fc2_weight[10][84], fc2_bias[10];
+
+  // Cycle counters accumulated over the samples of the request
+  cycle_count_t counters[Counters::kNum];
+
+#pragma HLS ARRAY_PARTITION variable=conv0_weight dim=1 factor=kConv0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_scale dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_bias dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn0_mean dim=1 factor=kBn0ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=conv1_weight dim=1 factor=kConv1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_scale dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_bias dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn1_mean dim=1 factor=kBn1ParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc0_weight dim=2 factor=kFc0WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc1_weight dim=2 factor=kFc1WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc2_weight dim=2 factor=kFc2WeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=counters dim=1 complete
+
+  axi_stream_data_t in_data;
+  in_data = in_stream.read();
+  const int mode = static_cast<int>(in_data.data.to_int());
+
+  if (mode == kModeInitWeights) {
+    // Read the model parameters
+    ReadConv2dParams<1, 6, 5>(conv0_weight, in_stream);
+    ReadBatchNorm2dParams<6>(bn0_scale, bn0_bias, bn0_mean, in_stream);
+    ReadConv2dParams<6, 16, 5>(conv1_weight, in_stream);
+    ReadBatchNorm2dParams<16>(bn1_scale, bn1_bias, bn1_mean, in_stream);
+    ReadLinearParams<400, 120>(fc0_weight, fc0_bias, in_stream);
+    ReadLinearParams<120, 84>(fc1_weight, fc1_bias, in_stream);
+    ReadLinearParams<84, 10>(fc2_weight, fc2_bias, in_stream);
+
+    // Write the acknowledgment message
+    WriteAck(out_stream);
+  } else if (mode == kModeInference || mode == kModeProfile) {
+    // Get the number of samples
+    in_data = in_stream.read();
+    const int num_samples = static_cast<int>(in_data.data.to_int());
+
+    for (int i = 0; i < Counters::kNum; ++i)
+#pragma HLS UNROLL
+      counters[i] = 0;
+
+    InferenceProfileCore(in_stream, out_stream, num_samples, counters,
+      conv0_weight, bn0_scale, bn0_bias, bn0_mean,
+      conv1_weight, bn1_scale, bn1_bias, bn1_mean,
+      fc0_weight, fc0_bias, fc1_weight, fc1_bias,
+      fc2_weight, fc2_bias);
+
+    // Write the counters after the outputs
+    if (mode == kModeProfile)
+      WriteCounters<Counters::kNum>(counters, out_stream);
+  }
+}
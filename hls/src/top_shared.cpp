@@ -0,0 +1,268 @@
+// top_shared.cpp
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "data_transfer.hpp"
+#include "data_types.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "max_pool_2d.hpp"
+#include "partition_plan.hpp"
+#include "toynet_plan.hpp"
+
+// Shapes of the convolution blocks (convolution, max-pooling, batch
+// normalization, and ReLU), which are sequenced over the shared engines
+struct ConvBlockShape
+{
+  int in_ch;
+  int out_ch;
+  int h;
+  int w;
+  int oh;
+  int ow;
+  int pad;
+  int weight_offset;
+};
+
+// Shapes of the fully-connected layers, which are sequenced over the
+// shared engine
+struct LinearShape
+{
+  int in_dims;
+  int in_stride;
+  int out_dims;
+  int weight_offset;
+  int bias_offset;
+  bool apply_relu;
+};
+
+constexpr int kNumConvBlocks = 2;
+constexpr int kNumLinearLayers = 3;
+
+constexpr ConvBlockShape kConvBlocks[kNumConvBlocks] = {
+  { 1, 6, 28, 28, 28, 28, 2, 0 },
+  { 6, 16, 14, 14, 10, 10, 0, 1 * 5 * 5 },
+};
+
+constexpr LinearShape kLinearLayers[kNumLinearLayers] = {
+  { 400, 400, 120, 0, 0, true },
+  { 120, 128, 84, 120 * 400, 120, true },
+  { 84, 96, 10, 120 * 400 + 84 * 128, 120 + 84, false },
+};
+
+// Kernel size of the convolution and max-pooling layers
+constexpr int kConvK = 5;
+constexpr int kPoolK = 2;
+
+// Maximum sizes of the buffers shared by all layers
+constexpr int kMaxC = 16;
+constexpr int kMaxHW = 28 * 28;
+constexpr int kMaxPoolHW = 14 * 14;
+constexpr int kMaxDims = 400;
+constexpr int kConvWeightCols = 1 * 5 * 5 + 6 * 5 * 5;
+constexpr int kLinearWeightSize = 120 * 400 + 84 * 128 + 10 * 96;
+constexpr int kLinearBiasSize = 120 + 84 + 10;
+
+// Parallelization factors of the shared engines
+// The convolution, max-pooling, and batch normalization engines are
+// parallelized over the channels, and the fully-connected engine is
+// parallelized over the input dimensions
+constexpr int kConvB = kSharedConvB;
+constexpr int kLinearB = kSharedLinearB;
+
+// Shape of the input of the first fully-connected layer (output of the
+// last convolution block)
+constexpr int kFlattenC = kConvBlocks[kNumConvBlocks - 1].out_ch;
+constexpr int kFlattenHW = (kConvBlocks[kNumConvBlocks - 1].oh / kPoolK) *
+  (kConvBlocks[kNumConvBlocks - 1].ow / kPoolK);
+
+static_assert(kFlattenC * kFlattenHW == kLinearLayers[0].in_dims,
+              "Output of the last convolution block must be the input of "
+              "the first fully-connected layer");
+static_assert(kLinearLayers[0].in_stride % kLinearB == 0 &&
+              kLinearLayers[1].in_stride % kLinearB == 0 &&
+              kLinearLayers[2].in_stride % kLinearB == 0,
+              "Rows of the weights must be padded to a multiple of `B`");
+static_assert(kLinearLayers[0].weight_offset % kLinearB == 0 &&
+              kLinearLayers[1].weight_offset % kLinearB == 0 &&
+              kLinearLayers[2].weight_offset % kLinearB == 0,
+              "Weights of each layer must be aligned to `B`");
+
+// Partition factors of the buffers
+constexpr int kInputFactor = CyclicPartition<kMaxC,
+  BatchNorm2dReLUDynamicPorts<kConvB>::kOutput,
+  Conv2dDynamicPorts<kConvB>::kInput>::kFactor;
+constexpr int kConvOutFactor = CyclicPartition<kMaxC,
+  Conv2dDynamicPorts<kConvB>::kOutput,
+  MaxPool2dDynamicPorts<kConvB>::kInput>::kFactor;
+constexpr int kPoolOutFactor = CyclicPartition<kMaxC,
+  MaxPool2dDynamicPorts<kConvB>::kOutput,
+  BatchNorm2dReLUDynamicPorts<kConvB>::kInput>::kFactor;
+constexpr int kVectorFactor = CyclicPartition<kMaxDims,
+  Flatten2dDynamicPorts::kOutput,
+  LinearDynamicPorts<kLinearB>::kInput>::kFactor;
+constexpr int kConvWeightFactor = CyclicPartition<kMaxC,
+  ReadArrayPorts::kOutput,
+  Conv2dDynamicPorts<kConvB>::kWeight>::kFactor;
+constexpr int kBnParamsFactor = CyclicPartition<kMaxC,
+  ReadArrayPorts::kOutput,
+  BatchNorm2dReLUDynamicPorts<kConvB>::kParams>::kFactor;
+constexpr int kLinearWeightFactor = CyclicPartition<kLinearWeightSize,
+  ReadArrayPorts::kOutput,
+  LinearDynamicPorts<kLinearB>::kWeight>::kFactor;
+
+template <int D0, int D1>
+void CopyArray1dDynamic(const fixed_t x[D0],
+                        fixed_t y[D1],
+                        const int dims)
+{
+#pragma HLS INLINE off
+  for (int i = 0; i < dims; ++i) {
+#pragma HLS LOOP_TRIPCOUNT max=D1
+#pragma HLS PIPELINE II=1
+    y[i] = x[i];
+  }
+}
+
+void InferenceSharedCore(
+  hls::stream<axi_stream_data_t>& in_stream,
+  hls::stream<axi_stream_data_t>& out_stream,
+  const int num_samples,
+  const fixed_t conv_weight[kMaxC][kConvWeightCols],
+  const fixed_t bn_scale[kNumConvBlocks][kMaxC],
+  const fixed_t bn_bias[kNumConvBlocks][kMaxC],
+  const fixed_t bn_mean[kNumConvBlocks][kMaxC],
+  const fixed_t fc_weight[kLinearWeightSize],
+  const fixed_t fc_bias[kLinearBiasSize])
+{
+#pragma HLS INLINE off
+
+  // Each engine has a single call site, so that one datapath is
+  // time-multiplexed over all layers of the same type
+
+  // Inputs and outputs of the engines
+  // `x_in` holds the input of each convolution block (x0, x3, x6)
+  // `x_conv` holds the output of the convolution (x1, x4)
+  // `x_pool` holds the output of the max-pooling (x2, x5)
+  fixed_t x_in[kMaxC][kMaxHW];
+  fixed_t x_conv[kMaxC][kMaxHW];
+  fixed_t x_pool[kMaxC][kMaxPoolHW];
+  // `x_vec` holds the input of each fully-connected layer (x7, x8, x9)
+  // `y_vec` holds the output of each fully-connected layer (x8, x9, x10)
+  fixed_t x_vec[kMaxDims];
+  fixed_t y_vec[kMaxDims];
+  fixed_t x10[10];
+
+#pragma HLS ARRAY_PARTITION variable=x_in dim=1 factor=kInputFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=x_conv dim=1 factor=kConvOutFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=x_pool dim=1 factor=kPoolOutFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=x_vec dim=1 factor=kVectorFactor cyclic
+
+  for (int i = 0; i < num_samples; ++i) {
+#pragma HLS PIPELINE off
+
+    // Read the input
+    ReadArray2d<1, 28 * 28>(x_in, in_stream);
+
+    // Convolution blocks
+    for (int l = 0; l < kNumConvBlocks; ++l) {
+#pragma HLS PIPELINE off
+      // Runtime shape registers
+      const ConvBlockShape shape = kConvBlocks[l];
+
+      Conv2dDynamic<kMaxC, kMaxC, kMaxHW, kMaxHW, kConvWeightCols,
+                    kConvK, kConvB>(
+        x_in, x_conv, conv_weight, shape.weight_offset,
+        shape.in_ch, shape.out_ch, shape.h, shape.w,
+        shape.oh, shape.ow, shape.pad);
+      MaxPool2dDynamic<kMaxC, kMaxHW, kMaxPoolHW, kPoolK, kConvB>(
+        x_conv, x_pool, shape.out_ch, shape.oh, shape.ow);
+      BatchNorm2dReLUDynamic<kNumConvBlocks, kMaxC, kMaxPoolHW, kMaxHW,
+                             kConvB>(
+        x_pool, x_in, bn_scale, bn_bias, bn_mean, l, shape.out_ch,
+        (shape.oh / kPoolK) * (shape.ow / kPoolK));
+    }
+
+    Flatten2dDynamic<kMaxC, kMaxHW, kMaxDims>(
+      x_in, x_vec, kFlattenC, kFlattenHW);
+
+    // Fully-connected layers
+    for (int l = 0; l < kNumLinearLayers; ++l) {
+#pragma HLS PIPELINE off
+      // Runtime shape registers
+      const LinearShape shape = kLinearLayers[l];
+
+      LinearDynamic<kMaxDims, kMaxDims, kLinearWeightSize,
+                    kLinearBiasSize, kLinearB>(
+        x_vec, fc_weight, fc_bias, y_vec,
+        shape.weight_offset, shape.bias_offset,
+        shape.in_stride, shape.out_dims, shape.apply_relu);
+      CopyArray1dDynamic<kMaxDims, kMaxDims>(y_vec, x_vec, shape.out_dims);
+    }
+
+    // Write the output
+    CopyArray1dDynamic<kMaxDims, 10>(x_vec, x10, 10);
+    WriteArray1d<10>(x10, out_stream);
+  }
+}
+
+void InferenceShared(hls::stream<axi_stream_data_t>& in_stream,
+                     hls::stream<axi_stream_data_t>& out_stream)
+{
+#pragma HLS INTERFACE axis register_mode=both register port=in_stream
+#pragma HLS INTERFACE axis register_mode=both register port=out_stream
+#pragma HLS INTERFACE s_axilite port=return bundle=control
+
+  // Resource-shared implementation for small devices (e.g., xc7z020)
+  // A single convolution, max-pooling, batch normalization, and
+  // fully-connected engine is sequenced over all layers
+
+  // Model parameters
+  static fixed_t conv_weight[kMaxC][kConvWeightCols];
+  static fixed_t bn_scale[kNumConvBlocks][kMaxC];
+  static fixed_t bn_bias[kNumConvBlocks][kMaxC];
+  static fixed_t bn_mean[kNumConvBlocks][kMaxC];
+  static fixed_t fc_weight[kLinearWeightSize];
+  static fixed_t fc_bias[kLinearBiasSize];
+
+#pragma HLS ARRAY_PARTITION variable=conv_weight dim=1 factor=kConvWeightFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn_scale dim=2 factor=kBnParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn_bias dim=2 factor=kBnParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=bn_mean dim=2 factor=kBnParamsFactor cyclic
+#pragma HLS ARRAY_PARTITION variable=fc_weight dim=1 factor=kLinearWeightFactor cyclic
+
+  axi_stream_data_t in_data;
+  in_data = in_stream.read();
+  const int mode = static_cast<int>(in_data.data.to_int());
+
+  if (mode == kModeInitWeights) {
+    // Read the model parameters in the same order as `InferenceOpt3`
+    for (int l = 0; l < kNumConvBlocks; ++l) {
+#pragma HLS PIPELINE off
+      const ConvBlockShape shape = kConvBlocks[l];
+      ReadDynamicConv2dParams<kMaxC, kConvWeightCols>(
+        conv_weight, shape.weight_offset, shape.out_ch,
+        shape.in_ch * kConvK * kConvK, in_stream);
+      ReadDynamicBatchNorm2dParams<kNumConvBlocks, kMaxC>(
+        bn_scale, bn_bias, bn_mean, l, shape.out_ch, in_stream);
+    }
+
+    for (int l = 0; l < kNumLinearLayers; ++l) {
+#pragma HLS PIPELINE off
+      const LinearShape shape = kLinearLayers[l];
+      ReadDynamicLinearParams<kLinearWeightSize, kLinearBiasSize, kMaxDims>(
+        fc_weight, fc_bias, shape.weight_offset, shape.bias_offset,
+        shape.in_dims, shape.in_stride, shape.out_dims, in_stream);
+    }
+
+    // Write the acknowledgment message
+    WriteAck(out_stream);
+  } else if (mode == kModeInference) {
+    // Get the number of samples
+    in_data = in_stream.read();
+    const int num_samples = static_cast<int>(in_data.data.to_int());
+
+    InferenceSharedCore(in_stream, out_stream, num_samples,
+      conv_weight, bn_scale, bn_bias, bn_mean, fc_weight, fc_bias);
+  }
+}
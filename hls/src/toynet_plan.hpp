@@ -0,0 +1,67 @@
+// toynet_plan.hpp
+
+#ifndef TOYNET_TOYNET_PLAN_HPP
+#define TOYNET_TOYNET_PLAN_HPP
+
+// Parallelization and partition factors chosen for the tops, which are
+// shared by the tops and the reports in host/model
+// (toynet_cost_report.cpp and toynet_resource_report.cpp), so that the
+// reports follow the tops when they are changed
+// The partition factors derived from these are in the tops (and in
+// opt3_plan.hpp)
+
+// Parallelization factors of the layers in `InferenceOpt3` (and the tops
+// built on the same pipeline), `InferencePacked`, and `InferenceDualMac`
+constexpr int kOpt3Conv0B = 6;
+constexpr int kOpt3Conv1B = 16;
+constexpr int kOpt3Fc0B = 16;
+constexpr int kOpt3Fc1B = 8;
+constexpr int kOpt3Fc2B = 4;
+
+// Parallelization factors of the depthwise separable convolution in
+// `InferenceDwSep` (the other layers are the same as in `InferenceOpt3`)
+constexpr int kDwSepDwConv1B = 6;
+constexpr int kDwSepPwConv1BI = 2;
+constexpr int kDwSepPwConv1BO = 16;
+
+// Parallelization factors of the layers in `InferenceLog`
+// The shift-add datapaths use no DSPs, so the fully-connected layers are
+// unrolled further than in `InferenceOpt3`
+constexpr int kLogConv0B = 6;
+constexpr int kLogConv1B = 16;
+constexpr int kLogFc0B = 40;
+constexpr int kLogFc1B = 24;
+constexpr int kLogFc2B = 12;
+
+// Partition factors of `InferenceOpt` and `InferenceOpt2`, which are chosen
+// by hand; the feature maps and parameters are partitioned by the factor of
+// the layer that reads them
+constexpr int kOptConv0Factor = 3;
+constexpr int kOptConv1Factor = 8;
+constexpr int kOptFc0Factor = 8;
+constexpr int kOptFc1Factor = 4;
+constexpr int kOptFc2Factor = 2;
+
+// Parallelization factors of the shared engines in `InferenceShared` and
+// `InferenceOverlay`
+constexpr int kSharedConvB = 16;
+constexpr int kSharedLinearB = 16;
+constexpr int kOverlayConvB = 16;
+constexpr int kOverlayLinearB = 16;
+
+// Number of the replicated cores in `InferenceMulti` (`NUM_CORES`
+// overrides it)
+#ifdef NUM_CORES
+constexpr int kMultiNumCores = NUM_CORES;
+#else
+constexpr int kMultiNumCores = 2;
+#endif // NUM_CORES
+
+// Tile sizes of the output and parallelization factor of
+// `InferenceConvTiled`
+constexpr int kConvTiledTileH = 28;
+constexpr int kConvTiledTileW = 28;
+constexpr int kConvTiledTileOutCh = 16;
+constexpr int kConvTiledB = 16;
+
+#endif // TOYNET_TOYNET_PLAN_HPP
@@ -0,0 +1,255 @@
+// toynet_cpu_server.cpp
+
+#include "toynet_cpu_server.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// Mean and standard deviation of the MNIST dataset (same as the
+// `Normalize` transform in the Python host programs)
+constexpr float kMnistMean = 0.1307f;
+constexpr float kMnistStd = 0.3081f;
+
+// Normalize the 8-bit pixels
+void NormalizePixels(float* images, const std::uint8_t* pixels,
+                     std::size_t len)
+{
+  for (std::size_t i = 0; i < len; ++i)
+    images[i] = (static_cast<float>(pixels[i]) / 255.0f - kMnistMean)
+                / kMnistStd;
+}
+
+// Check the number of images and return the number of samples
+std::size_t NumSamples(std::size_t num_elements)
+{
+  if (num_elements % ToyNetCpuServer::kInputSize != 0)
+    throw std::invalid_argument("Images are not a multiple of the input size");
+
+  return num_elements / ToyNetCpuServer::kInputSize;
+}
+
+} // namespace
+
+constexpr std::size_t ToyNetCpuServer::kInputSize;
+constexpr std::size_t ToyNetCpuServer::kOutputSize;
+constexpr std::size_t ToyNetCpuServer::kNumParams;
+constexpr std::size_t ToyNetCpuServer::kTaskSize;
+
+ToyNetCpuServer::ToyNetCpuServer(std::size_t num_threads) :
+  num_queued_(0), num_unfinished_(0), next_worker_(0), stop_(false)
+{
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (std::size_t i = 0; i < num_threads; ++i)
+    workers_.emplace_back(new Worker());
+
+  // The workers are started after all queues are created, as they steal
+  // from each other
+  for (std::size_t i = 0; i < num_threads; ++i)
+    workers_[i]->thread = std::thread(&ToyNetCpuServer::RunWorker, this, i);
+}
+
+ToyNetCpuServer::~ToyNetCpuServer()
+{
+  // Pending requests are processed before stopping
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+
+  task_cond_.notify_all();
+
+  for (auto& worker : workers_)
+    worker->thread.join();
+}
+
+void ToyNetCpuServer::InitWeights(const std::vector<float>& params)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The parameters are read by the running tasks without the lock
+  idle_cond_.wait(lock, [this] { return num_unfinished_ == 0; });
+  model_.InitWeights(params);
+}
+
+void ToyNetCpuServer::Infer(const float* images,
+                            std::size_t num_samples,
+                            float* outputs)
+{
+  // The caller's buffers are valid until the request completes
+  auto request = std::make_shared<Request>();
+  request->images = images;
+  request->pixels = nullptr;
+  request->outputs = outputs;
+  this->Enqueue(std::move(request), num_samples).get();
+}
+
+std::vector<float> ToyNetCpuServer::Infer(const std::vector<float>& images)
+{
+  const std::size_t num_samples = NumSamples(images.size());
+  std::vector<float> outputs(num_samples * kOutputSize);
+  this->Infer(images.data(), num_samples, outputs.data());
+  return outputs;
+}
+
+std::future<std::vector<float>> ToyNetCpuServer::Submit(
+  std::vector<float> images)
+{
+  const std::size_t num_samples = NumSamples(images.size());
+  // Move the images into the request, which outlives the caller's buffer
+  auto request = std::make_shared<Request>();
+  request->image_storage = std::move(images);
+  request->output_storage.resize(num_samples * kOutputSize);
+  request->images = request->image_storage.data();
+  request->pixels = nullptr;
+  request->outputs = request->output_storage.data();
+  return this->Enqueue(std::move(request), num_samples);
+}
+
+std::future<std::vector<float>> ToyNetCpuServer::Submit(
+  std::vector<std::uint8_t> images)
+{
+  const std::size_t num_samples = NumSamples(images.size());
+  auto request = std::make_shared<Request>();
+  request->pixel_storage = std::move(images);
+  request->output_storage.resize(num_samples * kOutputSize);
+  request->images = nullptr;
+  request->pixels = request->pixel_storage.data();
+  request->outputs = request->output_storage.data();
+  return this->Enqueue(std::move(request), num_samples);
+}
+
+std::future<std::vector<float>> ToyNetCpuServer::Enqueue(
+  std::shared_ptr<Request> request,
+  std::size_t num_samples)
+{
+  std::future<std::vector<float>> result = request->promise.get_future();
+  const std::size_t num_tasks = (num_samples + kTaskSize - 1) / kTaskSize;
+
+  if (num_tasks == 0) {
+    request->promise.set_value(std::move(request->output_storage));
+    return result;
+  }
+
+  request->num_remaining = num_tasks;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_)
+      throw std::runtime_error("Server is stopped");
+
+    num_queued_ += num_tasks;
+    num_unfinished_ += num_tasks;
+
+    // Distribute the tasks to the queues in turn
+    for (std::size_t i = 0; i < num_tasks; ++i) {
+      Worker& worker = *workers_[next_worker_];
+      next_worker_ = (next_worker_ + 1) % workers_.size();
+
+      const std::size_t begin = i * kTaskSize;
+      const std::size_t end = std::min(begin + kTaskSize, num_samples);
+      std::lock_guard<std::mutex> worker_lock(worker.mutex);
+      worker.tasks.push_back(Task { request, begin, end });
+    }
+  }
+
+  task_cond_.notify_all();
+  return result;
+}
+
+bool ToyNetCpuServer::TakeTask(std::size_t id, Task& task)
+{
+  {
+    Worker& worker = *workers_[id];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      --num_queued_;
+      return true;
+    }
+  }
+
+  // Steal from the other workers, starting from the next one
+  for (std::size_t i = 1; i < workers_.size(); ++i) {
+    Worker& victim = *workers_[(id + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      --num_queued_;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ToyNetCpuServer::RunTask(const Task& task,
+                              ToyNetFloatModel::Workspace& workspace)
+{
+  Request& request = *task.request;
+  const std::size_t num_samples = task.end - task.begin;
+
+  try {
+    const float* images = request.images + task.begin * kInputSize;
+
+    if (request.pixels != nullptr) {
+      NormalizePixels(workspace.x0, request.pixels + task.begin * kInputSize,
+                      num_samples * kInputSize);
+      images = workspace.x0;
+    }
+
+    model_.Infer(images, num_samples,
+                 request.outputs + task.begin * kOutputSize, workspace);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(request.error_mutex);
+    if (!request.error)
+      request.error = std::current_exception();
+  }
+
+  // The last task completes the request
+  if (--request.num_remaining == 0) {
+    if (request.error)
+      request.promise.set_exception(request.error);
+    else
+      request.promise.set_value(std::move(request.output_storage));
+  }
+}
+
+void ToyNetCpuServer::RunWorker(std::size_t id)
+{
+  // Intermediate results of this worker, allocated by the worker itself
+  // (placed on its NUMA node by the first touch)
+  std::unique_ptr<ToyNetFloatModel::Workspace> workspace(
+    new ToyNetFloatModel::Workspace());
+
+  while (true) {
+    Task task;
+
+    if (!TakeTask(id, task)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_cond_.wait(lock, [this] { return stop_ || num_queued_ > 0; });
+
+      if (stop_ && num_queued_ == 0)
+        return;
+
+      continue;
+    }
+
+    RunTask(task, *workspace);
+    // Release the request before the server becomes idle
+    task.request.reset();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--num_unfinished_ == 0)
+        idle_cond_.notify_all();
+    }
+  }
+}
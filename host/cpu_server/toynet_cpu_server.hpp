@@ -0,0 +1,138 @@
+// toynet_cpu_server.hpp
+
+#ifndef TOYNET_CPU_SERVER_TOYNET_CPU_SERVER_HPP
+#define TOYNET_CPU_SERVER_TOYNET_CPU_SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "toynet_float_model.hpp"
+#include "toynet_inference.hpp"
+
+// Inference server on the CPU with the floating-point model
+// (host/model/toynet_float_model.hpp), which is used in place of the
+// accelerator when it is busy or not available, with the same interface as
+// `ToyNetRuntime` (`ToyNetInference`)
+// Each request is split into the tasks of `kTaskSize` samples, which are
+// distributed to the queues of the worker threads in turn
+// A worker takes the oldest task from its own queue, and steals the newest
+// task from the other queues when its own queue is empty, so that the
+// workers stay busy with the requests of any size
+// Each worker has its own workspace (intermediate results of a task), which
+// is allocated once by the worker, and the workers only share the model
+// parameters (read-only) and the outputs of the requests (disjoint ranges)
+class ToyNetCpuServer : public ToyNetInference
+{
+public:
+  // Number of elements in an input image (1x28x28)
+  static constexpr std::size_t kInputSize = ToyNetFloatModel::kInputSize;
+  // Number of elements in an output (logits for 10 classes)
+  static constexpr std::size_t kOutputSize = ToyNetFloatModel::kOutputSize;
+  // Number of model parameters
+  static constexpr std::size_t kNumParams = ToyNetFloatModel::kNumParams;
+  // Number of samples in a task
+  static constexpr std::size_t kTaskSize = ToyNetFloatModel::kBlockSize;
+
+  // `num_threads` defaults to the number of hardware threads
+  explicit ToyNetCpuServer(std::size_t num_threads = 0);
+  ~ToyNetCpuServer() override;
+
+  ToyNetCpuServer(const ToyNetCpuServer&) = delete;
+  ToyNetCpuServer& operator=(const ToyNetCpuServer&) = delete;
+
+  std::size_t num_threads() const { return workers_.size(); }
+
+  // Set the model parameters, in the same order as the Python host
+  // programs (conv0, bn0, conv1, bn1, linear0, linear1, and linear2)
+  // This waits for the submitted requests to complete
+  void InitWeights(const std::vector<float>& params) override;
+
+  // Run the inference on `num_samples` images (`num_samples` x `kInputSize`)
+  // and write the outputs (`num_samples` x `kOutputSize`)
+  void Infer(const float* images, std::size_t num_samples,
+             float* outputs) override;
+  std::vector<float> Infer(const std::vector<float>& images) override;
+
+  // Submit the inference on the normalized images without blocking
+  // The requests are processed concurrently, and may complete out of the
+  // order of submission
+  std::future<std::vector<float>> Submit(
+    std::vector<float> images) override;
+  // Submit the inference on the 8-bit images (MNIST pixels), which are
+  // normalized by the workers
+  std::future<std::vector<float>> Submit(
+    std::vector<std::uint8_t> images) override;
+
+private:
+  // Submitted request, shared by its tasks
+  struct Request
+  {
+    // Inputs (either of them) and outputs, which point to the storage
+    // below or to the caller's buffers
+    const float* images;
+    const std::uint8_t* pixels;
+    float* outputs;
+
+    std::vector<float> image_storage;
+    std::vector<std::uint8_t> pixel_storage;
+    std::vector<float> output_storage;
+
+    // Number of tasks not yet completed
+    std::atomic<std::size_t> num_remaining;
+    // First error in the tasks
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    std::promise<std::vector<float>> promise;
+  };
+
+  // Samples [`begin`, `end`) of the request
+  struct Task
+  {
+    std::shared_ptr<Request> request;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  // Queue of the worker, where the owner takes the front and the other
+  // workers steal the back
+  struct Worker
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  std::future<std::vector<float>> Enqueue(std::shared_ptr<Request> request,
+                                          std::size_t num_samples);
+  bool TakeTask(std::size_t id, Task& task);
+  void RunTask(const Task& task, ToyNetFloatModel::Workspace& workspace);
+  void RunWorker(std::size_t id);
+
+  ToyNetFloatModel model_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  std::mutex mutex_;
+  // Notified when the tasks are queued or the server is stopped
+  std::condition_variable task_cond_;
+  // Notified when all tasks are completed
+  std::condition_variable idle_cond_;
+  // Number of tasks in the queues (updated before pushing and after
+  // taking the tasks, so that it is never less than the queued tasks)
+  std::atomic<std::size_t> num_queued_;
+  // Number of tasks queued or running (guarded by `mutex_`)
+  std::size_t num_unfinished_;
+  // Queue of the first task of the next request
+  std::size_t next_worker_;
+  bool stop_;
+};
+
+#endif // TOYNET_CPU_SERVER_TOYNET_CPU_SERVER_HPP
@@ -0,0 +1,136 @@
+// toynet_cpu_server_bench.cpp
+
+// Benchmark of the CPU server with the increasing number of threads
+// (1, 2, 4, ..., and the given number of threads), where the requests are
+// submitted at once as in host/runtime/toynet_runtime_bench
+// The outputs are checked against the floating-point model on one thread
+
+// Example:
+// ./toynet_cpu_server_bench [<Number of samples> [<Batch size>
+//   [<Threads>]]]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "toynet_cpu_server.hpp"
+#include "toynet_float_model.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// Submit all batches and wait for the results
+double BenchmarkServer(ToyNetCpuServer& server,
+                       const std::vector<std::uint8_t>& images,
+                       std::size_t batch_size,
+                       std::vector<float>& outputs)
+{
+  const std::size_t batch_len = batch_size * ToyNetCpuServer::kInputSize;
+  std::vector<std::future<std::vector<float>>> results;
+  const auto start = Clock::now();
+
+  for (std::size_t i = 0; i < images.size(); i += batch_len)
+    results.push_back(server.Submit(std::vector<std::uint8_t>(
+      images.begin() + i, images.begin() + i + batch_len)));
+
+  outputs.clear();
+  for (auto& result : results) {
+    const std::vector<float> batch_outputs = result.get();
+    outputs.insert(outputs.end(), batch_outputs.begin(),
+                   batch_outputs.end());
+  }
+
+  return images.size() / ToyNetCpuServer::kInputSize
+         / Seconds(start, Clock::now());
+}
+
+int main(int argc, char** argv)
+{
+  const std::size_t num_samples = argc > 1 ? std::stoul(argv[1]) : 4096;
+  const std::size_t batch_size = argc > 2 ? std::stoul(argv[2]) : 64;
+  const std::size_t max_threads = argc > 3 ? std::stoul(argv[3]) :
+    std::max(1u, std::thread::hardware_concurrency());
+
+  if (batch_size == 0 || num_samples % batch_size != 0) {
+    std::cerr << "Number of samples must be a multiple of the batch size\n";
+    return EXIT_FAILURE;
+  }
+
+  if (max_threads == 0) {
+    std::cerr << "Number of threads must be positive\n";
+    return EXIT_FAILURE;
+  }
+
+  // Use the random parameters and images
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  std::uniform_int_distribution<int> pixel_dist(0, 255);
+
+  std::vector<float> params(ToyNetCpuServer::kNumParams);
+  for (auto& x : params)
+    x = dist(rng);
+
+  std::vector<std::uint8_t> images(
+    num_samples * ToyNetCpuServer::kInputSize);
+  for (auto& x : images)
+    x = static_cast<std::uint8_t>(pixel_dist(rng));
+
+  // Expected outputs (same normalization as the server)
+  std::vector<float> normalized(images.size());
+  for (std::size_t i = 0; i < images.size(); ++i)
+    normalized[i] = (images[i] / 255.0f - 0.1307f) / 0.3081f;
+
+  ToyNetFloatModel model;
+  model.InitWeights(params);
+  const std::vector<float> expected = model.Infer(normalized);
+
+  std::vector<std::size_t> thread_counts;
+  for (std::size_t n = 1; n < max_threads; n *= 2)
+    thread_counts.push_back(n);
+  thread_counts.push_back(max_threads);
+
+  std::cout << "Instruction set: " << ToyNetFloatModel::SimdName()
+            << ", samples: " << num_samples << ", batch size: "
+            << batch_size << '\n';
+
+  double base = 0.0;
+
+  for (const std::size_t num_threads : thread_counts) {
+    ToyNetCpuServer server(num_threads);
+    server.InitWeights(params);
+
+    std::vector<float> outputs;
+    const double throughput = BenchmarkServer(
+      server, images, batch_size, outputs);
+
+    if (outputs != expected) {
+      std::cerr << "Outputs differ from the floating-point model "
+                << "(" << num_threads << " threads)\n";
+      return EXIT_FAILURE;
+    }
+
+    if (num_threads == 1)
+      base = throughput;
+
+    std::cout << "Threads: " << std::setw(3) << num_threads << ", "
+              << std::fixed << std::setprecision(0) << throughput
+              << " samples/s, speedup: " << std::setprecision(2)
+              << throughput / base << "x (efficiency: "
+              << std::setprecision(1)
+              << 100.0 * throughput / base / num_threads << "%)\n";
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+# coding: utf-8
+# export_params.py
+
+# Write the model parameters in the order transferred to the device (same
+# as `transfer_weights` in toynet_test3.py, or in toynet_test_dwsep.py for
+# the checkpoints of `ToyNetDwSep`), as the float32 binary file read by the
+# host programs in C++ (e.g., host/model/toynet_emulate)
+
+# Example:
+# python3 export_params.py ../net/toynet.pth toynet_params.bin
+# python3 export_params.py ../net/toynet_dwsep.pth toynet_dwsep_params.bin
+
+import numpy as np
+import os
+import sys
+import torch
+import torch.nn as nn
+
+sys.path.insert(0, os.path.abspath(os.path.join(
+    os.path.dirname(__file__), os.pardir)))
+
+from net import ToyNet, ToyNetDwSep
+
+def _conv2d_params(layer: nn.Conv2d) -> list:
+    return [layer.weight.data.view(-1)]
+
+def _batchnorm2d_params(layer: nn.BatchNorm2d) -> list:
+    stddev_inv = torch.sqrt(layer.running_var.data + layer.eps)
+    stddev_inv = torch.reciprocal(stddev_inv)
+    scale = stddev_inv * layer.weight.data
+    return [scale.view(-1), layer.bias.data.view(-1),
+            layer.running_mean.data.view(-1)]
+
+def _linear_params(layer: nn.Linear) -> list:
+    return [layer.weight.data.view(-1), layer.bias.data.view(-1)]
+
+def export_params(model: ToyNet) -> np.ndarray:
+    params = []
+    params += _conv2d_params(model.conv0)
+    params += _batchnorm2d_params(model.bn0)
+    if isinstance(model, ToyNetDwSep):
+        # Depthwise and pointwise convolutions
+        params += _conv2d_params(model.dwconv1)
+        params += _conv2d_params(model.pwconv1)
+    else:
+        params += _conv2d_params(model.conv1)
+    params += _batchnorm2d_params(model.bn1)
+    params += _linear_params(model.linear0)
+    params += _linear_params(model.linear1)
+    params += _linear_params(model.linear2)
+    return torch.cat(params).numpy().astype(np.float32)
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} <Checkpoint> <Output>")
+        sys.exit(1)
+
+    # Load the model (`ToyNetDwSep` if the checkpoint has the depthwise
+    # convolution)
+    state_dict = torch.load(sys.argv[1], map_location="cpu")
+    model = ToyNetDwSep() if "dwconv1.weight" in state_dict else ToyNet()
+    model.load_state_dict(state_dict)
+
+    params = export_params(model)
+    params.tofile(sys.argv[2])
+    print(f"{params.size} parameters are written to {sys.argv[2]}")
+
+if __name__ == "__main__":
+    main()
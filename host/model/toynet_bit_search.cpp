@@ -0,0 +1,345 @@
+// toynet_bit_search.cpp
+
+// Search for the narrowest fixed-point formats of the accelerator that keep
+// the accuracy drop from the floating-point model within the budget, with
+// the bit-exact emulator
+// The uniform format (`BIT_WIDTH` and `INT_BIT_WIDTH` of `InferenceOpt3`) is
+// narrowed first, one bit at a time from the integer or fractional part,
+// whichever keeps the higher accuracy, and then each layer is narrowed in
+// the same greedy way starting from the uniform format
+// The result is written as the configuration header, which is consumed by
+// `hls_add_targets` in hls/CMakeLists.txt (`TOYNET_FORMAT_CONFIG`)
+
+// Usage:
+// ./toynet_bit_search <Params> <Images> <Labels> <MaxAccuracyDrop> <Output>
+//   [NumSamples] [NumThreads]
+// <Params> is written by host/export_params.py
+// <MaxAccuracyDrop> is in percentage points (e.g., 0.5)
+
+// Example:
+// ./toynet_bit_search toynet_params.bin
+//   data/MNIST/raw/t10k-images-idx3-ubyte
+//   data/MNIST/raw/t10k-labels-idx1-ubyte 0.5 toynet_format_config.hpp
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "toynet_dataset.hpp"
+#include "toynet_fixed_emulator.hpp"
+#include "toynet_float_model.hpp"
+
+namespace {
+
+using LayerFormats = ToyNetFixedEmulator::LayerFormats;
+
+constexpr std::size_t kInputSize = ToyNetFixedEmulator::kInputSize;
+constexpr std::size_t kOutputSize = ToyNetFixedEmulator::kOutputSize;
+constexpr int kNumLayers = ToyNetFixedEmulator::kNumLayers;
+
+// Widest format (same as the default of the accelerator)
+constexpr FixedFormat kWidestFormat = { 32, 16 };
+
+// Images and labels used for the search
+struct SearchDataset
+{
+  std::size_t num_samples;
+  std::vector<float> images;
+  std::vector<std::uint8_t> labels;
+};
+
+// Accuracy (%) of the outputs
+double Accuracy(const std::vector<float>& outputs,
+                const SearchDataset& dataset)
+{
+  const std::vector<int> preds = Predict(outputs, kOutputSize);
+  std::size_t correct = 0;
+
+  for (std::size_t i = 0; i < dataset.num_samples; ++i)
+    correct += preds[i] == dataset.labels[i];
+
+  return 100.0 * correct / dataset.num_samples;
+}
+
+// Accuracy (%) of the emulator with the formats, where the samples are
+// split among `num_threads` threads
+double EvaluateFormats(const LayerFormats& formats,
+                       const std::vector<float>& params,
+                       const SearchDataset& dataset,
+                       std::size_t num_threads)
+{
+  ToyNetFixedEmulator emulator(formats);
+  emulator.InitWeights(params);
+
+  std::vector<float> outputs(dataset.num_samples * kOutputSize);
+  const std::size_t chunk =
+    (dataset.num_samples + num_threads - 1) / num_threads;
+  std::vector<std::thread> workers;
+
+  for (std::size_t begin = 0; begin < dataset.num_samples; begin += chunk) {
+    const std::size_t end = std::min(begin + chunk, dataset.num_samples);
+    workers.emplace_back([&, begin, end] {
+      emulator.Infer(dataset.images.data() + begin * kInputSize,
+                     end - begin, outputs.data() + begin * kOutputSize);
+    });
+  }
+
+  for (auto& worker : workers)
+    worker.join();
+
+  return Accuracy(outputs, dataset);
+}
+
+std::string FormatToString(const FixedFormat& format)
+{
+  std::ostringstream oss;
+  oss << format.width << "/" << format.int_width;
+  return oss.str();
+}
+
+std::string FormatsToString(const LayerFormats& formats)
+{
+  std::ostringstream oss;
+
+  for (int l = 0; l < kNumLayers; ++l)
+    oss << (l > 0 ? ", " : "") << ToyNetFixedEmulator::LayerName(l) << ": "
+        << FormatToString(formats[l]);
+
+  return oss.str();
+}
+
+// Formats with one bit less from the integer or fractional part
+std::vector<FixedFormat> NarrowerFormats(const FixedFormat& format)
+{
+  std::vector<FixedFormat> formats;
+
+  if (format.width <= 2)
+    return formats;
+
+  // One fractional bit less
+  if (format.int_width < format.width)
+    formats.push_back(FixedFormat { format.width - 1, format.int_width });
+  // One integer bit less
+  if (format.int_width > 1)
+    formats.push_back(FixedFormat { format.width - 1,
+                                    format.int_width - 1 });
+
+  return formats;
+}
+
+LayerFormats UniformFormats(const FixedFormat& format)
+{
+  LayerFormats formats;
+  formats.fill(format);
+  return formats;
+}
+
+// Narrow the uniform format while the accuracy is at least `min_accuracy`
+FixedFormat SearchUniformFormat(const std::vector<float>& params,
+                                const SearchDataset& dataset,
+                                double min_accuracy,
+                                std::size_t num_threads,
+                                double& accuracy)
+{
+  FixedFormat best = kWidestFormat;
+  accuracy = EvaluateFormats(UniformFormats(best), params,
+                             dataset, num_threads);
+
+  std::cout << "Uniform format " << FormatToString(best) << ": "
+            << accuracy << "%\n";
+
+  if (accuracy < min_accuracy)
+    throw std::runtime_error("Widest format does not meet the accuracy");
+
+  while (true) {
+    FixedFormat next = best;
+    double next_accuracy = -1.0;
+
+    for (const FixedFormat& format : NarrowerFormats(best)) {
+      const double candidate = EvaluateFormats(
+        UniformFormats(format), params, dataset, num_threads);
+      std::cout << "Uniform format " << FormatToString(format) << ": "
+                << candidate << "%\n";
+
+      if (candidate >= min_accuracy && candidate > next_accuracy) {
+        next = format;
+        next_accuracy = candidate;
+      }
+    }
+
+    if (next_accuracy < 0.0)
+      return best;
+
+    best = next;
+    accuracy = next_accuracy;
+  }
+}
+
+// Narrow the format of each layer while the accuracy is at least
+// `min_accuracy`, starting from `initial`
+// In each step, the narrowing that keeps the highest accuracy among all
+// layers is taken
+LayerFormats SearchLayerFormats(const std::vector<float>& params,
+                                const SearchDataset& dataset,
+                                const FixedFormat& initial,
+                                double min_accuracy,
+                                std::size_t num_threads,
+                                double& accuracy)
+{
+  LayerFormats best = UniformFormats(initial);
+
+  while (true) {
+    LayerFormats next = best;
+    double next_accuracy = -1.0;
+
+    for (int l = 0; l < kNumLayers; ++l) {
+      for (const FixedFormat& format : NarrowerFormats(best[l])) {
+        LayerFormats candidate_formats = best;
+        candidate_formats[l] = format;
+        const double candidate = EvaluateFormats(
+          candidate_formats, params, dataset, num_threads);
+
+        if (candidate >= min_accuracy && candidate > next_accuracy) {
+          next = candidate_formats;
+          next_accuracy = candidate;
+        }
+      }
+    }
+
+    if (next_accuracy < 0.0)
+      return best;
+
+    best = next;
+    accuracy = next_accuracy;
+    std::cout << "Layer formats (" << FormatsToString(best) << "): "
+              << accuracy << "%\n";
+  }
+}
+
+// Write the configuration header
+void WriteConfig(const std::string& path,
+                 double max_drop,
+                 double float_accuracy,
+                 const FixedFormat& uniform,
+                 double uniform_accuracy,
+                 const LayerFormats& layers,
+                 double layer_accuracy)
+{
+  std::ofstream ofs(path);
+
+  if (!ofs)
+    throw std::runtime_error("Failed to open the file: " + path);
+
+  ofs << std::fixed << std::setprecision(2)
+      << "// toynet_format_config.hpp\n\n"
+      << "// Written by host/model/toynet_bit_search\n"
+      << "// Accuracy drop budget: " << max_drop << "%, floating-point "
+      << "model: " << float_accuracy << "%\n"
+      << "// Uniform format: " << uniform_accuracy << "%, per-layer "
+      << "formats: " << layer_accuracy << "%\n\n"
+      << "#ifndef TOYNET_FORMAT_CONFIG_HPP\n"
+      << "#define TOYNET_FORMAT_CONFIG_HPP\n\n"
+      << "// Format of `fixed_t` (same as -DBIT_WIDTH and -DINT_BIT_WIDTH)\n"
+      << "#define BIT_WIDTH " << uniform.width << '\n'
+      << "#define INT_BIT_WIDTH " << uniform.int_width << "\n\n"
+      << "// Format of each layer (mixed precision), where the input of the\n"
+      << "// layer is converted to its format\n"
+      << "// These are only emulated, as the accelerator has one format for "
+      << "all layers\n";
+
+  for (int l = 0; l < kNumLayers; ++l) {
+    std::string name = ToyNetFixedEmulator::LayerName(l);
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    ofs << "#define TOYNET_" << name << "_BIT_WIDTH "
+        << layers[l].width << '\n'
+        << "#define TOYNET_" << name << "_INT_BIT_WIDTH "
+        << layers[l].int_width << '\n';
+  }
+
+  ofs << "\n#endif // TOYNET_FORMAT_CONFIG_HPP\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 6 || argc > 8) {
+    std::cerr << "Usage: " << argv[0] << " <Params> <Images> <Labels> "
+              << "<MaxAccuracyDrop> <Output> [NumSamples] [NumThreads]\n";
+    return EXIT_FAILURE;
+  }
+
+  const double max_drop = std::atof(argv[4]);
+  const std::size_t num_threads = argc > 7 ?
+    std::strtoul(argv[7], nullptr, 10) :
+    std::max(1u, std::thread::hardware_concurrency());
+
+  if (max_drop < 0.0 || num_threads == 0) {
+    std::cerr << "Accuracy drop must be non-negative and "
+              << "number of threads must be positive\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    const std::vector<float> params = LoadParams(argv[1]);
+    const MnistDataset mnist = LoadMnist(argv[2], argv[3]);
+
+    SearchDataset dataset;
+    dataset.num_samples = argc > 6 ?
+      std::min<std::size_t>(std::strtoul(argv[6], nullptr, 10),
+                            mnist.num_samples) :
+      mnist.num_samples;
+
+    if (dataset.num_samples == 0)
+      throw std::invalid_argument("No samples to run");
+
+    dataset.images = NormalizeMnist(std::vector<std::uint8_t>(
+      mnist.pixels.begin(),
+      mnist.pixels.begin() + dataset.num_samples * kInputSize));
+    dataset.labels.assign(mnist.labels.begin(),
+                          mnist.labels.begin() + dataset.num_samples);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Test dataset is successfully loaded ("
+              << dataset.num_samples << " samples, " << num_threads
+              << " threads)\n";
+
+    ToyNetFloatModel model;
+    model.InitWeights(params);
+    const double float_accuracy = Accuracy(
+      model.Infer(dataset.images), dataset);
+    const double min_accuracy = float_accuracy - max_drop;
+
+    std::cout << "Floating-point model: " << float_accuracy << "%, "
+              << "minimum accuracy: " << min_accuracy << "%\n";
+
+    double uniform_accuracy = 0.0;
+    const FixedFormat uniform = SearchUniformFormat(
+      params, dataset, min_accuracy, num_threads, uniform_accuracy);
+
+    double layer_accuracy = uniform_accuracy;
+    const LayerFormats layers = SearchLayerFormats(
+      params, dataset, uniform, min_accuracy, num_threads, layer_accuracy);
+
+    std::cout << "Uniform format: " << FormatToString(uniform) << " ("
+              << uniform_accuracy << "%)\n"
+              << "Per-layer formats: " << FormatsToString(layers) << " ("
+              << layer_accuracy << "%)\n";
+
+    WriteConfig(argv[5], max_drop, float_accuracy, uniform,
+                uniform_accuracy, layers, layer_accuracy);
+    std::cout << "Configuration is written to " << argv[5] << '\n';
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+// toynet_cost_report.cpp
+
+// Estimate the latency and throughput of the accelerator from the cost
+// model of the kernels (`*Cost` functions next to the kernel templates),
+// without running the synthesis
+
+// Usage:
+// ./toynet_cost_report <Top> [Conv0B Conv1B Fc0B Fc1B Fc2B]
+// <Top> is one of naive, opt, opt2, opt3, packed, dual_mac, log, pixel, rle,
+// dwsep, ddr_fc, conv_tiled
+// The parallelization factors default to the ones in the top
+// (toynet_plan.hpp)
+// `InferenceDwSep` uses Conv1B for the output channels of the pointwise
+// convolution, and `InferenceConvTiled` only uses Conv0B (for its single
+// convolution)
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "conv_2d_tiled.hpp"
+#include "cost_model.hpp"
+#include "data_transfer.hpp"
+#include "depthwise_conv_2d.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "linear_ddr.hpp"
+#include "max_pool_2d.hpp"
+#include "pointwise_conv_2d.hpp"
+#include "toynet_plan.hpp"
+
+namespace {
+
+// Clock frequency of the accelerator (hls/tcl/common.tcl)
+constexpr double kClockMHz = 100.0;
+
+// Parallelization factors of the layers
+struct Factors
+{
+  int conv0_b;
+  int conv1_b;
+  int fc0_b;
+  int fc1_b;
+  int fc2_b;
+};
+
+// Layer call in the top
+struct Stage
+{
+  std::string name;
+  KernelCost cost;
+};
+
+// Layer calls in the top
+struct Design
+{
+  // Whether the layers are overlapped across the samples (DATAFLOW)
+  bool dataflow;
+  std::vector<Stage> stages;
+};
+
+// Kernel variants used by the tops
+// The tops only differ in the input reader, convolution, and
+// fully-connected kernels (`InferenceConvTiled` is handled separately)
+enum class ReadKind { kFloat, kPixel, kRle };
+enum class ConvKind { kNaive, kConv2d3, kConv2d4, kPacked, kDualMac, kLog };
+enum class LinearKind { kNaive, kLinear2, kLinear3, kPacked, kDualMac, kLog };
+
+KernelCost ReadCost(const ReadKind kind)
+{
+  switch (kind) {
+    case ReadKind::kPixel:
+      return ReadPixelArray3dCost(1, 28, 28);
+    case ReadKind::kRle:
+      return ReadRlePixelArray3dCost(1, 28, 28);
+    default:
+      return ReadArray3dCost(1, 28, 28);
+  }
+}
+
+KernelCost ConvCost(const ConvKind kind,
+                    int in_ch, int out_ch, int h, int w,
+                    int oh, int ow, int k, int p, int s, int b)
+{
+  switch (kind) {
+    case ConvKind::kNaive:
+      return Conv2dCost(in_ch, out_ch, h, w, oh, ow, k, p, s);
+    case ConvKind::kConv2d3:
+      return Conv2d3Cost(in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+    case ConvKind::kPacked:
+      return Conv2dPackedCost(in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+    case ConvKind::kDualMac:
+      return Conv2dDualMacCost(in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+    case ConvKind::kLog:
+      return Conv2dLogCost(in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+    default:
+      return Conv2d4Cost(in_ch, out_ch, h, w, oh, ow, k, p, s, b);
+  }
+}
+
+KernelCost FcCost(const LinearKind kind,
+                  int in_dims, int out_dims, bool apply_relu, int b)
+{
+  switch (kind) {
+    case LinearKind::kNaive:
+      return LinearCost(in_dims, out_dims, apply_relu);
+    case LinearKind::kLinear2:
+      return Linear2Cost(in_dims, out_dims, apply_relu, b);
+    case LinearKind::kPacked:
+      return LinearPackedCost(in_dims, out_dims, apply_relu, b);
+    case LinearKind::kDualMac:
+      return LinearDualMacCost(in_dims, out_dims, apply_relu, b);
+    case LinearKind::kLog:
+      return LinearLogCost(in_dims, out_dims, apply_relu, b);
+    default:
+      return Linear3Cost(in_dims, out_dims, apply_relu, b);
+  }
+}
+
+// Layer call of `InferenceConvTiled`, which reads the input and writes
+// the output through the external memory
+Design MakeConvTiledDesign(const Factors& f)
+{
+  Design design;
+  design.dataflow = false;
+  design.stages.push_back(Stage { "conv", Conv2dTiledCost(
+    3, 16, 224, 224, 224, 224, 3, 1, 1, kConvTiledTileH, kConvTiledTileW,
+    kConvTiledTileOutCh, f.conv0_b) });
+  return design;
+}
+
+// Layer calls of the top (same order as the top)
+Design MakeDesign(const std::string& top, const Factors& f)
+{
+  if (top == "conv_tiled")
+    return MakeConvTiledDesign(f);
+
+  const bool naive = top == "naive";
+  const bool opt = top == "opt";
+  const bool dwsep = top == "dwsep";
+  const bool ddr_fc = top == "ddr_fc";
+
+  ReadKind read = ReadKind::kFloat;
+  ConvKind conv = ConvKind::kConv2d4;
+  LinearKind linear = LinearKind::kLinear3;
+
+  if (naive) {
+    conv = ConvKind::kNaive;
+    linear = LinearKind::kNaive;
+  } else if (opt) {
+    conv = ConvKind::kConv2d3;
+    linear = LinearKind::kLinear2;
+  } else if (top == "packed") {
+    conv = ConvKind::kPacked;
+    linear = LinearKind::kPacked;
+  } else if (top == "dual_mac") {
+    conv = ConvKind::kDualMac;
+    linear = LinearKind::kDualMac;
+  } else if (top == "log") {
+    conv = ConvKind::kLog;
+    linear = LinearKind::kLog;
+  } else if (top == "pixel") {
+    read = ReadKind::kPixel;
+  } else if (top == "rle") {
+    read = ReadKind::kRle;
+  } else if (!dwsep && !ddr_fc && top != "opt2" && top != "opt3") {
+    throw std::invalid_argument("Unexpected top: " + top);
+  }
+
+  Design design;
+  // `InferenceNaive`, `InferenceOpt`, and `InferenceOpt2` run the layers
+  // one after another
+  design.dataflow = !naive && !opt && top != "opt2";
+
+  auto add = [&design](const std::string& name, const KernelCost& cost) {
+    design.stages.push_back(Stage { name, cost }); };
+
+  add("read_input", ReadCost(read));
+  add("conv0", ConvCost(conv, 1, 6, 28, 28, 28, 28, 5, 2, 1, f.conv0_b));
+
+  if (naive) {
+    add("pool0", MaxPool2dCost(6, 28, 28, 2));
+    add("bn0", BatchNorm2dReLUCost(6, 14, 14));
+  } else if (opt) {
+    add("pool0", MaxPool2d2Cost(6, 28, 28, 2, f.conv0_b));
+    add("bn0", BatchNorm2dReLU2Cost(6, 14, 14, f.conv0_b));
+  } else {
+    add("pool0", MaxPool2d3Cost(6, 28, 28, 2, f.conv0_b));
+    add("bn0", BatchNorm2dReLU3Cost(6, 14, 14, f.conv0_b));
+  }
+
+  if (dwsep) {
+    add("dwconv1", DepthwiseConv2d3Cost(6, 14, 14, 10, 10, 5, 0, 1,
+                                        kDwSepDwConv1B));
+    add("pwconv1", PointwiseConv2d2Cost(6, 16, 10, 10,
+                                        kDwSepPwConv1BI, f.conv1_b));
+  } else {
+    add("conv1", ConvCost(conv, 6, 16, 14, 14, 10, 10, 5, 0, 1, f.conv1_b));
+  }
+
+  if (naive) {
+    add("pool1", MaxPool2dCost(16, 10, 10, 2));
+    add("bn1", BatchNorm2dReLUCost(16, 5, 5));
+  } else if (opt) {
+    add("pool1", MaxPool2d2Cost(16, 10, 10, 2, f.conv1_b));
+    add("bn1", BatchNorm2dReLU2Cost(16, 5, 5, f.conv1_b));
+  } else {
+    add("pool1", MaxPool2d3Cost(16, 10, 10, 2, f.conv1_b));
+    add("bn1", BatchNorm2dReLU3Cost(16, 5, 5, f.conv1_b));
+  }
+
+  add("flatten", Flatten3dCost(16, 5, 5));
+  // `InferenceDdrFc` reads the weights of the first fully-connected layer
+  // from the external memory
+  add("fc0", ddr_fc ? LinearDdrCost(400, 120, true, f.fc0_b) :
+      FcCost(linear, 400, 120, true, f.fc0_b));
+  add("fc1", FcCost(linear, 120, 84, true, f.fc1_b));
+  add("fc2", FcCost(linear, 84, 10, false, f.fc2_b));
+  add("write_output", WriteArray1dCost(10));
+
+  return design;
+}
+
+// Parallelization factors in the top
+Factors DefaultFactors(const std::string& top)
+{
+  if (top == "log")
+    return Factors { kLogConv0B, kLogConv1B, kLogFc0B, kLogFc1B, kLogFc2B };
+  if (top == "dwsep")
+    return Factors { kOpt3Conv0B, kDwSepPwConv1BO,
+                     kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B };
+  if (top == "conv_tiled")
+    return Factors { kConvTiledB, 0, 0, 0, 0 };
+
+  // `InferenceNaive` has no factors, and `InferenceOpt` and `InferenceOpt2`
+  // only have the partition factors, so that these are estimated with the
+  // factors of `InferenceOpt3`
+  return Factors { kOpt3Conv0B, kOpt3Conv1B,
+                   kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B };
+}
+
+// Check that the factors divide the parallelized dimensions, as the
+// `static_assert`s in the kernels do
+void CheckFactors(const std::string& top, const Factors& f)
+{
+  auto check = [](const char* name, int b, int dims) {
+    if (b <= 0 || dims % b != 0)
+      throw std::invalid_argument(std::string(name) + " must divide "
+                                  + std::to_string(dims));
+  };
+
+  // `InferenceConvTiled` splits the output channels of the tile
+  if (top == "conv_tiled") {
+    check("Conv0B", f.conv0_b, kConvTiledTileOutCh);
+    return;
+  }
+
+  // The convolutions split the output channels, and the fully-connected
+  // layers split the input dimensions
+  check("Conv0B", f.conv0_b, 6);
+  check("Conv1B", f.conv1_b, 16);
+  check("Fc0B", f.fc0_b, 400);
+  check("Fc1B", f.fc1_b, 120);
+  check("Fc2B", f.fc2_b, 84);
+
+  if (top == "dual_mac" && (f.conv0_b % 2 != 0 || f.conv1_b % 2 != 0))
+    throw std::invalid_argument("Conv0B and Conv1B must be even numbers");
+}
+
+void PrintReport(const std::string& top, const Factors& f,
+                 const Design& design)
+{
+  long long latency = 0;
+  long long interval = 0;
+  int multipliers = 0;
+  long long buffer_bytes = 0;
+  std::size_t bottleneck = 0;
+
+  for (std::size_t i = 0; i < design.stages.size(); ++i) {
+    const KernelCost& cost = design.stages[i].cost;
+    latency += cost.cycles;
+    multipliers += cost.multipliers;
+    buffer_bytes += cost.buffer_bytes;
+
+    if (cost.cycles > design.stages[bottleneck].cost.cycles)
+      bottleneck = i;
+  }
+
+  // The sample interval is limited by the slowest stage in the dataflow
+  // region, and is the same as the latency otherwise
+  interval = design.dataflow ?
+    design.stages[bottleneck].cost.cycles : latency;
+
+  std::cout << "Top: " << top << " (bit width: " << kBitWidth
+            << ", factors: " << f.conv0_b;
+  if (top != "conv_tiled")
+    std::cout << ' ' << f.conv1_b << ' ' << f.fc0_b << ' ' << f.fc1_b
+              << ' ' << f.fc2_b;
+  std::cout << ")\n";
+  std::cout << std::left << std::setw(14) << "Stage"
+            << std::right << std::setw(12) << "Cycles"
+            << std::setw(8) << "Share"
+            << std::setw(8) << "Mults"
+            << std::setw(12) << "Bytes" << '\n';
+
+  for (std::size_t i = 0; i < design.stages.size(); ++i) {
+    const Stage& stage = design.stages[i];
+    std::cout << std::left << std::setw(14) << stage.name
+              << std::right << std::setw(12) << stage.cost.cycles
+              << std::setw(7) << std::fixed << std::setprecision(1)
+              << 100.0 * stage.cost.cycles / latency << '%'
+              << std::setw(8) << stage.cost.multipliers
+              << std::setw(12) << stage.cost.buffer_bytes
+              << (i == bottleneck ? "  <- bottleneck" : "") << '\n';
+  }
+
+  std::cout << "Multipliers: " << multipliers << '\n'
+            << "Output buffers: " << buffer_bytes << " bytes\n"
+            << "Latency: " << latency << " cycles ("
+            << latency / kClockMHz << " us)\n"
+            << "Interval: " << interval << " cycles ("
+            << interval / kClockMHz << " us, "
+            << std::setprecision(0) << kClockMHz * 1.0e6 / interval
+            << " samples/s)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc != 2 && argc != 7) {
+    std::cerr << "Usage: " << argv[0]
+              << " <Top> [Conv0B Conv1B Fc0B Fc1B Fc2B]\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::string top = argv[1];
+  Factors factors = DefaultFactors(top);
+
+  if (argc == 7)
+    factors = Factors { std::atoi(argv[2]), std::atoi(argv[3]),
+                        std::atoi(argv[4]), std::atoi(argv[5]),
+                        std::atoi(argv[6]) };
+
+  try {
+    CheckFactors(top, factors);
+    PrintReport(top, factors, MakeDesign(top, factors));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,288 @@
+// toynet_csim.cpp
+
+// Run the C model of a top function (`TOYNET_CSIM_TOP`) on the MNIST test
+// set, and compare it with the labels and the floating-point model
+// The samples are split into chunks, which the worker threads take in turn
+// and run through their own pair of input and output streams
+// The model parameters are written once before the workers are started,
+// and are only read during the inference (the tops keep them in the static
+// arrays), so the workers can share the same C model
+// `TOYNET_CSIM_BATCHED` is zero if the top runs one sample per call without
+// the number of samples (`InferenceNaive`)
+// With `TOYNET_RANGE_MONITOR`, the saturation and range of each layer is
+// reported as well (hls/src/range_monitor.hpp)
+// `TOYNET_CSIM_DWSEP` is nonzero if the top takes the parameters of
+// `ToyNetDwSep` (`InferenceDwSep`), whose depthwise and pointwise weights
+// are multiplied into the weight of the second convolution for the
+// floating-point model
+
+// Usage:
+// ./toynet_csim_<Top> <Params> <Images> <Labels> [NumThreads] [NumSamples]
+// <Params> is written by host/export_params.py
+
+// Example:
+// ./toynet_csim_opt3 toynet_params.bin data/MNIST/raw/t10k-images-idx3-ubyte
+//   data/MNIST/raw/t10k-labels-idx1-ubyte 8
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data_conversion.hpp"
+#include "data_types.hpp"
+#include "range_monitor.hpp"
+#include "toynet_csim_stream.hpp"
+#include "toynet_dataset.hpp"
+#include "toynet_float_model.hpp"
+
+#ifndef TOYNET_CSIM_TOP
+#error Top function is not defined (e.g., -DTOYNET_CSIM_TOP=InferenceOpt3)
+#endif // TOYNET_CSIM_TOP
+
+#ifndef TOYNET_CSIM_BATCHED
+#define TOYNET_CSIM_BATCHED 1
+#endif // TOYNET_CSIM_BATCHED
+
+#ifndef TOYNET_CSIM_DWSEP
+#define TOYNET_CSIM_DWSEP 0
+#endif // TOYNET_CSIM_DWSEP
+
+#define TOYNET_CSIM_STRINGIFY_(x) #x
+#define TOYNET_CSIM_STRINGIFY(x) TOYNET_CSIM_STRINGIFY_(x)
+
+// Top function of the accelerator (hls/src/top_*.cpp)
+void TOYNET_CSIM_TOP(hls::stream<axi_stream_data_t>& in_stream,
+                     hls::stream<axi_stream_data_t>& out_stream);
+
+namespace {
+
+constexpr std::size_t kInputSize = ToyNetFloatModel::kInputSize;
+constexpr std::size_t kOutputSize = ToyNetFloatModel::kOutputSize;
+
+// Number of samples in a chunk (one request to the top)
+constexpr std::size_t kChunkSize = 32;
+
+#if TOYNET_CSIM_DWSEP
+// Parameters of `ToyNetDwSep` before and after the depthwise (6x5x5) and
+// pointwise (16x6) weights of the second convolution
+constexpr std::size_t kDwSepHeadSize = 6 * 1 * 5 * 5 + 6 * 3;
+constexpr std::size_t kDwSepWeightSize = 6 * 5 * 5 + 16 * 6;
+constexpr std::size_t kDwSepNumParams = ToyNetFloatModel::kNumParams
+  - 16 * 6 * 5 * 5 + kDwSepWeightSize;
+
+// Parameters of `ToyNet` with the same outputs as the parameters of
+// `ToyNetDwSep` (`w[oc][ic][kh][kw]` = `pw[oc][ic]` * `dw[ic][kh][kw]`)
+std::vector<float> ExpandDwSepParams(const std::vector<float>& params)
+{
+  if (params.size() != kDwSepNumParams)
+    throw std::invalid_argument("Unexpected number of model parameters");
+
+  const float* dw = params.data() + kDwSepHeadSize;
+  const float* pw = dw + 6 * 5 * 5;
+  std::vector<float> expanded(params.begin(),
+                              params.begin() + kDwSepHeadSize);
+
+  for (int oc = 0; oc < 16; ++oc)
+    for (int ic = 0; ic < 6; ++ic)
+      for (int i = 0; i < 5 * 5; ++i)
+        expanded.push_back(pw[oc * 6 + ic] * dw[ic * 5 * 5 + i]);
+
+  expanded.insert(expanded.end(),
+                  params.begin() + kDwSepHeadSize + kDwSepWeightSize,
+                  params.end());
+  return expanded;
+}
+#endif // TOYNET_CSIM_DWSEP
+
+// Write the model parameters to the top (shared by all workers)
+void InitWeights(const std::vector<float>& params)
+{
+  hls::stream<axi_stream_data_t> in_stream;
+  hls::stream<axi_stream_data_t> out_stream;
+
+  WriteWord(in_stream, kModeInitWeights);
+  for (const float x : params)
+    WriteWord(in_stream, FloatToU32(x));
+  TOYNET_CSIM_TOP(in_stream, out_stream);
+
+  if (out_stream.empty())
+    throw std::runtime_error("Top did not acknowledge the parameters");
+  out_stream.read();
+}
+
+// Run the top on the samples [`begin`, `end`) through the streams of the
+// worker
+void RunChunk(hls::stream<axi_stream_data_t>& in_stream,
+              hls::stream<axi_stream_data_t>& out_stream,
+              const float* images, float* outputs,
+              std::size_t begin, std::size_t end)
+{
+#if TOYNET_CSIM_BATCHED
+  WriteWord(in_stream, kModeInference);
+  WriteWord(in_stream, static_cast<std::uint32_t>(end - begin));
+  for (std::size_t i = begin * kInputSize; i < end * kInputSize; ++i)
+    WriteWord(in_stream, FloatToU32(images[i]));
+  TOYNET_CSIM_TOP(in_stream, out_stream);
+#else
+  for (std::size_t n = begin; n < end; ++n) {
+    WriteWord(in_stream, kModeInference);
+    for (std::size_t i = n * kInputSize; i < (n + 1) * kInputSize; ++i)
+      WriteWord(in_stream, FloatToU32(images[i]));
+    TOYNET_CSIM_TOP(in_stream, out_stream);
+  }
+#endif // TOYNET_CSIM_BATCHED
+
+  if (out_stream.size() != (end - begin) * kOutputSize)
+    throw std::runtime_error("Top returned an unexpected number of words");
+
+  for (std::size_t i = begin * kOutputSize; i < end * kOutputSize; ++i)
+    outputs[i] = U32ToFloat(out_stream.read().data.to_uint());
+}
+
+// Run the top on all samples with `num_threads` workers
+std::vector<float> RunTop(const std::vector<float>& images,
+                          std::size_t num_samples,
+                          std::size_t num_threads)
+{
+  std::vector<float> outputs(num_samples * kOutputSize);
+  const std::size_t num_chunks = (num_samples + kChunkSize - 1) / kChunkSize;
+  std::atomic<std::size_t> next_chunk(0);
+  std::vector<std::exception_ptr> errors(num_threads);
+  std::vector<std::thread> workers;
+
+  for (std::size_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t] {
+      hls::stream<axi_stream_data_t> in_stream;
+      hls::stream<axi_stream_data_t> out_stream;
+
+      try {
+        for (std::size_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+          const std::size_t begin = c * kChunkSize;
+          const std::size_t end = std::min(begin + kChunkSize, num_samples);
+          RunChunk(in_stream, out_stream, images.data(), outputs.data(),
+                   begin, end);
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+        // Stop the other workers
+        next_chunk = num_chunks;
+      }
+    });
+  }
+
+  for (auto& worker : workers)
+    worker.join();
+
+  for (const auto& error : errors)
+    if (error)
+      std::rethrow_exception(error);
+
+  return outputs;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 4 || argc > 6) {
+    std::cerr << "Usage: " << argv[0] << " <Params> <Images> <Labels> "
+              << "[NumThreads] [NumSamples]\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::size_t num_threads = argc > 4 ?
+    std::strtoul(argv[4], nullptr, 10) :
+    std::max(1u, std::thread::hardware_concurrency());
+
+  if (num_threads == 0) {
+    std::cerr << "Number of threads must be positive\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    const std::vector<float> params = LoadParams(argv[1]);
+    const MnistDataset dataset = LoadMnist(argv[2], argv[3]);
+    const std::vector<float> images = NormalizeMnist(dataset.pixels);
+
+    const std::size_t num_samples = argc > 5 ?
+      std::min<std::size_t>(std::strtoul(argv[5], nullptr, 10),
+                            dataset.num_samples) :
+      dataset.num_samples;
+
+    if (num_samples == 0)
+      throw std::invalid_argument("No samples to run");
+
+    std::cout << "Top: " << TOYNET_CSIM_STRINGIFY(TOYNET_CSIM_TOP)
+              << ", format: " << kBitWidth << " bits ("
+              << kIntegerBitWidth << " integer bits)\n"
+              << "Test dataset is successfully loaded (" << num_samples
+              << " samples, " << num_threads << " threads)\n";
+
+    ToyNetFloatModel model;
+#if TOYNET_CSIM_DWSEP
+    model.InitWeights(ExpandDwSepParams(params));
+#else
+    model.InitWeights(params);
+#endif // TOYNET_CSIM_DWSEP
+    const std::vector<float> expected = model.Infer(
+      std::vector<float>(images.begin(),
+                         images.begin() + num_samples * kInputSize));
+
+    InitWeights(params);
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<float> outputs = RunTop(
+      images, num_samples, num_threads);
+    const auto end = std::chrono::steady_clock::now();
+    const double elapsed =
+      std::chrono::duration<double>(end - start).count();
+
+    const std::vector<int> preds = Predict(outputs, kOutputSize);
+    const std::vector<int> expected_preds = Predict(expected, kOutputSize);
+    std::size_t correct = 0;
+    std::size_t expected_correct = 0;
+    std::size_t agreed = 0;
+    float max_error = 0.0f;
+
+    for (std::size_t i = 0; i < num_samples; ++i) {
+      correct += preds[i] == dataset.labels[i];
+      expected_correct += expected_preds[i] == dataset.labels[i];
+      agreed += preds[i] == expected_preds[i];
+    }
+
+    for (std::size_t i = 0; i < outputs.size(); ++i)
+      max_error = std::max(max_error, std::fabs(outputs[i] - expected[i]));
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Accuracy: " << correct << " / " << num_samples
+              << " (" << 100.0 * correct / num_samples << "%), "
+              << "float model: " << expected_correct << " / " << num_samples
+              << " (" << 100.0 * expected_correct / num_samples << "%)\n"
+              << "Agreement with the float model: " << agreed << " / "
+              << num_samples << " (" << 100.0 * agreed / num_samples
+              << "%), max. output error: " << std::setprecision(6)
+              << max_error << '\n'
+              << "Elapsed time: " << std::setprecision(3) << elapsed
+              << " s (" << std::setprecision(0) << num_samples / elapsed
+              << " samples/s)\n";
+
+#ifdef TOYNET_RANGE_MONITOR_ENABLED
+    PrintRangeReport(std::cout);
+#endif // TOYNET_RANGE_MONITOR_ENABLED
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
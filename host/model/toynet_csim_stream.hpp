@@ -0,0 +1,23 @@
+// toynet_csim_stream.hpp
+
+#ifndef TOYNET_MODEL_TOYNET_CSIM_STREAM_HPP
+#define TOYNET_MODEL_TOYNET_CSIM_STREAM_HPP
+
+#include <cstdint>
+
+#include "data_types.hpp"
+
+// Write the 32-bit word to the input stream of the top, as the DMA does on
+// the device (shared by the programs that run the C model of the tops)
+inline void WriteWord(hls::stream<axi_stream_data_t>& in_stream,
+                      std::uint32_t x)
+{
+  axi_stream_data_t in_data;
+  in_data.data = x;
+  in_data.keep = -1;
+  in_data.strb = -1;
+  in_data.last = 0;
+  in_stream.write(in_data);
+}
+
+#endif // TOYNET_MODEL_TOYNET_CSIM_STREAM_HPP
@@ -0,0 +1,118 @@
+// toynet_dataset.cpp
+
+#include "toynet_dataset.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+// Magic numbers of the IDX files (unsigned byte, 3 or 1 dimensions)
+constexpr std::uint32_t kIdxImagesMagic = 0x00000803;
+constexpr std::uint32_t kIdxLabelsMagic = 0x00000801;
+
+// Size of an MNIST image
+constexpr std::uint32_t kMnistRows = 28;
+constexpr std::uint32_t kMnistCols = 28;
+
+// Mean and standard deviation of the MNIST dataset (same as the
+// `Normalize` transform in the Python host programs)
+constexpr float kMnistMean = 0.1307f;
+constexpr float kMnistStd = 0.3081f;
+
+std::vector<std::uint8_t> ReadFile(const std::string& path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+
+  if (!ifs)
+    throw std::runtime_error("Failed to open the file: " + path);
+
+  return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(ifs),
+                                   std::istreambuf_iterator<char>());
+}
+
+// Read the big-endian 32-bit integer in the IDX header
+std::uint32_t ReadU32(const std::vector<std::uint8_t>& data,
+                      std::size_t offset)
+{
+  return (static_cast<std::uint32_t>(data[offset]) << 24)
+         | (static_cast<std::uint32_t>(data[offset + 1]) << 16)
+         | (static_cast<std::uint32_t>(data[offset + 2]) << 8)
+         | static_cast<std::uint32_t>(data[offset + 3]);
+}
+
+} // namespace
+
+MnistDataset LoadMnist(const std::string& images_path,
+                       const std::string& labels_path)
+{
+  const std::vector<std::uint8_t> images = ReadFile(images_path);
+  const std::vector<std::uint8_t> labels = ReadFile(labels_path);
+
+  if (images.size() < 16 || ReadU32(images, 0) != kIdxImagesMagic
+      || ReadU32(images, 8) != kMnistRows
+      || ReadU32(images, 12) != kMnistCols)
+    throw std::runtime_error("Unexpected IDX image file: " + images_path);
+
+  if (labels.size() < 8 || ReadU32(labels, 0) != kIdxLabelsMagic)
+    throw std::runtime_error("Unexpected IDX label file: " + labels_path);
+
+  const std::size_t num_samples = ReadU32(images, 4);
+  const std::size_t image_size = kMnistRows * kMnistCols;
+
+  if (ReadU32(labels, 4) != num_samples
+      || images.size() != 16 + num_samples * image_size
+      || labels.size() != 8 + num_samples)
+    throw std::runtime_error("Images and labels are inconsistent");
+
+  MnistDataset dataset;
+  dataset.num_samples = num_samples;
+  dataset.pixels.assign(images.begin() + 16, images.end());
+  dataset.labels.assign(labels.begin() + 8, labels.end());
+  return dataset;
+}
+
+std::vector<float> NormalizeMnist(const std::vector<std::uint8_t>& pixels)
+{
+  std::vector<float> images(pixels.size());
+
+  for (std::size_t i = 0; i < pixels.size(); ++i)
+    images[i] = (static_cast<float>(pixels[i]) / 255.0f - kMnistMean)
+                / kMnistStd;
+
+  return images;
+}
+
+std::vector<float> LoadParams(const std::string& path)
+{
+  const std::vector<std::uint8_t> data = ReadFile(path);
+
+  if (data.size() % sizeof(float) != 0)
+    throw std::runtime_error("Unexpected parameter file: " + path);
+
+  std::vector<float> params(data.size() / sizeof(float));
+  std::copy(data.begin(), data.end(),
+            reinterpret_cast<std::uint8_t*>(params.data()));
+  return params;
+}
+
+std::vector<int> Predict(const std::vector<float>& outputs,
+                         std::size_t output_size)
+{
+  std::vector<int> preds(outputs.size() / output_size);
+
+  for (std::size_t i = 0; i < preds.size(); ++i) {
+    const float* out = outputs.data() + i * output_size;
+    std::size_t best = 0;
+
+    for (std::size_t j = 1; j < output_size; ++j)
+      if (out[j] > out[best])
+        best = j;
+
+    preds[i] = static_cast<int>(best);
+  }
+
+  return preds;
+}
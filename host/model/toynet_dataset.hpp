@@ -0,0 +1,39 @@
+// toynet_dataset.hpp
+
+#ifndef TOYNET_MODEL_TOYNET_DATASET_HPP
+#define TOYNET_MODEL_TOYNET_DATASET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// MNIST images and labels in the IDX format (e.g., t10k-images-idx3-ubyte
+// and t10k-labels-idx1-ubyte under data/MNIST/raw, downloaded by
+// torchvision in the Python host programs)
+struct MnistDataset
+{
+  std::size_t num_samples;
+  // 8-bit pixels (`num_samples` x 784)
+  std::vector<std::uint8_t> pixels;
+  std::vector<std::uint8_t> labels;
+};
+
+// Load the images and labels, and throw `std::runtime_error` if the files
+// are missing or malformed
+MnistDataset LoadMnist(const std::string& images_path,
+                       const std::string& labels_path);
+
+// Normalize the pixels (same as the `ToTensor` and `Normalize` transforms
+// in the Python host programs)
+std::vector<float> NormalizeMnist(const std::vector<std::uint8_t>& pixels);
+
+// Load the model parameters (float32 in the device order, written by
+// host/export_params.py)
+std::vector<float> LoadParams(const std::string& path);
+
+// Index of the largest output of each sample (`output_size` outputs each)
+std::vector<int> Predict(const std::vector<float>& outputs,
+                         std::size_t output_size);
+
+#endif // TOYNET_MODEL_TOYNET_DATASET_HPP
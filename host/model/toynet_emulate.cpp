@@ -0,0 +1,88 @@
+// toynet_emulate.cpp
+
+// Evaluate the accuracy of the accelerator (`InferenceOpt3`) on the MNIST
+// test set for each fixed-point format, with the bit-exact emulator
+
+// Usage:
+// ./toynet_emulate <Params> <Images> <Labels> [Width IntWidth]...
+// <Params> is written by host/export_params.py
+// The formats default to the ones of `InferenceOpt3` in hls/CMakeLists.txt
+
+// Example:
+// ./toynet_emulate toynet_params.bin data/MNIST/raw/t10k-images-idx3-ubyte
+//   data/MNIST/raw/t10k-labels-idx1-ubyte 16 8 8 4
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "toynet_dataset.hpp"
+#include "toynet_fixed_emulator.hpp"
+
+namespace {
+
+// Formats of the `zcu104_toynet_opt3*` targets
+const std::vector<FixedFormat> kDefaultFormats = {
+  { 32, 16 }, { 24, 12 }, { 16, 8 }, { 14, 7 }, { 12, 6 },
+  { 11, 5 }, { 10, 5 }, { 9, 4 }, { 8, 4 } };
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 4 || argc % 2 != 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " <Params> <Images> <Labels> [Width IntWidth]...\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<FixedFormat> formats;
+  for (int i = 4; i < argc; i += 2)
+    formats.push_back(FixedFormat { std::atoi(argv[i]),
+                                    std::atoi(argv[i + 1]) });
+  if (formats.empty())
+    formats = kDefaultFormats;
+
+  try {
+    const std::vector<float> params = LoadParams(argv[1]);
+    const MnistDataset dataset = LoadMnist(argv[2], argv[3]);
+    const std::vector<float> images = NormalizeMnist(dataset.pixels);
+    std::cout << "Test dataset is successfully loaded ("
+              << dataset.num_samples << " samples)\n";
+
+    for (const FixedFormat& format : formats) {
+      ToyNetFixedEmulator emulator(format);
+      emulator.InitWeights(params);
+
+      const auto start = std::chrono::steady_clock::now();
+      const std::vector<float> outputs = emulator.Infer(images);
+      const auto end = std::chrono::steady_clock::now();
+      const double elapsed =
+        std::chrono::duration<double>(end - start).count();
+
+      const std::vector<int> preds = Predict(
+        outputs, ToyNetFixedEmulator::kOutputSize);
+      std::size_t correct = 0;
+      for (std::size_t i = 0; i < dataset.num_samples; ++i)
+        if (preds[i] == dataset.labels[i])
+          ++correct;
+
+      std::cout << "Format: " << std::setw(2) << format.width << " bits ("
+                << std::setw(2) << format.int_width << " integer bits), "
+                << "accuracy: " << correct << " / " << dataset.num_samples
+                << " (" << std::fixed << std::setprecision(2)
+                << 100.0 * correct / dataset.num_samples << "%), "
+                << std::setprecision(0) << dataset.num_samples / elapsed
+                << " samples/s\n";
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+// toynet_emulator_test.cpp
+
+// Check that the emulator is bit-exact with the C model of the accelerator
+// (`InferenceOpt3` in hls/src/top_opt3.cpp) for the format of the build
+// (`BIT_WIDTH` and `INT_BIT_WIDTH`)
+
+// Example:
+// ./toynet_emulator_test_16
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "data_conversion.hpp"
+#include "data_types.hpp"
+#include "toynet_csim_stream.hpp"
+#include "toynet_fixed_emulator.hpp"
+
+// Top function of the accelerator (hls/src/top_opt3.cpp)
+void InferenceOpt3(hls::stream<axi_stream_data_t>& in_stream,
+                   hls::stream<axi_stream_data_t>& out_stream);
+
+namespace {
+
+// Number of samples to test
+constexpr std::size_t kNumSamples = 32;
+
+// Run the C model on the images
+std::vector<float> RunModel(const std::vector<float>& params,
+                            const std::vector<float>& images)
+{
+  hls::stream<axi_stream_data_t> in_stream;
+  hls::stream<axi_stream_data_t> out_stream;
+
+  WriteWord(in_stream, kModeInitWeights);
+  for (const float x : params)
+    WriteWord(in_stream, FloatToU32(x));
+  InferenceOpt3(in_stream, out_stream);
+  out_stream.read();
+
+  const std::size_t num_samples =
+    images.size() / ToyNetFixedEmulator::kInputSize;
+  WriteWord(in_stream, kModeInference);
+  WriteWord(in_stream, static_cast<std::uint32_t>(num_samples));
+  for (const float x : images)
+    WriteWord(in_stream, FloatToU32(x));
+  InferenceOpt3(in_stream, out_stream);
+
+  std::vector<float> outputs(num_samples * ToyNetFixedEmulator::kOutputSize);
+  for (auto& x : outputs)
+    x = U32ToFloat(out_stream.read().data.to_uint());
+
+  return outputs;
+}
+
+// Compare the outputs of the emulator and C model bit by bit, with the
+// parameters and images drawn from [-`range`, `range`]
+bool Test(const char* name, float range, std::mt19937& rng)
+{
+  std::uniform_real_distribution<float> dist(-range, range);
+
+  std::vector<float> params(ToyNetFixedEmulator::kNumParams);
+  for (auto& x : params)
+    x = dist(rng);
+
+  std::vector<float> images(kNumSamples * ToyNetFixedEmulator::kInputSize);
+  for (auto& x : images)
+    x = dist(rng);
+
+  ToyNetFixedEmulator emulator(FixedFormat { kBitWidth, kIntegerBitWidth });
+  emulator.InitWeights(params);
+
+  const std::vector<float> expected = RunModel(params, images);
+  const std::vector<float> outputs = emulator.Infer(images);
+  std::size_t num_errors = 0;
+
+  for (std::size_t i = 0; i < outputs.size(); ++i) {
+    if (FloatToU32(outputs[i]) != FloatToU32(expected[i])) {
+      if (num_errors < 10)
+        std::cerr << "Mismatch at sample "
+                  << i / ToyNetFixedEmulator::kOutputSize << ": "
+                  << outputs[i] << " (expected: " << expected[i] << ")\n";
+      ++num_errors;
+    }
+  }
+
+  if (num_errors > 0) {
+    std::cerr << "Test for " << name << " failed (" << num_errors
+              << " mismatches)\n";
+    return false;
+  }
+
+  std::cout << "Test for " << name << " succeeded!\n";
+  return true;
+}
+
+} // namespace
+
+int main()
+{
+  std::mt19937 rng(42);
+  bool success = true;
+
+  std::cout << "Format: " << kBitWidth << " bits (" << kIntegerBitWidth
+            << " integer bits)\n";
+
+  // Small values, and the large ones that saturate the partial sums
+  success &= Test("small values", 0.5f, rng);
+  success &= Test("saturated values", 4.0f, rng);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,392 @@
+// toynet_fixed_emulator.cpp
+
+#include "toynet_fixed_emulator.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "toynet_plan.hpp"
+
+namespace {
+
+// Parallelization factors of the fully-connected layers in `InferenceOpt3`
+// The factors determine how the partial sums are split (and clipped), so
+// they are read from the plan of the top to stay bit-exact
+constexpr int kFc0B = kOpt3Fc0B;
+constexpr int kFc1B = kOpt3Fc1B;
+constexpr int kFc2B = kOpt3Fc2B;
+
+// Truncation and saturation of the intermediate values
+// `Acc` is wide enough to hold the products of two raw integers
+template <typename Acc>
+struct Quantizer
+{
+  int frac_width;
+  Acc min;
+  Acc max;
+
+  // Saturate the value with `frac_width` fractional bits (`AP_SAT`)
+  Acc Saturate(const Acc x) const
+  {
+    return x < min ? min : (x > max ? max : x);
+  }
+
+  // Truncate the product with `2 * frac_width` fractional bits to
+  // `frac_width` bits (`AP_TRN`, arithmetic shift rounds toward minus
+  // infinity)
+  Acc Truncate(const Acc x) const
+  {
+    return x >> frac_width;
+  }
+};
+
+// Convert the raw integers from `from_frac_width` fractional bits to
+// `to_frac_width` bits, and saturate them to [`min`, `max`] (same as the
+// assignment between the fixed-point types)
+void Requantize(std::int32_t* x, int size, int from_frac_width,
+                int to_frac_width, std::int32_t min, std::int32_t max)
+{
+  const int shift = to_frac_width - from_frac_width;
+
+  for (int i = 0; i < size; ++i) {
+    std::int64_t val = x[i];
+    val = shift >= 0 ? val * (static_cast<std::int64_t>(1) << shift) :
+          val >> -shift;
+    x[i] = static_cast<std::int32_t>(val < min ? min : (val > max ? max : val));
+  }
+}
+
+// Same as `Conv2d4` (the sum over the input channels and kernel positions
+// is accumulated in order)
+// `x` is padded with zeros in advance: the padded positions are skipped in
+// `Conv2d4`, which is the same as adding zero to the saturated partial sum
+// The innermost loop runs over all rows of the output at once, including
+// the `2 * P` columns per row that straddle the padded rows and are
+// discarded, so that the compiler vectorizes it as one long loop
+template <int InCh, int OutCh, int H, int W, int OH, int OW,
+          int K, int P, typename Acc>
+void Conv2d(const std::int32_t* x,
+            std::int32_t* y,
+            const std::int32_t* weight,
+            const Quantizer<Acc>& q)
+{
+  constexpr int PH = H + 2 * P;
+  constexpr int PW = W + 2 * P;
+  static_assert(PH - K + 1 == OH && PW - K + 1 == OW,
+                "Output size is inconsistent with the parameters");
+
+  // The last `K - 1` elements are read by the discarded columns
+  std::int32_t x_pad[InCh * PH * PW + K] = { };
+
+  for (int ic = 0; ic < InCh; ++ic)
+    for (int h = 0; h < H; ++h)
+      for (int w = 0; w < W; ++w)
+        x_pad[(ic * PH + h + P) * PW + w + P] = x[(ic * H + h) * W + w];
+
+  for (int oc = 0; oc < OutCh; ++oc) {
+    Acc vals[OH * PW] = { };
+
+    for (int ic = 0; ic < InCh; ++ic) {
+      for (int kh = 0; kh < K; ++kh) {
+        for (int kw = 0; kw < K; ++kw) {
+          const Acc w = weight[((oc * InCh + ic) * K + kh) * K + kw];
+          const std::int32_t* src = x_pad + (ic * PH + kh) * PW + kw;
+
+          for (int i = 0; i < OH * PW; ++i)
+            vals[i] = q.Saturate(
+              vals[i] + q.Truncate(static_cast<Acc>(src[i]) * w));
+        }
+      }
+    }
+
+    for (int oh = 0; oh < OH; ++oh)
+      for (int ow = 0; ow < OW; ++ow)
+        y[(oc * OH + oh) * OW + ow] =
+          static_cast<std::int32_t>(vals[oh * PW + ow]);
+  }
+}
+
+// Same as `MaxPool2d3`
+template <int C, int H, int W, int K>
+void MaxPool2d(const std::int32_t* x, std::int32_t* y)
+{
+  for (int c = 0; c < C; ++c) {
+    for (int oh = 0; oh < H / K; ++oh) {
+      for (int ow = 0; ow < W / K; ++ow) {
+        std::int32_t val = x[(c * H + oh * K) * W + ow * K];
+
+        for (int kh = 0; kh < K; ++kh)
+          for (int kw = 0; kw < K; ++kw) {
+            const std::int32_t v = x[(c * H + oh * K + kh) * W + ow * K + kw];
+            val = val > v ? val : v;
+          }
+
+        y[(c * (H / K) + oh) * (W / K) + ow] = val;
+      }
+    }
+  }
+}
+
+// Same as `BatchNorm2dReLU3`
+// The product of the difference (one bit wider than `fixed_t`) and the
+// scale needs up to 64 bits regardless of the bit width
+template <int C, int H, int W>
+void BatchNorm2dReLU(const std::int32_t* x,
+                     std::int32_t* y,
+                     const std::int32_t* scale,
+                     const std::int32_t* bias,
+                     const std::int32_t* mean,
+                     const Quantizer<std::int64_t>& q)
+{
+  for (int c = 0; c < C; ++c) {
+    const std::int64_t s = scale[c];
+    const std::int64_t b = bias[c];
+    const std::int64_t m = mean[c];
+
+    for (int i = 0; i < H * W; ++i) {
+      const std::int64_t val = q.Saturate(
+        q.Truncate((x[c * H * W + i] - m) * s) + b);
+      y[c * H * W + i] = static_cast<std::int32_t>(val > 0 ? val : 0);
+    }
+  }
+}
+
+// Same as `Linear3` (each of the `B` partial sums is accumulated over the
+// inputs `j1`, `j1 + B`, `j1 + 2B`, ..., and then the partial sums and
+// bias are added in order)
+// The partial sums of all outputs are updated together, so that the
+// dependent additions of each partial sum are interleaved
+template <int InDims, int OutDims, bool ApplyReLU, int B, typename Acc>
+void Linear(const std::int32_t* x,
+            const std::int32_t* weight,
+            const std::int32_t* bias,
+            std::int32_t* y,
+            const Quantizer<Acc>& q)
+{
+  static_assert(InDims % B == 0, "`InDims` must be a multiple of `B`");
+
+  Acc vals[OutDims][B];
+
+  for (int i = 0; i < OutDims; ++i) {
+    const std::int32_t* w = weight + i * InDims;
+
+    for (int j1 = 0; j1 < B; ++j1)
+      vals[i][j1] = q.Saturate(q.Truncate(
+        static_cast<Acc>(x[j1]) * static_cast<Acc>(w[j1])));
+  }
+
+  for (int j0 = B; j0 < InDims; j0 += B) {
+    for (int i = 0; i < OutDims; ++i) {
+      const std::int32_t* w = weight + i * InDims + j0;
+
+      for (int j1 = 0; j1 < B; ++j1)
+        vals[i][j1] = q.Saturate(vals[i][j1] + q.Truncate(
+          static_cast<Acc>(x[j0 + j1]) * static_cast<Acc>(w[j1])));
+    }
+  }
+
+  for (int i = 0; i < OutDims; ++i) {
+    Acc val = 0;
+
+    for (int j1 = 0; j1 < B; ++j1)
+      val = q.Saturate(val + vals[i][j1]);
+
+    val = q.Saturate(val + bias[i]);
+
+    if (ApplyReLU)
+      val = val > 0 ? val : 0;
+
+    y[i] = static_cast<std::int32_t>(val);
+  }
+}
+
+} // namespace
+
+ToyNetFixedEmulator::ToyNetFixedEmulator(const FixedFormat& format) :
+  ToyNetFixedEmulator(LayerFormats {
+    format, format, format, format, format, format, format, format })
+{
+}
+
+ToyNetFixedEmulator::ToyNetFixedEmulator(const LayerFormats& formats) :
+  formats_(formats)
+{
+  for (int l = 0; l < kNumLayers; ++l) {
+    const FixedFormat& format = formats[l];
+
+    if (format.width < 2 || format.width > 32
+        || format.int_width < 1 || format.int_width > format.width)
+      throw std::invalid_argument("Unsupported fixed-point format: "
+        + std::to_string(format.width) + " bits ("
+        + std::to_string(format.int_width) + " integer bits) in "
+        + LayerName(l));
+
+    raw_formats_[l].frac_width = format.width - format.int_width;
+    raw_formats_[l].min = static_cast<std::int32_t>(
+      -(static_cast<std::int64_t>(1) << (format.width - 1)));
+    raw_formats_[l].max = static_cast<std::int32_t>(
+      (static_cast<std::int64_t>(1) << (format.width - 1)) - 1);
+  }
+}
+
+const char* ToyNetFixedEmulator::LayerName(const int layer)
+{
+  static const char* const kLayerNames[kNumLayers] = {
+    "input", "conv0", "bn0", "conv1", "bn1", "fc0", "fc1", "fc2" };
+  return layer >= 0 && layer < kNumLayers ? kLayerNames[layer] : "unknown";
+}
+
+std::int32_t ToyNetFixedEmulator::ToFixed(const float x,
+                                          const RawFormat& format)
+{
+  // Scale by 2^F (exact), truncate toward minus infinity, and saturate
+  const double val = std::floor(
+    std::ldexp(static_cast<double>(x), format.frac_width));
+
+  if (!(val > format.min))
+    return format.min;
+  if (val >= format.max)
+    return format.max;
+
+  return static_cast<std::int32_t>(val);
+}
+
+float ToyNetFixedEmulator::ToFloat(const std::int32_t x,
+                                   const RawFormat& format)
+{
+  // Exact in `double` for up to 32 bits
+  return static_cast<float>(
+    std::ldexp(static_cast<double>(x), -format.frac_width));
+}
+
+void ToyNetFixedEmulator::InitWeights(const std::vector<float>& params)
+{
+  if (params.size() != kNumParams)
+    throw std::invalid_argument("Unexpected number of model parameters");
+
+  const float* p = params.data();
+
+  auto read = [this, &p](std::vector<std::int32_t>& dst, std::size_t len,
+                         int layer) {
+    dst.resize(len);
+    for (std::size_t i = 0; i < len; ++i)
+      dst[i] = ToFixed(*p++, raw_formats_[layer]);
+  };
+
+  read(conv0_weight_, 6 * 1 * 5 * 5, kLayerConv0);
+  read(bn0_scale_, 6, kLayerBn0);
+  read(bn0_bias_, 6, kLayerBn0);
+  read(bn0_mean_, 6, kLayerBn0);
+  read(conv1_weight_, 16 * 6 * 5 * 5, kLayerConv1);
+  read(bn1_scale_, 16, kLayerBn1);
+  read(bn1_bias_, 16, kLayerBn1);
+  read(bn1_mean_, 16, kLayerBn1);
+  read(fc0_weight_, 120 * 400, kLayerFc0);
+  read(fc0_bias_, 120, kLayerFc0);
+  read(fc1_weight_, 84 * 120, kLayerFc1);
+  read(fc1_bias_, 84, kLayerFc1);
+  read(fc2_weight_, 10 * 84, kLayerFc2);
+  read(fc2_bias_, 10, kLayerFc2);
+}
+
+template <typename Acc>
+void ToyNetFixedEmulator::InferSample(const float* image,
+                                      float* output) const
+{
+  // Quantizers of the layers (the batch normalization needs 64 bits)
+  Quantizer<Acc> q[kNumLayers];
+  Quantizer<std::int64_t> q64[kNumLayers];
+
+  for (int l = 0; l < kNumLayers; ++l) {
+    const RawFormat& f = raw_formats_[l];
+    q[l] = Quantizer<Acc> { f.frac_width, f.min, f.max };
+    q64[l] = Quantizer<std::int64_t> { f.frac_width, f.min, f.max };
+  }
+
+  // Convert the input of `layer` from the format of the previous layer
+  auto convert = [this](std::int32_t* x, int size, int layer) {
+    const RawFormat& from = raw_formats_[layer - 1];
+    const RawFormat& to = raw_formats_[layer];
+    if (from.frac_width != to.frac_width || from.min != to.min)
+      Requantize(x, size, from.frac_width, to.frac_width, to.min, to.max);
+  };
+
+  // Input, output, and intermediate results (same as `InferenceOpt3Core`)
+  std::int32_t x0[1 * 28 * 28];
+  std::int32_t x1[6 * 28 * 28];
+  std::int32_t x2[6 * 14 * 14];
+  std::int32_t x3[6 * 14 * 14];
+  std::int32_t x4[16 * 10 * 10];
+  std::int32_t x5[16 * 5 * 5];
+  std::int32_t x6[16 * 5 * 5];
+  std::int32_t x8[120];
+  std::int32_t x9[84];
+  std::int32_t x10[10];
+
+  for (std::size_t i = 0; i < kInputSize; ++i)
+    x0[i] = ToFixed(image[i], raw_formats_[kLayerInput]);
+
+  convert(x0, 1 * 28 * 28, kLayerConv0);
+  Conv2d<1, 6, 28, 28, 28, 28, 5, 2>(
+    x0, x1, conv0_weight_.data(), q[kLayerConv0]);
+  MaxPool2d<6, 28, 28, 2>(x1, x2);
+  convert(x2, 6 * 14 * 14, kLayerBn0);
+  BatchNorm2dReLU<6, 14, 14>(x2, x3, bn0_scale_.data(),
+    bn0_bias_.data(), bn0_mean_.data(), q64[kLayerBn0]);
+  convert(x3, 6 * 14 * 14, kLayerConv1);
+  Conv2d<6, 16, 14, 14, 10, 10, 5, 0>(
+    x3, x4, conv1_weight_.data(), q[kLayerConv1]);
+  MaxPool2d<16, 10, 10, 2>(x4, x5);
+  convert(x5, 16 * 5 * 5, kLayerBn1);
+  BatchNorm2dReLU<16, 5, 5>(x5, x6, bn1_scale_.data(),
+    bn1_bias_.data(), bn1_mean_.data(), q64[kLayerBn1]);
+  // `Flatten3d` keeps the order of the elements, so `x6` is used as `x7`
+  convert(x6, 16 * 5 * 5, kLayerFc0);
+  Linear<400, 120, true, kFc0B>(
+    x6, fc0_weight_.data(), fc0_bias_.data(), x8, q[kLayerFc0]);
+  convert(x8, 120, kLayerFc1);
+  Linear<120, 84, true, kFc1B>(
+    x8, fc1_weight_.data(), fc1_bias_.data(), x9, q[kLayerFc1]);
+  convert(x9, 84, kLayerFc2);
+  Linear<84, 10, false, kFc2B>(
+    x9, fc2_weight_.data(), fc2_bias_.data(), x10, q[kLayerFc2]);
+
+  for (std::size_t i = 0; i < kOutputSize; ++i)
+    output[i] = ToFloat(x10[i], raw_formats_[kLayerFc2]);
+}
+
+void ToyNetFixedEmulator::Infer(const float* images,
+                                std::size_t num_samples,
+                                float* outputs) const
+{
+  if (conv0_weight_.empty())
+    throw std::logic_error("Model parameters are not initialized");
+
+  // Products of two raw integers fit in 32 bits up to 16 bits
+  bool narrow = true;
+  for (const FixedFormat& format : formats_)
+    narrow &= format.width <= 16;
+
+  for (std::size_t i = 0; i < num_samples; ++i) {
+    const float* image = images + i * kInputSize;
+    float* output = outputs + i * kOutputSize;
+
+    if (narrow)
+      InferSample<std::int32_t>(image, output);
+    else
+      InferSample<std::int64_t>(image, output);
+  }
+}
+
+std::vector<float> ToyNetFixedEmulator::Infer(
+  const std::vector<float>& images) const
+{
+  if (images.size() % kInputSize != 0)
+    throw std::invalid_argument("Images are not a multiple of the input size");
+
+  const std::size_t num_samples = images.size() / kInputSize;
+  std::vector<float> outputs(num_samples * kOutputSize);
+  Infer(images.data(), num_samples, outputs.data());
+  return outputs;
+}
@@ -0,0 +1,122 @@
+// toynet_fixed_emulator.hpp
+
+#ifndef TOYNET_MODEL_TOYNET_FIXED_EMULATOR_HPP
+#define TOYNET_MODEL_TOYNET_FIXED_EMULATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-point format of `fixed_t` (`BIT_WIDTH` and `INT_BIT_WIDTH`)
+struct FixedFormat
+{
+  // Total number of bits (up to 32)
+  int width;
+  // Number of integer bits (including the sign bit)
+  int int_width;
+};
+
+// Bit-exact emulator of the C model of the accelerator (`InferenceOpt3` in
+// hls/src/top_opt3.cpp) with the native integer arithmetic
+// Each value of `fixed_t` is held as the raw integer (value times 2^F, where
+// F is the number of fractional bits), and each operation is followed by
+// the truncation (`AP_TRN`, rounding toward minus infinity) and saturation
+// (`AP_SAT`) in the same order as the kernels, so that the partial sums clip
+// at the same points
+// The operations run on 32-bit integers up to 16 bits (the products fit in
+// 32 bits) and on 64-bit integers otherwise, and the innermost loops run
+// over the independent partial sums (output pixels of the convolutions and
+// `B` partial sums of the fully-connected layers), so that the compiler
+// vectorizes them
+// Unlike the C model, the format is chosen at run time, so that one program
+// can sweep all bit widths
+// Each layer can also have its own format (mixed precision), in which case
+// the input of the layer is converted to its format (`AP_TRN` and `AP_SAT`)
+// before the layer, and the parameters, partial sums, and output of the
+// layer are in its format
+class ToyNetFixedEmulator
+{
+public:
+  // Number of elements in an input image (1x28x28)
+  static constexpr std::size_t kInputSize = 784;
+  // Number of elements in an output (logits for 10 classes)
+  static constexpr std::size_t kOutputSize = 10;
+  // Number of model parameters (same order as the host runtime)
+  static constexpr std::size_t kNumParams = 61750;
+
+  // Layers with their own format (the max-pooling and flatten layers keep
+  // the format of their inputs)
+  static constexpr int kLayerInput = 0;
+  static constexpr int kLayerConv0 = 1;
+  static constexpr int kLayerBn0 = 2;
+  static constexpr int kLayerConv1 = 3;
+  static constexpr int kLayerBn1 = 4;
+  static constexpr int kLayerFc0 = 5;
+  static constexpr int kLayerFc1 = 6;
+  static constexpr int kLayerFc2 = 7;
+  static constexpr int kNumLayers = 8;
+
+  using LayerFormats = std::array<FixedFormat, kNumLayers>;
+
+  // Same format in all layers (same as the accelerator)
+  // Throws `std::invalid_argument` if the format is not supported
+  explicit ToyNetFixedEmulator(const FixedFormat& format);
+  // Format of each layer
+  explicit ToyNetFixedEmulator(const LayerFormats& formats);
+
+  // Quantize the model parameters, in the same order as the Python host
+  // programs (conv0, bn0, conv1, bn1, linear0, linear1, and linear2)
+  void InitWeights(const std::vector<float>& params);
+
+  // Run the inference on `num_samples` images (`num_samples` x `kInputSize`)
+  // and write the outputs (`num_samples` x `kOutputSize`)
+  // This is thread-safe, as the intermediate results are local to the call
+  void Infer(const float* images, std::size_t num_samples,
+             float* outputs) const;
+  std::vector<float> Infer(const std::vector<float>& images) const;
+
+  const LayerFormats& formats() const { return formats_; }
+
+  // Name of the layer (e.g., "conv0")
+  static const char* LayerName(int layer);
+
+private:
+  // Number of fractional bits and range of the raw integer of a format
+  struct RawFormat
+  {
+    int frac_width;
+    std::int32_t min;
+    std::int32_t max;
+  };
+
+  // Conversion between `float` and the raw integer of `fixed_t` (same as
+  // `static_cast<fixed_t>` and `static_cast<float>`)
+  static std::int32_t ToFixed(float x, const RawFormat& format);
+  static float ToFloat(std::int32_t x, const RawFormat& format);
+
+  template <typename Acc>
+  void InferSample(const float* image, float* output) const;
+
+  LayerFormats formats_;
+  std::array<RawFormat, kNumLayers> raw_formats_;
+
+  // Raw integers of the model parameters (same layout as the kernels), in
+  // the format of each layer
+  std::vector<std::int32_t> conv0_weight_;
+  std::vector<std::int32_t> bn0_scale_;
+  std::vector<std::int32_t> bn0_bias_;
+  std::vector<std::int32_t> bn0_mean_;
+  std::vector<std::int32_t> conv1_weight_;
+  std::vector<std::int32_t> bn1_scale_;
+  std::vector<std::int32_t> bn1_bias_;
+  std::vector<std::int32_t> bn1_mean_;
+  std::vector<std::int32_t> fc0_weight_;
+  std::vector<std::int32_t> fc0_bias_;
+  std::vector<std::int32_t> fc1_weight_;
+  std::vector<std::int32_t> fc1_bias_;
+  std::vector<std::int32_t> fc2_weight_;
+  std::vector<std::int32_t> fc2_bias_;
+};
+
+#endif // TOYNET_MODEL_TOYNET_FIXED_EMULATOR_HPP
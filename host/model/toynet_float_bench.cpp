@@ -0,0 +1,121 @@
+// toynet_float_bench.cpp
+
+// Evaluate the accuracy and throughput of the floating-point model on the
+// CPU with the MNIST test set, which is the baseline for the accelerator
+// The samples are split evenly among the threads, and the throughput is
+// measured with one thread and with all threads
+
+// Usage:
+// ./toynet_float_bench <Params> <Images> <Labels> [NumThreads]
+// <Params> is written by host/export_params.py
+
+// Example:
+// ./toynet_float_bench toynet_params.bin
+//   data/MNIST/raw/t10k-images-idx3-ubyte
+//   data/MNIST/raw/t10k-labels-idx1-ubyte 8
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "toynet_dataset.hpp"
+#include "toynet_float_model.hpp"
+
+namespace {
+
+constexpr std::size_t kInputSize = ToyNetFloatModel::kInputSize;
+constexpr std::size_t kOutputSize = ToyNetFloatModel::kOutputSize;
+
+// Run the model on all samples with `num_threads` threads, and return the
+// elapsed time in seconds
+double RunModel(const ToyNetFloatModel& model,
+                const std::vector<float>& images,
+                std::vector<float>& outputs,
+                std::size_t num_threads)
+{
+  const std::size_t num_samples = images.size() / kInputSize;
+  const std::size_t chunk = (num_samples + num_threads - 1) / num_threads;
+  std::vector<std::thread> workers;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t begin = 0; begin < num_samples; begin += chunk) {
+    const std::size_t end = std::min(begin + chunk, num_samples);
+    workers.emplace_back([&, begin, end] {
+      model.Infer(images.data() + begin * kInputSize, end - begin,
+                  outputs.data() + begin * kOutputSize);
+    });
+  }
+
+  for (auto& worker : workers)
+    worker.join();
+
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 4 || argc > 5) {
+    std::cerr << "Usage: " << argv[0] << " <Params> <Images> <Labels> "
+              << "[NumThreads]\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::size_t num_threads = argc > 4 ?
+    std::strtoul(argv[4], nullptr, 10) :
+    std::max(1u, std::thread::hardware_concurrency());
+
+  if (num_threads == 0) {
+    std::cerr << "Number of threads must be positive\n";
+    return EXIT_FAILURE;
+  }
+
+  try {
+    const std::vector<float> params = LoadParams(argv[1]);
+    const MnistDataset dataset = LoadMnist(argv[2], argv[3]);
+    const std::vector<float> images = NormalizeMnist(dataset.pixels);
+    std::cout << "Test dataset is successfully loaded ("
+              << dataset.num_samples << " samples)\n"
+              << "Instruction set: " << ToyNetFloatModel::SimdName() << '\n';
+
+    ToyNetFloatModel model;
+    model.InitWeights(params);
+    std::vector<float> outputs(dataset.num_samples * kOutputSize);
+
+    std::vector<std::size_t> thread_counts = { 1 };
+    if (num_threads > 1)
+      thread_counts.push_back(num_threads);
+
+    for (const std::size_t threads : thread_counts) {
+      const double elapsed = RunModel(model, images, outputs, threads);
+
+      const std::vector<int> preds = Predict(outputs, kOutputSize);
+      std::size_t correct = 0;
+      for (std::size_t i = 0; i < dataset.num_samples; ++i)
+        if (preds[i] == dataset.labels[i])
+          ++correct;
+
+      std::cout << "Threads: " << std::setw(3) << threads << ", "
+                << "accuracy: " << correct << " / " << dataset.num_samples
+                << " (" << std::fixed << std::setprecision(2)
+                << 100.0 * correct / dataset.num_samples << "%), "
+                << std::setprecision(0) << dataset.num_samples / elapsed
+                << " samples/s, " << std::setprecision(2)
+                << 1e6 * elapsed * threads / dataset.num_samples
+                << " us/sample/thread\n";
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
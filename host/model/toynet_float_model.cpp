@@ -0,0 +1,380 @@
+// toynet_float_model.cpp
+
+#include "toynet_float_model.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Offsets of the model parameters (device order)
+constexpr std::size_t kConv0Weight = 0;
+constexpr std::size_t kBn0Scale = kConv0Weight + 6 * 1 * 5 * 5;
+constexpr std::size_t kBn0Bias = kBn0Scale + 6;
+constexpr std::size_t kBn0Mean = kBn0Bias + 6;
+constexpr std::size_t kConv1Weight = kBn0Mean + 6;
+constexpr std::size_t kBn1Scale = kConv1Weight + 16 * 6 * 5 * 5;
+constexpr std::size_t kBn1Bias = kBn1Scale + 16;
+constexpr std::size_t kBn1Mean = kBn1Bias + 16;
+constexpr std::size_t kFc0Weight = kBn1Mean + 16;
+constexpr std::size_t kFc0Bias = kFc0Weight + 120 * 400;
+constexpr std::size_t kFc1Weight = kFc0Bias + 120;
+constexpr std::size_t kFc1Bias = kFc1Weight + 84 * 120;
+constexpr std::size_t kFc2Weight = kFc1Bias + 84;
+constexpr std::size_t kFc2Bias = kFc2Weight + 10 * 84;
+constexpr std::size_t kParamsEnd = kFc2Bias + 10;
+
+static_assert(kParamsEnd == ToyNetFloatModel::kNumParams,
+              "Offsets of the model parameters are inconsistent");
+
+// Vector type of the inner loops and its operations
+#if defined(__AVX512F__)
+
+constexpr int kVecWidth = 16;
+using Vec = __m512;
+
+inline Vec VecZero() { return _mm512_setzero_ps(); }
+inline Vec VecSet1(const float x) { return _mm512_set1_ps(x); }
+inline Vec VecLoad(const float* p) { return _mm512_loadu_ps(p); }
+inline void VecStore(float* p, const Vec x) { _mm512_storeu_ps(p, x); }
+inline Vec VecAdd(const Vec x, const Vec y) { return _mm512_add_ps(x, y); }
+inline Vec VecMax(const Vec x, const Vec y) { return _mm512_max_ps(x, y); }
+inline Vec VecFmadd(const Vec x, const Vec y, const Vec z)
+{
+  return _mm512_fmadd_ps(x, y, z);
+}
+inline float VecReduce(const Vec x) { return _mm512_reduce_add_ps(x); }
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+constexpr int kVecWidth = 8;
+using Vec = __m256;
+
+inline Vec VecZero() { return _mm256_setzero_ps(); }
+inline Vec VecSet1(const float x) { return _mm256_set1_ps(x); }
+inline Vec VecLoad(const float* p) { return _mm256_loadu_ps(p); }
+inline void VecStore(float* p, const Vec x) { _mm256_storeu_ps(p, x); }
+inline Vec VecAdd(const Vec x, const Vec y) { return _mm256_add_ps(x, y); }
+inline Vec VecMax(const Vec x, const Vec y) { return _mm256_max_ps(x, y); }
+inline Vec VecFmadd(const Vec x, const Vec y, const Vec z)
+{
+  return _mm256_fmadd_ps(x, y, z);
+}
+inline float VecReduce(const Vec x)
+{
+  __m128 val = _mm_add_ps(_mm256_castps256_ps128(x),
+                          _mm256_extractf128_ps(x, 1));
+  val = _mm_add_ps(val, _mm_movehl_ps(val, val));
+  val = _mm_add_ss(val, _mm_movehdup_ps(val));
+  return _mm_cvtss_f32(val);
+}
+
+#else
+
+constexpr int kVecWidth = 1;
+using Vec = float;
+
+inline Vec VecZero() { return 0.0f; }
+inline Vec VecSet1(const float x) { return x; }
+inline Vec VecLoad(const float* p) { return *p; }
+inline void VecStore(float* p, const Vec x) { *p = x; }
+inline Vec VecAdd(const Vec x, const Vec y) { return x + y; }
+inline Vec VecMax(const Vec x, const Vec y) { return std::max(x, y); }
+inline Vec VecFmadd(const Vec x, const Vec y, const Vec z)
+{
+  return x * y + z;
+}
+inline float VecReduce(const Vec x) { return x; }
+
+#endif
+
+// Number of columns of the matrix product computed at once, so that the
+// columns of the right-hand side stay in the L1 cache (at most 150 x 256
+// elements for conv1)
+constexpr int kGemmBlockCols = 256;
+
+// Rows [0, `Rows`) and columns [`n0`, `n1`) of the matrix product C = A B,
+// where A is `Rows` x `k`, B is `k` x `n`, and C is `Rows` x `n`
+// (row-major), which accumulates two vectors of each row in the registers
+template <int Rows>
+void GemmRows(const float* a, const float* b, float* c,
+              const int n, const int k, const int n0, const int n1)
+{
+  int j = n0;
+
+  for (; j + 2 * kVecWidth <= n1; j += 2 * kVecWidth) {
+    Vec acc[Rows][2];
+    for (int r = 0; r < Rows; ++r)
+      acc[r][0] = acc[r][1] = VecZero();
+
+    for (int p = 0; p < k; ++p) {
+      const Vec b0 = VecLoad(b + p * n + j);
+      const Vec b1 = VecLoad(b + p * n + j + kVecWidth);
+
+      for (int r = 0; r < Rows; ++r) {
+        const Vec w = VecSet1(a[r * k + p]);
+        acc[r][0] = VecFmadd(w, b0, acc[r][0]);
+        acc[r][1] = VecFmadd(w, b1, acc[r][1]);
+      }
+    }
+
+    for (int r = 0; r < Rows; ++r) {
+      VecStore(c + r * n + j, acc[r][0]);
+      VecStore(c + r * n + j + kVecWidth, acc[r][1]);
+    }
+  }
+
+  for (; j + kVecWidth <= n1; j += kVecWidth) {
+    Vec acc[Rows];
+    for (int r = 0; r < Rows; ++r)
+      acc[r] = VecZero();
+
+    for (int p = 0; p < k; ++p) {
+      const Vec b0 = VecLoad(b + p * n + j);
+      for (int r = 0; r < Rows; ++r)
+        acc[r] = VecFmadd(VecSet1(a[r * k + p]), b0, acc[r]);
+    }
+
+    for (int r = 0; r < Rows; ++r)
+      VecStore(c + r * n + j, acc[r]);
+  }
+
+  for (; j < n1; ++j) {
+    for (int r = 0; r < Rows; ++r) {
+      float val = 0.0f;
+      for (int p = 0; p < k; ++p)
+        val += a[r * k + p] * b[p * n + j];
+      c[r * n + j] = val;
+    }
+  }
+}
+
+// Matrix product C = A B, where A is `M` x `K`, B is `K` x `N`, and C is
+// `M` x `N` (row-major)
+template <int M, int N, int K>
+void Gemm(const float* a, const float* b, float* c)
+{
+  for (int n0 = 0; n0 < N; n0 += kGemmBlockCols) {
+    const int n1 = std::min(n0 + kGemmBlockCols, N);
+    int m = 0;
+
+    for (; m + 2 <= M; m += 2)
+      GemmRows<2>(a + m * K, b, c + m * N, N, K, n0, n1);
+    for (; m < M; ++m)
+      GemmRows<1>(a + m * K, b, c + m * N, N, K, n0, n1);
+  }
+}
+
+// Dot product of `x` and `y`
+inline float Dot(const float* x, const float* y, const int size)
+{
+  Vec acc0 = VecZero();
+  Vec acc1 = VecZero();
+  int i = 0;
+
+  for (; i + 2 * kVecWidth <= size; i += 2 * kVecWidth) {
+    acc0 = VecFmadd(VecLoad(x + i), VecLoad(y + i), acc0);
+    acc1 = VecFmadd(VecLoad(x + i + kVecWidth),
+                    VecLoad(y + i + kVecWidth), acc1);
+  }
+
+  for (; i + kVecWidth <= size; i += kVecWidth)
+    acc0 = VecFmadd(VecLoad(x + i), VecLoad(y + i), acc0);
+
+  float val = VecReduce(VecAdd(acc0, acc1));
+
+  for (; i < size; ++i)
+    val += x[i] * y[i];
+
+  return val;
+}
+
+// Unfold the input of the convolution (im2col), where the row
+// `(ic * K + kh) * K + kw` holds the input elements multiplied by the
+// weight `weight[oc][ic][kh][kw]` for all outputs (`OH` x `OW`)
+template <int InCh, int H, int W, int OH, int OW, int K, int P>
+void Im2Col(const float* x, float* col)
+{
+  for (int ic = 0; ic < InCh; ++ic) {
+    for (int kh = 0; kh < K; ++kh) {
+      for (int kw = 0; kw < K; ++kw) {
+        float* row = col + ((ic * K + kh) * K + kw) * OH * OW;
+
+        for (int oh = 0; oh < OH; ++oh) {
+          const int ih = oh + kh - P;
+
+          for (int ow = 0; ow < OW; ++ow) {
+            const int iw = ow + kw - P;
+            row[oh * OW + ow] = ih >= 0 && ih < H && iw >= 0 && iw < W ?
+              x[(ic * H + ih) * W + iw] : 0.0f;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Same as `Conv2d` in hls/src/conv_2d.hpp (without the bias), where `col`
+// holds the unfolded input (`InCh` * `K` * `K` x `OH` * `OW`)
+template <int InCh, int OutCh, int H, int W, int OH, int OW, int K, int P>
+void Conv2d(const float* x, float* y, const float* weight, float* col)
+{
+  Im2Col<InCh, H, W, OH, OW, K, P>(x, col);
+  Gemm<OutCh, OH * OW, InCh * K * K>(weight, col, y);
+}
+
+// Same as `MaxPool2d` in hls/src/max_pool_2d.hpp
+template <int C, int H, int W, int K>
+void MaxPool2d(const float* x, float* y)
+{
+  for (int c = 0; c < C; ++c) {
+    for (int oh = 0; oh < H / K; ++oh) {
+      for (int ow = 0; ow < W / K; ++ow) {
+        float val = x[(c * H + oh * K) * W + ow * K];
+
+        for (int kh = 0; kh < K; ++kh)
+          for (int kw = 0; kw < K; ++kw)
+            val = std::max(val, x[(c * H + oh * K + kh) * W + ow * K + kw]);
+
+        y[(c * (H / K) + oh) * (W / K) + ow] = val;
+      }
+    }
+  }
+}
+
+// Same as `BatchNorm2dReLU` in hls/src/batch_norm_2d.hpp
+template <int C, int H, int W>
+void BatchNorm2dReLU(const float* x, float* y, const float* scale,
+                     const float* bias, const float* mean)
+{
+  for (int c = 0; c < C; ++c) {
+    const float* xc = x + c * H * W;
+    float* yc = y + c * H * W;
+    // (x - mean) * scale + bias is computed as x * scale + offset
+    const float offset = bias[c] - mean[c] * scale[c];
+    const Vec scale_vec = VecSet1(scale[c]);
+    const Vec offset_vec = VecSet1(offset);
+    int i = 0;
+
+    for (; i + kVecWidth <= H * W; i += kVecWidth)
+      VecStore(yc + i, VecMax(VecFmadd(VecLoad(xc + i), scale_vec,
+                                       offset_vec), VecZero()));
+    for (; i < H * W; ++i)
+      yc[i] = std::max(xc[i] * scale[c] + offset, 0.0f);
+  }
+}
+
+// Same as `Linear` in hls/src/linear.hpp, for `num_samples` inputs
+// (`num_samples` x `InDims`) and outputs (`num_samples` x `OutDims`)
+// Each row of the weights is used for all samples while it is in the cache
+template <int InDims, int OutDims, bool ApplyReLU>
+void Linear(const float* x, const float* weight, const float* bias,
+            float* y, const int num_samples)
+{
+  for (int i = 0; i < OutDims; ++i) {
+    for (int n = 0; n < num_samples; ++n) {
+      const float val = bias[i]
+        + Dot(weight + i * InDims, x + n * InDims, InDims);
+      y[n * OutDims + i] = ApplyReLU ? std::max(val, 0.0f) : val;
+    }
+  }
+}
+
+} // namespace
+
+constexpr std::size_t ToyNetFloatModel::kInputSize;
+constexpr std::size_t ToyNetFloatModel::kOutputSize;
+constexpr std::size_t ToyNetFloatModel::kNumParams;
+constexpr std::size_t ToyNetFloatModel::kBlockSize;
+
+const char* ToyNetFloatModel::SimdName()
+{
+#if defined(__AVX512F__)
+  return "AVX-512";
+#elif defined(__AVX2__) && defined(__FMA__)
+  return "AVX2";
+#else
+  return "Scalar";
+#endif
+}
+
+void ToyNetFloatModel::InitWeights(const std::vector<float>& params)
+{
+  if (params.size() != kNumParams)
+    throw std::invalid_argument("Unexpected number of model parameters");
+
+  params_ = params;
+}
+
+void ToyNetFloatModel::InferBlock(const float* images,
+                                  std::size_t num_samples,
+                                  float* outputs,
+                                  Workspace& workspace) const
+{
+  const float* p = params_.data();
+  Workspace& w = workspace;
+  const int n = static_cast<int>(num_samples);
+
+  for (int i = 0; i < n; ++i) {
+    float* x6 = w.x6 + i * 16 * 5 * 5;
+
+    Conv2d<1, 6, 28, 28, 28, 28, 5, 2>(images + i * kInputSize, w.x1,
+                                       p + kConv0Weight, w.col0);
+    MaxPool2d<6, 28, 28, 2>(w.x1, w.x2);
+    BatchNorm2dReLU<6, 14, 14>(w.x2, w.x3, p + kBn0Scale, p + kBn0Bias,
+                               p + kBn0Mean);
+    Conv2d<6, 16, 14, 14, 10, 10, 5, 0>(w.x3, w.x4,
+                                        p + kConv1Weight, w.col1);
+    MaxPool2d<16, 10, 10, 2>(w.x4, w.x5);
+    BatchNorm2dReLU<16, 5, 5>(w.x5, x6, p + kBn1Scale, p + kBn1Bias,
+                              p + kBn1Mean);
+  }
+
+  // `Flatten3d` keeps the order of the elements, so `x6` is used as `x7`
+  Linear<400, 120, true>(w.x6, p + kFc0Weight, p + kFc0Bias, w.x8, n);
+  Linear<120, 84, true>(w.x8, p + kFc1Weight, p + kFc1Bias, w.x9, n);
+  Linear<84, 10, false>(w.x9, p + kFc2Weight, p + kFc2Bias, outputs, n);
+}
+
+void ToyNetFloatModel::Infer(const float* images,
+                             std::size_t num_samples,
+                             float* outputs) const
+{
+  if (params_.empty())
+    throw std::logic_error("Model parameters are not initialized");
+
+  // The workspace is too large for the stack of the worker threads
+  std::unique_ptr<Workspace> workspace(new Workspace);
+  Infer(images, num_samples, outputs, *workspace);
+}
+
+void ToyNetFloatModel::Infer(const float* images,
+                             std::size_t num_samples,
+                             float* outputs,
+                             Workspace& workspace) const
+{
+  if (params_.empty())
+    throw std::logic_error("Model parameters are not initialized");
+
+  for (std::size_t i = 0; i < num_samples; i += kBlockSize)
+    InferBlock(images + i * kInputSize,
+               std::min(kBlockSize, num_samples - i),
+               outputs + i * kOutputSize, workspace);
+}
+
+std::vector<float> ToyNetFloatModel::Infer(
+  const std::vector<float>& images) const
+{
+  if (images.size() % kInputSize != 0)
+    throw std::invalid_argument("Images are not a multiple of the input size");
+
+  const std::size_t num_samples = images.size() / kInputSize;
+  std::vector<float> outputs(num_samples * kOutputSize);
+  Infer(images.data(), num_samples, outputs.data());
+  return outputs;
+}
@@ -0,0 +1,78 @@
+// toynet_float_model.hpp
+
+#ifndef TOYNET_MODEL_TOYNET_FLOAT_MODEL_HPP
+#define TOYNET_MODEL_TOYNET_FLOAT_MODEL_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Floating-point model of ToyNet (same as `ToyNet` in net/toynet.py in the
+// evaluation mode), which takes the model parameters in the device order
+// This is the reference for the fixed-point accelerator and its emulator,
+// and the CPU baseline for the throughput of the accelerator
+// The convolutions are computed as the matrix products of the weights and
+// the unfolded inputs (im2col), and the fully-connected layers are computed
+// for a block of samples at once, so that the weights are reused in the
+// cache; the inner loops use AVX-512 or AVX2 (with FMA) if the library is
+// compiled for them (`TOYNET_NATIVE_ARCH`), and plain loops otherwise
+class ToyNetFloatModel
+{
+public:
+  // Number of elements in an input image (1x28x28)
+  static constexpr std::size_t kInputSize = 784;
+  // Number of elements in an output (logits for 10 classes)
+  static constexpr std::size_t kOutputSize = 10;
+  // Number of model parameters (same order as the host runtime)
+  static constexpr std::size_t kNumParams = 61750;
+  // Number of samples computed at once in the fully-connected layers
+  static constexpr std::size_t kBlockSize = 16;
+
+  // Name of the instruction set used by the inner loops ("AVX-512",
+  // "AVX2", or "Scalar")
+  static const char* SimdName();
+
+  // Set the model parameters, in the same order as the Python host
+  // programs (conv0, bn0, conv1, bn1, linear0, linear1, and linear2)
+  void InitWeights(const std::vector<float>& params);
+
+  // Intermediate results of a block of samples (same shapes as `x0` to
+  // `x9` of `InferenceOpt3Core`) and the unfolded inputs of the
+  // convolutions
+  // `x0` is not used by the model, and is for the caller to prepare the
+  // inputs (e.g., normalize the 8-bit pixels); `Flatten3d` keeps the order
+  // of the elements, so `x6` is used as `x7`, and `x10` is the output
+  struct Workspace
+  {
+    float x0[kBlockSize * 1 * 28 * 28];
+    float col0[1 * 5 * 5 * 28 * 28];
+    float x1[6 * 28 * 28];
+    float x2[6 * 14 * 14];
+    float x3[6 * 14 * 14];
+    float col1[6 * 5 * 5 * 10 * 10];
+    float x4[16 * 10 * 10];
+    float x5[16 * 5 * 5];
+    float x6[kBlockSize * 16 * 5 * 5];
+    float x8[kBlockSize * 120];
+    float x9[kBlockSize * 84];
+  };
+
+  // Run the inference on `num_samples` images (`num_samples` x `kInputSize`)
+  // and write the outputs (`num_samples` x `kOutputSize`)
+  // This is thread-safe, as the intermediate results are local to the call
+  void Infer(const float* images, std::size_t num_samples,
+             float* outputs) const;
+  std::vector<float> Infer(const std::vector<float>& images) const;
+  // Same as above, with the workspace of the caller (e.g., preallocated for
+  // each thread), which should not be shared by the concurrent calls
+  void Infer(const float* images, std::size_t num_samples,
+             float* outputs, Workspace& workspace) const;
+
+private:
+  // Run the inference on up to `kBlockSize` samples
+  void InferBlock(const float* images, std::size_t num_samples,
+                  float* outputs, Workspace& workspace) const;
+
+  std::vector<float> params_;
+};
+
+#endif // TOYNET_MODEL_TOYNET_FLOAT_MODEL_HPP
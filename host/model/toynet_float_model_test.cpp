@@ -0,0 +1,195 @@
+// toynet_float_model_test.cpp
+
+// Check the floating-point model (`ToyNetFloatModel` in
+// toynet_float_model.cpp) against the plain loops written from the layer
+// definitions, for the numbers of samples that are not multiples of the
+// block size (`kBlockSize`) or the vector width, so that the vectorized
+// matrix products and dot products and their scalar tails are all run
+
+// Example:
+// ./toynet_float_model_test
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "toynet_float_model.hpp"
+
+namespace {
+
+constexpr std::size_t kInputSize = ToyNetFloatModel::kInputSize;
+constexpr std::size_t kOutputSize = ToyNetFloatModel::kOutputSize;
+constexpr std::size_t kNumParams = ToyNetFloatModel::kNumParams;
+
+// Tolerance relative to the magnitude of the expected output (the model
+// accumulates in a different order from the reference)
+constexpr double kTolerance = 1e-4;
+
+// Reference of the layers, computed in double precision
+// `x` is of size (`InCh`, `H`, `W`), and `y` is of size (`OutCh`, `OH`,
+// `OW`), where `OH` = `H` + 2 * `P` - `K` + 1 (same for `OW`)
+void Conv2d(const std::vector<double>& x, std::vector<double>& y,
+            const float* weight, const int in_ch, const int out_ch,
+            const int h, const int w, const int k, const int p)
+{
+  const int oh = h + 2 * p - k + 1;
+  const int ow = w + 2 * p - k + 1;
+  y.assign(out_ch * oh * ow, 0.0);
+
+  for (int oc = 0; oc < out_ch; ++oc)
+    for (int i = 0; i < oh; ++i)
+      for (int j = 0; j < ow; ++j)
+        for (int ic = 0; ic < in_ch; ++ic)
+          for (int kh = 0; kh < k; ++kh)
+            for (int kw = 0; kw < k; ++kw) {
+              const int ih = i + kh - p;
+              const int iw = j + kw - p;
+              if (ih >= 0 && ih < h && iw >= 0 && iw < w)
+                y[(oc * oh + i) * ow + j] +=
+                  weight[((oc * in_ch + ic) * k + kh) * k + kw] *
+                  x[(ic * h + ih) * w + iw];
+            }
+}
+
+void MaxPool2d(const std::vector<double>& x, std::vector<double>& y,
+               const int c, const int h, const int w)
+{
+  y.assign(c * (h / 2) * (w / 2), 0.0);
+
+  for (int ch = 0; ch < c; ++ch)
+    for (int i = 0; i < h / 2; ++i)
+      for (int j = 0; j < w / 2; ++j)
+        y[(ch * (h / 2) + i) * (w / 2) + j] = std::max(
+          std::max(x[(ch * h + 2 * i) * w + 2 * j],
+                   x[(ch * h + 2 * i) * w + 2 * j + 1]),
+          std::max(x[(ch * h + 2 * i + 1) * w + 2 * j],
+                   x[(ch * h + 2 * i + 1) * w + 2 * j + 1]));
+}
+
+void BatchNorm2dReLU(std::vector<double>& x, const float* scale,
+                     const float* bias, const float* mean, const int c)
+{
+  const int size = static_cast<int>(x.size()) / c;
+
+  for (int ch = 0; ch < c; ++ch)
+    for (int i = 0; i < size; ++i) {
+      double& val = x[ch * size + i];
+      val = std::max((val - mean[ch]) * scale[ch] + bias[ch], 0.0);
+    }
+}
+
+void Linear(const std::vector<double>& x, std::vector<double>& y,
+            const float* weight, const float* bias, const int in_dims,
+            const int out_dims, const bool apply_relu)
+{
+  y.assign(out_dims, 0.0);
+
+  for (int i = 0; i < out_dims; ++i) {
+    double val = bias[i];
+    for (int j = 0; j < in_dims; ++j)
+      val += weight[i * in_dims + j] * x[j];
+    y[i] = apply_relu ? std::max(val, 0.0) : val;
+  }
+}
+
+// Run the reference on one image, with the parameters in the device order
+// (conv0, bn0, conv1, bn1, linear0, linear1, and linear2)
+std::vector<double> Reference(const std::vector<float>& params,
+                              const float* image)
+{
+  const float* p = params.data();
+  std::vector<double> x(image, image + kInputSize);
+  std::vector<double> y;
+
+  Conv2d(x, y, p, 1, 6, 28, 28, 5, 2);
+  p += 6 * 1 * 5 * 5;
+  MaxPool2d(y, x, 6, 28, 28);
+  BatchNorm2dReLU(x, p, p + 6, p + 12, 6);
+  p += 6 * 3;
+  Conv2d(x, y, p, 6, 16, 14, 14, 5, 0);
+  p += 16 * 6 * 5 * 5;
+  MaxPool2d(y, x, 16, 10, 10);
+  BatchNorm2dReLU(x, p, p + 16, p + 32, 16);
+  p += 16 * 3;
+  Linear(x, y, p, p + 120 * 400, 400, 120, true);
+  p += 120 * 400 + 120;
+  Linear(y, x, p, p + 84 * 120, 120, 84, true);
+  p += 84 * 120 + 84;
+  Linear(x, y, p, p + 10 * 84, 84, 10, false);
+
+  return y;
+}
+
+// Compare the outputs of the model and the reference for `num_samples`
+// images, with the parameters and images drawn from [-1, 1]
+// The scales of the batch normalization are positive, as in the trained
+// model, so that the ReLUs do not clip most of the outputs
+bool Test(const std::size_t num_samples, std::mt19937& rng)
+{
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+  std::vector<float> params(kNumParams);
+  for (auto& x : params)
+    x = dist(rng) * 0.25f;
+
+  const std::size_t bn0_scale = 6 * 1 * 5 * 5;
+  const std::size_t bn1_scale = bn0_scale + 6 * 3 + 16 * 6 * 5 * 5;
+  for (std::size_t i = 0; i < 6; ++i)
+    params[bn0_scale + i] = 0.5f + std::abs(dist(rng));
+  for (std::size_t i = 0; i < 16; ++i)
+    params[bn1_scale + i] = 0.5f + std::abs(dist(rng));
+
+  std::vector<float> images(num_samples * kInputSize);
+  for (auto& x : images)
+    x = dist(rng);
+
+  ToyNetFloatModel model;
+  model.InitWeights(params);
+  const std::vector<float> outputs = model.Infer(images);
+  std::size_t num_errors = 0;
+
+  for (std::size_t n = 0; n < num_samples; ++n) {
+    const std::vector<double> expected =
+      Reference(params, images.data() + n * kInputSize);
+
+    for (std::size_t i = 0; i < kOutputSize; ++i) {
+      const double output = outputs[n * kOutputSize + i];
+
+      if (std::abs(output - expected[i]) >
+          kTolerance * std::max(1.0, std::abs(expected[i]))) {
+        if (num_errors < 10)
+          std::cerr << "Mismatch at sample " << n << ": " << output
+                    << " (expected: " << expected[i] << ")\n";
+        ++num_errors;
+      }
+    }
+  }
+
+  if (num_errors > 0) {
+    std::cerr << "Test for " << num_samples << " samples failed ("
+              << num_errors << " mismatches)\n";
+    return false;
+  }
+
+  std::cout << "Test for " << num_samples << " samples succeeded!\n";
+  return true;
+}
+
+} // namespace
+
+int main()
+{
+  std::mt19937 rng(42);
+  bool success = true;
+
+  std::cout << "Instruction set: " << ToyNetFloatModel::SimdName() << '\n';
+
+  // One sample, and the partial blocks before and after the full ones
+  for (const std::size_t num_samples : { 1, 15, 17, 33 })
+    success &= Test(num_samples, rng);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,215 @@
+// toynet_overlay_test.cpp
+
+// Check that the programmable layer engine (`InferenceOverlay` in
+// hls/src/top_overlay.cpp) running the ToyNet program compiled by
+// host/overlay_compiler.py is bit-exact with the C model of the fixed
+// pipeline (`InferenceOpt3` in hls/src/top_opt3.cpp) for the format of the
+// build (`BIT_WIDTH` and `INT_BIT_WIDTH`)
+// The engines accumulate in a different order from `InferenceOpt3`, which
+// gives the same results as long as the partial sums do not saturate, so
+// the parameters and images are drawn from a small range
+
+// Usage:
+// ./toynet_overlay_test_<Width> [Program]
+// <Program> is written by host/overlay_compiler.py (one word per line), and
+// defaults to the one written by the build (`TOYNET_OVERLAY_PROGRAM`)
+
+// Example:
+// ./toynet_overlay_test_16
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "data_conversion.hpp"
+#include "data_types.hpp"
+#include "overlay_instruction.hpp"
+#include "toynet_csim_stream.hpp"
+#include "toynet_float_model.hpp"
+
+// Top functions of the accelerator (hls/src/top_overlay.cpp and
+// hls/src/top_opt3.cpp)
+void InferenceOverlay(hls::stream<axi_stream_data_t>& in_stream,
+                      hls::stream<axi_stream_data_t>& out_stream);
+void InferenceOpt3(hls::stream<axi_stream_data_t>& in_stream,
+                   hls::stream<axi_stream_data_t>& out_stream);
+
+using TopFunction = void (*)(hls::stream<axi_stream_data_t>&,
+                             hls::stream<axi_stream_data_t>&);
+
+namespace {
+
+constexpr std::size_t kInputSize = ToyNetFloatModel::kInputSize;
+constexpr std::size_t kOutputSize = ToyNetFloatModel::kOutputSize;
+constexpr std::size_t kNumParams = ToyNetFloatModel::kNumParams;
+
+// Number of samples to test
+constexpr std::size_t kNumSamples = 16;
+// Capacity of the instruction memory (same as hls/src/top_overlay.cpp)
+constexpr std::size_t kMaxInstructions = 32;
+
+// Read the encoded program (number of instructions followed by the
+// instructions)
+std::vector<std::uint32_t> LoadProgram(const std::string& path)
+{
+  std::ifstream ifs(path);
+
+  if (!ifs)
+    throw std::runtime_error("Failed to open the file: " + path);
+
+  std::vector<std::uint32_t> words;
+  std::uint32_t word;
+
+  while (ifs >> word)
+    words.push_back(word);
+
+  if (words.empty() ||
+      words.size() != 1 + words[0] * kOverlayInstructionWords)
+    throw std::runtime_error("Program has an unexpected number of words: " +
+                             path);
+
+  return words;
+}
+
+// Run the top on the images, after the program (if any) and the parameters
+// are written
+std::vector<float> RunTop(TopFunction top,
+                          const std::vector<std::uint32_t>& program,
+                          const std::vector<float>& params,
+                          const std::vector<float>& images)
+{
+  hls::stream<axi_stream_data_t> in_stream;
+  hls::stream<axi_stream_data_t> out_stream;
+
+  WriteWord(in_stream, kModeInitWeights);
+  for (const std::uint32_t x : program)
+    WriteWord(in_stream, x);
+  for (const float x : params)
+    WriteWord(in_stream, FloatToU32(x));
+  top(in_stream, out_stream);
+
+  if (!in_stream.empty() || out_stream.size() != 1)
+    throw std::runtime_error("Top did not consume the parameters");
+  out_stream.read();
+
+  const std::size_t num_samples = images.size() / kInputSize;
+  WriteWord(in_stream, kModeInference);
+  WriteWord(in_stream, static_cast<std::uint32_t>(num_samples));
+  for (const float x : images)
+    WriteWord(in_stream, FloatToU32(x));
+  top(in_stream, out_stream);
+
+  if (out_stream.size() != num_samples * kOutputSize)
+    throw std::runtime_error("Top returned an unexpected number of words");
+
+  std::vector<float> outputs(num_samples * kOutputSize);
+  for (auto& x : outputs)
+    x = U32ToFloat(out_stream.read().data.to_uint());
+
+  return outputs;
+}
+
+// Compare the outputs of the overlay and the fixed pipeline bit by bit,
+// with the parameters and images drawn from [-`range`, `range`]
+bool Test(const char* name, const std::vector<std::uint32_t>& program,
+          float range, std::mt19937& rng)
+{
+  std::uniform_real_distribution<float> dist(-range, range);
+
+  std::vector<float> params(kNumParams);
+  for (auto& x : params)
+    x = dist(rng);
+
+  std::vector<float> images(kNumSamples * kInputSize);
+  for (auto& x : images)
+    x = dist(rng);
+
+  const std::vector<float> expected = RunTop(InferenceOpt3, { },
+                                             params, images);
+  const std::vector<float> outputs = RunTop(InferenceOverlay, program,
+                                            params, images);
+  std::size_t num_errors = 0;
+
+  for (std::size_t i = 0; i < outputs.size(); ++i) {
+    if (FloatToU32(outputs[i]) != FloatToU32(expected[i])) {
+      if (num_errors < 10)
+        std::cerr << "Mismatch at sample " << i / kOutputSize << ": "
+                  << outputs[i] << " (expected: " << expected[i] << ")\n";
+      ++num_errors;
+    }
+  }
+
+  if (num_errors > 0) {
+    std::cerr << "Test for " << name << " failed (" << num_errors
+              << " mismatches)\n";
+    return false;
+  }
+
+  std::cout << "Test for " << name << " succeeded!\n";
+  return true;
+}
+
+// Check that the program longer than the instruction memory is clamped
+// The instructions are the end markers without the parameters, so that the
+// top only reads the instructions that fit (including the end marker)
+bool TestLongProgram()
+{
+  const std::size_t num_instructions = kMaxInstructions + 8;
+  const std::size_t num_loaded = kMaxInstructions - 1;
+
+  hls::stream<axi_stream_data_t> in_stream;
+  hls::stream<axi_stream_data_t> out_stream;
+
+  WriteWord(in_stream, kModeInitWeights);
+  WriteWord(in_stream, static_cast<std::uint32_t>(num_instructions));
+  for (std::size_t i = 0; i < num_instructions; ++i)
+    for (int j = 0; j < kOverlayInstructionWords; ++j)
+      WriteWord(in_stream, j == 0 ? kOpEnd : 0);
+  InferenceOverlay(in_stream, out_stream);
+
+  const std::size_t num_remaining =
+    (num_instructions - num_loaded) * kOverlayInstructionWords;
+
+  if (out_stream.size() != 1 || in_stream.size() != num_remaining) {
+    std::cerr << "Test for long program failed: " << in_stream.size()
+              << " words are left (expected: " << num_remaining << ")\n";
+    return false;
+  }
+
+  std::cout << "Test for long program succeeded!\n";
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [Program]\n";
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 rng(42);
+  bool success = true;
+
+  std::cout << "Format: " << kBitWidth << " bits (" << kIntegerBitWidth
+            << " integer bits)\n";
+
+  try {
+    const std::vector<std::uint32_t> program =
+      LoadProgram(argc > 1 ? argv[1] : TOYNET_OVERLAY_PROGRAM);
+
+    success &= Test("small values", program, 0.25f, rng);
+    success &= TestLongProgram();
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,574 @@
+// toynet_resource_report.cpp
+
+// Estimate the on-chip memory (BRAM18, URAM, LUTRAM, and registers) used by
+// the arrays in the top, and check it against the budget of the board,
+// without running the synthesis
+
+// Usage:
+// ./toynet_resource_report <Top> <Board> [--uram]
+// <Top> is one of naive, opt, opt2, opt3, packed, dual_mac, log, pixel, rle,
+// multi, profile, shared, overlay, dwsep, ddr_fc, conv_tiled, empty
+// <Board> is one of zcu104, ultra96v2, pynqz2 (`TARGET_BOARD`)
+// `--uram` binds the weights of the fully-connected layers to the URAM
+// The program fails when the arrays do not fit in the board, so that it
+// can be run before the synthesis (`<Project>_check_resources` in
+// hls/CMakeLists.txt runs it before each `<Project>_csynth`)
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "batch_norm_2d.hpp"
+#include "conv_2d.hpp"
+#include "conv_2d_tiled.hpp"
+#include "data_packing.hpp"
+#include "data_transfer.hpp"
+#include "depthwise_conv_2d.hpp"
+#include "flatten.hpp"
+#include "linear.hpp"
+#include "linear_ddr.hpp"
+#include "max_pool_2d.hpp"
+#include "overlay_instruction.hpp"
+#include "partition_plan.hpp"
+#include "pointwise_conv_2d.hpp"
+#include "profile.hpp"
+#include "resource_model.hpp"
+#include "toynet_plan.hpp"
+
+namespace {
+
+// On-chip memory of the device on the board
+struct Board
+{
+  std::string name;
+  long long bram18;
+  long long uram;
+  long long lutram;
+  long long registers;
+};
+
+// Devices in hls/CMakeLists.txt (BRAM36 blocks count as two BRAM18 blocks)
+const Board kBoards[] = {
+  // xczu7ev-ffvc1156-2-e
+  { "zcu104", 624, 96, 101760, 460800 },
+  // xczu3eg-sbva484-1-e
+  { "ultra96v2", 432, 0, 28800, 141120 },
+  // xc7z020-clg400-1
+  { "pynqz2", 280, 0, 17400, 106400 },
+};
+
+// Array declared in the top
+struct Array
+{
+  std::string name;
+  long long elements;
+  int width;
+  int banks;
+  int copies;
+  MemoryStorage storage;
+};
+
+using ArrayList = std::vector<Array>;
+
+void AddArray(ArrayList& arrays, const std::string& name,
+              long long elements, int width, int banks, int copies,
+              MemoryStorage storage = MemoryStorage::kAuto)
+{
+  arrays.push_back(Array { name, elements, width, banks, copies, storage });
+}
+
+// Input, output, and intermediate results (`x0` to `x10`)
+// `X1Factor` to `X9Factor` are the partition factors, and `Copies` is two
+// for the ping-pong buffers between the dataflow processes
+template <int X1Factor, int X2Factor, int X3Factor, int X4Factor,
+          int X5Factor, int X6Factor, int X7Factor, int X8Factor,
+          int X9Factor, int Copies>
+void AddFeatureMaps(ArrayList& arrays)
+{
+  AddArray(arrays, "x0", 1 * 28 * 28, kBitWidth, 1, Copies);
+  AddArray(arrays, "x1", 6 * 28 * 28, kBitWidth, X1Factor, Copies);
+  AddArray(arrays, "x2", 6 * 14 * 14, kBitWidth, X2Factor, Copies);
+  AddArray(arrays, "x3", 6 * 14 * 14, kBitWidth, X3Factor, Copies);
+  AddArray(arrays, "x4", 16 * 10 * 10, kBitWidth, X4Factor, Copies);
+  AddArray(arrays, "x5", 16 * 5 * 5, kBitWidth, X5Factor, Copies);
+  AddArray(arrays, "x6", 16 * 5 * 5, kBitWidth, X6Factor, Copies);
+  AddArray(arrays, "x7", 400, kBitWidth, X7Factor, Copies);
+  AddArray(arrays, "x8", 120, kBitWidth, X8Factor, Copies);
+  AddArray(arrays, "x9", 84, kBitWidth, X9Factor, Copies);
+  AddArray(arrays, "x10", 10, kBitWidth, 1, Copies);
+}
+
+// Feature maps in the dataflow region, partitioned as in `InferenceOpt3Core`
+// `ConvPorts` and `LinearPorts` are the ports of the convolution and
+// fully-connected kernels used in the top
+template <template <int> class ConvPorts, template <int> class LinearPorts,
+          int Conv0B, int Conv1B, int Fc0B, int Fc1B, int Fc2B>
+void AddDataflowFeatureMaps(ArrayList& arrays)
+{
+  AddFeatureMaps<
+    CyclicPartition<6, ConvPorts<Conv0B>::kOutput,
+      MaxPool2d3Ports<Conv0B>::kInput>::kFactor,
+    CyclicPartition<6, MaxPool2d3Ports<Conv0B>::kOutput,
+      BatchNorm2dReLU3Ports<Conv0B>::kInput>::kFactor,
+    CyclicPartition<6, BatchNorm2dReLU3Ports<Conv0B>::kOutput,
+      ConvPorts<Conv1B>::kInput>::kFactor,
+    CyclicPartition<16, ConvPorts<Conv1B>::kOutput,
+      MaxPool2d3Ports<Conv1B>::kInput>::kFactor,
+    CyclicPartition<16, MaxPool2d3Ports<Conv1B>::kOutput,
+      BatchNorm2dReLU3Ports<Conv1B>::kInput>::kFactor,
+    CyclicPartition<16, BatchNorm2dReLU3Ports<Conv1B>::kOutput,
+      Flatten3dPorts::kInput>::kFactor,
+    CyclicPartition<400, Flatten3dPorts::kOutput,
+      LinearPorts<Fc0B>::kInput>::kFactor,
+    CyclicPartition<120, LinearPorts<Fc0B>::kOutput,
+      LinearPorts<Fc1B>::kInput>::kFactor,
+    CyclicPartition<84, LinearPorts<Fc1B>::kOutput,
+      LinearPorts<Fc2B>::kInput>::kFactor,
+    2>(arrays);
+}
+
+// Parameters of the batch normalization and biases of the fully-connected
+// layers, which are the same in all tops
+template <int Bn0Factor, int Bn1Factor>
+void AddBatchNormAndBias(ArrayList& arrays)
+{
+  AddArray(arrays, "bn0_scale", 6, kBitWidth, Bn0Factor, 1);
+  AddArray(arrays, "bn0_bias", 6, kBitWidth, Bn0Factor, 1);
+  AddArray(arrays, "bn0_mean", 6, kBitWidth, Bn0Factor, 1);
+  AddArray(arrays, "bn1_scale", 16, kBitWidth, Bn1Factor, 1);
+  AddArray(arrays, "bn1_bias", 16, kBitWidth, Bn1Factor, 1);
+  AddArray(arrays, "bn1_mean", 16, kBitWidth, Bn1Factor, 1);
+  AddArray(arrays, "fc0_bias", 120, kBitWidth, 1, 1);
+  AddArray(arrays, "fc1_bias", 84, kBitWidth, 1, 1);
+  AddArray(arrays, "fc2_bias", 10, kBitWidth, 1, 1);
+}
+
+// Weights of the second and third fully-connected layers
+template <template <int> class LinearPorts, int Fc1B, int Fc2B,
+          int WeightWidth, int FcWeightRows>
+void AddFc1Fc2Weights(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+
+  AddArray(arrays, "fc1_weight", 84 * 120, WeightWidth,
+    CyclicPartition<120, kIn, LinearPorts<Fc1B>::kWeight>::kFactor
+    * FcWeightRows, 1, fc_storage);
+  AddArray(arrays, "fc2_weight", 10 * 84, WeightWidth,
+    CyclicPartition<84, kIn, LinearPorts<Fc2B>::kWeight>::kFactor
+    * FcWeightRows, 1, fc_storage);
+}
+
+// Model parameters, partitioned as in `InferenceOpt3`
+// `WeightWidth` is the bit width of the weights, and `FcWeightRows` is the
+// number of rows of the fully-connected weights read at once
+template <template <int> class ConvPorts, template <int> class LinearPorts,
+          int Conv0B, int Conv1B, int Fc0B, int Fc1B, int Fc2B,
+          int WeightWidth, int FcWeightRows>
+void AddParams(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+
+  AddArray(arrays, "conv0_weight", 6 * 1 * 5 * 5, WeightWidth,
+    CyclicPartition<6, kIn, ConvPorts<Conv0B>::kWeight>::kFactor, 1);
+  AddArray(arrays, "conv1_weight", 16 * 6 * 5 * 5, WeightWidth,
+    CyclicPartition<16, kIn, ConvPorts<Conv1B>::kWeight>::kFactor, 1);
+  AddArray(arrays, "fc0_weight", 120 * 400, WeightWidth,
+    CyclicPartition<400, kIn, LinearPorts<Fc0B>::kWeight>::kFactor
+    * FcWeightRows, 1, fc_storage);
+  AddFc1Fc2Weights<LinearPorts, Fc1B, Fc2B, WeightWidth, FcWeightRows>(
+    arrays, fc_storage);
+
+  AddBatchNormAndBias<
+    CyclicPartition<6, kIn, BatchNorm2dReLU3Ports<Conv0B>::kParams>::kFactor,
+    CyclicPartition<16, kIn, BatchNorm2dReLU3Ports<Conv1B>::kParams>::kFactor
+    >(arrays);
+}
+
+// Model parameters of `InferencePacked`, where each word holds `B` weights
+template <int Conv0B, int Conv1B, int Fc0B, int Fc1B, int Fc2B>
+void AddPackedParams(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+
+  AddArray(arrays, "conv0_weight", (6 / Conv0B) * 1 * 5 * 5,
+           Conv0B * kBitWidth, 1, 1);
+  AddArray(arrays, "conv1_weight", (16 / Conv1B) * 6 * 5 * 5,
+           Conv1B * kBitWidth, 1, 1);
+  AddArray(arrays, "fc0_weight", 120 * (400 / Fc0B),
+           Fc0B * kBitWidth, 1, 1, fc_storage);
+  AddArray(arrays, "fc1_weight", 84 * (120 / Fc1B),
+           Fc1B * kBitWidth, 1, 1, fc_storage);
+  AddArray(arrays, "fc2_weight", 10 * (84 / Fc2B),
+           Fc2B * kBitWidth, 1, 1, fc_storage);
+
+  AddBatchNormAndBias<
+    CyclicPartition<6, kIn, BatchNorm2dReLU3Ports<Conv0B>::kParams>::kFactor,
+    CyclicPartition<16, kIn, BatchNorm2dReLU3Ports<Conv1B>::kParams>::kFactor
+    >(arrays);
+}
+
+// Arrays of `InferenceDwSep`, where the second convolution is split into
+// the depthwise and pointwise convolutions (`x4a` is the output of the
+// depthwise convolution)
+void AddDwSepArrays(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+  using ConvPorts = Conv2d4Ports<kOpt3Conv0B>;
+  using DwPorts = DepthwiseConv2d3Ports<kDwSepDwConv1B>;
+  using PwPorts = PointwiseConv2d2Ports<kDwSepPwConv1BI, kDwSepPwConv1BO>;
+  using Pool0Ports = MaxPool2d3Ports<kOpt3Conv0B>;
+  using Pool1Ports = MaxPool2d3Ports<kOpt3Conv1B>;
+  using Bn0Ports = BatchNorm2dReLU3Ports<kOpt3Conv0B>;
+  using Bn1Ports = BatchNorm2dReLU3Ports<kOpt3Conv1B>;
+
+  AddFeatureMaps<
+    CyclicPartition<6, ConvPorts::kOutput, Pool0Ports::kInput>::kFactor,
+    CyclicPartition<6, Pool0Ports::kOutput, Bn0Ports::kInput>::kFactor,
+    CyclicPartition<6, Bn0Ports::kOutput, DwPorts::kInput>::kFactor,
+    CyclicPartition<16, PwPorts::kOutput, Pool1Ports::kInput>::kFactor,
+    CyclicPartition<16, Pool1Ports::kOutput, Bn1Ports::kInput>::kFactor,
+    CyclicPartition<16, Bn1Ports::kOutput, Flatten3dPorts::kInput>::kFactor,
+    CyclicPartition<400, Flatten3dPorts::kOutput,
+      Linear3Ports<kOpt3Fc0B>::kInput>::kFactor,
+    CyclicPartition<120, Linear3Ports<kOpt3Fc0B>::kOutput,
+      Linear3Ports<kOpt3Fc1B>::kInput>::kFactor,
+    CyclicPartition<84, Linear3Ports<kOpt3Fc1B>::kOutput,
+      Linear3Ports<kOpt3Fc2B>::kInput>::kFactor,
+    2>(arrays);
+  AddArray(arrays, "x4a", 6 * 10 * 10, kBitWidth,
+    CyclicPartition<6, DwPorts::kOutput, PwPorts::kInput>::kFactor, 2);
+
+  // The second dimension of `pwconv1_weight` is completely partitioned
+  AddArray(arrays, "conv0_weight", 6 * 1 * 5 * 5, kBitWidth,
+    CyclicPartition<6, kIn, ConvPorts::kWeight>::kFactor, 1);
+  AddArray(arrays, "dwconv1_weight", 6 * 5 * 5, kBitWidth,
+    CyclicPartition<6, kIn, DwPorts::kWeight>::kFactor, 1);
+  AddArray(arrays, "pwconv1_weight", 16 * 6, kBitWidth,
+    CyclicPartition<16, kIn, PwPorts::kWeightOut>::kFactor * 6, 1);
+  AddArray(arrays, "fc0_weight", 120 * 400, kBitWidth,
+    CyclicPartition<400, kIn, Linear3Ports<kOpt3Fc0B>::kWeight>::kFactor,
+    1, fc_storage);
+  AddFc1Fc2Weights<Linear3Ports, kOpt3Fc1B, kOpt3Fc2B, kBitWidth, 1>(
+    arrays, fc_storage);
+  AddBatchNormAndBias<
+    CyclicPartition<6, kIn, Bn0Ports::kParams>::kFactor,
+    CyclicPartition<16, kIn, Bn1Ports::kParams>::kFactor>(arrays);
+}
+
+// Arrays of `InferenceDdrFc`, where the weights of the first
+// fully-connected layer are in the external memory, and only the two rows
+// cached by `LinearDdr` are on chip
+void AddDdrFcArrays(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+  using Conv0Ports = Conv2d4Ports<kOpt3Conv0B>;
+  using Conv1Ports = Conv2d4Ports<kOpt3Conv1B>;
+  using Pool0Ports = MaxPool2d3Ports<kOpt3Conv0B>;
+  using Pool1Ports = MaxPool2d3Ports<kOpt3Conv1B>;
+  using Bn0Ports = BatchNorm2dReLU3Ports<kOpt3Conv0B>;
+  using Bn1Ports = BatchNorm2dReLU3Ports<kOpt3Conv1B>;
+
+  AddFeatureMaps<
+    CyclicPartition<6, Conv0Ports::kOutput, Pool0Ports::kInput>::kFactor,
+    CyclicPartition<6, Pool0Ports::kOutput, Bn0Ports::kInput>::kFactor,
+    CyclicPartition<6, Bn0Ports::kOutput, Conv1Ports::kInput>::kFactor,
+    CyclicPartition<16, Conv1Ports::kOutput, Pool1Ports::kInput>::kFactor,
+    CyclicPartition<16, Pool1Ports::kOutput, Bn1Ports::kInput>::kFactor,
+    CyclicPartition<16, Bn1Ports::kOutput, Flatten3dPorts::kInput>::kFactor,
+    CyclicPartition<400, Flatten3dPorts::kOutput,
+      LinearDdrPorts<kOpt3Fc0B>::kInput>::kFactor,
+    CyclicPartition<120, LinearDdrPorts<kOpt3Fc0B>::kOutput,
+      Linear3Ports<kOpt3Fc1B>::kInput>::kFactor,
+    CyclicPartition<84, Linear3Ports<kOpt3Fc1B>::kOutput,
+      Linear3Ports<kOpt3Fc2B>::kInput>::kFactor,
+    2>(arrays);
+
+  AddArray(arrays, "conv0_weight", 6 * 1 * 5 * 5, kBitWidth,
+    CyclicPartition<6, kIn, Conv0Ports::kWeight>::kFactor, 1);
+  AddArray(arrays, "conv1_weight", 16 * 6 * 5 * 5, kBitWidth,
+    CyclicPartition<16, kIn, Conv1Ports::kWeight>::kFactor, 1);
+  AddArray(arrays, "fc0_row", 400 / kOpt3Fc0B, kOpt3Fc0B * kBitWidth, 1, 2);
+  AddFc1Fc2Weights<Linear3Ports, kOpt3Fc1B, kOpt3Fc2B, kBitWidth, 1>(
+    arrays, fc_storage);
+  AddBatchNormAndBias<
+    CyclicPartition<6, kIn, Bn0Ports::kParams>::kFactor,
+    CyclicPartition<16, kIn, Bn1Ports::kParams>::kFactor>(arrays);
+}
+
+// Arrays of `InferenceShared`, where the engines are sequenced over the
+// layers, so that the buffers are sized for the largest layer
+void AddSharedArrays(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+  using ConvPorts = Conv2dDynamicPorts<kSharedConvB>;
+  using PoolPorts = MaxPool2dDynamicPorts<kSharedConvB>;
+  using BnPorts = BatchNorm2dReLUDynamicPorts<kSharedConvB>;
+  using LinearPorts = LinearDynamicPorts<kSharedLinearB>;
+  constexpr int kLinearWeightSize = 120 * 400 + 84 * 128 + 10 * 96;
+
+  AddArray(arrays, "x_in", 16 * 28 * 28, kBitWidth,
+    CyclicPartition<16, BnPorts::kOutput, ConvPorts::kInput>::kFactor, 1);
+  AddArray(arrays, "x_conv", 16 * 28 * 28, kBitWidth,
+    CyclicPartition<16, ConvPorts::kOutput, PoolPorts::kInput>::kFactor, 1);
+  AddArray(arrays, "x_pool", 16 * 14 * 14, kBitWidth,
+    CyclicPartition<16, PoolPorts::kOutput, BnPorts::kInput>::kFactor, 1);
+  AddArray(arrays, "x_vec", 400, kBitWidth,
+    CyclicPartition<400, Flatten2dDynamicPorts::kOutput,
+      LinearPorts::kInput>::kFactor, 1);
+  AddArray(arrays, "y_vec", 400, kBitWidth, 1, 1);
+  AddArray(arrays, "x10", 10, kBitWidth, 1, 1);
+
+  AddArray(arrays, "conv_weight", 16 * (1 * 5 * 5 + 6 * 5 * 5), kBitWidth,
+    CyclicPartition<16, kIn, ConvPorts::kWeight>::kFactor, 1);
+  for (const char* name : { "bn_scale", "bn_bias", "bn_mean" })
+    AddArray(arrays, name, 2 * 16, kBitWidth,
+      CyclicPartition<16, kIn, BnPorts::kParams>::kFactor, 1);
+  AddArray(arrays, "fc_weight", kLinearWeightSize, kBitWidth,
+    CyclicPartition<kLinearWeightSize, kIn, LinearPorts::kWeight>::kFactor,
+    1, fc_storage);
+  AddArray(arrays, "fc_bias", 120 + 84 + 10, kBitWidth, 1, 1);
+}
+
+// Arrays of `InferenceOverlay`, which are sized for the capacity of the
+// programmable engine (`kMax*` in the top), and the rows of the vector and
+// fully-connected weights (`kOverlayLinearB` elements) are read at once
+void AddOverlayArrays(ArrayList& arrays, const MemoryStorage fc_storage)
+{
+  constexpr int kIn = ReadArrayPorts::kOutput;
+  using BnPorts = BatchNorm2dReLUOverlayPorts<kOverlayConvB>;
+
+  AddArray(arrays, "program", 32, 8 * sizeof(OverlayInstruction), 1, 1);
+  AddArray(arrays, "fmap", 16 * 2 * 28 * 28, kBitWidth,
+    CyclicPartition<16, BnPorts::kOutput + BnPorts::kInput,
+      MaxPool2dOverlayPorts<kOverlayConvB>::kInput>::kFactor, 1);
+  AddArray(arrays, "vec", 2 * 512, kBitWidth, kOverlayLinearB, 1);
+
+  AddArray(arrays, "conv_weight", 16 * 512, kBitWidth,
+    CyclicPartition<16, kIn,
+      Conv2dOverlayPorts<kOverlayConvB>::kWeight>::kFactor, 1);
+  for (const char* name : { "bn_scale", "bn_bias", "bn_mean" })
+    AddArray(arrays, name, 4 * 16, kBitWidth,
+      CyclicPartition<16, kIn, BnPorts::kParams>::kFactor, 1);
+  AddArray(arrays, "fc_weight", 64 * 1024, kBitWidth, kOverlayLinearB, 1,
+           fc_storage);
+  AddArray(arrays, "fc_bias", 512, kBitWidth, 1, 1);
+}
+
+// Ping-pong buffers of the tiles in `Conv2dTiled`, which are the only
+// arrays of `InferenceConvTiled` (the feature maps and weights are in the
+// external memory)
+void AddConvTiledArrays(ArrayList& arrays)
+{
+  using Shape = Conv2dTiledShape<3, 16, 224, 224, 224, 224, 3, 1, 1,
+    kConvTiledTileH, kConvTiledTileW, kConvTiledTileOutCh>;
+  constexpr int kTileOutCh = kConvTiledTileOutCh;
+
+  AddArray(arrays, "x_tile", 3 * Shape::kTileInH * Shape::kTileInW,
+           kBitWidth, 1, 2);
+  AddArray(arrays, "weight_tile", kTileOutCh * 3 * 3 * 3, kBitWidth,
+    CyclicPartition<kTileOutCh, 1, kConvTiledB>::kFactor, 2);
+  AddArray(arrays, "y_tile", kTileOutCh * kConvTiledTileH * kConvTiledTileW,
+    kBitWidth, CyclicPartition<kTileOutCh, kConvTiledB, 1>::kFactor, 2);
+}
+
+// Arrays declared in the top (same as the top, with the factors in
+// hls/src/toynet_plan.hpp)
+ArrayList MakeArrays(const std::string& top, const MemoryStorage fc_storage)
+{
+  ArrayList arrays;
+
+  if (top == "naive") {
+    // No partitioning and no dataflow
+    AddFeatureMaps<1, 1, 1, 1, 1, 1, 1, 1, 1, 1>(arrays);
+    AddArray(arrays, "conv0_weight", 6 * 1 * 5 * 5, kBitWidth, 1, 1);
+    AddArray(arrays, "conv1_weight", 16 * 6 * 5 * 5, kBitWidth, 1, 1);
+    AddArray(arrays, "fc0_weight", 120 * 400, kBitWidth, 1, 1, fc_storage);
+    AddArray(arrays, "fc1_weight", 84 * 120, kBitWidth, 1, 1, fc_storage);
+    AddArray(arrays, "fc2_weight", 10 * 84, kBitWidth, 1, 1, fc_storage);
+    AddBatchNormAndBias<1, 1>(arrays);
+  } else if (top == "opt" || top == "opt2") {
+    // Partition factors written in `InferenceOpt` and `InferenceOpt2`
+    AddFeatureMaps<kOptConv0Factor, kOptConv0Factor, kOptConv0Factor,
+                   kOptConv1Factor, kOptConv1Factor, kOptConv1Factor,
+                   kOptFc0Factor, kOptFc1Factor, kOptFc2Factor, 1>(arrays);
+    AddArray(arrays, "conv0_weight", 6 * 1 * 5 * 5, kBitWidth,
+             kOptConv0Factor, 1);
+    AddArray(arrays, "conv1_weight", 16 * 6 * 5 * 5, kBitWidth,
+             kOptConv1Factor, 1);
+    AddArray(arrays, "fc0_weight", 120 * 400, kBitWidth,
+             kOptFc0Factor, 1, fc_storage);
+    AddArray(arrays, "fc1_weight", 84 * 120, kBitWidth,
+             kOptFc1Factor, 1, fc_storage);
+    AddArray(arrays, "fc2_weight", 10 * 84, kBitWidth,
+             kOptFc2Factor, 1, fc_storage);
+    AddBatchNormAndBias<kOptConv0Factor, kOptConv1Factor>(arrays);
+  } else if (top == "opt3" || top == "pixel" || top == "rle" ||
+             top == "multi" || top == "profile") {
+    AddDataflowFeatureMaps<Conv2d4Ports, Linear3Ports, kOpt3Conv0B,
+      kOpt3Conv1B, kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B>(arrays);
+    AddParams<Conv2d4Ports, Linear3Ports, kOpt3Conv0B, kOpt3Conv1B,
+      kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B, kBitWidth, 1>(arrays, fc_storage);
+
+    // `InferenceMulti` replicates the buffers and parameters in each core
+    if (top == "multi")
+      for (Array& array : arrays)
+        array.copies *= kMultiNumCores;
+
+    // Cycle counters of the stages (input, 10 layers, and output), which
+    // are completely partitioned
+    if (top == "profile")
+      AddArray(arrays, "counters", ProfileCounters<12>::kNum,
+               cycle_count_t::width, ProfileCounters<12>::kNum, 1);
+  } else if (top == "dwsep") {
+    AddDwSepArrays(arrays, fc_storage);
+  } else if (top == "ddr_fc") {
+    AddDdrFcArrays(arrays, fc_storage);
+  } else if (top == "shared") {
+    AddSharedArrays(arrays, fc_storage);
+  } else if (top == "overlay") {
+    AddOverlayArrays(arrays, fc_storage);
+  } else if (top == "conv_tiled") {
+    AddConvTiledArrays(arrays);
+  } else if (top == "empty") {
+    // `InferenceEmpty` has no arrays
+  } else if (top == "packed") {
+    AddDataflowFeatureMaps<Conv2dPackedPorts, LinearPackedPorts, kOpt3Conv0B,
+      kOpt3Conv1B, kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B>(arrays);
+    AddPackedParams<kOpt3Conv0B, kOpt3Conv1B, kOpt3Fc0B, kOpt3Fc1B,
+      kOpt3Fc2B>(arrays, fc_storage);
+  } else if (top == "dual_mac") {
+    AddDataflowFeatureMaps<Conv2dDualMacPorts, LinearDualMacPorts,
+      kOpt3Conv0B, kOpt3Conv1B, kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B>(arrays);
+    AddParams<Conv2dDualMacPorts, LinearDualMacPorts, kOpt3Conv0B,
+      kOpt3Conv1B, kOpt3Fc0B, kOpt3Fc1B, kOpt3Fc2B, kBitWidth,
+      LinearDualMacPorts<kOpt3Fc0B>::kWeightRows>(arrays, fc_storage);
+  } else if (top == "log") {
+    AddDataflowFeatureMaps<Conv2dLogPorts, LinearLogPorts, kLogConv0B,
+      kLogConv1B, kLogFc0B, kLogFc1B, kLogFc2B>(arrays);
+    AddParams<Conv2dLogPorts, LinearLogPorts, kLogConv0B, kLogConv1B,
+      kLogFc0B, kLogFc1B, kLogFc2B, kLogWeightWidth, 1>(arrays, fc_storage);
+  } else {
+    throw std::invalid_argument("Unexpected top: " + top);
+  }
+
+  return arrays;
+}
+
+const Board& FindBoard(const std::string& name)
+{
+  for (const Board& board : kBoards)
+    if (board.name == name)
+      return board;
+
+  throw std::invalid_argument("Unexpected board: " + name);
+}
+
+const char* StorageName(const MemoryResources& res)
+{
+  if (res.bram18 > 0)
+    return "BRAM";
+  if (res.uram > 0)
+    return "URAM";
+  if (res.lutram > 0)
+    return "LUTRAM";
+  return "REG";
+}
+
+// Print the usage of the resource and check it against the budget
+bool CheckBudget(const char* name, long long used, long long budget)
+{
+  const bool fits = used <= budget;
+
+  std::cout << std::left << std::setw(12) << name
+            << std::right << std::setw(10) << used << " / "
+            << std::setw(8) << budget;
+  if (budget > 0)
+    std::cout << " (" << std::fixed << std::setprecision(1)
+              << 100.0 * used / budget << "%)";
+  std::cout << (fits ? "" : "  <- exceeds the budget") << '\n';
+
+  return fits;
+}
+
+// Print the report and return whether the arrays fit in the board
+bool PrintReport(const std::string& top, const Board& board,
+                 const ArrayList& arrays)
+{
+  MemoryResources total { 0, 0, 0, 0 };
+
+  std::cout << "Top: " << top << " (bit width: " << kBitWidth
+            << ", board: " << board.name << ")\n";
+  std::cout << std::left << std::setw(14) << "Array"
+            << std::right << std::setw(8) << "Depth"
+            << std::setw(7) << "Width"
+            << std::setw(7) << "Banks"
+            << std::setw(8) << "Copies"
+            << std::setw(8) << "Type"
+            << std::setw(8) << "BRAM18"
+            << std::setw(6) << "URAM"
+            << std::setw(8) << "LUTRAM"
+            << std::setw(8) << "FFs" << '\n';
+
+  for (const Array& array : arrays) {
+    const MemoryResources res = ArrayResources(
+      array.elements, array.width, array.banks, array.copies, array.storage);
+    total.bram18 += res.bram18;
+    total.uram += res.uram;
+    total.lutram += res.lutram;
+    total.registers += res.registers;
+
+    std::cout << std::left << std::setw(14) << array.name
+              << std::right << std::setw(8)
+              << CeilDiv(array.elements, array.banks)
+              << std::setw(7) << array.width
+              << std::setw(7) << array.banks
+              << std::setw(8) << array.copies
+              << std::setw(8) << StorageName(res)
+              << std::setw(8) << res.bram18
+              << std::setw(6) << res.uram
+              << std::setw(8) << res.lutram
+              << std::setw(8) << res.registers << '\n';
+  }
+
+  // Check all resources, so that the report shows every shortage
+  bool fits = CheckBudget("BRAM18:", total.bram18, board.bram18);
+  fits &= CheckBudget("URAM:", total.uram, board.uram);
+  fits &= CheckBudget("LUTRAM:", total.lutram, board.lutram);
+  fits &= CheckBudget("FFs:", total.registers, board.registers);
+
+  return fits;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const bool uram = argc == 4 && std::string(argv[3]) == "--uram";
+
+  if (argc != 3 && !uram) {
+    std::cerr << "Usage: " << argv[0] << " <Top> <Board> [--uram]\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::string top = argv[1];
+  const MemoryStorage fc_storage = uram ?
+    MemoryStorage::kUram : MemoryStorage::kAuto;
+
+  try {
+    const Board& board = FindBoard(argv[2]);
+
+    if (!PrintReport(top, board, MakeArrays(top, fc_storage))) {
+      std::cerr << "Arrays in " << top << " do not fit in "
+                << board.name << '\n';
+      return EXIT_FAILURE;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+# coding: utf-8
+# overlay_compiler.py
+
+# Compiler for the programmable layer engine (`InferenceOverlay` in
+# hls/src/top_overlay.cpp), which turns a network description into the
+# instruction stream
+# The instruction format follows hls/src/overlay_instruction.hpp, and the
+# capacity follows hls/src/top_overlay.cpp
+
+# Usage:
+# python3 overlay_compiler.py [Output]
+# The encoded program of `ToyNet` is written to <Output> (one word per line)
+# if given, e.g., for the C simulation (host/model/toynet_overlay_test.cpp)
+
+# Example:
+# python3 overlay_compiler.py
+
+import collections
+import sys
+
+# Operation codes
+OP_INPUT = 1
+OP_CONV2D = 2
+OP_MAX_POOL2D = 3
+OP_BATCH_NORM2D_RELU = 4
+OP_FLATTEN = 5
+OP_LINEAR = 6
+OP_OUTPUT = 7
+
+# Flags
+FLAG_RELU = 1
+
+# Number of words per instruction
+INSTRUCTION_WORDS = 16
+
+# Capacity of the programmable layer engine
+MAX_INSTRUCTIONS = 32
+MAX_C = 16
+MAX_K = 7
+MAX_HW = 28 * 28
+FMAP_SIZE = 2 * MAX_HW
+MAX_DIMS = 512
+VEC_SIZE = 2 * MAX_DIMS
+MAX_CONV_WEIGHT_COLS = 512
+MAX_BN_LAYERS = 4
+LINEAR_WEIGHT_SIZE = 64 * 1024
+LINEAR_BIAS_SIZE = 512
+LINEAR_B = 16
+
+# Network description
+Input = collections.namedtuple("Input", ["channels", "height", "width"])
+Conv2d = collections.namedtuple(
+    "Conv2d", ["in_channels", "out_channels", "kernel_size",
+               "padding", "stride"])
+MaxPool2d = collections.namedtuple("MaxPool2d", ["kernel_size"])
+BatchNorm2dReLU = collections.namedtuple("BatchNorm2dReLU", ["num_features"])
+Flatten = collections.namedtuple("Flatten", [])
+Linear = collections.namedtuple(
+    "Linear", ["in_features", "out_features", "relu"])
+
+# Instruction (same order of the fields as `OverlayInstruction`)
+Instruction = collections.namedtuple(
+    "Instruction", ["opcode", "src", "dst", "in_ch", "out_ch",
+                    "h", "w", "oh", "ow", "k", "pad", "stride", "flags",
+                    "param_offset", "bias_offset", "in_stride"])
+
+def _instruction(opcode: int, **kwargs) -> Instruction:
+    fields = { f: 0 for f in Instruction._fields }
+    fields["opcode"] = opcode
+    fields.update(kwargs)
+    return Instruction(**fields)
+
+def _check(cond: bool, message: str):
+    if not cond:
+        raise ValueError(f"Network exceeds the overlay capacity: {message}")
+
+def _round_up(x: int, b: int) -> int:
+    return (x + b - 1) // b * b
+
+def compile_network(layers: list) -> list:
+    # Compile the network description (`Input` followed by the layers) into
+    # the list of instructions
+    # The feature maps and vectors alternate between the two halves of the
+    # feature map and vector memories, and the parameters are packed into
+    # the parameter memories in the order of the layers
+    _check(len(layers) > 0 and isinstance(layers[0], Input),
+           "network must start with `Input`")
+
+    insts = []
+    fmap_bufs = [0, MAX_HW]
+    vec_bufs = [0, MAX_DIMS]
+    conv_cols = 0
+    bn_layers = 0
+    fc_weights = 0
+    fc_biases = 0
+
+    # Current shape and buffer
+    c, h, w = layers[0].channels, layers[0].height, layers[0].width
+    dims = None
+    cur = 0
+
+    _check(c <= MAX_C, f"{c} input channels")
+    _check(h * w <= MAX_HW, f"input of size {h}x{w}")
+    insts.append(_instruction(OP_INPUT, dst=fmap_bufs[cur],
+                              in_ch=c, h=h, w=w))
+
+    for layer in layers[1:]:
+        nxt = 1 - cur
+
+        if isinstance(layer, Conv2d):
+            _check(dims is None, "convolution after `Flatten`")
+            _check(layer.in_channels == c, f"input channels of {layer}")
+            k, p, s = layer.kernel_size, layer.padding, layer.stride
+            oh = (h + 2 * p - k) // s + 1
+            ow = (w + 2 * p - k) // s + 1
+            cols = layer.in_channels * k * k
+            _check(layer.out_channels <= MAX_C,
+                   f"{layer.out_channels} output channels")
+            _check(k <= MAX_K, f"kernel size {k}")
+            _check(oh * ow <= MAX_HW, f"output of size {oh}x{ow}")
+            _check(conv_cols + cols <= MAX_CONV_WEIGHT_COLS,
+                   "too many convolution weights")
+            insts.append(_instruction(
+                OP_CONV2D, src=fmap_bufs[cur], dst=fmap_bufs[nxt],
+                in_ch=c, out_ch=layer.out_channels, h=h, w=w, oh=oh, ow=ow,
+                k=k, pad=p, stride=s, param_offset=conv_cols))
+            conv_cols += cols
+            c, h, w = layer.out_channels, oh, ow
+        elif isinstance(layer, MaxPool2d):
+            _check(dims is None, "max-pooling after `Flatten`")
+            k = layer.kernel_size
+            _check(k <= MAX_K, f"kernel size {k}")
+            _check(h % k == 0 and w % k == 0,
+                   f"input of size {h}x{w} is not a multiple of {k}")
+            insts.append(_instruction(
+                OP_MAX_POOL2D, src=fmap_bufs[cur], dst=fmap_bufs[nxt],
+                in_ch=c, out_ch=c, h=h, w=w, oh=h // k, ow=w // k,
+                k=k, stride=k))
+            h, w = h // k, w // k
+        elif isinstance(layer, BatchNorm2dReLU):
+            _check(dims is None, "batch normalization after `Flatten`")
+            _check(layer.num_features == c, f"features of {layer}")
+            _check(bn_layers < MAX_BN_LAYERS, "too many batch normalizations")
+            insts.append(_instruction(
+                OP_BATCH_NORM2D_RELU, src=fmap_bufs[cur], dst=fmap_bufs[nxt],
+                in_ch=c, out_ch=c, h=h, w=w, oh=h, ow=w,
+                param_offset=bn_layers))
+            bn_layers += 1
+        elif isinstance(layer, Flatten):
+            _check(dims is None, "`Flatten` is applied twice")
+            dims = c * h * w
+            _check(dims <= MAX_DIMS, f"{dims} flattened dimensions")
+            insts.append(_instruction(
+                OP_FLATTEN, src=fmap_bufs[cur], dst=vec_bufs[nxt],
+                in_ch=c, h=h, w=w))
+        elif isinstance(layer, Linear):
+            _check(dims is not None, "fully-connected layer before `Flatten`")
+            _check(layer.in_features == dims, f"input features of {layer}")
+            _check(layer.out_features <= MAX_DIMS,
+                   f"{layer.out_features} output features")
+            # Rows of the weights are zero-padded to a multiple of `B`
+            in_stride = _round_up(layer.in_features, LINEAR_B)
+            weight_size = in_stride * layer.out_features
+            _check(fc_weights + weight_size <= LINEAR_WEIGHT_SIZE,
+                   "too many fully-connected weights")
+            _check(fc_biases + layer.out_features <= LINEAR_BIAS_SIZE,
+                   "too many fully-connected biases")
+            insts.append(_instruction(
+                OP_LINEAR, src=vec_bufs[cur], dst=vec_bufs[nxt],
+                in_ch=layer.in_features, out_ch=layer.out_features,
+                flags=FLAG_RELU if layer.relu else 0,
+                param_offset=fc_weights, bias_offset=fc_biases,
+                in_stride=in_stride))
+            fc_weights += weight_size
+            fc_biases += layer.out_features
+            dims = layer.out_features
+        else:
+            raise ValueError(f"Unsupported layer: {layer}")
+
+        cur = nxt
+
+    _check(dims is not None, "network must end with a fully-connected layer")
+    insts.append(_instruction(OP_OUTPUT, src=vec_bufs[cur], in_ch=dims))
+
+    # One more entry is used for the end marker
+    _check(len(insts) < MAX_INSTRUCTIONS, f"{len(insts)} instructions")
+    return insts
+
+def encode_program(insts: list) -> list:
+    # Encode the instructions into the 32-bit words sent after the mode
+    # (number of instructions followed by the instructions)
+    words = [len(insts)]
+    for inst in insts:
+        words.extend(int(x) for x in inst)
+    assert len(words) == 1 + len(insts) * INSTRUCTION_WORDS
+    return words
+
+def toynet_layers() -> list:
+    # Network description of `ToyNet`
+    return [
+        Input(1, 28, 28),
+        Conv2d(1, 6, kernel_size=5, padding=2, stride=1),
+        MaxPool2d(2),
+        BatchNorm2dReLU(6),
+        Conv2d(6, 16, kernel_size=5, padding=0, stride=1),
+        MaxPool2d(2),
+        BatchNorm2dReLU(16),
+        Flatten(),
+        Linear(400, 120, relu=True),
+        Linear(120, 84, relu=True),
+        Linear(84, 10, relu=False),
+    ]
+
+def main():
+    insts = compile_network(toynet_layers())
+    words = encode_program(insts)
+    for inst in insts:
+        print(inst)
+    print(" ".join(str(x) for x in words))
+
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "w") as f:
+            f.writelines(f"{x}\n" for x in words)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,50 @@
+// toynet_backend.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_BACKEND_HPP
+#define TOYNET_RUNTIME_TOYNET_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Interface to the accelerator
+// Each transaction sends the words to the input stream (MM2S channel of
+// the AXI DMA) and receives the words from the output stream (S2MM
+// channel), in the same format as the Python host programs
+class ToyNetBackend
+{
+public:
+  // Independent transaction submitted with the others
+  struct Segment
+  {
+    const std::uint32_t* tx;
+    std::size_t tx_len;
+    std::uint32_t* rx;
+    std::size_t rx_len;
+    // Number of words in each output packet (terminated by `TLAST`), which
+    // is `rx_len` if the output is not split
+    std::size_t rx_packet_len;
+  };
+
+  virtual ~ToyNetBackend() = default;
+
+  // Send `tx_len` words from `tx` and receive `rx_len` words to `rx`
+  // Blocks until all words are received, and throws `std::runtime_error`
+  // if the transaction fails
+  virtual void Transfer(const std::uint32_t* tx,
+                        std::size_t tx_len,
+                        std::uint32_t* rx,
+                        std::size_t rx_len) = 0;
+
+  // Run the transactions in order, and block until all of them complete
+  // The backends may chain them into one submission, while the default
+  // implementation runs them one by one
+  virtual void TransferBatch(const Segment* segments,
+                             std::size_t num_segments)
+  {
+    for (std::size_t i = 0; i < num_segments; ++i)
+      this->Transfer(segments[i].tx, segments[i].tx_len,
+                     segments[i].rx, segments[i].rx_len);
+  }
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_BACKEND_HPP
@@ -0,0 +1,46 @@
+// toynet_device_memory.cpp
+
+#include "toynet_device_memory.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MappedRegion::MappedRegion(const std::string& path,
+                           std::uint64_t offset,
+                           std::size_t size) :
+  fd_(-1), data_(nullptr), size_(size)
+{
+  fd_ = open(path.c_str(), O_RDWR | O_SYNC);
+  if (fd_ < 0)
+    throw std::runtime_error("Failed to open " + path);
+
+  data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd_, static_cast<off_t>(offset));
+  if (data_ == MAP_FAILED) {
+    close(fd_);
+    throw std::runtime_error("Failed to map " + path);
+  }
+}
+
+MappedRegion::~MappedRegion()
+{
+  munmap(data_, size_);
+  close(fd_);
+}
+
+std::uint64_t ReadUdmabufAttribute(const std::string& name,
+                                   const std::string& attr)
+{
+  const std::string path = "/sys/class/u-dma-buf/" + name + "/" + attr;
+  std::ifstream ifs(path);
+  std::string str;
+
+  if (!(ifs >> str))
+    throw std::runtime_error("Failed to read " + path);
+
+  return std::stoull(str, nullptr, 0);
+}
@@ -0,0 +1,37 @@
+// toynet_device_memory.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_DEVICE_MEMORY_HPP
+#define TOYNET_RUNTIME_TOYNET_DEVICE_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Region of the device file mapped to the user space (e.g., the registers
+// from /dev/mem, or the buffers from the u-dma-buf device)
+// The file is opened with `O_SYNC`, so that the mapping is uncached
+class MappedRegion
+{
+public:
+  MappedRegion(const std::string& path, std::uint64_t offset,
+               std::size_t size);
+  ~MappedRegion();
+
+  MappedRegion(const MappedRegion&) = delete;
+  MappedRegion& operator=(const MappedRegion&) = delete;
+
+  void* Data() const { return data_; }
+  std::size_t Size() const { return size_; }
+
+private:
+  int fd_;
+  void* data_;
+  std::size_t size_;
+};
+
+// Read the attribute of the u-dma-buf device from sysfs (e.g., "phys_addr"
+// and "size")
+std::uint64_t ReadUdmabufAttribute(const std::string& name,
+                                   const std::string& attr);
+
+#endif // TOYNET_RUNTIME_TOYNET_DEVICE_MEMORY_HPP
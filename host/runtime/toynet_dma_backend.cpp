@@ -0,0 +1,151 @@
+// toynet_dma_backend.cpp
+
+#include "toynet_dma_backend.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Register offsets of the AXI DMA (simple mode)
+constexpr std::size_t kMm2sControl = 0x00;
+constexpr std::size_t kMm2sStatus = 0x04;
+constexpr std::size_t kMm2sSourceAddr = 0x18;
+constexpr std::size_t kMm2sSourceAddrMsb = 0x1C;
+constexpr std::size_t kMm2sLength = 0x28;
+constexpr std::size_t kS2mmControl = 0x30;
+constexpr std::size_t kS2mmStatus = 0x34;
+constexpr std::size_t kS2mmDestAddr = 0x48;
+constexpr std::size_t kS2mmDestAddrMsb = 0x4C;
+constexpr std::size_t kS2mmLength = 0x58;
+// Size of the register space
+constexpr std::size_t kRegisterSpaceSize = 0x10000;
+
+// Bits of the control registers
+constexpr std::uint32_t kControlRunStop = 1U << 0;
+constexpr std::uint32_t kControlReset = 1U << 2;
+// Bits of the status registers
+constexpr std::uint32_t kStatusErrors = (1U << 4) | (1U << 5) | (1U << 6);
+constexpr std::uint32_t kStatusIoc = 1U << 12;
+
+// Timeout of each transaction
+constexpr auto kTimeout = std::chrono::seconds(10);
+
+} // namespace
+
+ToyNetDmaBackend::ToyNetDmaBackend(std::uint64_t dma_base,
+                                   const std::string& udmabuf_name) :
+  regs_("/dev/mem", dma_base, kRegisterSpaceSize),
+  buf_("/dev/" + udmabuf_name, 0,
+       ReadUdmabufAttribute(udmabuf_name, "size")),
+  buf_phys_addr_(ReadUdmabufAttribute(udmabuf_name, "phys_addr"))
+{
+  this->Reset();
+}
+
+void ToyNetDmaBackend::Transfer(const std::uint32_t* tx,
+                                std::size_t tx_len,
+                                std::uint32_t* rx,
+                                std::size_t rx_len)
+{
+  const std::size_t half_size = buf_.Size() / 2;
+  const std::size_t tx_bytes = tx_len * sizeof(std::uint32_t);
+  const std::size_t rx_bytes = rx_len * sizeof(std::uint32_t);
+
+  if (tx_bytes > half_size || rx_bytes > half_size)
+    throw std::runtime_error("Transaction exceeds the transfer buffers");
+
+  const std::uint64_t tx_addr = buf_phys_addr_;
+  const std::uint64_t rx_addr = buf_phys_addr_ + half_size;
+
+  std::uint8_t* buf = static_cast<std::uint8_t*>(buf_.Data());
+  std::memcpy(buf, tx, tx_bytes);
+
+  // The S2MM channel is started first, so that the output stream is not
+  // stalled when the accelerator starts writing
+  this->StartReceive(rx_addr, rx_bytes);
+
+  this->WriteRegister(kMm2sSourceAddr, static_cast<std::uint32_t>(tx_addr));
+  this->WriteRegister(kMm2sSourceAddrMsb,
+                      static_cast<std::uint32_t>(tx_addr >> 32));
+  this->WriteRegister(kMm2sLength, static_cast<std::uint32_t>(tx_bytes));
+
+  // The accelerator asserts `TLAST` at the end of each output sample, which
+  // terminates the S2MM transfer, so the channel is restarted until all
+  // words are received (the length register holds the received bytes)
+  std::size_t received = 0;
+
+  while (received < rx_bytes) {
+    this->Wait(kS2mmStatus);
+    const std::size_t len = this->ReadRegister(kS2mmLength);
+
+    if (len == 0)
+      throw std::runtime_error("DMA received an empty packet");
+
+    received += len;
+    if (received < rx_bytes)
+      this->StartReceive(rx_addr + received, rx_bytes - received);
+  }
+
+  this->Wait(kMm2sStatus);
+
+  std::memcpy(rx, buf + half_size, rx_bytes);
+}
+
+std::uint32_t ToyNetDmaBackend::ReadRegister(std::size_t offset) const
+{
+  return static_cast<volatile std::uint32_t*>(
+    regs_.Data())[offset / sizeof(std::uint32_t)];
+}
+
+void ToyNetDmaBackend::WriteRegister(std::size_t offset, std::uint32_t val)
+{
+  static_cast<volatile std::uint32_t*>(
+    regs_.Data())[offset / sizeof(std::uint32_t)] = val;
+}
+
+void ToyNetDmaBackend::StartReceive(std::uint64_t addr, std::size_t len)
+{
+  this->WriteRegister(kS2mmDestAddr, static_cast<std::uint32_t>(addr));
+  this->WriteRegister(kS2mmDestAddrMsb, static_cast<std::uint32_t>(addr >> 32));
+  this->WriteRegister(kS2mmLength, static_cast<std::uint32_t>(len));
+}
+
+void ToyNetDmaBackend::Reset()
+{
+  // Reset both channels (the reset of one channel resets the other) and
+  // start them
+  this->WriteRegister(kMm2sControl, kControlReset);
+  while (this->ReadRegister(kMm2sControl) & kControlReset)
+    ;
+
+  this->WriteRegister(kMm2sControl, kControlRunStop);
+  this->WriteRegister(kS2mmControl, kControlRunStop);
+}
+
+void ToyNetDmaBackend::Wait(std::size_t status_offset)
+{
+  // Poll the completion (`IOC_Irq`) or error bits of the status register
+  const auto start = std::chrono::steady_clock::now();
+
+  while (true) {
+    const std::uint32_t status = this->ReadRegister(status_offset);
+
+    if (status & kStatusErrors) {
+      this->Reset();
+      throw std::runtime_error("DMA transfer failed");
+    }
+
+    if (status & kStatusIoc) {
+      // Clear the completion bit
+      this->WriteRegister(status_offset, kStatusIoc);
+      return;
+    }
+
+    if (std::chrono::steady_clock::now() - start > kTimeout) {
+      this->Reset();
+      throw std::runtime_error("DMA transfer timed out");
+    }
+  }
+}
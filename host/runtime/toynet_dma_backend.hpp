@@ -0,0 +1,49 @@
+// toynet_dma_backend.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_DMA_BACKEND_HPP
+#define TOYNET_RUNTIME_TOYNET_DMA_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "toynet_backend.hpp"
+#include "toynet_device_memory.hpp"
+
+// Backend that drives the AXI DMA (simple mode) in the board design
+// The DMA registers are mapped from /dev/mem, and the transfer buffers are
+// allocated from the u-dma-buf device (physically contiguous and
+// uncached), whose first and second halves are used for the MM2S and S2MM
+// channels, respectively
+// The accelerator must be started with `AP_START` and `AUTO_RESTART`
+// beforehand (e.g., by loading the bitstream with PYNQ)
+class ToyNetDmaBackend : public ToyNetBackend
+{
+public:
+  // `dma_base` is the physical address of the AXI DMA registers, and
+  // `udmabuf_name` is the name of the u-dma-buf device (e.g., "udmabuf0")
+  ToyNetDmaBackend(std::uint64_t dma_base, const std::string& udmabuf_name);
+
+  ToyNetDmaBackend(const ToyNetDmaBackend&) = delete;
+  ToyNetDmaBackend& operator=(const ToyNetDmaBackend&) = delete;
+
+  void Transfer(const std::uint32_t* tx,
+                std::size_t tx_len,
+                std::uint32_t* rx,
+                std::size_t rx_len) override;
+
+private:
+  std::uint32_t ReadRegister(std::size_t offset) const;
+  void WriteRegister(std::size_t offset, std::uint32_t val);
+  void StartReceive(std::uint64_t addr, std::size_t len);
+  void Reset();
+  void Wait(std::size_t status_offset);
+
+  // Mapped DMA registers and transfer buffers
+  MappedRegion regs_;
+  MappedRegion buf_;
+  // Physical address of the transfer buffers
+  std::uint64_t buf_phys_addr_;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_DMA_BACKEND_HPP
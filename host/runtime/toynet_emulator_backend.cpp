@@ -0,0 +1,97 @@
+// toynet_emulator_backend.cpp
+
+#include "toynet_emulator_backend.hpp"
+
+#include <stdexcept>
+
+#include "data_types.hpp"
+
+// Top function of the accelerator (hls/src/top_opt3.cpp)
+void InferenceOpt3(hls::stream<axi_stream_data_t>& in_stream,
+                   hls::stream<axi_stream_data_t>& out_stream);
+
+ToyNetEmulatorBackend::ToyNetEmulatorBackend() :
+  stop_(false)
+{
+  device_thread_ = std::thread(&ToyNetEmulatorBackend::Run, this);
+}
+
+ToyNetEmulatorBackend::~ToyNetEmulatorBackend()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+
+  cond_.notify_all();
+  device_thread_.join();
+}
+
+void ToyNetEmulatorBackend::Transfer(const std::uint32_t* tx,
+                                     std::size_t tx_len,
+                                     std::uint32_t* rx,
+                                     std::size_t rx_len)
+{
+  Transaction trans { tx, tx_len, rx, rx_len, std::promise<void>() };
+  std::future<void> done = trans.done.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(&trans);
+  }
+
+  cond_.notify_all();
+  done.get();
+}
+
+void ToyNetEmulatorBackend::Run()
+{
+  hls::stream<axi_stream_data_t> in_stream;
+  hls::stream<axi_stream_data_t> out_stream;
+
+  while (true) {
+    Transaction* trans;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+
+      if (queue_.empty())
+        return;
+
+      trans = queue_.front();
+      queue_.pop_front();
+    }
+
+    // Send the words (same as the MM2S channel of the AXI DMA)
+    for (std::size_t i = 0; i < trans->tx_len; ++i) {
+      axi_stream_data_t in_data;
+      in_data.data = trans->tx[i];
+      in_data.keep = -1;
+      in_data.strb = -1;
+      in_data.last = (i == trans->tx_len - 1);
+      in_stream.write(in_data);
+    }
+
+    // Run the accelerator until the input stream is consumed
+    while (!in_stream.empty())
+      InferenceOpt3(in_stream, out_stream);
+
+    // Receive the words (same as the S2MM channel of the AXI DMA)
+    if (out_stream.size() < trans->rx_len) {
+      // Discard the incomplete output
+      while (!out_stream.empty())
+        out_stream.read();
+
+      trans->done.set_exception(std::make_exception_ptr(
+        std::runtime_error("Accelerator returned fewer words than expected")));
+      continue;
+    }
+
+    for (std::size_t i = 0; i < trans->rx_len; ++i)
+      trans->rx[i] = static_cast<std::uint32_t>(
+        out_stream.read().data.to_uint());
+
+    trans->done.set_value();
+  }
+}
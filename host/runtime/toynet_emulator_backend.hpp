@@ -0,0 +1,57 @@
+// toynet_emulator_backend.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_EMULATOR_BACKEND_HPP
+#define TOYNET_RUNTIME_TOYNET_EMULATOR_BACKEND_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "toynet_backend.hpp"
+
+// Backend that runs the C model of the accelerator (`InferenceOpt3` in
+// hls/src/top_opt3.cpp) in-process
+// The C model is invoked on a device thread that owns the input and output
+// streams, and is restarted while the input stream has words left, in the
+// same way as the accelerator with `AUTO_RESTART`
+// The model parameters are static in the C model, so only one emulator
+// backend should exist at a time
+class ToyNetEmulatorBackend : public ToyNetBackend
+{
+public:
+  ToyNetEmulatorBackend();
+  ~ToyNetEmulatorBackend() override;
+
+  ToyNetEmulatorBackend(const ToyNetEmulatorBackend&) = delete;
+  ToyNetEmulatorBackend& operator=(const ToyNetEmulatorBackend&) = delete;
+
+  void Transfer(const std::uint32_t* tx,
+                std::size_t tx_len,
+                std::uint32_t* rx,
+                std::size_t rx_len) override;
+
+private:
+  // Transaction passed to the device thread
+  struct Transaction
+  {
+    const std::uint32_t* tx;
+    std::size_t tx_len;
+    std::uint32_t* rx;
+    std::size_t rx_len;
+    std::promise<void> done;
+  };
+
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Transaction*> queue_;
+  bool stop_;
+  std::thread device_thread_;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_EMULATOR_BACKEND_HPP
@@ -0,0 +1,40 @@
+// toynet_inference.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_INFERENCE_HPP
+#define TOYNET_RUNTIME_TOYNET_INFERENCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+// Interface to the inference on ToyNet, implemented by the host runtime of
+// the accelerator (`ToyNetRuntime`) and the inference server on the CPU
+// (`ToyNetCpuServer` in host/cpu_server), so that the callers can switch
+// between them (e.g., to the CPU when the accelerator is busy or not
+// available)
+// The images are of size 1x28x28, and the outputs are the logits for 10
+// classes
+class ToyNetInference
+{
+public:
+  virtual ~ToyNetInference() = default;
+
+  // Set the model parameters, in the same order as the Python host
+  // programs (conv0, bn0, conv1, bn1, linear0, linear1, and linear2)
+  virtual void InitWeights(const std::vector<float>& params) = 0;
+
+  // Run the inference on `num_samples` images and write the outputs
+  virtual void Infer(const float* images, std::size_t num_samples,
+                     float* outputs) = 0;
+  virtual std::vector<float> Infer(const std::vector<float>& images) = 0;
+
+  // Submit the inference on the normalized images without blocking
+  virtual std::future<std::vector<float>> Submit(
+    std::vector<float> images) = 0;
+  // Submit the inference on the 8-bit images (MNIST pixels)
+  virtual std::future<std::vector<float>> Submit(
+    std::vector<std::uint8_t> images) = 0;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_INFERENCE_HPP
@@ -0,0 +1,314 @@
+// toynet_runtime.cpp
+
+#include "toynet_runtime.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// Operation modes (hls/src/data_types.hpp)
+constexpr std::uint32_t kModeInitWeights = 1;
+constexpr std::uint32_t kModeInference = 2;
+
+// Mean and standard deviation of the MNIST dataset (same as the
+// `Normalize` transform in the Python host programs)
+constexpr float kMnistMean = 0.1307f;
+constexpr float kMnistStd = 0.3081f;
+
+// Write the header of the inference request
+void PackInferenceHeader(std::vector<std::uint32_t>& words,
+                         std::size_t num_samples,
+                         std::size_t num_elements)
+{
+  words.resize(2 + num_elements);
+  words[0] = kModeInference;
+  words[1] = static_cast<std::uint32_t>(num_samples);
+}
+
+// Copy the floats to the words without conversion
+void PackFloats(std::uint32_t* words, const float* values, std::size_t len)
+{
+  std::memcpy(words, values, len * sizeof(float));
+}
+
+// Normalize the 8-bit pixels and copy them to the words
+void PackPixels(std::uint32_t* words,
+                const std::uint8_t* pixels,
+                std::size_t len)
+{
+  for (std::size_t i = 0; i < len; ++i) {
+    const float x = (static_cast<float>(pixels[i]) / 255.0f - kMnistMean)
+                    / kMnistStd;
+    std::memcpy(words + i, &x, sizeof(float));
+  }
+}
+
+// Convert the received words to the outputs
+std::vector<float> UnpackOutputs(const std::vector<std::uint32_t>& words)
+{
+  std::vector<float> outputs(words.size());
+  std::memcpy(outputs.data(), words.data(), words.size() * sizeof(float));
+  return outputs;
+}
+
+// Check the number of images and return the number of samples
+std::size_t NumSamples(std::size_t num_elements)
+{
+  if (num_elements % ToyNetRuntime::kInputSize != 0)
+    throw std::invalid_argument("Images are not a multiple of the input size");
+
+  return num_elements / ToyNetRuntime::kInputSize;
+}
+
+} // namespace
+
+constexpr std::size_t ToyNetRuntime::kInputSize;
+constexpr std::size_t ToyNetRuntime::kOutputSize;
+constexpr std::size_t ToyNetRuntime::kNumParams;
+constexpr std::size_t ToyNetRuntime::kDefaultNumBuffers;
+
+ToyNetRuntime::ToyNetRuntime(std::unique_ptr<ToyNetBackend> backend,
+                             std::size_t num_buffers) :
+  backend_(std::move(backend)), stop_packing_(false), stop_device_(false)
+{
+  if (!backend_)
+    throw std::invalid_argument("Backend is not specified");
+  if (num_buffers == 0)
+    throw std::invalid_argument("At least one transfer buffer is required");
+
+  for (std::size_t i = 0; i < num_buffers; ++i) {
+    batches_.emplace_back(new Batch());
+    free_batches_.push_back(batches_.back().get());
+  }
+
+  packing_thread_ = std::thread(&ToyNetRuntime::RunPacking, this);
+  device_thread_ = std::thread(&ToyNetRuntime::RunDevice, this);
+}
+
+ToyNetRuntime::~ToyNetRuntime()
+{
+  // Pending requests are processed before stopping
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_packing_ = true;
+  }
+
+  cond_.notify_all();
+  packing_thread_.join();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_device_ = true;
+  }
+
+  cond_.notify_all();
+  device_thread_.join();
+}
+
+void ToyNetRuntime::InitWeights(const std::vector<float>& params)
+{
+  if (params.size() != kNumParams)
+    throw std::invalid_argument("Unexpected number of model parameters");
+
+  const std::uint32_t ack = this->Enqueue<std::uint32_t>(
+    [&params](std::vector<std::uint32_t>& tx) {
+      tx.resize(1 + params.size());
+      tx[0] = kModeInitWeights;
+      PackFloats(tx.data() + 1, params.data(), params.size());
+    }, 1, 1,
+    [](const std::vector<std::uint32_t>& rx) { return rx[0]; }).get();
+
+  if (ack != 1)
+    throw std::runtime_error("Weight initialization is not acknowledged");
+}
+
+void ToyNetRuntime::Infer(const float* images,
+                          std::size_t num_samples,
+                          float* outputs)
+{
+  // The caller's buffers are valid until the request completes
+  this->Enqueue<int>(
+    [images, num_samples](std::vector<std::uint32_t>& tx) {
+      PackInferenceHeader(tx, num_samples, num_samples * kInputSize);
+      PackFloats(tx.data() + 2, images, num_samples * kInputSize);
+    }, num_samples * kOutputSize, kOutputSize,
+    [outputs](const std::vector<std::uint32_t>& rx) {
+      std::memcpy(outputs, rx.data(), rx.size() * sizeof(float));
+      return 0;
+    }).get();
+}
+
+std::vector<float> ToyNetRuntime::Infer(const std::vector<float>& images)
+{
+  const std::size_t num_samples = NumSamples(images.size());
+  std::vector<float> outputs(num_samples * kOutputSize);
+  this->Infer(images.data(), num_samples, outputs.data());
+  return outputs;
+}
+
+std::future<std::vector<float>> ToyNetRuntime::Submit(
+  std::vector<float> images)
+{
+  const std::size_t num_samples = NumSamples(images.size());
+  // Move the images into the request, which outlives the caller's buffer
+  auto request = std::make_shared<std::vector<float>>(std::move(images));
+
+  return this->Enqueue<std::vector<float>>(
+    [request, num_samples](std::vector<std::uint32_t>& tx) {
+      PackInferenceHeader(tx, num_samples, request->size());
+      PackFloats(tx.data() + 2, request->data(), request->size());
+    }, num_samples * kOutputSize, kOutputSize, UnpackOutputs);
+}
+
+std::future<std::vector<float>> ToyNetRuntime::Submit(
+  std::vector<std::uint8_t> images)
+{
+  const std::size_t num_samples = NumSamples(images.size());
+  auto request = std::make_shared<std::vector<std::uint8_t>>(
+    std::move(images));
+
+  return this->Enqueue<std::vector<float>>(
+    [request, num_samples](std::vector<std::uint32_t>& tx) {
+      PackInferenceHeader(tx, num_samples, request->size());
+      PackPixels(tx.data() + 2, request->data(), request->size());
+    }, num_samples * kOutputSize, kOutputSize, UnpackOutputs);
+}
+
+template <typename R>
+std::future<R> ToyNetRuntime::Enqueue(
+  std::function<void(std::vector<std::uint32_t>&)> pack,
+  std::size_t rx_len,
+  std::size_t rx_packet_len,
+  std::function<R(const std::vector<std::uint32_t>&)> finish)
+{
+  auto promise = std::make_shared<std::promise<R>>();
+  std::future<R> result = promise->get_future();
+
+  Request request;
+  request.pack = std::move(pack);
+  request.rx_len = rx_len;
+  request.rx_packet_len = rx_packet_len;
+  request.complete = [promise, finish](
+    const std::vector<std::uint32_t>& rx) {
+    try {
+      promise->set_value(finish(rx));
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  };
+  request.fail = [promise](std::exception_ptr e) {
+    promise->set_exception(e);
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_packing_)
+      throw std::runtime_error("Runtime is stopped");
+    requests_.push_back(std::move(request));
+  }
+
+  cond_.notify_all();
+  return result;
+}
+
+void ToyNetRuntime::RunPacking()
+{
+  while (true) {
+    Request request;
+    Batch* batch;
+
+    {
+      // Wait for both the request and free transfer buffer
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] {
+        return (stop_packing_ && requests_.empty())
+               || (!requests_.empty() && !free_batches_.empty()); });
+
+      if (requests_.empty())
+        return;
+
+      request = std::move(requests_.front());
+      requests_.pop_front();
+      batch = free_batches_.front();
+      free_batches_.pop_front();
+    }
+
+    // Prepare the buffer while the previous one is in flight
+    // The capacity of the buffers is reused across the requests
+    bool packed = true;
+
+    try {
+      request.pack(batch->tx);
+      batch->rx.resize(request.rx_len);
+      batch->rx_packet_len = request.rx_packet_len;
+      batch->complete = std::move(request.complete);
+      batch->fail = std::move(request.fail);
+    } catch (...) {
+      request.fail(std::current_exception());
+      packed = false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (packed)
+        ready_batches_.push_back(batch);
+      else
+        free_batches_.push_back(batch);
+    }
+
+    cond_.notify_all();
+  }
+}
+
+void ToyNetRuntime::RunDevice()
+{
+  std::vector<Batch*> batches;
+  std::vector<ToyNetBackend::Segment> segments;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] {
+        return stop_device_ || !ready_batches_.empty(); });
+
+      if (ready_batches_.empty())
+        return;
+
+      // Take all prepared batches
+      batches.assign(ready_batches_.begin(), ready_batches_.end());
+      ready_batches_.clear();
+    }
+
+    segments.clear();
+    for (Batch* batch : batches)
+      segments.push_back(ToyNetBackend::Segment {
+        batch->tx.data(), batch->tx.size(),
+        batch->rx.data(), batch->rx.size(), batch->rx_packet_len });
+
+    try {
+      backend_->TransferBatch(segments.data(), segments.size());
+
+      for (Batch* batch : batches)
+        batch->complete(batch->rx);
+    } catch (...) {
+      // The results of the failed submission are not reliable
+      for (Batch* batch : batches)
+        batch->fail(std::current_exception());
+    }
+
+    for (Batch* batch : batches) {
+      batch->complete = nullptr;
+      batch->fail = nullptr;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_batches_.insert(free_batches_.end(),
+                           batches.begin(), batches.end());
+    }
+
+    cond_.notify_all();
+  }
+}
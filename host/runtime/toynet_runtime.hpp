@@ -0,0 +1,116 @@
+// toynet_runtime.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_RUNTIME_HPP
+#define TOYNET_RUNTIME_TOYNET_RUNTIME_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "toynet_backend.hpp"
+#include "toynet_inference.hpp"
+
+// Host runtime for the ToyNet accelerator
+// Requests go through the two-stage pipeline: the packing thread copies
+// (and normalizes) the inputs into the transfer buffer, while the device
+// thread runs the transaction of the previous buffer on the backend
+// The transfer buffers are recycled from the fixed pool, so that at most
+// `num_buffers` batches are prepared or in flight at a time (two buffers
+// for double buffering), and the device thread submits all prepared
+// batches at once (chained into one submission by the scatter-gather
+// backends)
+class ToyNetRuntime : public ToyNetInference
+{
+public:
+  // Number of elements in an input image (1x28x28)
+  static constexpr std::size_t kInputSize = 784;
+  // Number of elements in an output (logits for 10 classes)
+  static constexpr std::size_t kOutputSize = 10;
+  // Number of model parameters (batch normalization layers have the scale,
+  // bias, and mean)
+  static constexpr std::size_t kNumParams = 61750;
+  // Default number of transfer buffers
+  static constexpr std::size_t kDefaultNumBuffers = 2;
+
+  explicit ToyNetRuntime(std::unique_ptr<ToyNetBackend> backend,
+                         std::size_t num_buffers = kDefaultNumBuffers);
+  ~ToyNetRuntime() override;
+
+  ToyNetRuntime(const ToyNetRuntime&) = delete;
+  ToyNetRuntime& operator=(const ToyNetRuntime&) = delete;
+
+  // Transfer the model parameters, in the same order as the Python host
+  // programs (conv0, bn0, conv1, bn1, linear0, linear1, and linear2)
+  void InitWeights(const std::vector<float>& params) override;
+
+  // Run the inference on `num_samples` images (`num_samples` x `kInputSize`)
+  // and write the outputs (`num_samples` x `kOutputSize`)
+  void Infer(const float* images, std::size_t num_samples,
+             float* outputs) override;
+  std::vector<float> Infer(const std::vector<float>& images) override;
+
+  // Submit the inference on the normalized images without blocking
+  // The requests are processed in the order of submission
+  std::future<std::vector<float>> Submit(
+    std::vector<float> images) override;
+  // Submit the inference on the 8-bit images (MNIST pixels), which are
+  // normalized by the packing thread
+  std::future<std::vector<float>> Submit(
+    std::vector<std::uint8_t> images) override;
+
+private:
+  // Transfer buffer
+  struct Batch
+  {
+    std::vector<std::uint32_t> tx;
+    std::vector<std::uint32_t> rx;
+    std::size_t rx_packet_len;
+    // Called on the device thread after the transaction
+    std::function<void(const std::vector<std::uint32_t>&)> complete;
+    std::function<void(std::exception_ptr)> fail;
+  };
+
+  // Request waiting for the transfer buffer
+  struct Request
+  {
+    // Fill the words to send (called on the packing thread)
+    std::function<void(std::vector<std::uint32_t>&)> pack;
+    std::size_t rx_len;
+    std::size_t rx_packet_len;
+    std::function<void(const std::vector<std::uint32_t>&)> complete;
+    std::function<void(std::exception_ptr)> fail;
+  };
+
+  template <typename R>
+  std::future<R> Enqueue(
+    std::function<void(std::vector<std::uint32_t>&)> pack,
+    std::size_t rx_len,
+    std::size_t rx_packet_len,
+    std::function<R(const std::vector<std::uint32_t>&)> finish);
+
+  void RunPacking();
+  void RunDevice();
+
+  std::unique_ptr<ToyNetBackend> backend_;
+  std::vector<std::unique_ptr<Batch>> batches_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Request> requests_;
+  std::deque<Batch*> free_batches_;
+  std::deque<Batch*> ready_batches_;
+  bool stop_packing_;
+  bool stop_device_;
+  std::thread packing_thread_;
+  std::thread device_thread_;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_RUNTIME_HPP
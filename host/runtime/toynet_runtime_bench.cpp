@@ -0,0 +1,156 @@
+// toynet_runtime_bench.cpp
+
+// Benchmark of the submission pipeline with the emulator backend
+// The throughput of the pipeline is compared with that of the C model
+// alone (lower bound of the overhead, corresponding to the initiation
+// interval of the accelerator) and the serialized submission of one sample
+// at a time (same as host/toynet_test3.py)
+
+// Example:
+// ./toynet_runtime_bench [<Number of samples> [<Batch size> [<Buffers>
+//   [emulator | sg]]]]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "toynet_emulator_backend.hpp"
+#include "toynet_runtime.hpp"
+#include "toynet_sg_emulator_backend.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start, Clock::time_point end)
+{
+  return std::chrono::duration<double>(end - start).count();
+}
+
+std::unique_ptr<ToyNetBackend> CreateBackend(const std::string& name)
+{
+  if (name == "emulator")
+    return std::unique_ptr<ToyNetBackend>(new ToyNetEmulatorBackend());
+  if (name == "sg")
+    return std::unique_ptr<ToyNetBackend>(new ToyNetSgEmulatorBackend());
+  return nullptr;
+}
+
+// Run the C model directly on the prepared words
+double BenchmarkDevice(ToyNetBackend& backend,
+                       const std::vector<float>& params,
+                       const std::vector<std::uint8_t>& images,
+                       std::size_t batch_size)
+{
+  const std::size_t num_samples = images.size() / ToyNetRuntime::kInputSize;
+
+  std::vector<std::uint32_t> tx(1 + params.size());
+  tx[0] = 1;
+  std::memcpy(tx.data() + 1, params.data(), params.size() * sizeof(float));
+  std::uint32_t ack;
+  backend.Transfer(tx.data(), tx.size(), &ack, 1);
+
+  // Prepare the words in advance (the pixels are not normalized, which
+  // does not affect the timing)
+  tx.assign(2 + batch_size * ToyNetRuntime::kInputSize, 0);
+  tx[0] = 2;
+  tx[1] = static_cast<std::uint32_t>(batch_size);
+  for (std::size_t i = 0; i < batch_size * ToyNetRuntime::kInputSize; ++i) {
+    const float x = images[i];
+    std::memcpy(&tx[2 + i], &x, sizeof(float));
+  }
+
+  std::vector<std::uint32_t> rx(batch_size * ToyNetRuntime::kOutputSize);
+  const auto start = Clock::now();
+
+  const ToyNetBackend::Segment segment { tx.data(), tx.size(),
+    rx.data(), rx.size(), ToyNetRuntime::kOutputSize };
+
+  for (std::size_t i = 0; i < num_samples; i += batch_size)
+    backend.TransferBatch(&segment, 1);
+
+  return num_samples / Seconds(start, Clock::now());
+}
+
+// Submit all batches and wait for the results
+double BenchmarkRuntime(ToyNetRuntime& runtime,
+                        const std::vector<std::uint8_t>& images,
+                        std::size_t batch_size,
+                        bool serialized)
+{
+  const std::size_t batch_len = batch_size * ToyNetRuntime::kInputSize;
+  std::vector<std::future<std::vector<float>>> results;
+  const auto start = Clock::now();
+
+  for (std::size_t i = 0; i < images.size(); i += batch_len) {
+    results.push_back(runtime.Submit(std::vector<std::uint8_t>(
+      images.begin() + i, images.begin() + i + batch_len)));
+
+    if (serialized)
+      results.back().wait();
+  }
+
+  for (auto& result : results)
+    result.get();
+
+  return images.size() / ToyNetRuntime::kInputSize
+         / Seconds(start, Clock::now());
+}
+
+int main(int argc, char** argv)
+{
+  const std::size_t num_samples = argc > 1 ? std::stoul(argv[1]) : 512;
+  const std::size_t batch_size = argc > 2 ? std::stoul(argv[2]) : 16;
+  const std::size_t num_buffers = argc > 3 ? std::stoul(argv[3]) :
+    ToyNetRuntime::kDefaultNumBuffers;
+  const std::string backend_name = argc > 4 ? argv[4] : "emulator";
+
+  if (!CreateBackend(backend_name)) {
+    std::cerr << "Unknown backend: " << backend_name << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (batch_size == 0 || num_samples % batch_size != 0) {
+    std::cerr << "Number of samples must be a multiple of the batch size\n";
+    return EXIT_FAILURE;
+  }
+
+  // Use the random parameters and images
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  std::uniform_int_distribution<int> pixel_dist(0, 255);
+
+  std::vector<float> params(ToyNetRuntime::kNumParams);
+  for (auto& x : params)
+    x = dist(rng);
+
+  std::vector<std::uint8_t> images(num_samples * ToyNetRuntime::kInputSize);
+  for (auto& x : images)
+    x = static_cast<std::uint8_t>(pixel_dist(rng));
+
+  const double device = BenchmarkDevice(
+    *CreateBackend(backend_name), params, images, batch_size);
+
+  ToyNetRuntime runtime(CreateBackend(backend_name), num_buffers);
+  runtime.InitWeights(params);
+
+  const double serialized = BenchmarkRuntime(runtime, images, 1, true);
+  const double pipelined = BenchmarkRuntime(
+    runtime, images, batch_size, false);
+
+  std::cout << "C model only (batch size " << batch_size << "): "
+            << device << " samples/s\n"
+            << "Serialized (batch size 1): "
+            << serialized << " samples/s\n"
+            << "Pipelined (batch size " << batch_size << ", "
+            << num_buffers << " buffers): "
+            << pipelined << " samples/s ("
+            << 100.0 * pipelined / device << "% of the C model)\n";
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+// toynet_runtime_test.cpp
+
+// Example:
+// ./toynet_runtime_test
+// ./toynet_runtime_test sg
+// sudo ./toynet_runtime_test dma 0xA0000000 udmabuf0
+// sudo ./toynet_runtime_test sgdma 0xA0000000 udmabuf0
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "toynet_dma_backend.hpp"
+#include "toynet_emulator_backend.hpp"
+#include "toynet_runtime.hpp"
+#include "toynet_sg_dma_backend.hpp"
+#include "toynet_sg_emulator_backend.hpp"
+
+// Number of samples to test
+constexpr std::size_t kNumSamples = 64;
+// Number of outstanding requests
+constexpr std::size_t kNumRequests = 8;
+
+std::unique_ptr<ToyNetBackend> CreateBackend(int argc, char** argv)
+{
+  if (argc == 1)
+    return std::unique_ptr<ToyNetBackend>(new ToyNetEmulatorBackend());
+
+  if (argc == 2 && std::strcmp(argv[1], "sg") == 0)
+    return std::unique_ptr<ToyNetBackend>(new ToyNetSgEmulatorBackend());
+
+  if (argc == 4 && std::strcmp(argv[1], "dma") == 0)
+    return std::unique_ptr<ToyNetBackend>(new ToyNetDmaBackend(
+      std::stoull(argv[2], nullptr, 0), argv[3]));
+
+  if (argc == 4 && std::strcmp(argv[1], "sgdma") == 0)
+    return std::unique_ptr<ToyNetBackend>(new ToyNetSgDmaBackend(
+      std::stoull(argv[2], nullptr, 0), argv[3]));
+
+  return nullptr;
+}
+
+int main(int argc, char** argv)
+{
+  std::unique_ptr<ToyNetBackend> backend = CreateBackend(argc, argv);
+
+  if (!backend) {
+    std::cerr << "Usage: " << argv[0] << " [sg | dma <DMA address> "
+              << "<u-dma-buf> | sgdma <DMA address> <u-dma-buf>]\n";
+    return EXIT_FAILURE;
+  }
+
+  // More buffers than the requests, so that the requests are chained
+  ToyNetRuntime runtime(std::move(backend), kNumRequests);
+
+  // Use the random parameters and images
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+
+  std::vector<float> params(ToyNetRuntime::kNumParams);
+  for (auto& x : params)
+    x = dist(rng);
+
+  std::vector<float> images(kNumSamples * ToyNetRuntime::kInputSize);
+  for (auto& x : images)
+    x = dist(rng);
+
+  runtime.InitWeights(params);
+  std::cout << "Weight initialization successful\n";
+
+  // Run the inference on all samples at once
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<float> outputs = runtime.Infer(images);
+  const auto end = std::chrono::steady_clock::now();
+  const double elapsed = std::chrono::duration<double>(end - start).count();
+
+  std::cout << "Batched inference: " << kNumSamples / elapsed
+            << " samples/s\n";
+
+  // Submit the same samples in the smaller requests, and check that the
+  // outputs are consistent with the batched inference
+  const std::size_t request_samples = kNumSamples / kNumRequests;
+  const std::size_t request_size = request_samples * ToyNetRuntime::kInputSize;
+  std::vector<std::future<std::vector<float>>> results;
+
+  for (std::size_t i = 0; i < kNumRequests; ++i)
+    results.push_back(runtime.Submit(std::vector<float>(
+      images.begin() + i * request_size,
+      images.begin() + (i + 1) * request_size)));
+
+  std::size_t num_errors = 0;
+
+  for (std::size_t i = 0; i < kNumRequests; ++i) {
+    const std::vector<float> result = results[i].get();
+    const std::size_t offset = i * request_samples * ToyNetRuntime::kOutputSize;
+
+    for (std::size_t j = 0; j < result.size(); ++j) {
+      if (result[j] != outputs[offset + j]) {
+        std::cerr << "Mismatch at sample "
+                  << offset / ToyNetRuntime::kOutputSize
+                     + j / ToyNetRuntime::kOutputSize
+                  << ": " << result[j] << " (expected: "
+                  << outputs[offset + j] << ")\n";
+        ++num_errors;
+      }
+    }
+  }
+
+  if (num_errors > 0) {
+    std::cerr << num_errors << " mismatches found\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Asynchronous inference successful\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+// toynet_sg_backend.cpp
+
+#include "toynet_sg_backend.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Alignment of the buffers in the pool
+constexpr std::size_t kBufferAlignment = 64;
+
+// Timeout of each submission
+constexpr auto kTimeout = std::chrono::seconds(10);
+
+constexpr std::size_t DivCeil(std::size_t x, std::size_t y)
+{
+  return (x + y - 1) / y;
+}
+
+constexpr std::size_t AlignUp(std::size_t x, std::size_t y)
+{
+  return DivCeil(x, y) * y;
+}
+
+// Placement of the transaction in the current submission
+struct SegmentPlan
+{
+  std::size_t rx_offset;
+  std::size_t rx_desc;
+  std::size_t rx_num_descs;
+};
+
+} // namespace
+
+constexpr std::size_t ToyNetSgBackend::kDefaultNumDescriptors;
+constexpr std::size_t ToyNetSgBackend::kMaxDescriptorBytes;
+
+ToyNetSgBackend::ToyNetSgBackend() :
+  mem_(nullptr), phys_addr_(0), num_descriptors_(0),
+  pool_offset_(0), pool_size_(0), mm2s_next_(0), s2mm_next_(0)
+{
+}
+
+void ToyNetSgBackend::InitializeRings(std::uint8_t* mem,
+                                      std::uint64_t phys_addr,
+                                      std::size_t size,
+                                      std::size_t num_descriptors)
+{
+  const std::size_t rings_size = 2 * num_descriptors * sizeof(SgDescriptor);
+
+  if (num_descriptors == 0 || size <= rings_size)
+    throw std::invalid_argument("DMA-able memory is too small for the rings");
+  if (phys_addr % sizeof(SgDescriptor) != 0)
+    throw std::invalid_argument("DMA-able memory is not aligned");
+
+  mem_ = mem;
+  phys_addr_ = phys_addr;
+  num_descriptors_ = num_descriptors;
+  pool_offset_ = rings_size;
+  pool_size_ = size - rings_size;
+  mm2s_next_ = 0;
+  s2mm_next_ = 0;
+
+  // Link the descriptors into the circular rings
+  for (const Channel channel : { Channel::kMm2s, Channel::kS2mm }) {
+    for (std::size_t i = 0; i < num_descriptors_; ++i) {
+      SgDescriptor* desc = this->Descriptor(channel, i);
+      const std::uint64_t next = this->DescriptorAddr(
+        channel, (i + 1) % num_descriptors_);
+
+      std::memset(desc, 0, sizeof(SgDescriptor));
+      desc->next_desc = static_cast<std::uint32_t>(next);
+      desc->next_desc_msb = static_cast<std::uint32_t>(next >> 32);
+    }
+  }
+}
+
+std::uint8_t* ToyNetSgBackend::ToVirtual(std::uint64_t phys_addr) const
+{
+  return mem_ + (phys_addr - phys_addr_);
+}
+
+void ToyNetSgBackend::Transfer(const std::uint32_t* tx,
+                               std::size_t tx_len,
+                               std::uint32_t* rx,
+                               std::size_t rx_len)
+{
+  const Segment segment { tx, tx_len, rx, rx_len, rx_len };
+  this->TransferBatch(&segment, 1);
+}
+
+void ToyNetSgBackend::TransferBatch(const Segment* segments,
+                                    std::size_t num_segments)
+{
+  while (num_segments > 0) {
+    const std::size_t num_submitted = this->Submit(segments, num_segments);
+    segments += num_submitted;
+    num_segments -= num_submitted;
+  }
+}
+
+void ToyNetSgBackend::WaitDescriptor(const SgDescriptor* desc)
+{
+  const volatile std::uint32_t* status = &desc->status;
+  const auto start = std::chrono::steady_clock::now();
+
+  while (!(*status & kSgStatusComplete)) {
+    if (std::chrono::steady_clock::now() - start > kTimeout)
+      throw std::runtime_error("DMA transfer timed out");
+  }
+}
+
+std::size_t ToyNetSgBackend::Submit(const Segment* segments,
+                                    std::size_t num_segments)
+{
+  // Place the transactions in the buffer pool and rings
+  // The whole pool and rings are available, since the previous submission
+  // is completed
+  std::vector<SegmentPlan> plans;
+  std::size_t pool_used = 0;
+  std::size_t mm2s_used = 0;
+  std::size_t s2mm_used = 0;
+
+  for (std::size_t i = 0; i < num_segments; ++i) {
+    const Segment& segment = segments[i];
+
+    if (segment.tx_len == 0 || segment.rx_packet_len == 0
+        || segment.rx_len % segment.rx_packet_len != 0)
+      throw std::invalid_argument("Invalid transaction");
+
+    const std::size_t tx_bytes = segment.tx_len * sizeof(std::uint32_t);
+    const std::size_t rx_bytes = segment.rx_len * sizeof(std::uint32_t);
+    const std::size_t packet_bytes =
+      segment.rx_packet_len * sizeof(std::uint32_t);
+    const std::size_t tx_descs = DivCeil(tx_bytes, kMaxDescriptorBytes);
+    const std::size_t rx_descs = segment.rx_len / segment.rx_packet_len
+      * DivCeil(packet_bytes, kMaxDescriptorBytes);
+    const std::size_t tx_size = AlignUp(tx_bytes, kBufferAlignment);
+    const std::size_t rx_size = AlignUp(rx_bytes, kBufferAlignment);
+
+    if (pool_used + tx_size + rx_size > pool_size_
+        || mm2s_used + tx_descs > num_descriptors_
+        || s2mm_used + rx_descs > num_descriptors_) {
+      if (i == 0)
+        throw std::runtime_error(
+          "Transaction exceeds the descriptor rings or buffer pool");
+      break;
+    }
+
+    // Copy the input to the pool and chain the MM2S descriptors
+    const std::size_t tx_offset = pool_offset_ + pool_used;
+    std::memcpy(mem_ + tx_offset, segment.tx, tx_bytes);
+
+    for (std::size_t j = 0; j < tx_descs; ++j) {
+      SgDescriptor* desc = this->Descriptor(
+        Channel::kMm2s, (mm2s_next_ + mm2s_used + j) % num_descriptors_);
+      const std::uint64_t addr = phys_addr_ + tx_offset
+                                 + j * kMaxDescriptorBytes;
+      const std::size_t len = j < tx_descs - 1 ? kMaxDescriptorBytes :
+                              tx_bytes - j * kMaxDescriptorBytes;
+
+      desc->buffer_addr = static_cast<std::uint32_t>(addr);
+      desc->buffer_addr_msb = static_cast<std::uint32_t>(addr >> 32);
+      desc->control = static_cast<std::uint32_t>(len)
+                      | (j == 0 ? kSgControlSof : 0)
+                      | (j == tx_descs - 1 ? kSgControlEof : 0);
+      desc->status = 0;
+    }
+
+    // Chain the S2MM descriptors for each output packet
+    const std::size_t rx_offset = tx_offset + tx_size;
+    const std::size_t descs_per_packet =
+      DivCeil(packet_bytes, kMaxDescriptorBytes);
+
+    for (std::size_t j = 0; j < rx_descs; ++j) {
+      SgDescriptor* desc = this->Descriptor(
+        Channel::kS2mm, (s2mm_next_ + s2mm_used + j) % num_descriptors_);
+      const std::size_t packet = j / descs_per_packet;
+      const std::size_t part = j % descs_per_packet;
+      const std::uint64_t addr = phys_addr_ + rx_offset
+                                 + packet * packet_bytes
+                                 + part * kMaxDescriptorBytes;
+      const std::size_t len = part < descs_per_packet - 1 ?
+        kMaxDescriptorBytes : packet_bytes - part * kMaxDescriptorBytes;
+
+      desc->buffer_addr = static_cast<std::uint32_t>(addr);
+      desc->buffer_addr_msb = static_cast<std::uint32_t>(addr >> 32);
+      desc->control = static_cast<std::uint32_t>(len);
+      desc->status = 0;
+    }
+
+    plans.push_back(SegmentPlan { rx_offset, s2mm_used, rx_descs });
+    pool_used += tx_size + rx_size;
+    mm2s_used += tx_descs;
+    s2mm_used += rx_descs;
+  }
+
+  // The request without the output (e.g., inference on zero samples) does
+  // not use the S2MM channel
+  const std::size_t mm2s_head = mm2s_next_;
+  const std::size_t mm2s_tail = (mm2s_next_ + mm2s_used - 1)
+                                % num_descriptors_;
+  const std::size_t s2mm_head = s2mm_next_;
+  const std::size_t s2mm_tail = (s2mm_next_ + s2mm_used + num_descriptors_
+                                 - 1) % num_descriptors_;
+  mm2s_next_ = (mm2s_next_ + mm2s_used) % num_descriptors_;
+  s2mm_next_ = (s2mm_next_ + s2mm_used) % num_descriptors_;
+
+  // Make the descriptors and buffers visible before the doorbell
+  // The S2MM channel is started first, so that the output stream is not
+  // stalled when the accelerator starts writing
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (s2mm_used > 0)
+    this->StartChannel(Channel::kS2mm,
+                       this->DescriptorAddr(Channel::kS2mm, s2mm_head),
+                       this->DescriptorAddr(Channel::kS2mm, s2mm_tail));
+  this->StartChannel(Channel::kMm2s,
+                     this->DescriptorAddr(Channel::kMm2s, mm2s_head),
+                     this->DescriptorAddr(Channel::kMm2s, mm2s_tail));
+
+  // Drain the completion ring (descriptors complete in order)
+  this->WaitDescriptor(this->Descriptor(Channel::kMm2s, mm2s_tail));
+  if (s2mm_used > 0)
+    this->WaitDescriptor(this->Descriptor(Channel::kS2mm, s2mm_tail));
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  for (std::size_t i = 0; i < mm2s_used; ++i) {
+    const SgDescriptor* desc = this->Descriptor(
+      Channel::kMm2s, (mm2s_head + i) % num_descriptors_);
+    if (desc->status & kSgStatusErrors)
+      throw std::runtime_error("DMA transfer failed");
+  }
+
+  for (std::size_t i = 0; i < plans.size(); ++i) {
+    const SegmentPlan& plan = plans[i];
+
+    for (std::size_t j = 0; j < plan.rx_num_descs; ++j) {
+      const SgDescriptor* desc = this->Descriptor(
+        Channel::kS2mm, (s2mm_head + plan.rx_desc + j) % num_descriptors_);
+      if (desc->status & kSgStatusErrors)
+        throw std::runtime_error("DMA transfer failed");
+      if ((desc->status & kSgStatusLengthMask)
+          != (desc->control & kSgControlLengthMask))
+        throw std::runtime_error("Unexpected length of the output packet");
+    }
+
+    std::memcpy(segments[i].rx, mem_ + plan.rx_offset,
+                segments[i].rx_len * sizeof(std::uint32_t));
+  }
+
+  return plans.size();
+}
+
+SgDescriptor* ToyNetSgBackend::Descriptor(Channel channel,
+                                          std::size_t index) const
+{
+  const std::size_t ring = channel == Channel::kMm2s ? 0 : num_descriptors_;
+  return reinterpret_cast<SgDescriptor*>(mem_) + ring + index;
+}
+
+std::uint64_t ToyNetSgBackend::DescriptorAddr(Channel channel,
+                                              std::size_t index) const
+{
+  const std::size_t ring = channel == Channel::kMm2s ? 0 : num_descriptors_;
+  return phys_addr_ + (ring + index) * sizeof(SgDescriptor);
+}
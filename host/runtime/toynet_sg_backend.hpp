@@ -0,0 +1,106 @@
+// toynet_sg_backend.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_SG_BACKEND_HPP
+#define TOYNET_RUNTIME_TOYNET_SG_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "toynet_backend.hpp"
+
+// Descriptor of the AXI DMA in the scatter-gather mode (PG021)
+struct alignas(64) SgDescriptor
+{
+  std::uint32_t next_desc;
+  std::uint32_t next_desc_msb;
+  std::uint32_t buffer_addr;
+  std::uint32_t buffer_addr_msb;
+  std::uint32_t reserved[2];
+  std::uint32_t control;
+  std::uint32_t status;
+  std::uint32_t app[5];
+};
+
+static_assert(sizeof(SgDescriptor) == 64,
+              "Descriptors must be aligned to 16 words");
+
+// Bits of the control field
+constexpr std::uint32_t kSgControlLengthMask = (1U << 26) - 1;
+constexpr std::uint32_t kSgControlEof = 1U << 26;
+constexpr std::uint32_t kSgControlSof = 1U << 27;
+// Bits of the status field
+constexpr std::uint32_t kSgStatusLengthMask = (1U << 26) - 1;
+constexpr std::uint32_t kSgStatusRxEof = 1U << 26;
+constexpr std::uint32_t kSgStatusRxSof = 1U << 27;
+constexpr std::uint32_t kSgStatusErrors = (1U << 28) | (1U << 29) | (1U << 30);
+constexpr std::uint32_t kSgStatusComplete = 1U << 31;
+
+// Backend that chains the transactions into the descriptor rings of the
+// AXI DMA (scatter-gather mode)
+// The DMA-able memory holds the circular MM2S and S2MM descriptor rings
+// followed by the buffer pool, which are allocated once and reused by each
+// submission; the inputs are copied to the pool and split into the
+// descriptors, and each output packet gets its own S2MM descriptor
+// Derived classes provide the memory and start the channels (doorbell)
+class ToyNetSgBackend : public ToyNetBackend
+{
+public:
+  // Default number of descriptors in each ring
+  static constexpr std::size_t kDefaultNumDescriptors = 256;
+  // Maximum number of bytes per descriptor (the buffer length register of
+  // the AXI DMA is 14 bits wide by default)
+  static constexpr std::size_t kMaxDescriptorBytes = 8192;
+
+  // The output must be a single packet
+  void Transfer(const std::uint32_t* tx,
+                std::size_t tx_len,
+                std::uint32_t* rx,
+                std::size_t rx_len) override;
+  // The transactions are split into as few submissions as the rings and
+  // buffer pool allow
+  void TransferBatch(const Segment* segments,
+                     std::size_t num_segments) override;
+
+protected:
+  enum class Channel { kMm2s, kS2mm };
+
+  ToyNetSgBackend();
+
+  // Lay out the descriptor rings and buffer pool in the DMA-able memory
+  void InitializeRings(std::uint8_t* mem,
+                       std::uint64_t phys_addr,
+                       std::size_t size,
+                       std::size_t num_descriptors);
+
+  // Translate the physical address in the DMA-able memory
+  std::uint8_t* ToVirtual(std::uint64_t phys_addr) const;
+
+  // Process the descriptors from `head` to `tail` (physical addresses)
+  virtual void StartChannel(Channel channel,
+                            std::uint64_t head,
+                            std::uint64_t tail) = 0;
+  // Wait until the descriptor is completed (the default implementation
+  // polls the status field)
+  virtual void WaitDescriptor(const SgDescriptor* desc);
+
+private:
+  // Submit the leading transactions that fit into the rings and buffer
+  // pool, and return the number of submitted transactions
+  std::size_t Submit(const Segment* segments, std::size_t num_segments);
+
+  SgDescriptor* Descriptor(Channel channel, std::size_t index) const;
+  std::uint64_t DescriptorAddr(Channel channel, std::size_t index) const;
+
+  // DMA-able memory
+  std::uint8_t* mem_;
+  std::uint64_t phys_addr_;
+  std::size_t num_descriptors_;
+  // Offset and size of the buffer pool
+  std::size_t pool_offset_;
+  std::size_t pool_size_;
+  // Next descriptors to use
+  std::size_t mm2s_next_;
+  std::size_t s2mm_next_;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_SG_BACKEND_HPP
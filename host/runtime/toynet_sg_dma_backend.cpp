@@ -0,0 +1,122 @@
+// toynet_sg_dma_backend.cpp
+
+#include "toynet_sg_dma_backend.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+// Register offsets of the AXI DMA (scatter-gather mode)
+constexpr std::size_t kMm2sControl = 0x00;
+constexpr std::size_t kMm2sStatus = 0x04;
+constexpr std::size_t kMm2sCurrentDesc = 0x08;
+constexpr std::size_t kMm2sCurrentDescMsb = 0x0C;
+constexpr std::size_t kMm2sTailDesc = 0x10;
+constexpr std::size_t kMm2sTailDescMsb = 0x14;
+constexpr std::size_t kS2mmControl = 0x30;
+constexpr std::size_t kS2mmStatus = 0x34;
+constexpr std::size_t kS2mmCurrentDesc = 0x38;
+constexpr std::size_t kS2mmCurrentDescMsb = 0x3C;
+constexpr std::size_t kS2mmTailDesc = 0x40;
+constexpr std::size_t kS2mmTailDescMsb = 0x44;
+// Size of the register space
+constexpr std::size_t kRegisterSpaceSize = 0x10000;
+
+// Bits of the control registers
+constexpr std::uint32_t kControlRunStop = 1U << 0;
+constexpr std::uint32_t kControlReset = 1U << 2;
+// Bits of the status registers (internal, slave, and decode errors of the
+// data mover and scatter-gather engine)
+constexpr std::uint32_t kStatusErrors = (1U << 4) | (1U << 5) | (1U << 6)
+                                        | (1U << 8) | (1U << 9) | (1U << 10);
+
+// Timeout of each submission
+constexpr auto kTimeout = std::chrono::seconds(10);
+
+} // namespace
+
+ToyNetSgDmaBackend::ToyNetSgDmaBackend(std::uint64_t dma_base,
+                                       const std::string& udmabuf_name,
+                                       std::size_t num_descriptors) :
+  regs_("/dev/mem", dma_base, kRegisterSpaceSize),
+  buf_("/dev/" + udmabuf_name, 0,
+       ReadUdmabufAttribute(udmabuf_name, "size")),
+  mm2s_running_(false), s2mm_running_(false)
+{
+  this->InitializeRings(static_cast<std::uint8_t*>(buf_.Data()),
+                        ReadUdmabufAttribute(udmabuf_name, "phys_addr"),
+                        buf_.Size(), num_descriptors);
+  this->Reset();
+}
+
+void ToyNetSgDmaBackend::StartChannel(Channel channel,
+                                      std::uint64_t head,
+                                      std::uint64_t tail)
+{
+  const bool mm2s = channel == Channel::kMm2s;
+  bool& running = mm2s ? mm2s_running_ : s2mm_running_;
+
+  // The current descriptor is set only while the channel is halted, and
+  // the running channel resumes from the descriptor after the last one
+  if (!running) {
+    this->WriteRegister(mm2s ? kMm2sCurrentDescMsb : kS2mmCurrentDescMsb,
+                        static_cast<std::uint32_t>(head >> 32));
+    this->WriteRegister(mm2s ? kMm2sCurrentDesc : kS2mmCurrentDesc,
+                        static_cast<std::uint32_t>(head));
+    this->WriteRegister(mm2s ? kMm2sControl : kS2mmControl,
+                        kControlRunStop);
+    running = true;
+  }
+
+  // Writing the lower half of the tail descriptor starts the transfer
+  this->WriteRegister(mm2s ? kMm2sTailDescMsb : kS2mmTailDescMsb,
+                      static_cast<std::uint32_t>(tail >> 32));
+  this->WriteRegister(mm2s ? kMm2sTailDesc : kS2mmTailDesc,
+                      static_cast<std::uint32_t>(tail));
+}
+
+void ToyNetSgDmaBackend::WaitDescriptor(const SgDescriptor* desc)
+{
+  // Poll the completion bit of the descriptor and the error bits of the
+  // status registers
+  const volatile std::uint32_t* status = &desc->status;
+  const auto start = std::chrono::steady_clock::now();
+
+  while (!(*status & kSgStatusComplete)) {
+    if ((this->ReadRegister(kMm2sStatus) & kStatusErrors)
+        || (this->ReadRegister(kS2mmStatus) & kStatusErrors)) {
+      this->Reset();
+      throw std::runtime_error("DMA transfer failed");
+    }
+
+    if (std::chrono::steady_clock::now() - start > kTimeout) {
+      this->Reset();
+      throw std::runtime_error("DMA transfer timed out");
+    }
+  }
+}
+
+std::uint32_t ToyNetSgDmaBackend::ReadRegister(std::size_t offset) const
+{
+  return static_cast<volatile std::uint32_t*>(
+    regs_.Data())[offset / sizeof(std::uint32_t)];
+}
+
+void ToyNetSgDmaBackend::WriteRegister(std::size_t offset, std::uint32_t val)
+{
+  static_cast<volatile std::uint32_t*>(
+    regs_.Data())[offset / sizeof(std::uint32_t)] = val;
+}
+
+void ToyNetSgDmaBackend::Reset()
+{
+  // Reset both channels (the reset of one channel resets the other), which
+  // are started again from the next submission
+  this->WriteRegister(kMm2sControl, kControlReset);
+  while (this->ReadRegister(kMm2sControl) & kControlReset)
+    ;
+
+  mm2s_running_ = false;
+  s2mm_running_ = false;
+}
@@ -0,0 +1,49 @@
+// toynet_sg_dma_backend.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_SG_DMA_BACKEND_HPP
+#define TOYNET_RUNTIME_TOYNET_SG_DMA_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "toynet_device_memory.hpp"
+#include "toynet_sg_backend.hpp"
+
+// Backend that drives the AXI DMA in the scatter-gather mode
+// The descriptor rings and buffer pool are placed in the u-dma-buf device,
+// and each submission only writes the tail descriptors (doorbell)
+// The AXI DMA must be configured with the scatter-gather engine, and the
+// accelerator must be started with `AP_START` and `AUTO_RESTART`
+class ToyNetSgDmaBackend : public ToyNetSgBackend
+{
+public:
+  // `dma_base` is the physical address of the AXI DMA registers, and
+  // `udmabuf_name` is the name of the u-dma-buf device (e.g., "udmabuf0")
+  ToyNetSgDmaBackend(std::uint64_t dma_base,
+                     const std::string& udmabuf_name,
+                     std::size_t num_descriptors = kDefaultNumDescriptors);
+
+  ToyNetSgDmaBackend(const ToyNetSgDmaBackend&) = delete;
+  ToyNetSgDmaBackend& operator=(const ToyNetSgDmaBackend&) = delete;
+
+protected:
+  void StartChannel(Channel channel,
+                    std::uint64_t head,
+                    std::uint64_t tail) override;
+  void WaitDescriptor(const SgDescriptor* desc) override;
+
+private:
+  std::uint32_t ReadRegister(std::size_t offset) const;
+  void WriteRegister(std::size_t offset, std::uint32_t val);
+  void Reset();
+
+  // Mapped DMA registers and DMA-able memory
+  MappedRegion regs_;
+  MappedRegion buf_;
+  // Whether the channels are running (the current descriptors are set)
+  bool mm2s_running_;
+  bool s2mm_running_;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_SG_DMA_BACKEND_HPP
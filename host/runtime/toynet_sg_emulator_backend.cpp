@@ -0,0 +1,176 @@
+// toynet_sg_emulator_backend.cpp
+
+#include "toynet_sg_emulator_backend.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "data_types.hpp"
+
+// Top function of the accelerator (hls/src/top_opt3.cpp)
+void InferenceOpt3(hls::stream<axi_stream_data_t>& in_stream,
+                   hls::stream<axi_stream_data_t>& out_stream);
+
+namespace {
+
+// Fake physical address of the DMA-able memory
+constexpr std::uint64_t kPhysAddr = 0x40000000;
+
+// Timeout of each descriptor
+constexpr auto kTimeout = std::chrono::seconds(10);
+
+std::uint64_t NextDescriptor(const SgDescriptor* desc)
+{
+  return (static_cast<std::uint64_t>(desc->next_desc_msb) << 32)
+         | desc->next_desc;
+}
+
+std::uint64_t BufferAddr(const SgDescriptor* desc)
+{
+  return (static_cast<std::uint64_t>(desc->buffer_addr_msb) << 32)
+         | desc->buffer_addr;
+}
+
+} // namespace
+
+constexpr std::size_t ToyNetSgEmulatorBackend::kDefaultMemorySize;
+
+ToyNetSgEmulatorBackend::ToyNetSgEmulatorBackend(
+  std::size_t mem_size, std::size_t num_descriptors) :
+  storage_(new std::uint8_t[mem_size + sizeof(SgDescriptor)]),
+  mm2s_ { 0, 0, false }, s2mm_ { 0, 0, false }, stop_(false)
+{
+  // Align the memory to the descriptors
+  const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(
+    storage_.get());
+  const std::size_t padding = (sizeof(SgDescriptor)
+    - addr % sizeof(SgDescriptor)) % sizeof(SgDescriptor);
+
+  this->InitializeRings(storage_.get() + padding, kPhysAddr,
+                        mem_size, num_descriptors);
+  engine_thread_ = std::thread(&ToyNetSgEmulatorBackend::Run, this);
+}
+
+ToyNetSgEmulatorBackend::~ToyNetSgEmulatorBackend()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+
+  cond_.notify_all();
+  engine_thread_.join();
+}
+
+void ToyNetSgEmulatorBackend::StartChannel(Channel channel,
+                                           std::uint64_t head,
+                                           std::uint64_t tail)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ChannelState& state = channel == Channel::kMm2s ? mm2s_ : s2mm_;
+
+    // The idle channel resumes from the descriptor after the last one
+    if (!state.running)
+      state.current = head;
+    state.tail = tail;
+    state.running = true;
+  }
+
+  cond_.notify_all();
+}
+
+void ToyNetSgEmulatorBackend::WaitDescriptor(const SgDescriptor* desc)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (!cond_.wait_for(lock, kTimeout, [desc] {
+        return (desc->status & kSgStatusComplete) != 0; }))
+    throw std::runtime_error("DMA transfer timed out");
+}
+
+void ToyNetSgEmulatorBackend::Run()
+{
+  hls::stream<axi_stream_data_t> in_stream;
+  hls::stream<axi_stream_data_t> out_stream;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this, &out_stream] {
+        return stop_ || mm2s_.running
+               || (s2mm_.running && !out_stream.empty()); });
+
+      if (stop_)
+        return;
+
+      // Gather the MM2S descriptors into the input stream
+      while (mm2s_.running) {
+        SgDescriptor* desc = reinterpret_cast<SgDescriptor*>(
+          this->ToVirtual(mm2s_.current));
+        const std::size_t len = desc->control & kSgControlLengthMask;
+        const std::uint8_t* buf = this->ToVirtual(BufferAddr(desc));
+
+        for (std::size_t i = 0; i < len; i += sizeof(std::uint32_t)) {
+          std::uint32_t word;
+          std::memcpy(&word, buf + i, sizeof(std::uint32_t));
+
+          axi_stream_data_t in_data;
+          in_data.data = word;
+          in_data.keep = -1;
+          in_data.strb = -1;
+          in_data.last = (desc->control & kSgControlEof)
+                         && (i + sizeof(std::uint32_t) >= len);
+          in_stream.write(in_data);
+        }
+
+        desc->status = static_cast<std::uint32_t>(len) | kSgStatusComplete;
+
+        if (mm2s_.current == mm2s_.tail)
+          mm2s_.running = false;
+        else
+          mm2s_.current = NextDescriptor(desc);
+      }
+    }
+
+    cond_.notify_all();
+
+    // Run the accelerator until the input stream is consumed
+    while (!in_stream.empty())
+      InferenceOpt3(in_stream, out_stream);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      // Scatter the output stream to the S2MM descriptors
+      // Each descriptor is filled until its length or the end of the packet
+      while (s2mm_.running && !out_stream.empty()) {
+        SgDescriptor* desc = reinterpret_cast<SgDescriptor*>(
+          this->ToVirtual(s2mm_.current));
+        const std::size_t len = desc->control & kSgControlLengthMask;
+        std::uint8_t* buf = this->ToVirtual(BufferAddr(desc));
+        std::size_t received = 0;
+        bool last = false;
+
+        while (received < len && !last && !out_stream.empty()) {
+          const axi_stream_data_t out_data = out_stream.read();
+          const std::uint32_t word = out_data.data.to_uint();
+          std::memcpy(buf + received, &word, sizeof(std::uint32_t));
+          received += sizeof(std::uint32_t);
+          last = out_data.last;
+        }
+
+        desc->status = static_cast<std::uint32_t>(received)
+                       | (last ? kSgStatusRxEof : 0) | kSgStatusComplete;
+
+        if (s2mm_.current == s2mm_.tail)
+          s2mm_.running = false;
+        else
+          s2mm_.current = NextDescriptor(desc);
+      }
+    }
+
+    cond_.notify_all();
+  }
+}
@@ -0,0 +1,67 @@
+// toynet_sg_emulator_backend.hpp
+
+#ifndef TOYNET_RUNTIME_TOYNET_SG_EMULATOR_BACKEND_HPP
+#define TOYNET_RUNTIME_TOYNET_SG_EMULATOR_BACKEND_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "toynet_sg_backend.hpp"
+
+// Backend that emulates the AXI DMA in the scatter-gather mode in software
+// The descriptor rings and buffer pool are placed in the ordinary memory
+// with the fake physical address, and the engine thread walks the
+// descriptors in the same way as the AXI DMA: the MM2S descriptors are
+// gathered into the input stream of the C model (`InferenceOpt3`), and
+// the output stream is scattered to the S2MM descriptors, each of which is
+// terminated by `TLAST`
+// The model parameters are static in the C model, so only one emulator
+// backend should exist at a time
+class ToyNetSgEmulatorBackend : public ToyNetSgBackend
+{
+public:
+  // Default size of the DMA-able memory
+  static constexpr std::size_t kDefaultMemorySize = 4 << 20;
+
+  explicit ToyNetSgEmulatorBackend(
+    std::size_t mem_size = kDefaultMemorySize,
+    std::size_t num_descriptors = kDefaultNumDescriptors);
+  ~ToyNetSgEmulatorBackend() override;
+
+  ToyNetSgEmulatorBackend(const ToyNetSgEmulatorBackend&) = delete;
+  ToyNetSgEmulatorBackend& operator=(
+    const ToyNetSgEmulatorBackend&) = delete;
+
+protected:
+  void StartChannel(Channel channel,
+                    std::uint64_t head,
+                    std::uint64_t tail) override;
+  void WaitDescriptor(const SgDescriptor* desc) override;
+
+private:
+  // State of each channel
+  struct ChannelState
+  {
+    // Physical addresses of the current and tail descriptors
+    std::uint64_t current;
+    std::uint64_t tail;
+    bool running;
+  };
+
+  void Run();
+
+  std::unique_ptr<std::uint8_t[]> storage_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  ChannelState mm2s_;
+  ChannelState s2mm_;
+  bool stop_;
+  std::thread engine_thread_;
+};
+
+#endif // TOYNET_RUNTIME_TOYNET_SG_EMULATOR_BACKEND_HPP
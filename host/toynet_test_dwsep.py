@@ -0,0 +1,119 @@
+# coding: utf-8
+# toynet_test_dwsep.py
+
+# Example:
+# sudo XILINX_XRT=/usr python3 toynet_test_dwsep.py toynet_dwsep.pth \
+#   zcu104_toynet_dwsep.bit
+
+import numpy as np
+import os
+import pynq
+import sys
+import torch
+import torch.nn as nn
+import torch.utils.data
+import torchvision.datasets
+import torchvision.transforms
+
+from pynq import allocate, Overlay
+
+sys.path.insert(0, os.path.abspath(os.path.join(
+    os.path.dirname(__file__), os.pardir)))
+
+from net import ToyNetDwSep
+from toynet_test3 import _copy_batchnorm2d_weights, _copy_linear_weights
+from toynet_test3 import test
+
+def _copy_grouped_conv2d_weights(buf: pynq.buffer.PynqBuffer,
+                                 layer: nn.Conv2d,
+                                 offset: int) -> int:
+    # Depthwise and pointwise convolutions, whose weights are of size
+    # (`out_channels`, `in_channels` / `groups`, `K`, `K`)
+    param_size = layer.weight.numel()
+    buf[offset:offset+param_size] = layer.weight.data.view(-1)
+    offset += param_size
+    return offset
+
+def transfer_weights(dma: pynq.lib.DMA, model: ToyNetDwSep):
+    # Compute the number of parameters in the model
+    buf_len = 0
+    buf_len += 6 * 1 * 5 * 5
+    buf_len += 6 * 3
+    buf_len += 6 * 5 * 5
+    buf_len += 16 * 6
+    buf_len += 16 * 3
+    buf_len += 120 * 400
+    buf_len += 120
+    buf_len += 84 * 120
+    buf_len += 84
+    buf_len += 10 * 84
+    buf_len += 10
+
+    # Allocate the buffers for transfer
+    buf_in0 = allocate(shape=(1,), dtype=np.uint32, cacheable=False)
+    buf_in1 = allocate(shape=(buf_len,), dtype=np.float32, cacheable=False)
+    buf_out = allocate(shape=(1,), dtype=np.uint32, cacheable=False)
+
+    # Fill the buffer
+    buf_in0[0] = 1
+
+    offset = 0
+    offset = _copy_grouped_conv2d_weights(buf_in1, model.conv0, offset)
+    offset = _copy_batchnorm2d_weights(buf_in1, model.bn0, offset)
+    offset = _copy_grouped_conv2d_weights(buf_in1, model.dwconv1, offset)
+    offset = _copy_grouped_conv2d_weights(buf_in1, model.pwconv1, offset)
+    offset = _copy_batchnorm2d_weights(buf_in1, model.bn1, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear0, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear1, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear2, offset)
+    assert offset == buf_len
+
+    # Transfer the weights
+    dma.sendchannel.transfer(buf_in0)
+    dma.sendchannel.wait()
+    dma.sendchannel.transfer(buf_in1)
+    dma.sendchannel.wait()
+    dma.recvchannel.transfer(buf_out)
+    dma.recvchannel.wait()
+    print(f"Ack: {buf_out[0]}")
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} <Checkpoint> <Bitstream>")
+        sys.exit(1)
+
+    # Load the model
+    model = ToyNetDwSep()
+    model.load_state_dict(torch.load(sys.argv[1], map_location="cpu"))
+
+    # Load the overlay
+    overlay = Overlay(sys.argv[2])
+
+    if not overlay.is_loaded():
+        print(f"Failed to load the bitstream: {sys.argv[2]}")
+        sys.exit(1)
+
+    dma = overlay.axi_dma
+    toynet_ip = overlay.toynet
+    toynet_ip.register_map.CTRL.AP_START = 1
+    toynet_ip.register_map.CTRL.AUTO_RESTART = 1
+
+    # Transfer the weights
+    transfer_weights(dma, model)
+    print("Weight initialization successful")
+
+    # Load the dataset
+    transform = torchvision.transforms.Compose([
+        torchvision.transforms.ToTensor(),
+        torchvision.transforms.Normalize((0.1307,), (0.3081,))])
+    test_set = torchvision.datasets.MNIST(
+        "./data", train=False, download=True, transform=transform)
+    test_loader = torch.utils.data.DataLoader(
+        test_set, batch_size=1, shuffle=False, num_workers=1)
+    print("Test dataset is successfully loaded")
+
+    # Test the model
+    test(dma, test_loader)
+
+if __name__ == "__main__":
+    main()
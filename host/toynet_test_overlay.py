@@ -0,0 +1,106 @@
+# coding: utf-8
+# toynet_test_overlay.py
+
+# Example:
+# sudo XILINX_XRT=/usr python3 toynet_test_overlay.py toynet.pth \
+#   zcu104_toynet_overlay.bit
+
+import numpy as np
+import os
+import pynq
+import sys
+import torch
+import torch.utils.data
+import torchvision.datasets
+import torchvision.transforms
+
+from pynq import allocate, Overlay
+
+sys.path.insert(0, os.path.abspath(os.path.join(
+    os.path.dirname(__file__), os.pardir)))
+
+from net import ToyNet
+from overlay_compiler import compile_network, encode_program, toynet_layers
+from toynet_test3 import _copy_conv2d_weights, _copy_batchnorm2d_weights
+from toynet_test3 import _copy_linear_weights
+from toynet_test3 import test
+
+def transfer_program_and_weights(dma: pynq.lib.DMA, model: ToyNet):
+    # Compile the network into the program
+    program = encode_program(compile_network(toynet_layers()))
+
+    # Compute the number of parameters in the model
+    # The parameters are sent in the order of the instructions, and the
+    # rows of the fully-connected weights are zero-padded on chip
+    buf_len = sum(p.numel() for p in model.parameters())
+    buf_len += model.bn0.num_features + model.bn1.num_features
+
+    # Allocate the buffers for transfer
+    buf_in0 = allocate(shape=(1 + len(program),), dtype=np.uint32,
+                       cacheable=False)
+    buf_in1 = allocate(shape=(buf_len,), dtype=np.float32, cacheable=False)
+    buf_out = allocate(shape=(1,), dtype=np.uint32, cacheable=False)
+
+    # Fill the buffer
+    buf_in0[0] = 1
+    buf_in0[1:] = program
+
+    offset = 0
+    offset = _copy_conv2d_weights(buf_in1, model.conv0, offset)
+    offset = _copy_batchnorm2d_weights(buf_in1, model.bn0, offset)
+    offset = _copy_conv2d_weights(buf_in1, model.conv1, offset)
+    offset = _copy_batchnorm2d_weights(buf_in1, model.bn1, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear0, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear1, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear2, offset)
+    assert offset == buf_len
+
+    # Transfer the program and weights
+    dma.sendchannel.transfer(buf_in0)
+    dma.sendchannel.wait()
+    dma.sendchannel.transfer(buf_in1)
+    dma.sendchannel.wait()
+    dma.recvchannel.transfer(buf_out)
+    dma.recvchannel.wait()
+    print(f"Ack: {buf_out[0]}")
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} <Checkpoint> <Bitstream>")
+        sys.exit(1)
+
+    # Load the model
+    model = ToyNet()
+    model.load_state_dict(torch.load(sys.argv[1], map_location="cpu"))
+
+    # Load the overlay
+    overlay = Overlay(sys.argv[2])
+
+    if not overlay.is_loaded():
+        print(f"Failed to load the bitstream: {sys.argv[2]}")
+        sys.exit(1)
+
+    dma = overlay.axi_dma
+    toynet_ip = overlay.toynet
+    toynet_ip.register_map.CTRL.AP_START = 1
+    toynet_ip.register_map.CTRL.AUTO_RESTART = 1
+
+    # Transfer the program and weights
+    transfer_program_and_weights(dma, model)
+    print("Program and weight initialization successful")
+
+    # Load the dataset
+    transform = torchvision.transforms.Compose([
+        torchvision.transforms.ToTensor(),
+        torchvision.transforms.Normalize((0.1307,), (0.3081,))])
+    test_set = torchvision.datasets.MNIST(
+        "./data", train=False, download=True, transform=transform)
+    test_loader = torch.utils.data.DataLoader(
+        test_set, batch_size=1, shuffle=False, num_workers=1)
+    print("Test dataset is successfully loaded")
+
+    # Test the model
+    test(dma, test_loader)
+
+if __name__ == "__main__":
+    main()
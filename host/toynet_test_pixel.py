@@ -0,0 +1,145 @@
+# coding: utf-8
+# toynet_test_pixel.py
+
+# Example:
+# sudo XILINX_XRT=/usr python3 toynet_test_pixel.py toynet.pth \
+#   zcu104_toynet_pixel_16.bit
+
+import numpy as np
+import os
+import pynq
+import sys
+import torch
+import torch.nn.functional as F
+import torchvision.datasets
+
+from pynq import allocate, Overlay
+
+sys.path.insert(0, os.path.abspath(os.path.join(
+    os.path.dirname(__file__), os.pardir)))
+
+from net import ToyNet
+from toynet_test3 import _copy_conv2d_weights, _copy_batchnorm2d_weights
+from toynet_test3 import _copy_linear_weights
+
+# Mean and standard deviation of the MNIST dataset
+MNIST_MEAN = 0.1307
+MNIST_STD = 0.3081
+
+# Number of pixels per transfer
+PIXELS_PER_BEAT = 4
+
+def transfer_weights(dma: pynq.lib.DMA, model: ToyNet):
+    # Compute the number of parameters in the model
+    # The normalization constants (scale and bias) follow the parameters
+    buf_len = sum(p.numel() for p in model.parameters())
+    buf_len += model.bn0.num_features + model.bn1.num_features
+    buf_len += 2
+
+    # Allocate the buffers for transfer
+    buf_in0 = allocate(shape=(1,), dtype=np.uint32, cacheable=False)
+    buf_in1 = allocate(shape=(buf_len,), dtype=np.float32, cacheable=False)
+    buf_out = allocate(shape=(1,), dtype=np.uint32, cacheable=False)
+
+    # Fill the buffer
+    buf_in0[0] = 1
+
+    offset = 0
+    offset = _copy_conv2d_weights(buf_in1, model.conv0, offset)
+    offset = _copy_batchnorm2d_weights(buf_in1, model.bn0, offset)
+    offset = _copy_conv2d_weights(buf_in1, model.conv1, offset)
+    offset = _copy_batchnorm2d_weights(buf_in1, model.bn1, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear0, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear1, offset)
+    offset = _copy_linear_weights(buf_in1, model.linear2, offset)
+
+    # `Normalize((MNIST_MEAN,), (MNIST_STD,))` after `ToTensor()` is
+    # equivalent to `pixel * scale + bias`
+    buf_in1[offset] = 1.0 / (255.0 * MNIST_STD)
+    buf_in1[offset + 1] = -MNIST_MEAN / MNIST_STD
+    offset += 2
+    assert offset == buf_len
+
+    # Transfer the weights
+    dma.sendchannel.transfer(buf_in0)
+    dma.sendchannel.wait()
+    dma.sendchannel.transfer(buf_in1)
+    dma.sendchannel.wait()
+    dma.recvchannel.transfer(buf_out)
+    dma.recvchannel.wait()
+    print(f"Ack: {buf_out[0]}")
+
+def test(dma: pynq.lib.DMA, test_set: torchvision.datasets.MNIST):
+    correct = 0
+    in_len = 1 * 28 * 28 // PIXELS_PER_BEAT
+    out_len = 10
+
+    # Allocate the buffer for transfer
+    # The raw pixels are sent as is, four per 32-bit word
+    buf_in0 = allocate(shape=(2,), dtype=np.uint32, cacheable=False)
+    buf_in1 = allocate(shape=(in_len,), dtype=np.uint32, cacheable=False)
+    buf_out = allocate(shape=(out_len,), dtype=np.float32, cacheable=False)
+
+    images = test_set.data.numpy()
+    targets = test_set.targets
+
+    for idx in range(len(images)):
+        # Transfer the data sample and receive the result
+        buf_in0[0] = 2
+        buf_in0[1] = 1
+        buf_in1[:] = np.frombuffer(
+            np.ascontiguousarray(images[idx]).tobytes(), dtype="<u4")
+        dma.sendchannel.transfer(buf_in0)
+        dma.sendchannel.wait()
+        dma.sendchannel.transfer(buf_in1)
+        dma.sendchannel.wait()
+        dma.recvchannel.transfer(buf_out)
+        dma.recvchannel.wait()
+
+        out = torch.from_numpy(buf_out).clone()
+        out = out.view(1, out_len)
+        out = F.log_softmax(out, dim=1)
+        pred = out.argmax(dim=1).item()
+        correct += int(pred == targets[idx].item())
+
+        if idx % 100 == 0:
+            print("Index: {}, correct: {}".format(idx, correct))
+
+    print("Test accuracy: {} / {} ({:.0f}%)".format(
+          correct, len(images), 100.0 * correct / len(images)))
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} <Checkpoint> <Bitstream>")
+        sys.exit(1)
+
+    # Load the model
+    model = ToyNet()
+    model.load_state_dict(torch.load(sys.argv[1], map_location="cpu"))
+
+    # Load the overlay
+    overlay = Overlay(sys.argv[2])
+
+    if not overlay.is_loaded():
+        print(f"Failed to load the bitstream: {sys.argv[2]}")
+        sys.exit(1)
+
+    dma = overlay.axi_dma
+    toynet_ip = overlay.toynet
+    toynet_ip.register_map.CTRL.AP_START = 1
+    toynet_ip.register_map.CTRL.AUTO_RESTART = 1
+
+    # Transfer the weights and normalization constants
+    transfer_weights(dma, model)
+    print("Weight initialization successful")
+
+    # Load the dataset (raw 8-bit pixels without the transforms)
+    test_set = torchvision.datasets.MNIST(
+        "./data", train=False, download=True)
+    print("Test dataset is successfully loaded")
+
+    # Test the model
+    test(dma, test_set)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,134 @@
+# coding: utf-8
+# toynet_test_profile.py
+
+# Example:
+# sudo XILINX_XRT=/usr python3 toynet_test_profile.py toynet.pth \
+#   zcu104_toynet_profile_16.bit 100
+
+import numpy as np
+import os
+import pynq
+import sys
+import torch
+import torch.utils.data
+import torchvision.datasets
+import torchvision.transforms
+
+from pynq import allocate, Overlay
+
+sys.path.insert(0, os.path.abspath(os.path.join(
+    os.path.dirname(__file__), os.pardir)))
+
+from net import ToyNet
+from toynet_test3 import transfer_weights
+
+# Operation mode for the inference with the cycle counters
+MODE_PROFILE = 3
+
+# Stages of the dataflow region in `InferenceProfileCore`
+STAGE_NAMES = [
+    "read_input", "conv0", "pool0", "bn0", "conv1", "pool1", "bn1",
+    "flatten", "fc0", "fc1", "fc2", "write_output"]
+# Counters following the stages
+NUM_COUNTERS = len(STAGE_NAMES) + 3
+
+def profile(dma: pynq.lib.DMA,
+            test_loader: torch.utils.data.DataLoader,
+            num_samples: int) -> np.ndarray:
+    in_len = 1 * 28 * 28
+    out_len = 10
+
+    # Allocate the buffer for transfer
+    buf_in0 = allocate(shape=(2,), dtype=np.uint32, cacheable=False)
+    buf_in1 = allocate(shape=(num_samples, in_len),
+                       dtype=np.float32, cacheable=False)
+    buf_out = allocate(shape=(out_len,), dtype=np.float32, cacheable=False)
+    buf_counters = allocate(shape=(NUM_COUNTERS,),
+                            dtype=np.uint32, cacheable=False)
+
+    for idx, (data, _) in enumerate(test_loader):
+        if idx == num_samples:
+            break
+        buf_in1[idx, :] = data[0].view(-1)
+
+    # Send all samples in one request
+    buf_in0[0] = MODE_PROFILE
+    buf_in0[1] = num_samples
+    dma.sendchannel.transfer(buf_in0)
+    dma.sendchannel.wait()
+    dma.sendchannel.transfer(buf_in1)
+
+    # Each output sample and the counters are terminated by `TLAST`
+    for _ in range(num_samples):
+        dma.recvchannel.transfer(buf_out)
+        dma.recvchannel.wait()
+
+    dma.recvchannel.transfer(buf_counters)
+    dma.recvchannel.wait()
+    dma.sendchannel.wait()
+
+    return np.array(buf_counters)
+
+def print_counters(counters: np.ndarray, num_samples: int):
+    num_stages = len(STAGE_NAMES)
+    stage_cycles = counters[:num_stages]
+    sample_loop = int(counters[num_stages + 2])
+
+    # The stage with the most cycles limits the throughput of the dataflow
+    bottleneck = int(np.argmax(stage_cycles))
+
+    for i, name in enumerate(STAGE_NAMES):
+        mark = " <- bottleneck" if i == bottleneck else ""
+        print("{:>12}: {:>10} cycles ({:.1f} per sample){}".format(
+              name, stage_cycles[i], stage_cycles[i] / num_samples, mark))
+
+    print("{:>12}: {:>10} cycles".format(
+          "input stall", counters[num_stages]))
+    print("{:>12}: {:>10} cycles".format(
+          "output stall", counters[num_stages + 1]))
+    print("{:>12}: {:>10} cycles ({:.1f} per sample)".format(
+          "sample loop", sample_loop, sample_loop / num_samples))
+
+def main():
+    if len(sys.argv) < 3 or len(sys.argv) > 4:
+        print(f"Usage: {sys.argv[0]} <Checkpoint> <Bitstream> [Samples]")
+        sys.exit(1)
+
+    num_samples = int(sys.argv[3]) if len(sys.argv) == 4 else 100
+
+    # Load the model
+    model = ToyNet()
+    model.load_state_dict(torch.load(sys.argv[1], map_location="cpu"))
+
+    # Load the overlay
+    overlay = Overlay(sys.argv[2])
+
+    if not overlay.is_loaded():
+        print(f"Failed to load the bitstream: {sys.argv[2]}")
+        sys.exit(1)
+
+    dma = overlay.axi_dma
+    toynet_ip = overlay.toynet
+    toynet_ip.register_map.CTRL.AP_START = 1
+    toynet_ip.register_map.CTRL.AUTO_RESTART = 1
+
+    # Transfer the weights
+    transfer_weights(dma, model)
+    print("Weight initialization successful")
+
+    # Load the dataset
+    transform = torchvision.transforms.Compose([
+        torchvision.transforms.ToTensor(),
+        torchvision.transforms.Normalize((0.1307,), (0.3081,))])
+    test_set = torchvision.datasets.MNIST(
+        "./data", train=False, download=True, transform=transform)
+    test_loader = torch.utils.data.DataLoader(
+        test_set, batch_size=1, shuffle=False)
+    print("Test dataset is successfully loaded")
+
+    # Profile the stages
+    counters = profile(dma, test_loader, num_samples)
+    print_counters(counters, num_samples)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+# coding: utf-8
+# toynet_test_rle.py
+
+# Example:
+# sudo XILINX_XRT=/usr python3 toynet_test_rle.py toynet.pth \
+#   zcu104_toynet_rle_16.bit
+
+import numpy as np
+import os
+import pynq
+import sys
+import torch
+import torch.nn.functional as F
+import torchvision.datasets
+
+from pynq import allocate, Overlay
+
+sys.path.insert(0, os.path.abspath(os.path.join(
+    os.path.dirname(__file__), os.pardir)))
+
+from toynet_test_pixel import transfer_weights
+from net import ToyNet
+
+# Maximum number of zeros in a pair
+RLE_MAX_RUN = 255
+# Number of pairs per transfer
+RLE_PAIRS_PER_BEAT = 2
+
+def rle_encode(pixels: np.ndarray) -> np.ndarray:
+    # Encode the frame of the 8-bit pixels into the pairs of the number of
+    # zeros (lower byte) followed by the pixel value (upper byte), which are
+    # packed two per 32-bit word (`ReadRlePixelArray3d` in
+    # hls/src/data_transfer.hpp)
+    pixels = pixels.reshape(-1)
+    pairs = []
+    prev = -1
+
+    # Each nonzero pixel (and the last pixel) ends the pair, and the runs
+    # longer than `RLE_MAX_RUN` are split with the zero-valued pairs
+    ends = np.flatnonzero(pixels).tolist()
+    if not ends or ends[-1] != len(pixels) - 1:
+        ends.append(len(pixels) - 1)
+
+    for idx in ends:
+        run = idx - prev - 1
+        while run > RLE_MAX_RUN:
+            pairs.append(RLE_MAX_RUN)
+            run -= RLE_MAX_RUN + 1
+        pairs.append(run | (int(pixels[idx]) << 8))
+        prev = idx
+
+    # Pad the last word
+    if len(pairs) % RLE_PAIRS_PER_BEAT != 0:
+        pairs.append(0)
+
+    pairs = np.array(pairs, dtype=np.uint32)
+    return pairs[0::2] | (pairs[1::2] << 16)
+
+def test(dma: pynq.lib.DMA, test_set: torchvision.datasets.MNIST):
+    correct = 0
+    max_in_len = 1 * 28 * 28 // RLE_PAIRS_PER_BEAT
+    out_len = 10
+    total_in_len = 0
+
+    # Allocate the buffer for transfer
+    # The buffer is large enough for the worst case (no zeros), and only
+    # the encoded words are transferred
+    buf_in0 = allocate(shape=(2,), dtype=np.uint32, cacheable=False)
+    buf_in1 = allocate(shape=(max_in_len,), dtype=np.uint32,
+                       cacheable=False)
+    buf_out = allocate(shape=(out_len,), dtype=np.float32, cacheable=False)
+
+    images = test_set.data.numpy()
+    targets = test_set.targets
+
+    for idx in range(len(images)):
+        # Transfer the data sample and receive the result
+        words = rle_encode(images[idx])
+        total_in_len += len(words)
+
+        buf_in0[0] = 2
+        buf_in0[1] = 1
+        buf_in1[:len(words)] = words
+        dma.sendchannel.transfer(buf_in0)
+        dma.sendchannel.wait()
+        dma.sendchannel.transfer(buf_in1, nbytes=words.nbytes)
+        dma.sendchannel.wait()
+        dma.recvchannel.transfer(buf_out)
+        dma.recvchannel.wait()
+
+        out = torch.from_numpy(buf_out).clone()
+        out = out.view(1, out_len)
+        out = F.log_softmax(out, dim=1)
+        pred = out.argmax(dim=1).item()
+        correct += int(pred == targets[idx].item())
+
+        if idx % 100 == 0:
+            print("Index: {}, correct: {}".format(idx, correct))
+
+    print("Test accuracy: {} / {} ({:.0f}%)".format(
+          correct, len(images), 100.0 * correct / len(images)))
+    print("Average input words per sample: {:.1f} (raw pixels: {})".format(
+          total_in_len / len(images), 1 * 28 * 28 // 4))
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} <Checkpoint> <Bitstream>")
+        sys.exit(1)
+
+    # Load the model
+    model = ToyNet()
+    model.load_state_dict(torch.load(sys.argv[1], map_location="cpu"))
+
+    # Load the overlay
+    overlay = Overlay(sys.argv[2])
+
+    if not overlay.is_loaded():
+        print(f"Failed to load the bitstream: {sys.argv[2]}")
+        sys.exit(1)
+
+    dma = overlay.axi_dma
+    toynet_ip = overlay.toynet
+    toynet_ip.register_map.CTRL.AP_START = 1
+    toynet_ip.register_map.CTRL.AUTO_RESTART = 1
+
+    # Transfer the weights and normalization constants
+    transfer_weights(dma, model)
+    print("Weight initialization successful")
+
+    # Load the dataset (raw 8-bit pixels without the transforms)
+    test_set = torchvision.datasets.MNIST(
+        "./data", train=False, download=True)
+    print("Test dataset is successfully loaded")
+
+    # Test the model
+    test(dma, test_set)
+
+if __name__ == "__main__":
+    main()
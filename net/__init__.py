@@ -2,3 +2,4 @@
 # __init__.py
 
 from .toynet import ToyNet
+from .toynet_dwsep import ToyNetDwSep
@@ -1,6 +1,7 @@
 # coding: utf-8
 # test.py
 
+import sys
 import torch
 import torch.nn.functional as F
 import torch.utils.data
@@ -8,6 +9,10 @@ import torchvision.datasets
 import torchvision.transforms
 
 from toynet import ToyNet
+from toynet_dwsep import ToyNetDwSep
+
+# Models that can be selected from the command line
+MODELS = { "toynet": ToyNet, "toynet_dwsep": ToyNetDwSep }
 
 def test(model: ToyNet,
          device: torch.device,
@@ -32,6 +37,11 @@ def test(model: ToyNet,
           100.0 * correct / len(test_loader.dataset)))
 
 def main():
+    model_name = sys.argv[1] if len(sys.argv) > 1 else "toynet"
+    if model_name not in MODELS:
+        print(f"Usage: {sys.argv[0]} [{' | '.join(MODELS)}]")
+        sys.exit(1)
+
     # Load the dataset
     transform = torchvision.transforms.Compose([
         torchvision.transforms.ToTensor(),
@@ -43,8 +53,8 @@ def main():
 
     # Create the model
     device = torch.device("cuda" if torch.cuda.is_available() else "cpu")
-    model = ToyNet().to(device)
-    model.load_state_dict(torch.load("toynet.pth"))
+    model = MODELS[model_name]().to(device)
+    model.load_state_dict(torch.load(f"{model_name}.pth"))
 
     # Test the model
     test(model, device, test_loader)
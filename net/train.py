@@ -1,6 +1,7 @@
 # coding: utf-8
 # train.py
 
+import sys
 import torch
 import torch.nn.functional as F
 import torch.optim as optim
@@ -9,6 +10,10 @@ import torchvision.datasets
 import torchvision.transforms
 
 from toynet import ToyNet
+from toynet_dwsep import ToyNetDwSep
+
+# Models that can be selected from the command line
+MODELS = { "toynet": ToyNet, "toynet_dwsep": ToyNetDwSep }
 
 def train(model: ToyNet,
           device: torch.device,
@@ -54,6 +59,11 @@ def test(model: ToyNet,
           100.0 * correct / len(test_loader.dataset)))
 
 def main():
+    model_name = sys.argv[1] if len(sys.argv) > 1 else "toynet"
+    if model_name not in MODELS:
+        print(f"Usage: {sys.argv[0]} [{' | '.join(MODELS)}]")
+        sys.exit(1)
+
     # Load the dataset
     transform = torchvision.transforms.Compose([
         torchvision.transforms.ToTensor(),
@@ -69,7 +79,7 @@ def main():
 
     # Create the model
     device = torch.device("cuda" if torch.cuda.is_available() else "cpu")
-    model = ToyNet().to(device)
+    model = MODELS[model_name]().to(device)
     optimizer = optim.Adam(model.parameters())
 
     for epoch in range(1, 6):
@@ -77,7 +87,7 @@ def main():
         test(model, device, test_loader, epoch)
 
     # Save the model
-    torch.save(model.state_dict(), "toynet.pth")
+    torch.save(model.state_dict(), f"{model_name}.pth")
 
 if __name__ == "__main__":
     main()